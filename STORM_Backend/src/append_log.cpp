@@ -0,0 +1,518 @@
+#include "append_log.h"
+#include "key_hash.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <system_error>
+#include <unistd.h>
+
+namespace {
+
+constexpr char kLogMagic[8] = {'S', 'T', 'O', 'R', 'M', 'L', 'O', 'G'};
+constexpr uint32_t kLogVersion = 1;
+constexpr size_t kHeaderBytes = sizeof(kLogMagic) + 2 * sizeof(uint32_t);
+constexpr size_t kRecordHeaderBytes = 2 * sizeof(uint32_t); ///< Payload length and checksum
+constexpr uint64_t kChecksumSeed = 0x53544f524d4c4f47ull;
+
+[[noreturn]] void ThrowSystemError(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+uint32_t PayloadChecksum(const char* payload, size_t payload_size) {
+    return static_cast<uint32_t>(HashKey(std::string_view(payload, payload_size), kChecksumSeed));
+}
+
+template <typename Integer>
+char* PutInteger(char* output, Integer value) {
+    std::memcpy(output, &value, sizeof(value));
+    return output + sizeof(value);
+}
+
+template <typename Integer>
+Integer GetInteger(const char* input) {
+    Integer value;
+    std::memcpy(&value, input, sizeof(value));
+    return value;
+}
+
+char* PutBytes(char* output, std::string_view bytes) {
+    std::memcpy(output, bytes.data(), bytes.size());
+    return output + bytes.size();
+}
+
+/**
+ * @brief Write a whole buffer, retrying short writes and EINTR.
+ */
+bool WriteAll(int file_descriptor, const char* bytes, size_t byte_count) {
+    while (byte_count > 0) {
+        ssize_t written = ::write(file_descriptor, bytes, byte_count);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bytes += written;
+        byte_count -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+/**
+ * @brief Read the file header and check its magic and version.
+ */
+bool ReadHeader(int file_descriptor, char* header) {
+    size_t read_bytes = 0;
+    while (read_bytes < kHeaderBytes) {
+        ssize_t result = ::pread(file_descriptor, header + read_bytes, kHeaderBytes - read_bytes,
+                                 static_cast<off_t>(read_bytes));
+        if (result < 0 && errno == EINTR) continue;
+        if (result <= 0) return false;
+        read_bytes += static_cast<size_t>(result);
+    }
+    return std::memcmp(header, kLogMagic, sizeof(kLogMagic)) == 0 &&
+           GetInteger<uint32_t>(header + sizeof(kLogMagic)) == kLogVersion;
+}
+
+/**
+ * @brief Open a log file for appending, writing the header into a new or emptied file.
+ * @param path Log file.
+ * @param truncate Discard any existing contents first.
+ * @param file_size Output; the file's length.
+ * @return int Open file descriptor.
+ * @throws std::system_error If the file cannot be opened or an existing header is invalid.
+ */
+int OpenLogFile(const std::string& path, bool truncate, uint64_t& file_size) {
+    int flags = O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC | (truncate ? O_TRUNC : 0);
+    int file_descriptor = ::open(path.c_str(), flags, 0644);
+    if (file_descriptor < 0) ThrowSystemError("open " + path);
+
+    off_t end_offset = ::lseek(file_descriptor, 0, SEEK_END);
+    if (end_offset < 0) {
+        ::close(file_descriptor);
+        ThrowSystemError("lseek " + path);
+    }
+
+    // A new log starts with its header; an existing one must already carry it
+    if (end_offset == 0) {
+        char header[kHeaderBytes] = {};
+        char* cursor = PutBytes(header, std::string_view(kLogMagic, sizeof(kLogMagic)));
+        cursor = PutInteger<uint32_t>(cursor, kLogVersion);
+        PutInteger<uint32_t>(cursor, 0);
+        if (!WriteAll(file_descriptor, header, kHeaderBytes) || ::fsync(file_descriptor) != 0) {
+            ::close(file_descriptor);
+            ThrowSystemError("write " + path);
+        }
+        end_offset = static_cast<off_t>(kHeaderBytes);
+    } else {
+        char header[kHeaderBytes];
+        if (!ReadHeader(file_descriptor, header)) {
+            ::close(file_descriptor);
+            errno = EINVAL;
+            ThrowSystemError("not a store log: " + path);
+        }
+    }
+
+    file_size = static_cast<uint64_t>(end_offset);
+    return file_descriptor;
+}
+
+} // namespace
+
+void SyncParentDirectory(const std::string& path) {
+    size_t separator = path.find_last_of('/');
+    std::string directory = separator == std::string::npos ? "." : path.substr(0, separator + 1);
+    int directory_descriptor = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (directory_descriptor < 0) ThrowSystemError("open " + directory);
+    int sync_result = ::fsync(directory_descriptor);
+    int sync_error = errno;
+    ::close(directory_descriptor);
+    if (sync_result != 0) {
+        errno = sync_error;
+        ThrowSystemError("fsync " + directory);
+    }
+}
+
+// ========================================
+// Record encoding
+// ========================================
+
+size_t EncodedLogRecordSize(const LogRecord& record) {
+    size_t payload_size = 1;
+    switch (record.type) {
+        case LogRecordType::Put:
+            payload_size += 2 * sizeof(uint32_t) + sizeof(uint64_t) + record.key.size() + record.value.size();
+            break;
+        case LogRecordType::Delete:
+            payload_size += sizeof(uint32_t) + record.key.size();
+            break;
+        case LogRecordType::Expire:
+            payload_size += sizeof(uint32_t) + sizeof(uint64_t) + record.key.size();
+            break;
+        case LogRecordType::Clear:
+            break;
+    }
+    return kRecordHeaderBytes + payload_size;
+}
+
+void EncodeLogRecord(const LogRecord& record, char* output) {
+    char* payload = output + kRecordHeaderBytes;
+    char* cursor = payload;
+    *cursor++ = static_cast<char>(record.type);
+    switch (record.type) {
+        case LogRecordType::Put:
+            cursor = PutInteger<uint32_t>(cursor, static_cast<uint32_t>(record.key.size()));
+            cursor = PutInteger<uint32_t>(cursor, static_cast<uint32_t>(record.value.size()));
+            cursor = PutInteger<uint64_t>(cursor, record.expiresAtWallMillis);
+            cursor = PutBytes(cursor, record.key);
+            cursor = PutBytes(cursor, record.value);
+            break;
+        case LogRecordType::Delete:
+            cursor = PutInteger<uint32_t>(cursor, static_cast<uint32_t>(record.key.size()));
+            cursor = PutBytes(cursor, record.key);
+            break;
+        case LogRecordType::Expire:
+            cursor = PutInteger<uint32_t>(cursor, static_cast<uint32_t>(record.key.size()));
+            cursor = PutInteger<uint64_t>(cursor, record.expiresAtWallMillis);
+            cursor = PutBytes(cursor, record.key);
+            break;
+        case LogRecordType::Clear:
+            break;
+    }
+
+    size_t payload_size = static_cast<size_t>(cursor - payload);
+    char* header = PutInteger<uint32_t>(output, static_cast<uint32_t>(payload_size));
+    PutInteger<uint32_t>(header, PayloadChecksum(payload, payload_size));
+}
+
+LogDecodeStatus DecodeLogRecord(const char* data, size_t available, LogRecord& record, size_t& record_bytes) {
+    if (available < kRecordHeaderBytes) {
+        record_bytes = kRecordHeaderBytes;
+        return LogDecodeStatus::Incomplete;
+    }
+    uint32_t payload_size = GetInteger<uint32_t>(data);
+    uint32_t checksum = GetInteger<uint32_t>(data + sizeof(uint32_t));
+    record_bytes = kRecordHeaderBytes + payload_size;
+    if (payload_size == 0) {
+        return LogDecodeStatus::Corrupt;
+    }
+    if (available < record_bytes) {
+        return LogDecodeStatus::Incomplete;
+    }
+
+    const char* payload = data + kRecordHeaderBytes;
+    if (PayloadChecksum(payload, payload_size) != checksum) {
+        return LogDecodeStatus::Corrupt;
+    }
+
+    // Decode with bounds checks; a checksummed but malformed record is still corrupt
+    const char* payload_end = payload + payload_size;
+    const char* cursor = payload + 1;
+    auto has = [&](size_t byte_count) { return static_cast<size_t>(payload_end - cursor) >= byte_count; };
+    record = LogRecord{};
+    record.type = static_cast<LogRecordType>(payload[0]);
+    bool well_formed = false;
+
+    switch (record.type) {
+        case LogRecordType::Put:
+            if (has(2 * sizeof(uint32_t) + sizeof(uint64_t))) {
+                uint32_t key_size = GetInteger<uint32_t>(cursor);
+                uint32_t value_size = GetInteger<uint32_t>(cursor + sizeof(uint32_t));
+                record.expiresAtWallMillis = GetInteger<uint64_t>(cursor + 2 * sizeof(uint32_t));
+                cursor += 2 * sizeof(uint32_t) + sizeof(uint64_t);
+                if (static_cast<size_t>(payload_end - cursor) == size_t{key_size} + value_size) {
+                    record.key = std::string_view(cursor, key_size);
+                    record.value = std::string_view(cursor + key_size, value_size);
+                    well_formed = true;
+                }
+            }
+            break;
+        case LogRecordType::Delete:
+            if (has(sizeof(uint32_t))) {
+                uint32_t key_size = GetInteger<uint32_t>(cursor);
+                cursor += sizeof(uint32_t);
+                if (static_cast<size_t>(payload_end - cursor) == key_size) {
+                    record.key = std::string_view(cursor, key_size);
+                    well_formed = true;
+                }
+            }
+            break;
+        case LogRecordType::Expire:
+            if (has(sizeof(uint32_t) + sizeof(uint64_t))) {
+                uint32_t key_size = GetInteger<uint32_t>(cursor);
+                record.expiresAtWallMillis = GetInteger<uint64_t>(cursor + sizeof(uint32_t));
+                cursor += sizeof(uint32_t) + sizeof(uint64_t);
+                if (static_cast<size_t>(payload_end - cursor) == key_size) {
+                    record.key = std::string_view(cursor, key_size);
+                    well_formed = true;
+                }
+            }
+            break;
+        case LogRecordType::Clear:
+            well_formed = payload_size == 1;
+            break;
+    }
+    return well_formed ? LogDecodeStatus::Complete : LogDecodeStatus::Corrupt;
+}
+
+// ========================================
+// AppendLog
+// ========================================
+
+AppendLog::AppendLog(const std::string& path, FsyncPolicy fsync_policy) : logPath(path), policy(fsync_policy) {
+    uint64_t file_size = 0;
+    fileDescriptor = OpenLogFile(path, false, file_size);
+    appendedOffset = writtenOffset = syncedOffset = file_size;
+    flusher = std::thread([this] { flushLoop(); });
+}
+
+AppendLog::~AppendLog() {
+    {
+        std::lock_guard<std::mutex> log_lock_guard(logLock);
+        stopping = true;
+    }
+    workPending.notify_one();
+    flusher.join();
+    ::close(fileDescriptor);
+}
+
+void AppendLog::appendRecord(const LogRecord& record) {
+    std::unique_lock<std::mutex> log_lock_guard(logLock);
+
+    // Backpressure only when the disk is far behind; normally this never waits
+    groupWritten.wait(log_lock_guard, [this] { return failed || pendingRecords.size() < kMaxPendingBytes; });
+    if (failed) {
+        return;
+    }
+
+    bool was_empty = pendingRecords.empty();
+    size_t record_start = pendingRecords.size();
+    size_t record_bytes = EncodedLogRecordSize(record);
+    pendingRecords.resize(record_start + record_bytes);
+    EncodeLogRecord(record, &pendingRecords[record_start]);
+    appendedOffset += record_bytes;
+
+    // The flusher only sleeps while the buffer is empty
+    if (was_empty) {
+        workPending.notify_one();
+    }
+}
+
+void AppendLog::appendPut(std::string_view key, std::string_view value, uint64_t expires_at_wall_millis) {
+    appendRecord(LogRecord{LogRecordType::Put, key, value, expires_at_wall_millis});
+}
+
+void AppendLog::appendDelete(std::string_view key) {
+    appendRecord(LogRecord{LogRecordType::Delete, key, {}, 0});
+}
+
+void AppendLog::appendExpire(std::string_view key, uint64_t expires_at_wall_millis) {
+    appendRecord(LogRecord{LogRecordType::Expire, key, {}, expires_at_wall_millis});
+}
+
+void AppendLog::appendClear() {
+    appendRecord(LogRecord{LogRecordType::Clear, {}, {}, 0});
+}
+
+bool AppendLog::sync() {
+    std::unique_lock<std::mutex> log_lock_guard(logLock);
+    uint64_t target_offset = appendedOffset;
+    syncRequestedOffset = std::max(syncRequestedOffset, target_offset);
+    workPending.notify_one();
+    groupWritten.wait(log_lock_guard, [&] { return failed || syncedOffset >= target_offset; });
+    return !failed;
+}
+
+bool AppendLog::healthy() const {
+    std::lock_guard<std::mutex> log_lock_guard(logLock);
+    return !failed;
+}
+
+uint64_t AppendLog::writtenBytes() const {
+    std::lock_guard<std::mutex> log_lock_guard(logLock);
+    return writtenOffset - fileStartOffset;
+}
+
+void AppendLog::compact(const std::function<void()>& write_snapshot) {
+    std::lock_guard<std::mutex> compaction_guard(compactionLock);
+    std::string next_path = logPath + ".next";
+
+    // A pending rotation from a failed attempt already holds every record since it started
+    if (!rotationPending) {
+        uint64_t file_size = 0;
+        int next_file = OpenLogFile(next_path, true, file_size);
+        SyncParentDirectory(next_path);
+        switchFile(next_file);
+        rotationPending = true;
+    }
+
+    write_snapshot();
+
+    if (::rename(next_path.c_str(), logPath.c_str()) != 0) {
+        ThrowSystemError("rename " + next_path);
+    }
+    SyncParentDirectory(logPath);
+    rotationPending = false;
+}
+
+/**
+ * @brief Finish the current file and make nextFile the one records go to.
+ *
+ * Holds the log lock throughout, so every record appended before the switch
+ * lands in the old file and every later one in the new file.
+ */
+void AppendLog::switchFile(int next_file) {
+    std::unique_lock<std::mutex> log_lock_guard(logLock);
+    groupWritten.wait(log_lock_guard, [this] { return !groupInFlight; });
+
+    bool succeeded = !failed && WriteAll(fileDescriptor, pendingRecords.data(), pendingRecords.size()) &&
+                     ::fdatasync(fileDescriptor) == 0;
+    if (!succeeded && !failed) {
+        std::cerr << "Append log write failed: " << std::strerror(errno) << "; logging stopped\n";
+        failed = true;
+    }
+    pendingRecords.clear();
+
+    ::close(fileDescriptor);
+    fileDescriptor = next_file;
+    fileStartOffset = appendedOffset;
+    appendedOffset += kHeaderBytes;
+    writtenOffset = syncedOffset = appendedOffset;
+    groupWritten.notify_all();
+}
+
+/**
+ * @brief Flusher thread: write each group of pending records with one call, then fsync per policy.
+ */
+void AppendLog::flushLoop() {
+    using Clock = std::chrono::steady_clock;
+    constexpr auto kFsyncInterval = std::chrono::seconds(1);
+    std::string group_records;
+    Clock::time_point last_fsync = Clock::now();
+
+    std::unique_lock<std::mutex> log_lock_guard(logLock);
+    while (true) {
+        // Wake for new records, a sync request, or stop, and at least once a second for EverySecond
+        workPending.wait_for(log_lock_guard, kFsyncInterval, [&] {
+            return stopping || !pendingRecords.empty() || syncRequestedOffset > syncedOffset;
+        });
+
+        bool sync_requested = stopping || syncRequestedOffset > syncedOffset;
+        bool fsync_due = policy == FsyncPolicy::EverySecond && Clock::now() - last_fsync >= kFsyncInterval;
+        bool unsynced = writtenOffset > syncedOffset;
+        if (pendingRecords.empty() && !((sync_requested || fsync_due) && unsynced)) {
+            if (stopping) break;
+            continue;
+        }
+
+        group_records.swap(pendingRecords);
+        uint64_t group_end = appendedOffset;
+        int group_file = fileDescriptor;
+        groupInFlight = true;
+        log_lock_guard.unlock();
+
+        // Disk work happens without the lock, so appends continue into the fresh buffer
+        bool succeeded = WriteAll(group_file, group_records.data(), group_records.size());
+        group_records.clear();
+        bool fsync_now = policy == FsyncPolicy::Always || sync_requested || fsync_due;
+        if (succeeded && fsync_now) {
+            succeeded = ::fdatasync(group_file) == 0;
+            last_fsync = Clock::now();
+        }
+        int write_error = errno;
+
+        log_lock_guard.lock();
+        groupInFlight = false;
+        if (!succeeded) {
+            std::cerr << "Append log write failed: " << std::strerror(write_error) << "; logging stopped\n";
+            failed = true;
+            pendingRecords.clear();
+            groupWritten.notify_all();
+            workPending.wait(log_lock_guard, [this] { return stopping; });
+            break;
+        }
+
+        writtenOffset = group_end;
+        if (fsync_now) {
+            syncedOffset = group_end;
+        }
+        groupWritten.notify_all();
+    }
+}
+
+// ========================================
+// AppendLogReader
+// ========================================
+
+AppendLogReader::AppendLogReader(const std::string& path) {
+    fileDescriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fileDescriptor < 0) ThrowSystemError("open " + path);
+
+    char header[kHeaderBytes];
+    if (!ReadHeader(fileDescriptor, header)) {
+        ::close(fileDescriptor);
+        errno = EINVAL;
+        ThrowSystemError("not a store log: " + path);
+    }
+    if (::lseek(fileDescriptor, static_cast<off_t>(kHeaderBytes), SEEK_SET) < 0) {
+        ::close(fileDescriptor);
+        ThrowSystemError("lseek " + path);
+    }
+    ::posix_fadvise(fileDescriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    buffer.resize(kReadChunkBytes);
+    validOffset = kHeaderBytes;
+}
+
+AppendLogReader::~AppendLogReader() {
+    ::close(fileDescriptor);
+}
+
+bool AppendLogReader::fill(size_t byte_count) {
+    if (bufferEnd - bufferStart >= byte_count) {
+        return true;
+    }
+
+    // Move the undecoded tail to the front and make room for a whole record
+    std::memmove(buffer.data(), buffer.data() + bufferStart, bufferEnd - bufferStart);
+    bufferEnd -= bufferStart;
+    bufferStart = 0;
+    if (buffer.size() < byte_count) {
+        buffer.resize(std::max(byte_count, buffer.size() * 2));
+    }
+
+    while (bufferEnd < byte_count && !endOfFile) {
+        ssize_t result = ::read(fileDescriptor, buffer.data() + bufferEnd, buffer.size() - bufferEnd);
+        if (result < 0 && errno == EINTR) continue;
+        if (result <= 0) {
+            endOfFile = true;
+            break;
+        }
+        bufferEnd += static_cast<size_t>(result);
+    }
+    return bufferEnd >= byte_count;
+}
+
+bool AppendLogReader::next(LogRecord& record) {
+    if (stoppedEarly) {
+        return false;
+    }
+    if (!fill(kRecordHeaderBytes)) {
+        stoppedEarly = bufferEnd > bufferStart;
+        return false;
+    }
+
+    size_t record_bytes = 0;
+    LogDecodeStatus status = DecodeLogRecord(buffer.data() + bufferStart, bufferEnd - bufferStart, record, record_bytes);
+    if (status == LogDecodeStatus::Incomplete && fill(record_bytes)) {
+        status = DecodeLogRecord(buffer.data() + bufferStart, bufferEnd - bufferStart, record, record_bytes);
+    }
+    if (status != LogDecodeStatus::Complete) {
+        stoppedEarly = true;
+        return false;
+    }
+
+    bufferStart += record_bytes;
+    validOffset += record_bytes;
+    return true;
+}
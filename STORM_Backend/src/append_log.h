@@ -0,0 +1,296 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Binary append-only log of store mutations, for crash recovery.
+ *
+ * File layout (all integers little-endian):
+ *  - Header: the 8 bytes "STORMLOG", a uint32 format version, a uint32 reserved word.
+ *  - Records: uint32 payload length, uint32 checksum of the payload, payload.
+ *
+ * A payload starts with its LogRecordType byte:
+ *  - Put:    uint32 key length, uint32 value length, uint64 deadline, key, value
+ *  - Delete: uint32 key length, key
+ *  - Expire: uint32 key length, uint64 deadline, key (deadline 0 = persist)
+ *  - Clear:  nothing
+ *
+ * Deadlines are wall-clock milliseconds since the Unix epoch (0 = none), so
+ * they keep their meaning across restarts. Every record is length-prefixed
+ * and checksummed, so replay streams through the file in large reads and
+ * stops cleanly at a torn tail left by a crash.
+ */
+
+/**
+ * @brief Kind of a logged mutation.
+ */
+enum class LogRecordType : uint8_t {
+    Put = 1,
+    Delete = 2,
+    Expire = 3,
+    Clear = 4
+};
+
+/**
+ * @brief When the log flusher forces written records to disk.
+ */
+enum class FsyncPolicy {
+    Always,      ///< fsync after every group commit
+    EverySecond, ///< fsync at most once per second; a crash loses about a second of writes
+    Never        ///< Leave it to the operating system
+};
+
+/**
+ * @brief One log record; when decoded, the views point into the decoder's buffer.
+ */
+struct LogRecord {
+    LogRecordType type = LogRecordType::Clear; ///< Kind of mutation
+    std::string_view key;                      ///< Key, for every type but Clear
+    std::string_view value;                    ///< Value, for Put
+    uint64_t expiresAtWallMillis = 0;          ///< Wall-clock deadline for Put and Expire; 0 = none
+};
+
+/**
+ * @brief Outcome of decoding the bytes at the front of a buffer.
+ */
+enum class LogDecodeStatus {
+    Complete,   ///< A whole, valid record was decoded
+    Incomplete, ///< More bytes are needed; recordBytes says how many in total
+    Corrupt     ///< Bad checksum, length, or layout
+};
+
+/**
+ * @brief Bytes a record takes in the log format, length and checksum included.
+ */
+size_t EncodedLogRecordSize(const LogRecord& record);
+
+/**
+ * @brief Encode a record in the log format.
+ * @param record Record to encode.
+ * @param output Destination of EncodedLogRecordSize(record) bytes.
+ */
+void EncodeLogRecord(const LogRecord& record, char* output);
+
+/**
+ * @brief Decode the record at the start of a buffer.
+ * @param data Encoded bytes.
+ * @param available Number of bytes at data.
+ * @param record Output; views into data.
+ * @param recordBytes Output; the record's full encoded length, once its header is available.
+ */
+LogDecodeStatus DecodeLogRecord(const char* data, size_t available, LogRecord& record, size_t& recordBytes);
+
+/**
+ * @brief Writer side of the log: group commit on a dedicated flusher thread.
+ *
+ * Appends only encode the record into an in-memory buffer under a short
+ * mutex; they never touch the file. The flusher swaps that buffer for an
+ * empty one, writes the whole group with one write call, and fsyncs as the
+ * policy says. If the disk falls more than kMaxPendingBytes behind,
+ * appends wait for the flusher rather than growing the buffer further.
+ *
+ * Callers that need a consistent order (the store) append while holding the
+ * lock that orders the mutations. Thread-safe.
+ */
+class AppendLog {
+public:
+    /**
+     * @brief Bytes of unwritten records before appends start to wait.
+     */
+    static constexpr size_t kMaxPendingBytes = size_t{256} << 20;
+
+    /**
+     * @brief Open (or create) a log for appending and start the flusher.
+     * @param path Log file; records are appended after its existing contents.
+     * @param fsyncPolicy When written records are fsynced.
+     * @throws std::system_error If the file cannot be opened or its header is invalid.
+     *
+     * Replay the file and cut off any torn tail (see AppendLogReader) first.
+     */
+    AppendLog(const std::string& path, FsyncPolicy fsyncPolicy);
+
+    /**
+     * @brief Write and fsync everything appended, stop the flusher, and close the file.
+     */
+    ~AppendLog();
+
+    AppendLog(const AppendLog&) = delete;
+    AppendLog& operator=(const AppendLog&) = delete;
+
+    /**
+     * @brief Log an insert or overwrite.
+     * @param key Key written.
+     * @param value New value.
+     * @param expiresAtWallMillis Wall-clock deadline in milliseconds, or 0 for none.
+     */
+    void appendPut(std::string_view key, std::string_view value, uint64_t expiresAtWallMillis);
+
+    /**
+     * @brief Log a delete of a key that existed.
+     * @param key Key deleted.
+     */
+    void appendDelete(std::string_view key);
+
+    /**
+     * @brief Log a TTL change of an existing key.
+     * @param key Key updated.
+     * @param expiresAtWallMillis New wall-clock deadline, or 0 if the key no longer expires.
+     */
+    void appendExpire(std::string_view key, uint64_t expiresAtWallMillis);
+
+    /**
+     * @brief Log that every key was removed.
+     */
+    void appendClear();
+
+    /**
+     * @brief Block until every record appended so far is written and fsynced.
+     * @return true If the records reached the disk; false if the log has failed.
+     */
+    bool sync();
+
+    /**
+     * @brief Replace the log's history with a snapshot, keeping every record the snapshot may miss.
+     * @param writeSnapshot Writes the snapshot; called after new records start going to a fresh file.
+     * @throws std::system_error If the fresh file cannot be created or installed, or from writeSnapshot.
+     *
+     * New records go to path + ".next" from the moment this is called, so
+     * whatever writeSnapshot captures is at least as new as the old file,
+     * and replaying the fresh file over the snapshot yields the current
+     * state. Once the snapshot is written the fresh file is renamed over
+     * the log. If writeSnapshot throws, records keep going to the fresh
+     * file and the next call retries the snapshot. After a crash in between,
+     * replaying the log and then path + ".next" recovers everything.
+     * Calls are serialised.
+     */
+    void compact(const std::function<void()>& writeSnapshot);
+
+    /**
+     * @brief Whether every write and fsync so far has succeeded.
+     *
+     * After the first failure the log stops writing and drops new records,
+     * so a partial group never lands in the middle of the file.
+     */
+    bool healthy() const;
+
+    /**
+     * @brief Bytes handed to the current file so far, header and earlier contents included.
+     */
+    uint64_t writtenBytes() const;
+
+private:
+    std::string logPath;          ///< Path of the log file
+    int fileDescriptor = -1;      ///< Current log file, opened for appending; swapped by compact
+    FsyncPolicy policy;           ///< When groups are fsynced
+    std::mutex compactionLock;    ///< Serialises compact
+    bool rotationPending = false; ///< Records go to the ".next" file; guarded by compactionLock
+
+    // Positions count bytes from the start of the file the log was opened on,
+    // and keep counting across compactions so sync() waiters are never stranded
+
+    mutable std::mutex logLock;           ///< Guards everything below
+    std::condition_variable workPending;  ///< Signalled when records, a sync request, or stop arrive
+    std::condition_variable groupWritten; ///< Signalled after each group commit
+    std::string pendingRecords;           ///< Encoded records not yet handed to the flusher
+    uint64_t appendedOffset = 0;          ///< Log position just past the last appended record
+    uint64_t writtenOffset = 0;           ///< Log position up to which records were written
+    uint64_t syncedOffset = 0;            ///< Log position up to which records were fsynced
+    uint64_t syncRequestedOffset = 0;     ///< Position a sync() caller is waiting to see fsynced
+    uint64_t fileStartOffset = 0;         ///< Log position of the current file's first byte
+    bool groupInFlight = false;           ///< The flusher is writing a group without the lock
+    bool failed = false;                  ///< A write or fsync failed
+    bool stopping = false;                ///< Set by the destructor
+    std::thread flusher;                  ///< Runs flushLoop
+
+    /**
+     * @brief Encode one record onto the pending buffer.
+     */
+    void appendRecord(const LogRecord& record);
+
+    /**
+     * @brief Write and fsync everything appended to the current file, then continue in nextFile.
+     */
+    void switchFile(int nextFile);
+
+    void flushLoop();
+};
+
+/**
+ * @brief Streaming reader for replaying a log at startup.
+ *
+ * Reads the file in large sequential chunks and decodes records in place.
+ * Reading stops at the end of the file or at the first incomplete or
+ * corrupt record, whose offset validBytes() reports so the caller can cut
+ * the torn tail off before appending again.
+ */
+class AppendLogReader {
+public:
+    /**
+     * @brief Open a log and check its header.
+     * @param path Log file.
+     * @throws std::system_error If the file cannot be opened or has no valid header.
+     */
+    explicit AppendLogReader(const std::string& path);
+
+    ~AppendLogReader();
+
+    AppendLogReader(const AppendLogReader&) = delete;
+    AppendLogReader& operator=(const AppendLogReader&) = delete;
+
+    /**
+     * @brief Decode the next record.
+     * @param record Output; valid until the next call.
+     * @return true If a record was read; false at the end of the valid records.
+     */
+    bool next(LogRecord& record);
+
+    /**
+     * @brief Length of the file's valid prefix: the header plus every complete record read so far.
+     */
+    uint64_t validBytes() const { return validOffset; }
+
+    /**
+     * @brief Whether reading stopped before the end of the file (a torn or corrupt tail).
+     */
+    bool tornTail() const { return stoppedEarly; }
+
+private:
+    static constexpr size_t kReadChunkBytes = size_t{1} << 20;
+
+    int fileDescriptor = -1;
+    std::vector<char> buffer;  ///< Read-ahead; bytes from bufferStart to bufferEnd are not yet decoded
+    size_t bufferStart = 0;    ///< First undecoded byte
+    size_t bufferEnd = 0;      ///< End of the bytes read
+    bool endOfFile = false;    ///< The file has been read to its end
+    bool stoppedEarly = false; ///< A torn or corrupt record ended the replay
+    uint64_t validOffset = 0;  ///< File offset just past the last complete record
+
+    /**
+     * @brief Make at least byteCount undecoded bytes available, reading more if needed.
+     * @return true If they are available.
+     */
+    bool fill(size_t byteCount);
+};
+
+/**
+ * @brief fsync the directory that holds path, so a rename or create in it survives a crash.
+ * @throws std::system_error If the directory cannot be opened or synced.
+ */
+void SyncParentDirectory(const std::string& path);
+
+/**
+ * @brief Current wall-clock time in milliseconds since the Unix epoch; the time base of logged deadlines.
+ */
+inline uint64_t WallClockMillis() {
+    auto since_epoch = std::chrono::system_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(since_epoch).count());
+}
@@ -0,0 +1,689 @@
+#include "command_processor.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <utility>
+
+/**
+ * @brief Trim leading and trailing whitespace from a string.
+ * @param inputString String to trim.
+ * @return std::string Trimmed string.
+ */
+std::string TrimWhitespace(const std::string& inputString) {
+    std::string trimmedString = inputString;
+
+    // Trim leading whitespace
+    trimmedString.erase(
+        trimmedString.begin(),
+        std::find_if(
+            trimmedString.begin(),
+            trimmedString.end(),
+            [](unsigned char character) { return !std::isspace(character); }
+        )
+    );
+
+    // Trim trailing whitespace
+    trimmedString.erase(
+        std::find_if(
+            trimmedString.rbegin(),
+            trimmedString.rend(),
+            [](unsigned char character) { return !std::isspace(character); }
+        ).base(),
+        trimmedString.end()
+    );
+
+    return trimmedString;
+}
+
+namespace {
+
+/**
+ * @brief Whitespace test matching std::isspace in the "C" locale.
+ */
+bool IsWhitespace(char character) {
+    return std::isspace(static_cast<unsigned char>(character)) != 0;
+}
+
+/**
+ * @brief View of input without leading and trailing whitespace.
+ */
+std::string_view TrimWhitespaceView(std::string_view input) {
+    size_t first = 0;
+    while (first < input.size() && IsWhitespace(input[first])) ++first;
+    size_t last = input.size();
+    while (last > first && IsWhitespace(input[last - 1])) --last;
+    return input.substr(first, last - first);
+}
+
+/**
+ * @brief Pop the next whitespace-delimited token, as operator>> would read it.
+ * @param remaining Unparsed input; advanced past the token.
+ * @return std::string_view The token, or an empty view if none is left.
+ */
+std::string_view NextToken(std::string_view& remaining) {
+    size_t first = 0;
+    while (first < remaining.size() && IsWhitespace(remaining[first])) ++first;
+    size_t last = first;
+    while (last < remaining.size() && !IsWhitespace(remaining[last])) ++last;
+
+    std::string_view token = remaining.substr(first, last - first);
+    remaining.remove_prefix(last);
+    return token;
+}
+
+/**
+ * @brief Parse a whole token as an unsigned number.
+ * @return false If the token is empty, has trailing characters, or overflows.
+ */
+bool ParseUnsigned(std::string_view token, uint64_t& value) {
+    auto conversion = std::from_chars(token.data(), token.data() + token.size(), value);
+    return !token.empty() && conversion.ec == std::errc() && conversion.ptr == token.data() + token.size();
+}
+
+/**
+ * @brief Parse a whole token as a signed number.
+ * @return false If the token is empty, has trailing characters, or overflows.
+ */
+bool ParseSigned(std::string_view token, int64_t& value) {
+    auto conversion = std::from_chars(token.data(), token.data() + token.size(), value);
+    return !token.empty() && conversion.ec == std::errc() && conversion.ptr == token.data() + token.size();
+}
+
+/**
+ * @brief Whether a command changes the store, and so is refused on a replica.
+ */
+bool IsWriteCommand(std::string_view command_keyword) {
+    return command_keyword == "PUT" || command_keyword == "DEL" || command_keyword == "EXPIRE" ||
+           command_keyword == "CLEAR" || command_keyword == "INCR" || command_keyword == "APPEND" ||
+           command_keyword == "CAS";
+}
+
+/**
+ * @brief Append nanoseconds as microseconds with three decimals.
+ */
+void AppendMicros(std::string& reply, uint64_t nanos) {
+    char micros[32];
+    std::snprintf(micros, sizeof(micros), "%.3f", static_cast<double>(nanos) / 1000.0);
+    reply += micros;
+}
+
+/**
+ * @brief Slab usage as a JSON object.
+ */
+std::string SlabJson(const SlabStats& slab) {
+    char fragmentation[32];
+    std::snprintf(fragmentation, sizeof(fragmentation), "%.4f", slab.fragmentation());
+    std::string json = "{ \"pageBytes\": " + std::to_string(slab.pageBytes);
+    json += ", \"chunkBytes\": " + std::to_string(slab.chunkBytes);
+    json += ", \"requestedBytes\": " + std::to_string(slab.requestedBytes);
+    json += ", \"heapBytes\": " + std::to_string(slab.heapBytes);
+    json += ", \"fragmentation\": ";
+    json += fragmentation;
+    json += " }";
+    return json;
+}
+
+/**
+ * @brief Hot keys as a JSON array of key and estimated-read pairs.
+ */
+std::string HotKeysJson(const std::vector<HotKey>& hot_keys) {
+    std::string json = "[";
+    for (size_t key_index = 0; key_index < hot_keys.size(); ++key_index) {
+        json += key_index == 0 ? " " : ", ";
+        json += "{ \"key\": \"" + hot_keys[key_index].key + "\", \"reads\": ";
+        json += std::to_string(hot_keys[key_index].reads) + " }";
+    }
+    json += hot_keys.empty() ? "]" : " ]";
+    return json;
+}
+
+/**
+ * @brief Compression counters as a JSON object.
+ */
+std::string CompressionJson(const CompressionStats& compression) {
+    char ratio[32];
+    std::snprintf(ratio, sizeof(ratio), "%.4f", compression.ratio());
+    std::string json = "{ \"compressedValues\": " + std::to_string(compression.compressedValues);
+    json += ", \"incompressibleValues\": " + std::to_string(compression.incompressibleValues);
+    json += ", \"inputBytes\": " + std::to_string(compression.inputBytes);
+    json += ", \"outputBytes\": " + std::to_string(compression.outputBytes);
+    json += ", \"ratio\": ";
+    json += ratio;
+    json += ", \"compressMicros\": " + std::to_string(compression.compressNanos / 1000);
+    json += ", \"decompressions\": " + std::to_string(compression.decompressions);
+    json += ", \"decompressMicros\": " + std::to_string(compression.decompressNanos / 1000);
+    json += " }";
+    return json;
+}
+
+} // namespace
+
+/**
+ * @brief Construct a processor for one session.
+ * @param target_store Store that commands operate on.
+ * @param record_history Whether to remember commands for HISTORY.
+ * @param options Read-only mode and replication status source.
+ */
+CommandProcessor::CommandProcessor(Store& target_store, bool record_history, SessionOptions options)
+    : store(target_store), historyEnabled(record_history), sessionOptions(std::move(options)) {}
+
+/**
+ * @brief Execute a single command line and append its response to reply.
+ * @param input_line Raw command line.
+ * @param reply Output buffer for the response.
+ * @return Status Exit if the session should end, Continue otherwise.
+ */
+CommandProcessor::Status CommandProcessor::execute(std::string_view input_line, std::string& reply) {
+    // Trim whitespace from user input
+    std::string_view trimmed_input_line = TrimWhitespaceView(input_line);
+
+    // Save command in history if not empty
+    if (historyEnabled && !trimmed_input_line.empty()) {
+        commandHistory.emplace_back(trimmed_input_line);
+        if (commandHistory.size() > kMaximumHistorySize) {
+            commandHistory.pop_front();
+        }
+    }
+
+    // Split input into command keyword and arguments without copying
+    std::string_view remaining_input = trimmed_input_line;
+    std::string_view command_keyword = NextToken(remaining_input);
+
+    if (sessionOptions.readOnly && IsWriteCommand(command_keyword)) {
+        reply += "{ \"success\": false, \"error\": \"Read-only replica\" }\n";
+        return Status::Continue;
+    }
+
+    // ===========================
+    // Command: PUT
+    // ===========================
+    if (command_keyword == "PUT") {
+        std::string_view key_argument = NextToken(remaining_input);
+        std::string_view value_argument = NextToken(remaining_input);
+
+        if (key_argument.empty() || value_argument.empty()) {
+            reply += "{ \"success\": false, \"error\": \"PUT requires key and value\" }\n";
+            return Status::Continue;
+        }
+
+        if (store.put(key_argument, value_argument)) {
+            reply += "{ \"success\": true }\n";
+        } else {
+            reply += "{ \"success\": false, \"error\": \"Value too large\" }\n";
+        }
+    }
+    // ===========================
+    // Command: GET
+    // ===========================
+    else if (command_keyword == "GET") {
+        std::string_view key_argument = NextToken(remaining_input);
+
+        if (key_argument.empty()) {
+            reply += "{ \"success\": false, \"error\": \"GET requires key\" }\n";
+            return Status::Continue;
+        }
+
+        ValueHandle retrieved_value = store.get(key_argument);
+        if (retrieved_value) {
+            reply += "{ \"success\": true, \"value\": \"";
+            reply += retrieved_value.view();
+            reply += "\" }\n";
+        } else {
+            reply += "{ \"success\": false, \"error\": \"Key not found\" }\n";
+        }
+    }
+    // ===========================
+    // Command: DEL
+    // ===========================
+    else if (command_keyword == "DEL") {
+        std::string_view key_argument = NextToken(remaining_input);
+
+        if (key_argument.empty()) {
+            reply += "{ \"success\": false, \"error\": \"DEL requires key\" }\n";
+            return Status::Continue;
+        }
+
+        if (store.del(key_argument)) {
+            reply += "{ \"success\": true }\n";
+        } else {
+            reply += "{ \"success\": false, \"error\": \"Key not found\" }\n";
+        }
+    }
+    // ===========================
+    // Command: EXPIRE
+    // ===========================
+    else if (command_keyword == "EXPIRE") {
+        std::string_view key_argument = NextToken(remaining_input);
+        std::string_view seconds_argument = NextToken(remaining_input);
+        int64_t ttl_seconds = 0;
+        auto conversion = std::from_chars(seconds_argument.data(), seconds_argument.data() + seconds_argument.size(),
+                                          ttl_seconds);
+
+        if (key_argument.empty() || seconds_argument.empty() || conversion.ec != std::errc() ||
+            conversion.ptr != seconds_argument.data() + seconds_argument.size() ||
+            ttl_seconds > INT64_MAX / 1000 || ttl_seconds < INT64_MIN / 1000) {
+            reply += "{ \"success\": false, \"error\": \"EXPIRE requires key and seconds\" }\n";
+            return Status::Continue;
+        }
+
+        if (store.expire(key_argument, std::chrono::seconds(ttl_seconds))) {
+            reply += "{ \"success\": true }\n";
+        } else {
+            reply += "{ \"success\": false, \"error\": \"Key not found\" }\n";
+        }
+    }
+    // ===========================
+    // Command: TTL
+    // ===========================
+    else if (command_keyword == "TTL") {
+        std::string_view key_argument = NextToken(remaining_input);
+
+        if (key_argument.empty()) {
+            reply += "{ \"success\": false, \"error\": \"TTL requires key\" }\n";
+            return Status::Continue;
+        }
+
+        int64_t remaining_millis = store.ttl(key_argument);
+        if (remaining_millis == Store::kTtlMissing) {
+            reply += "{ \"success\": false, \"error\": \"Key not found\" }\n";
+        } else {
+            // Whole seconds, rounded up; -1 means the key never expires
+            int64_t remaining_seconds = remaining_millis < 0 ? remaining_millis : (remaining_millis + 999) / 1000;
+            reply += "{ \"success\": true, \"ttl\": ";
+            reply += std::to_string(remaining_seconds);
+            reply += " }\n";
+        }
+    }
+    // ===========================
+    // Command: LIST
+    // ===========================
+    else if (command_keyword == "LIST") {
+        std::ostringstream listing_stream;
+        store.list(listing_stream);
+        reply += listing_stream.str();
+    }
+    // ===========================
+    // Command: INCR
+    // ===========================
+    else if (command_keyword == "INCR") {
+        std::string_view key_argument = NextToken(remaining_input);
+        std::string_view delta_argument = NextToken(remaining_input);
+        int64_t delta = 1;
+
+        if (key_argument.empty() || (!delta_argument.empty() && !ParseSigned(delta_argument, delta))) {
+            reply += "{ \"success\": false, \"error\": \"INCR requires key [delta]\" }\n";
+            return Status::Continue;
+        }
+
+        int64_t new_value = 0;
+        if (store.incrBy(key_argument, delta, new_value)) {
+            reply += "{ \"success\": true, \"value\": " + std::to_string(new_value) + " }\n";
+        } else {
+            reply += "{ \"success\": false, \"error\": \"Value is not an integer or would overflow\" }\n";
+        }
+    }
+    // ===========================
+    // Command: APPEND
+    // ===========================
+    else if (command_keyword == "APPEND") {
+        std::string_view key_argument = NextToken(remaining_input);
+        std::string_view suffix_argument = NextToken(remaining_input);
+
+        if (key_argument.empty() || suffix_argument.empty()) {
+            reply += "{ \"success\": false, \"error\": \"APPEND requires key and value\" }\n";
+            return Status::Continue;
+        }
+
+        size_t new_length = 0;
+        if (store.append(key_argument, suffix_argument, new_length)) {
+            reply += "{ \"success\": true, \"length\": " + std::to_string(new_length) + " }\n";
+        } else {
+            reply += "{ \"success\": false, \"error\": \"Value too large\" }\n";
+        }
+    }
+    // ===========================
+    // Command: CAS
+    // ===========================
+    else if (command_keyword == "CAS") {
+        std::string_view key_argument = NextToken(remaining_input);
+        std::string_view expected_argument = NextToken(remaining_input);
+        std::string_view desired_argument = NextToken(remaining_input);
+
+        if (key_argument.empty() || expected_argument.empty() || desired_argument.empty()) {
+            reply += "{ \"success\": false, \"error\": \"CAS requires key, expected value, and new value\" }\n";
+            return Status::Continue;
+        }
+
+        bool swapped = store.compareAndSet(key_argument, expected_argument, desired_argument);
+        reply += "{ \"success\": true, \"swapped\": ";
+        reply += swapped ? "true" : "false";
+        reply += " }\n";
+    }
+    // ===========================
+    // Command: SCAN
+    // ===========================
+    else if (command_keyword == "SCAN") {
+        uint64_t cursor = 0;
+        uint64_t count = Store::kDefaultScanCount;
+        std::string_view prefix;
+        bool valid = ParseUnsigned(NextToken(remaining_input), cursor);
+        for (std::string_view option = NextToken(remaining_input); valid && !option.empty();
+             option = NextToken(remaining_input)) {
+            if (option == "COUNT") {
+                valid = ParseUnsigned(NextToken(remaining_input), count) && count > 0;
+            } else if (option == "PREFIX") {
+                prefix = NextToken(remaining_input);
+                valid = !prefix.empty();
+            } else {
+                valid = false;
+            }
+        }
+        if (!valid) {
+            reply += "{ \"success\": false, \"error\": \"SCAN requires cursor [COUNT n] [PREFIX p]\" }\n";
+            return Status::Continue;
+        }
+
+        ScanResult scan_result = store.scan(cursor, count, prefix);
+        reply += "{ \"success\": true, \"cursor\": " + std::to_string(scan_result.cursor) + ", \"keys\": [";
+        for (size_t key_index = 0; key_index < scan_result.keys.size(); ++key_index) {
+            reply += key_index == 0 ? " \"" : ", \"";
+            reply += scan_result.keys[key_index];
+            reply += "\"";
+        }
+        reply += " ] }\n";
+    }
+    // ===========================
+    // Command: CLEAR
+    // ===========================
+    else if (command_keyword == "CLEAR") {
+        std::string_view mode_argument = NextToken(remaining_input);
+        if (!mode_argument.empty() && mode_argument != "ASYNC") {
+            reply += "{ \"success\": false, \"error\": \"CLEAR takes no argument but ASYNC\" }\n";
+        } else {
+            // ASYNC replies once the keys are gone; the memory is freed in the background
+            store.clear();
+            if (mode_argument.empty()) {
+                store.waitForReclamation();
+            }
+            reply += "{ \"success\": true }\n";
+        }
+    }
+    // ===========================
+    // Command: RESHARD
+    // ===========================
+    else if (command_keyword == "RESHARD") {
+        std::string_view count_argument = NextToken(remaining_input);
+
+        // Without a count, report the progress of the current or last reshard
+        if (count_argument.empty()) {
+            ReshardProgress progress = store.reshardProgress();
+            reply += "{ \"success\": true, \"active\": ";
+            reply += progress.active ? "true" : "false";
+            reply += ", \"from\": " + std::to_string(progress.sourceShardCount);
+            reply += ", \"to\": " + std::to_string(progress.targetShardCount);
+            reply += ", \"scanned\": " + std::to_string(progress.shardsScanned);
+            reply += ", \"total\": " + std::to_string(progress.shardsToScan);
+            reply += ", \"moved\": " + std::to_string(progress.keysMoved);
+            reply += " }\n";
+            return Status::Continue;
+        }
+
+        size_t shard_count = 0;
+        auto conversion = std::from_chars(count_argument.data(), count_argument.data() + count_argument.size(),
+                                          shard_count);
+        if (conversion.ec != std::errc() || conversion.ptr != count_argument.data() + count_argument.size() ||
+            !store.reshard(shard_count)) {
+            reply += "{ \"success\": false, \"error\": \"Invalid shard count or reshard in progress\" }\n";
+            return Status::Continue;
+        }
+
+        // Other sessions keep running while this one drives the migration to the end
+        while (store.migrateSome()) {
+        }
+        reply += "{ \"success\": true, \"shards\": " + std::to_string(shard_count);
+        reply += ", \"moved\": " + std::to_string(store.reshardProgress().keysMoved) + " }\n";
+    }
+    // ===========================
+    // Command: STATS
+    // ===========================
+    else if (command_keyword == "STATS") {
+        StoreStats stats = store.stats();
+        char hit_ratio[32];
+        std::snprintf(hit_ratio, sizeof(hit_ratio), "%.4f", stats.hitRatio());
+
+        reply += "{ \"success\": true, \"gets\": " + std::to_string(stats.gets);
+        reply += ", \"hits\": " + std::to_string(stats.hits);
+        reply += ", \"misses\": " + std::to_string(stats.misses);
+        reply += ", \"hitRatio\": ";
+        reply += hit_ratio;
+        reply += ", \"puts\": " + std::to_string(stats.puts);
+        reply += ", \"deletes\": " + std::to_string(stats.deletes);
+        reply += ", \"evictions\": " + std::to_string(stats.evictions);
+        reply += ", \"expirations\": " + std::to_string(stats.expirations);
+        reply += ", \"keys\": " + std::to_string(stats.keys);
+        reply += ", \"bytes\": " + std::to_string(stats.bytes);
+        reply += ", \"lockContentions\": " + std::to_string(stats.lockContentions);
+        reply += ", \"lockWaitMicros\": " + std::to_string(stats.lockWaitNanos / 1000);
+        reply += ", \"slab\": " + SlabJson(stats.slab);
+        reply += ", \"compression\": " + CompressionJson(stats.compression);
+        reply += ", \"nearCacheHits\": " + std::to_string(stats.nearCacheHits);
+        reply += ", \"nearCacheFills\": " + std::to_string(stats.nearCacheFills);
+        reply += ", \"hotKeys\": " + HotKeysJson(stats.hotKeys);
+        reply += ", \"shards\": [";
+        for (size_t shard_index = 0; shard_index < stats.shards.size(); ++shard_index) {
+            const ShardStats& shard = stats.shards[shard_index];
+            reply += shard_index == 0 ? " " : ", ";
+            reply += "{ \"keys\": " + std::to_string(shard.keys);
+            reply += ", \"bytes\": " + std::to_string(shard.bytes);
+            reply += ", \"evictions\": " + std::to_string(shard.evictions);
+            reply += ", \"expirations\": " + std::to_string(shard.expirations);
+            reply += ", \"lockContentions\": " + std::to_string(shard.lockContentions);
+            reply += ", \"lockWaitMicros\": " + std::to_string(shard.lockWaitNanos / 1000);
+            reply += ", \"slab\": " + SlabJson(shard.slab);
+            reply += ", \"hotKeys\": " + HotKeysJson(shard.hotKeys) + " }";
+        }
+        reply += " ] }\n";
+    }
+    // ===========================
+    // Command: LATENCY
+    // ===========================
+    else if (command_keyword == "LATENCY") {
+        std::string_view subcommand = NextToken(remaining_input);
+        if (subcommand == "RESET") {
+            store.resetLatency();
+            reply += "{ \"success\": true }\n";
+            return Status::Continue;
+        }
+        if (!subcommand.empty()) {
+            reply += "{ \"success\": false, \"error\": \"Usage: LATENCY [RESET]\" }\n";
+            return Status::Continue;
+        }
+
+        reply += "{ \"success\": true, \"enabled\": ";
+        reply += kLatencyTracking ? "true" : "false";
+        reply += ", \"unit\": \"us\"";
+        for (const LatencySummary& summary : store.latency()) {
+            reply += ", \"";
+            reply += LatencyOpName(summary.op);
+            reply += "\": { \"count\": " + std::to_string(summary.count);
+            reply += ", \"mean\": ";
+            AppendMicros(reply, summary.meanNanos);
+            reply += ", \"p50\": ";
+            AppendMicros(reply, summary.p50Nanos);
+            reply += ", \"p90\": ";
+            AppendMicros(reply, summary.p90Nanos);
+            reply += ", \"p99\": ";
+            AppendMicros(reply, summary.p99Nanos);
+            reply += ", \"p99.9\": ";
+            AppendMicros(reply, summary.p999Nanos);
+            reply += ", \"max\": ";
+            AppendMicros(reply, summary.maxNanos);
+            reply += " }";
+        }
+        reply += " }\n";
+    }
+    // ===========================
+    // Command: REPLICATION
+    // ===========================
+    else if (command_keyword == "REPLICATION") {
+        ReplicationStatus status = sessionOptions.replicationStatus ? sessionOptions.replicationStatus()
+                                                                    : ReplicationStatus{};
+        if (status.replica) {
+            reply += "{ \"success\": true, \"role\": \"replica\", \"connected\": ";
+            reply += status.connected ? "true" : "false";
+            reply += ", \"applied\": " + std::to_string(status.appliedOffset);
+            reply += ", \"primary\": " + std::to_string(status.primaryOffset);
+            reply += ", \"lagBytes\": " + std::to_string(status.lagBytes);
+            reply += ", \"lagMillis\": " + std::to_string(status.lagMillis);
+            reply += ", \"fullSyncs\": " + std::to_string(status.fullSyncs);
+        } else {
+            reply += "{ \"success\": true, \"role\": \"primary\"";
+            reply += ", \"replicas\": " + std::to_string(status.connectedReplicas);
+            reply += ", \"offset\": " + std::to_string(status.primaryOffset);
+        }
+        reply += " }\n";
+    }
+    // ===========================
+    // Command: HELP
+    // ===========================
+    else if (command_keyword == "HELP") {
+        reply += "Commands:\n";
+        reply += "  PUT key value    - store key with value\n";
+        reply += "  GET key          - retrieve value for key\n";
+        reply += "  DEL key          - delete key\n";
+        reply += "  EXPIRE key secs  - expire key after secs seconds\n";
+        reply += "  TTL key          - seconds left before key expires (-1: never)\n";
+        reply += "  INCR key [delta] - add delta (default 1) to an integer value; a missing key counts as 0\n";
+        reply += "  APPEND key value - append to a key's value, creating it if missing\n";
+        reply += "  CAS key old new  - set key to new only if it currently holds old\n";
+        reply += "  LIST             - list all keys (most recent first)\n";
+        reply += "  SCAN cursor [COUNT n] [PREFIX p] - next page of keys; start at 0, done when 0 comes back\n";
+        reply += "  CLEAR [ASYNC]    - remove all keys; ASYNC frees their memory in the background\n";
+        reply += "  RESHARD [n]      - move to n shards live, or show reshard progress\n";
+        reply += "  STATS            - show hit ratio, evictions, occupancy, and lock waits\n";
+        reply += "  LATENCY [RESET]  - show p50/p90/p99/p99.9 latency per operation, or reset\n";
+        reply += "  REPLICATION      - show replication role, offsets, and lag\n";
+        reply += "  HISTORY          - show recent commands\n";
+        reply += "  HELP             - show this message\n";
+        reply += "  EXIT             - quit\n";
+    }
+    // ===========================
+    // Command: HISTORY
+    // ===========================
+    else if (command_keyword == "HISTORY") {
+        reply += "{ \"history\": [\n";
+        for (size_t index = 0; index < commandHistory.size(); ++index) {
+            reply += "  \"";
+            reply += commandHistory[index];
+            reply += "\"";
+            if (index + 1 < commandHistory.size()) {
+                reply += ",";
+            }
+            reply += "\n";
+        }
+        reply += "] }\n";
+    }
+    // ===========================
+    // Command: EXIT
+    // ===========================
+    else if (command_keyword == "EXIT") {
+        return Status::Exit;
+    }
+    // ===========================
+    // Unknown command
+    // ===========================
+    else if (!command_keyword.empty()) {
+        reply += "{ \"error\": \"Unknown command\" }\n";
+    }
+
+    return Status::Continue;
+}
+
+// ========================================
+// Batch mode
+// ========================================
+
+/**
+ * @brief Construct a processor for one input stream.
+ * @param target_store Store that commands operate on.
+ * @param options Read-only mode and replication status source.
+ * @param run_size Largest number of PUTs sent in one putMany.
+ */
+BatchProcessor::BatchProcessor(Store& target_store, SessionOptions options, size_t run_size)
+    : store(target_store), batchPuts(!options.readOnly), maxRunSize(std::max<size_t>(1, run_size)),
+      lineProcessor(target_store, false, std::move(options)) {}
+
+/**
+ * @brief Execute every complete line of input, gathering PUT runs for putMany.
+ * @param input Unconsumed input.
+ * @param end_of_input Whether a last line without a newline is complete.
+ * @param consumed Output parameter for the bytes executed.
+ * @param reply Output buffer for the replies.
+ * @return CommandProcessor::Status Exit if an EXIT line was executed.
+ */
+CommandProcessor::Status BatchProcessor::execute(std::string_view input, bool end_of_input, size_t& consumed,
+                                                 std::string& reply) {
+    consumed = 0;
+    while (consumed < input.size()) {
+        const char* line_begin = input.data() + consumed;
+        size_t remaining_length = input.size() - consumed;
+        const char* line_end = static_cast<const char*>(std::memchr(line_begin, '\n', remaining_length));
+        if (line_end == nullptr && !end_of_input) {
+            break; // Incomplete line; the caller passes it again with more input
+        }
+
+        size_t line_length = line_end != nullptr ? static_cast<size_t>(line_end - line_begin) : remaining_length;
+        std::string_view input_line(line_begin, line_length);
+        consumed += line_end != nullptr ? line_length + 1 : line_length;
+
+        // Fast path: a well-formed PUT joins the pending run, parsed like CommandProcessor does
+        std::string_view remaining_input = TrimWhitespaceView(input_line);
+        if (batchPuts && NextToken(remaining_input) == "PUT") {
+            std::string_view key_argument = NextToken(remaining_input);
+            std::string_view value_argument = NextToken(remaining_input);
+            if (!key_argument.empty() && !value_argument.empty()) {
+                if (runLength == putRun.size()) {
+                    putRun.emplace_back();
+                }
+                putRun[runLength].first.assign(key_argument);
+                putRun[runLength].second.assign(value_argument);
+                if (++runLength == maxRunSize) {
+                    flushPuts(reply);
+                }
+                continue;
+            }
+        }
+
+        flushPuts(reply);
+        if (lineProcessor.execute(input_line, reply) == CommandProcessor::Status::Exit) {
+            return CommandProcessor::Status::Exit;
+        }
+    }
+
+    // Pending pairs are copies, but flushing keeps replies in step with the input consumed
+    flushPuts(reply);
+    return CommandProcessor::Status::Continue;
+}
+
+void BatchProcessor::flushPuts(std::string& reply) {
+    if (runLength == 0) {
+        return;
+    }
+    // Only a short final run shrinks the vector; full runs reuse every string's capacity
+    putRun.resize(runLength);
+    size_t stored_count = store.putMany(putRun);
+    size_t rejected_count = runLength - stored_count;
+    runLength = 0;
+
+    if (rejected_count == 0) {
+        reply += "{ \"success\": true, \"stored\": " + std::to_string(stored_count) + " }\n";
+    } else {
+        reply += "{ \"success\": false, \"stored\": " + std::to_string(stored_count) +
+                 ", \"rejected\": " + std::to_string(rejected_count) + ", \"error\": \"Value too large\" }\n";
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "replication.h"
+#include "store.h"
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Executes line-protocol commands against a Store.
+ *
+ * Shared by the interactive CLI and the network text mode so both speak the
+ * same protocol:
+ *  - PUT key value    : Insert or update a key-value pair
+ *  - GET key          : Retrieve the value for a key
+ *  - DEL key          : Delete a key
+ *  - INCR key [delta] : Add to an integer value atomically
+ *  - APPEND key value : Append to a value atomically
+ *  - CAS key old new  : Replace a value only if it still holds old
+ *  - LIST             : Display all keys and values
+ *  - CLEAR [ASYNC]    : Remove all keys; ASYNC frees their memory in the background
+ *  - RESHARD [n]      : Move to n shards while serving, or report progress
+ *  - STATS            : Show operation counters, occupancy, and lock waits
+ *  - LATENCY [RESET]  : Show latency percentiles per operation, or reset them
+ *  - REPLICATION      : Show the node's replication role, offsets, and lag
+ *  - HELP             : Show available commands
+ *  - HISTORY          : Show recent commands
+ *  - EXIT             : End the session
+ *
+ * A read-only session (a replica) rejects PUT, DEL, EXPIRE, INCR, APPEND, CAS, and CLEAR.
+ * One processor represents one session (a CLI or a connection). It is not
+ * thread-safe, but any number of processors may share the same Store.
+ */
+class CommandProcessor {
+public:
+    /**
+     * @brief Outcome of executing a command line.
+     */
+    enum class Status {
+        Continue, ///< Session stays open
+        Exit      ///< EXIT was received; the caller should end the session
+    };
+
+    /**
+     * @brief Construct a processor for one session.
+     * @param targetStore Store that commands operate on.
+     * @param recordHistory Whether to remember commands for HISTORY.
+     * @param options Read-only mode and replication status source.
+     */
+    explicit CommandProcessor(Store& targetStore, bool recordHistory = true, SessionOptions options = {});
+
+    /**
+     * @brief Execute a single command line.
+     * @param inputLine Raw line without the trailing newline.
+     * @param reply Output buffer; the response text is appended to it.
+     * @return Status Whether the session should continue.
+     */
+    Status execute(std::string_view inputLine, std::string& reply);
+
+private:
+    Store& store;                           ///< Store shared by all sessions
+    bool historyEnabled = true;             ///< Whether commands are recorded
+    SessionOptions sessionOptions;          ///< Read-only mode and replication status
+    std::deque<std::string> commandHistory; ///< Most recent commands, oldest first
+
+    static constexpr size_t kMaximumHistorySize = 50; ///< Commands kept for HISTORY
+};
+
+/**
+ * @brief Executes a stream of line-protocol commands in bulk, for non-interactive imports.
+ *
+ * Lines are split with memchr and parsed into views of the input, without
+ * per-line copies. Runs of consecutive PUTs are gathered into putMany calls
+ * of up to runSize pairs, which a store with an executor spreads across its
+ * worker threads; each run gets one summary reply instead of one per line:
+ * { "success": true, "stored": N }, or success false with a "rejected" count
+ * if some values were too large. Every other line, including a malformed PUT,
+ * first flushes the pending run and then goes through a CommandProcessor
+ * without history, so its reply and ordering match the CLI.
+ *
+ * Not thread-safe; one processor represents one input stream.
+ */
+class BatchProcessor {
+public:
+    static constexpr size_t kDefaultRunSize = 4096; ///< Default largest PUT run per putMany
+
+    /**
+     * @brief Construct a processor for one input stream.
+     * @param targetStore Store that commands operate on.
+     * @param options Read-only mode and replication status source; a read-only session never batches.
+     * @param runSize Largest number of PUTs sent in one putMany.
+     */
+    explicit BatchProcessor(Store& targetStore, SessionOptions options = {}, size_t runSize = kDefaultRunSize);
+
+    /**
+     * @brief Execute every complete line of a block of input.
+     * @param input Bytes read so far and not yet consumed.
+     * @param endOfInput Whether input is the rest of the stream, so a last line without a newline is executed too.
+     * @param consumed Output parameter for the bytes executed; the caller passes the rest again with more input.
+     * @param reply Output buffer; replies are appended to it.
+     * @return CommandProcessor::Status Exit if an EXIT line was executed; the lines after it are not.
+     */
+    CommandProcessor::Status execute(std::string_view input, bool endOfInput, size_t& consumed, std::string& reply);
+
+private:
+    /**
+     * @brief putMany the pending PUT run and append its summary reply.
+     */
+    void flushPuts(std::string& reply);
+
+    Store& store;                      ///< Store shared by all sessions
+    bool batchPuts = true;             ///< False for a read-only session, whose PUTs must be refused
+    size_t maxRunSize;                 ///< Largest PUT run per putMany
+    CommandProcessor lineProcessor;    ///< Executes every line that is not part of a PUT run
+    size_t runLength = 0;              ///< Pairs of putRun that belong to the pending run
+    std::vector<std::pair<std::string, std::string>> putRun; ///< Pending PUTs; kept between runs to reuse capacity
+};
+
+/**
+ * @brief Trim leading and trailing whitespace from a string.
+ * @param inputString String to trim.
+ * @return std::string Trimmed string.
+ */
+std::string TrimWhitespace(const std::string& inputString);
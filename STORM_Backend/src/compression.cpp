@@ -0,0 +1,219 @@
+#include "compression.h"
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+constexpr size_t kMinMatch = 4;          ///< Shortest match the format can encode
+constexpr size_t kLastLiterals = 5;      ///< The block always ends with at least this many literals
+constexpr size_t kMatchStartLimit = 12;  ///< The last match must start at least this far before the end
+constexpr size_t kMaxOffset = 65535;     ///< Farthest back a match may point
+constexpr unsigned kHashBits = 12;       ///< log2 of the match-finder table size
+constexpr unsigned kSkipStrength = 6;    ///< Step grows by one every 2^kSkipStrength misses
+
+uint32_t Load32(const uint8_t* bytes) {
+    uint32_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+    return word;
+}
+
+uint64_t Load64(const uint8_t* bytes) {
+    uint64_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+    return word;
+}
+
+uint32_t HashSequence(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - kHashBits);
+}
+
+/**
+ * @brief Length of the common run of two positions, not reading at or beyond limit.
+ */
+size_t CommonLength(const uint8_t* first, const uint8_t* second, const uint8_t* limit) {
+    const uint8_t* start = first;
+    while (first + sizeof(uint64_t) <= limit) {
+        uint64_t difference = Load64(first) ^ Load64(second);
+        if (difference != 0) {
+            return static_cast<size_t>(first - start) + static_cast<size_t>(__builtin_ctzll(difference) / 8);
+        }
+        first += sizeof(uint64_t);
+        second += sizeof(uint64_t);
+    }
+    while (first < limit && *first == *second) {
+        ++first;
+        ++second;
+    }
+    return static_cast<size_t>(first - start);
+}
+
+/**
+ * @brief Write the 255-run extension of a length whose 4-bit token field saturated.
+ */
+void WriteLengthExtension(uint8_t*& output, size_t remainder) {
+    while (remainder >= 255) {
+        *output++ = 255;
+        remainder -= 255;
+    }
+    *output++ = static_cast<uint8_t>(remainder);
+}
+
+/**
+ * @brief Append one sequence: literals, then a match unless match_length is 0 (the final sequence).
+ * @return false If the output buffer is too small.
+ */
+bool WriteSequence(uint8_t*& output, const uint8_t* output_end, const uint8_t* literals, size_t literal_length,
+                   size_t offset, size_t match_length) {
+    // Token, both length extensions, literals, and the offset, at their largest
+    size_t worst_case = 1 + literal_length / 255 + 1 + literal_length + 2 + match_length / 255 + 1;
+    if (worst_case > static_cast<size_t>(output_end - output)) {
+        return false;
+    }
+
+    uint8_t* token = output++;
+    *token = static_cast<uint8_t>((literal_length < 15 ? literal_length : 15) << 4);
+    if (literal_length >= 15) {
+        WriteLengthExtension(output, literal_length - 15);
+    }
+    std::memcpy(output, literals, literal_length);
+    output += literal_length;
+    if (match_length == 0) {
+        return true;
+    }
+
+    *output++ = static_cast<uint8_t>(offset);
+    *output++ = static_cast<uint8_t>(offset >> 8);
+    size_t match_code = match_length - kMinMatch;
+    *token |= static_cast<uint8_t>(match_code < 15 ? match_code : 15);
+    if (match_code >= 15) {
+        WriteLengthExtension(output, match_code - 15);
+    }
+    return true;
+}
+
+/**
+ * @brief Read a 255-run length extension.
+ * @return false If the input ended inside it.
+ */
+bool ReadLengthExtension(const uint8_t*& input, const uint8_t* input_end, size_t& length) {
+    uint8_t extension = 255;
+    while (extension == 255) {
+        if (input == input_end) {
+            return false;
+        }
+        extension = *input++;
+        length += extension;
+    }
+    return true;
+}
+
+} // namespace
+
+size_t Lz4Compress(const char* input, size_t inputSize, char* output, size_t outputCapacity) {
+    const auto* source = reinterpret_cast<const uint8_t*>(input);
+    auto* destination = reinterpret_cast<uint8_t*>(output);
+    const uint8_t* destination_end = destination + outputCapacity;
+
+    size_t anchor = 0;
+    if (inputSize > kMatchStartLimit) {
+        // Positions are stored +1 so that 0 means "no candidate yet"
+        std::array<uint32_t, size_t{1} << kHashBits> last_seen{};
+        size_t match_start_limit = inputSize - kMatchStartLimit;
+        const uint8_t* match_end_limit = source + inputSize - kLastLiterals;
+
+        size_t position = 0;
+        while (position < match_start_limit) {
+            uint32_t sequence = Load32(source + position);
+            uint32_t& slot = last_seen[HashSequence(sequence)];
+            size_t candidate = slot;
+            slot = static_cast<uint32_t>(position + 1);
+            if (candidate == 0 || position + 1 - candidate > kMaxOffset || Load32(source + candidate - 1) != sequence) {
+                // Skip faster through data that keeps missing
+                position += 1 + ((position - anchor) >> kSkipStrength);
+                continue;
+            }
+            candidate -= 1;
+
+            // Extend backwards over literals that also match
+            while (position > anchor && candidate > 0 && source[position - 1] == source[candidate - 1]) {
+                --position;
+                --candidate;
+            }
+            size_t match_length = kMinMatch + CommonLength(source + position + kMinMatch,
+                                                           source + candidate + kMinMatch, match_end_limit);
+            if (!WriteSequence(destination, destination_end, source + anchor, position - anchor,
+                               position - candidate, match_length)) {
+                return 0;
+            }
+            position += match_length;
+            anchor = position;
+            if (position < match_start_limit) {
+                // Remember a position inside the match so the next sequence can refer back to it
+                last_seen[HashSequence(Load32(source + position - 2))] = static_cast<uint32_t>(position - 2 + 1);
+            }
+        }
+    }
+
+    if (!WriteSequence(destination, destination_end, source + anchor, inputSize - anchor, 0, 0)) {
+        return 0;
+    }
+    return static_cast<size_t>(destination - reinterpret_cast<uint8_t*>(output));
+}
+
+bool Lz4Decompress(const char* input, size_t inputSize, char* output, size_t outputSize) {
+    const auto* source = reinterpret_cast<const uint8_t*>(input);
+    const uint8_t* source_end = source + inputSize;
+    auto* destination = reinterpret_cast<uint8_t*>(output);
+    uint8_t* const destination_begin = destination;
+    uint8_t* const destination_end = destination + outputSize;
+
+    while (source != source_end) {
+        uint8_t token = *source++;
+
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !ReadLengthExtension(source, source_end, literal_length)) {
+            return false;
+        }
+        if (literal_length > static_cast<size_t>(source_end - source) ||
+            literal_length > static_cast<size_t>(destination_end - destination)) {
+            return false;
+        }
+        std::memcpy(destination, source, literal_length);
+        source += literal_length;
+        destination += literal_length;
+        if (source == source_end) {
+            break; // Final sequence: literals only
+        }
+
+        if (source_end - source < 2) {
+            return false;
+        }
+        size_t offset = source[0] | (static_cast<size_t>(source[1]) << 8);
+        source += 2;
+        if (offset == 0 || offset > static_cast<size_t>(destination - destination_begin)) {
+            return false;
+        }
+
+        size_t match_length = token & 15;
+        if (match_length == 15 && !ReadLengthExtension(source, source_end, match_length)) {
+            return false;
+        }
+        match_length += kMinMatch;
+        if (match_length > static_cast<size_t>(destination_end - destination)) {
+            return false;
+        }
+
+        const uint8_t* match = destination - offset;
+        if (offset >= match_length) {
+            std::memcpy(destination, match, match_length);
+            destination += match_length;
+        } else {
+            // Overlapping copy: the match repeats bytes it is still writing
+            for (size_t index = 0; index < match_length; ++index) {
+                *destination++ = match[index];
+            }
+        }
+    }
+    return destination == destination_end;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * @brief LZ4 block-format compression for large values.
+ *
+ * A self-contained greedy LZ77 compressor with a 4096-entry hash table,
+ * writing the LZ4 block format (no frame header), so its output can be read
+ * by any LZ4 decoder and vice versa. It favours speed over ratio, which
+ * suits repetitive payloads such as JSON documents: a few hundred MB/s to
+ * compress and over a GB/s to decompress on one core.
+ */
+
+/**
+ * @brief Compress a buffer in the LZ4 block format.
+ * @param input Bytes to compress.
+ * @param inputSize Number of input bytes.
+ * @param output Destination buffer.
+ * @param outputCapacity Size of the destination buffer.
+ * @return size_t Compressed length, or 0 if the result would not fit in outputCapacity.
+ *
+ * Passing a capacity smaller than inputSize doubles as a "worth it" test:
+ * data that does not shrink enough reports 0.
+ */
+size_t Lz4Compress(const char* input, size_t inputSize, char* output, size_t outputCapacity);
+
+/**
+ * @brief Decompress an LZ4 block of known decompressed length.
+ * @param input Compressed bytes.
+ * @param inputSize Number of compressed bytes.
+ * @param output Destination buffer of exactly outputSize bytes.
+ * @param outputSize Decompressed length.
+ * @return true If the block was well formed and decompressed to exactly outputSize bytes.
+ *
+ * Never reads or writes outside the given buffers, even for corrupt input.
+ */
+bool Lz4Decompress(const char* input, size_t inputSize, char* output, size_t outputSize);
@@ -0,0 +1,88 @@
+#include "eviction_policy.h"
+
+namespace {
+
+/**
+ * @brief Smallest power of two greater than or equal to value.
+ */
+size_t RoundUpToPowerOfTwo(size_t value) {
+    size_t rounded = 1;
+    while (rounded < value) {
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+// Bounds on the sketch size per shard: tiny shards still get a useful sketch,
+// and unbounded shards (no key capacity) do not reserve memory for billions of keys
+constexpr size_t kMinSketchWords = 16;
+constexpr size_t kMaxSketchWords = size_t{1} << 20;
+
+// Odd multipliers giving each row an independent view of the key hash
+constexpr uint64_t kRowSeeds[] = {0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull,
+                                  0xD6E8FEB86659FD93ull};
+
+constexpr uint64_t kCounterMask = 0xF;
+constexpr uint64_t kHalvingMask = 0x7777777777777777ull; ///< Clears the bit shifted in from the next counter
+
+} // namespace
+
+FrequencySketch::FrequencySketch(size_t expected_entries) {
+    size_t word_count = RoundUpToPowerOfTwo(std::clamp(expected_entries, kMinSketchWords, kMaxSketchWords));
+    words.assign(word_count, 0);
+    wordMask = word_count - 1;
+    sampleSize = word_count * 10;
+}
+
+void FrequencySketch::locate(uint64_t hash, size_t row, size_t& word_index, size_t& shift) const {
+    uint64_t row_hash = (hash + kRowSeeds[row]) * kRowSeeds[row];
+    row_hash ^= row_hash >> 32;
+
+    // Each word holds four counters per row: row r owns nibbles 4r .. 4r + 3
+    word_index = static_cast<size_t>(row_hash) & wordMask;
+    size_t counter_in_row = static_cast<size_t>(row_hash >> 60) & 3;
+    shift = (row * 4 + counter_in_row) * 4;
+}
+
+void FrequencySketch::increment(uint64_t hash) {
+    bool incremented = false;
+    for (size_t row = 0; row < kRowCount; ++row) {
+        size_t word_index = 0;
+        size_t shift = 0;
+        locate(hash, row, word_index, shift);
+
+        uint64_t& word = words[word_index];
+        if (((word >> shift) & kCounterMask) != kCounterMask) {
+            word += uint64_t{1} << shift;
+            incremented = true;
+        }
+    }
+
+    // Saturated keys do not count towards the sample, like in TinyLFU
+    if (incremented && ++additions >= sampleSize) {
+        age();
+    }
+}
+
+uint32_t FrequencySketch::estimate(uint64_t hash) const {
+    uint64_t frequency = kCounterMask;
+    for (size_t row = 0; row < kRowCount; ++row) {
+        size_t word_index = 0;
+        size_t shift = 0;
+        locate(hash, row, word_index, shift);
+        frequency = std::min(frequency, (words[word_index] >> shift) & kCounterMask);
+    }
+    return static_cast<uint32_t>(frequency);
+}
+
+void FrequencySketch::clear() {
+    std::fill(words.begin(), words.end(), 0);
+    additions = 0;
+}
+
+void FrequencySketch::age() {
+    for (uint64_t& word : words) {
+        word = (word >> 1) & kHalvingMask;
+    }
+    additions /= 2;
+}
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Eviction policies used by BasicStore.
+ *
+ * A policy decides how entries move through the shard table's recency
+ * segments and which entry is evicted next. Every shard owns one instance,
+ * built from the shard's key capacity, and calls it with the shard's
+ * exclusive lock held:
+ *  - onInsert(table, entry): entry was just inserted at the front of segment 0.
+ *  - onAccess(table, entry): entry was read or overwritten.
+ *  - selectVictim(table): entry to evict next, or nullptr if the table is
+ *    empty; may move entries between segments to reach its decision.
+ *  - clear(): the table was emptied.
+ *
+ * RecencyMode::Clock readers cannot call onAccess under their shared lock;
+ * they set the entry's reference bit and the store replays one onAccess when
+ * the entry is next picked as a victim.
+ */
+
+/**
+ * @brief Plain LRU: one segment, evict the least recently used entry.
+ */
+class LruPolicy {
+public:
+    explicit LruPolicy(size_t /*capacity*/) {}
+
+    template <typename Table>
+    void onInsert(Table& /*table*/, typename Table::Node* /*entry*/) {}
+
+    template <typename Table>
+    void onAccess(Table& table, typename Table::Node* entry) {
+        table.touch(entry);
+    }
+
+    template <typename Table>
+    typename Table::Node* selectVictim(Table& table) {
+        return table.leastRecent(0);
+    }
+
+    void clear() {}
+};
+
+/**
+ * @brief Segmented LRU: new entries are probationary until their first hit.
+ *
+ * Entries enter the probation segment and move to the protected segment
+ * when accessed again. The protected segment is held to 80% of the most
+ * entries the shard has held (its steady-state size once full, whether the
+ * key capacity or the byte budget is the binding limit); its least recent
+ * entries are demoted back to probation. Victims come from probation first,
+ * so a scan of keys that are never read twice only cycles through probation
+ * and leaves the protected working set alone.
+ */
+class SlruPolicy {
+public:
+    explicit SlruPolicy(size_t /*capacity*/) {}
+
+    template <typename Table>
+    void onInsert(Table& table, typename Table::Node* /*entry*/) {
+        peakSize = std::max(peakSize, table.size());
+    }
+
+    template <typename Table>
+    void onAccess(Table& table, typename Table::Node* entry) {
+        if (entry->state.segment() == kProbation) {
+            table.moveToSegment(entry, kProtected);
+            DemoteOverflow(table, kProbation, kProtected, peakSize);
+        } else {
+            table.touch(entry);
+        }
+    }
+
+    template <typename Table>
+    typename Table::Node* selectVictim(Table& table) {
+        typename Table::Node* victim = table.leastRecent(kProbation);
+        return victim != nullptr ? victim : table.leastRecent(kProtected);
+    }
+
+    void clear() { peakSize = 0; }
+
+    /**
+     * @brief Move the protected segment's least recent entries to probation
+     *        until it holds at most 80% of mainSize.
+     */
+    template <typename Table>
+    static void DemoteOverflow(Table& table, size_t probation, size_t protectedSegment, size_t mainSize) {
+        size_t protected_limit = std::max<size_t>(1, mainSize - mainSize / 5);
+        while (table.segmentSize(protectedSegment) > protected_limit) {
+            table.moveToSegment(table.leastRecent(protectedSegment), probation);
+        }
+    }
+
+private:
+    static constexpr size_t kProbation = 0;
+    static constexpr size_t kProtected = 1;
+
+    size_t peakSize = 0; ///< Most entries held since the last clear
+};
+
+/**
+ * @brief Count-min sketch of 4-bit access counters with periodic aging.
+ *
+ * Each hash bumps one counter in each of four rows and the estimate is the
+ * smallest of the four. The rows share 64-bit words: a word holds four
+ * counters per row, so an increment touches at most four words. After
+ * every ten accesses per tracked entry all counters are halved, so the
+ * sketch follows shifts in popularity instead of remembering old hot keys.
+ */
+class FrequencySketch {
+public:
+    /**
+     * @brief Size the sketch for the number of entries it should tell apart.
+     * @param expectedEntries Usually the shard's key capacity; clamped to a sane range.
+     */
+    explicit FrequencySketch(size_t expectedEntries);
+
+    /**
+     * @brief Record one access.
+     * @param hash Hash of the key.
+     */
+    void increment(uint64_t hash);
+
+    /**
+     * @brief Estimated recent accesses, 0 to 15; never less than the true count before aging.
+     * @param hash Hash of the key.
+     */
+    uint32_t estimate(uint64_t hash) const;
+
+    /**
+     * @brief Forget every count.
+     */
+    void clear();
+
+private:
+    static constexpr size_t kRowCount = 4;
+
+    std::vector<uint64_t> words; ///< Packed counters, power-of-two sized
+    size_t wordMask = 0;         ///< words.size() - 1
+    size_t sampleSize = 0;       ///< Increments between agings
+    size_t additions = 0;        ///< Increments since the last aging
+
+    /**
+     * @brief Word index and bit shift of a key's counter in one row.
+     */
+    void locate(uint64_t hash, size_t row, size_t& wordIndex, size_t& shift) const;
+
+    /**
+     * @brief Halve every counter.
+     */
+    void age();
+};
+
+/**
+ * @brief W-TinyLFU: a small LRU window in front of an SLRU main area guarded by a frequency filter.
+ *
+ * New entries land in a window of about 1% of the shard. When the window
+ * is full its least recent entry becomes a candidate for the main area and
+ * competes with the main area's next victim: whichever key the sketch has
+ * seen less often is evicted, ties going against the candidate. One-hit
+ * wonders from a scan therefore never displace frequently used keys, while
+ * the window still gives new keys a chance to build up hits. The main area
+ * is an SLRU (probation and protected segments, protected capped at 80%
+ * of the shard's peak size).
+ *
+ * The sketch counts inserts and hits and is sized per shard from its key
+ * capacity.
+ */
+class TinyLfuPolicy {
+public:
+    explicit TinyLfuPolicy(size_t capacity) : sketch(capacity) {}
+
+    template <typename Table>
+    void onInsert(Table& table, typename Table::Node* entry) {
+        sketch.increment(KeyHash(table, entry));
+        peakSize = std::max(peakSize, table.size());
+
+        // Normally only while the shard is still filling: once it is full,
+        // selectVictim has already made room in the window for this entry
+        while (table.segmentSize(kWindow) > WindowLimit(table)) {
+            table.moveToSegment(table.leastRecent(kWindow), kProbation);
+        }
+    }
+
+    template <typename Table>
+    void onAccess(Table& table, typename Table::Node* entry) {
+        sketch.increment(KeyHash(table, entry));
+
+        if (entry->state.segment() == kProbation) {
+            table.moveToSegment(entry, kProtected);
+            SlruPolicy::DemoteOverflow(table, kProbation, kProtected, peakSize - WindowLimit(table));
+        } else {
+            table.touch(entry);
+        }
+    }
+
+    template <typename Table>
+    typename Table::Node* selectVictim(Table& table) {
+        typename Table::Node* main_victim = MainVictim(table);
+
+        // A full window hands its oldest entry to the admission filter
+        size_t window_size = table.segmentSize(kWindow);
+        if (window_size == 0 || window_size < WindowLimit(table)) {
+            return main_victim != nullptr ? main_victim : table.leastRecent(kWindow);
+        }
+
+        typename Table::Node* candidate = table.leastRecent(kWindow);
+        if (main_victim == nullptr) {
+            return candidate;
+        }
+        if (sketch.estimate(KeyHash(table, candidate)) > sketch.estimate(KeyHash(table, main_victim))) {
+            table.moveToSegment(candidate, kProbation);
+            return main_victim;
+        }
+        return candidate;
+    }
+
+    void clear() {
+        sketch.clear();
+        peakSize = 0;
+    }
+
+private:
+    static constexpr size_t kWindow = 0;
+    static constexpr size_t kProbation = 1;
+    static constexpr size_t kProtected = 2;
+
+    FrequencySketch sketch; ///< Access frequencies of recently seen keys
+    size_t peakSize = 0;    ///< Most entries held since the last clear
+
+    template <typename Table>
+    static size_t WindowLimit(const Table& table) {
+        return std::max<size_t>(1, table.size() / 100);
+    }
+
+    template <typename Table>
+    static typename Table::Node* MainVictim(Table& table) {
+        typename Table::Node* victim = table.leastRecent(kProbation);
+        return victim != nullptr ? victim : table.leastRecent(kProtected);
+    }
+
+    /**
+     * @brief The seeded hash the entry was inserted with; the sketch rows remix it.
+     */
+    template <typename Table>
+    static uint64_t KeyHash(const Table& /*table*/, const typename Table::Node* entry) {
+        return Table::hashOf(*entry);
+    }
+};
@@ -0,0 +1,103 @@
+#include "hot_keys.h"
+#include <algorithm>
+
+namespace {
+
+/**
+ * @brief Odd multipliers that give each row its own counter index for the same hash.
+ */
+constexpr std::array<uint64_t, HotKeyTracker::kRowCount> kRowMultipliers = {
+    0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull, 0xD6E8FEB86659FD93ull};
+
+} // namespace
+
+/**
+ * @brief Pseudo-random rather than every n-th read, so that periodic access patterns cannot alias with the sampling.
+ */
+bool HotKeyTracker::ShouldSample() {
+    static_assert((kSampleInterval & (kSampleInterval - 1)) == 0, "kSampleInterval must be a power of two");
+    // xorshift32, seeded per thread; the seed only has to be non-zero
+    thread_local uint32_t random_state = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&random_state)) | 1u;
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return (random_state & (kSampleInterval - 1)) == 0;
+}
+
+size_t HotKeyTracker::CounterIndex(uint64_t keyHash, size_t row) {
+    return static_cast<size_t>((keyHash * kRowMultipliers[row]) >> (64 - kWidthBits));
+}
+
+uint32_t HotKeyTracker::estimate(uint64_t keyHash) const {
+    uint32_t smallest = UINT16_MAX;
+    for (size_t row = 0; row < kRowCount; ++row) {
+        smallest = std::min<uint32_t>(smallest, counters[row][CounterIndex(keyHash, row)].load(std::memory_order_relaxed));
+    }
+    return smallest;
+}
+
+/**
+ * @brief Bump the key's counters, age the sketch at the end of a window, and remember the key if hot.
+ *
+ * Halving races with concurrent increments and may lose a few of them,
+ * which only shifts estimates by a sample or two.
+ */
+void HotKeyTracker::record(std::string_view key, uint64_t keyHash) {
+    uint32_t key_estimate = UINT16_MAX;
+    for (size_t row = 0; row < kRowCount; ++row) {
+        std::atomic<uint16_t>& counter = counters[row][CounterIndex(keyHash, row)];
+        uint32_t count = counter.fetch_add(1, std::memory_order_relaxed) + 1u;
+        key_estimate = std::min(key_estimate, count);
+    }
+
+    if (windowSamples.fetch_add(1, std::memory_order_relaxed) + 1 == kWindowSamples) {
+        for (auto& row_counters : counters) {
+            for (std::atomic<uint16_t>& counter : row_counters) {
+                counter.store(counter.load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+            }
+        }
+        windowSamples.store(0, std::memory_order_relaxed);
+    }
+
+    if (key_estimate < kHotSamples) {
+        return;
+    }
+    // Readers of a hot key all come through here; whoever finds the lock taken skips the bookkeeping
+    std::unique_lock<std::mutex> tracked_lock_guard(trackedLock, std::try_to_lock);
+    if (!tracked_lock_guard.owns_lock()) {
+        return;
+    }
+    auto coldest = tracked.end();
+    uint32_t coldest_estimate = key_estimate;
+    for (auto tracked_iterator = tracked.begin(); tracked_iterator != tracked.end(); ++tracked_iterator) {
+        if (tracked_iterator->hash == keyHash && tracked_iterator->key == key) {
+            return;
+        }
+        uint32_t tracked_estimate = estimate(tracked_iterator->hash);
+        if (tracked_estimate < coldest_estimate) {
+            coldest = tracked_iterator;
+            coldest_estimate = tracked_estimate;
+        }
+    }
+    if (tracked.size() < kTrackedKeys) {
+        tracked.push_back(Tracked{std::string(key), keyHash});
+    } else if (coldest != tracked.end()) {
+        *coldest = Tracked{std::string(key), keyHash};
+    }
+}
+
+std::vector<HotKey> HotKeyTracker::hotKeys() const {
+    std::vector<HotKey> hot_keys;
+    {
+        std::lock_guard<std::mutex> tracked_lock_guard(trackedLock);
+        for (const Tracked& tracked_key : tracked) {
+            uint32_t key_estimate = estimate(tracked_key.hash);
+            if (key_estimate >= kHotSamples) {
+                hot_keys.push_back(HotKey{tracked_key.key, uint64_t{key_estimate} * kSampleInterval});
+            }
+        }
+    }
+    std::sort(hot_keys.begin(), hot_keys.end(),
+              [](const HotKey& left, const HotKey& right) { return left.reads > right.reads; });
+    return hot_keys;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief A key read often enough to count as hot, as reported in ShardStats.
+ */
+struct HotKey {
+    std::string key;    ///< The key
+    uint64_t reads = 0; ///< Estimated reads in the tracker's current window
+};
+
+/**
+ * @brief Per-shard detector of hot keys, fed by a sample of the shard's reads.
+ *
+ * Each thread samples one get in kSampleInterval at random and counts it in a
+ * count-min sketch of kRowCount rows of relaxed atomic counters, so
+ * recording never takes a lock and runs before the shard lock is acquired
+ * (or instead of it, for near-cache hits). Every kWindowSamples samples the
+ * counters are halved, so estimates follow the current load rather than
+ * the store's history. A key whose estimate reaches kHotSamples, about one
+ * read in 128 of the shard's recent traffic, is hot; the kTrackedKeys
+ * hottest are remembered for stats.
+ */
+class HotKeyTracker {
+public:
+    static constexpr size_t kSampleInterval = 16;    ///< Reads per sampled read, on average; a power of two
+    static constexpr size_t kRowCount = 4;           ///< Independent counter rows; the estimate is their minimum
+    static constexpr size_t kWidthBits = 10;         ///< log2 of the counters per row
+    static constexpr uint32_t kWindowSamples = 4096; ///< Samples between halvings
+    static constexpr uint32_t kHotSamples = 32;      ///< Estimate at which a key is hot
+    static constexpr size_t kTrackedKeys = 8;        ///< Hot keys remembered for stats
+
+    /**
+     * @brief Whether the calling thread should sample its current read; true for one call in kSampleInterval.
+     */
+    static bool ShouldSample();
+
+    /**
+     * @brief Count one sampled read of a key.
+     * @param key Key read.
+     * @param keyHash Key hash from the store's keyHash.
+     */
+    void record(std::string_view key, uint64_t keyHash);
+
+    /**
+     * @brief Whether a key's estimate has reached kHotSamples.
+     */
+    bool isHot(uint64_t keyHash) const { return estimate(keyHash) >= kHotSamples; }
+
+    /**
+     * @brief The remembered keys that are still hot, hottest first.
+     *
+     * Reads are the sampled estimate scaled by kSampleInterval.
+     */
+    std::vector<HotKey> hotKeys() const;
+
+private:
+    static constexpr size_t kWidth = size_t{1} << kWidthBits;
+
+    /**
+     * @brief A remembered hot key.
+     */
+    struct Tracked {
+        std::string key;
+        uint64_t hash = 0;
+    };
+
+    /// Sampled reads per counter; at most twice kWindowSamples between halvings, so 16 bits suffice
+    std::array<std::array<std::atomic<uint16_t>, kWidth>, kRowCount> counters{};
+    std::atomic<uint32_t> windowSamples{0}; ///< Samples since the last halving
+    mutable std::mutex trackedLock;         ///< Guards tracked; only ever try-locked by record
+    std::vector<Tracked> tracked;           ///< Up to kTrackedKeys keys seen hot
+
+    uint32_t estimate(uint64_t keyHash) const;
+    static size_t CounterIndex(uint64_t keyHash, size_t row);
+};
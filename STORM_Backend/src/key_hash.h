@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+/**
+ * @brief Seeded 64-bit key hash in the style of wyhash.
+ *
+ * Keys are consumed 16 or 48 bytes at a time and folded with 64x64->128-bit
+ * multiplies; keys of up to 16 bytes take a branch-light path of at most four
+ * loads. The seed is mixed in before any key byte, so without it an attacker
+ * cannot precompute keys that collide in a shard's index. Every store picks
+ * its own random seed unless one is supplied.
+ */
+
+namespace key_hash_detail {
+
+constexpr uint64_t kSecret0 = 0xa0761d6478bd642full;
+constexpr uint64_t kSecret1 = 0xe7037ed1a0b428dbull;
+constexpr uint64_t kSecret2 = 0x8ebc6af09c88c6e3ull;
+constexpr uint64_t kSecret3 = 0x589965cc75374cc3ull;
+
+/**
+ * @brief Fold the 128-bit product of two words into 64 bits.
+ */
+inline uint64_t Mix(uint64_t left, uint64_t right) {
+    __uint128_t product = static_cast<__uint128_t>(left) * right;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+}
+
+inline uint64_t Read64(const unsigned char* bytes) {
+    uint64_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+inline uint64_t Read32(const unsigned char* bytes) {
+    uint32_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+} // namespace key_hash_detail
+
+/**
+ * @brief Hash a key with a seed.
+ * @param key Key bytes.
+ * @param seed Per-store seed.
+ * @return uint64_t Hash whose high and low halves are both well mixed.
+ */
+inline uint64_t HashKey(std::string_view key, uint64_t seed) {
+    using namespace key_hash_detail;
+
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(key.data());
+    size_t length = key.size();
+    seed ^= Mix(seed ^ kSecret0, kSecret1);
+
+    uint64_t first = 0;
+    uint64_t second = 0;
+    if (length <= 16) {
+        if (length >= 4) {
+            // Two overlapping 4-byte reads from each end cover 4 to 16 bytes
+            size_t inner_offset = (length >> 3) << 2;
+            first = (Read32(bytes) << 32) | Read32(bytes + inner_offset);
+            second = (Read32(bytes + length - 4) << 32) | Read32(bytes + length - 4 - inner_offset);
+        } else if (length > 0) {
+            first = (uint64_t{bytes[0]} << 16) | (uint64_t{bytes[length >> 1]} << 8) | bytes[length - 1];
+        }
+    } else {
+        size_t remaining = length;
+        if (remaining > 48) {
+            // Three independent lanes keep the multipliers busy on long keys
+            uint64_t lane1 = seed;
+            uint64_t lane2 = seed;
+            do {
+                seed = Mix(Read64(bytes) ^ kSecret1, Read64(bytes + 8) ^ seed);
+                lane1 = Mix(Read64(bytes + 16) ^ kSecret2, Read64(bytes + 24) ^ lane1);
+                lane2 = Mix(Read64(bytes + 32) ^ kSecret3, Read64(bytes + 40) ^ lane2);
+                bytes += 48;
+                remaining -= 48;
+            } while (remaining > 48);
+            seed ^= lane1 ^ lane2;
+        }
+        while (remaining > 16) {
+            seed = Mix(Read64(bytes) ^ kSecret1, Read64(bytes + 8) ^ seed);
+            bytes += 16;
+            remaining -= 16;
+        }
+        // The last 16 bytes of the key, overlapping what was already consumed
+        first = Read64(bytes + remaining - 16);
+        second = Read64(bytes + remaining - 8);
+    }
+
+    __uint128_t product = static_cast<__uint128_t>(first ^ kSecret1) * (second ^ seed);
+    return Mix(static_cast<uint64_t>(product) ^ kSecret0 ^ length, static_cast<uint64_t>(product >> 64) ^ kSecret1);
+}
@@ -0,0 +1,176 @@
+#include "latency_histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <utility>
+
+// ========================================
+// Buckets
+// ========================================
+
+const char* LatencyOpName(LatencyOp op) {
+    switch (op) {
+        case LatencyOp::Get: return "get";
+        case LatencyOp::Put: return "put";
+        case LatencyOp::Del: return "del";
+        case LatencyOp::GetMany: return "get_many";
+        case LatencyOp::PutMany: return "put_many";
+        case LatencyOp::DelMany: return "del_many";
+        case LatencyOp::LockAcquire: return "lock";
+        case LatencyOp::Count: break;
+    }
+    return "unknown";
+}
+
+size_t LatencyHistogram::BucketIndex(uint64_t nanos) {
+    if (nanos < kSubBucketCount) {
+        return static_cast<size_t>(nanos);
+    }
+    unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(nanos));
+    if (exponent > kMaxExponent) {
+        return kBucketCount - 1;
+    }
+    // The top kSubBucketBits + 1 bits: the leading one and the sub-bucket
+    uint64_t mantissa = nanos >> (exponent - kSubBucketBits);
+    return (exponent - kSubBucketBits) * kSubBucketCount + static_cast<size_t>(mantissa);
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(size_t index) {
+    if (index < kSubBucketCount) {
+        return index;
+    }
+    unsigned shift = static_cast<unsigned>(index / kSubBucketCount) - 1;
+    uint64_t mantissa = index % kSubBucketCount + kSubBucketCount;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+uint64_t LatencyHistogram::count() const {
+    uint64_t total = 0;
+    for (uint64_t bucket_count : buckets) {
+        total += bucket_count;
+    }
+    return total;
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const {
+    uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(total))));
+    uint64_t seen = 0;
+    for (size_t index = 0; index < kBucketCount; ++index) {
+        seen += buckets[index];
+        if (seen >= rank) {
+            return std::min(BucketUpperBound(index), max);
+        }
+    }
+    return max;
+}
+
+// ========================================
+// Recording and merging
+// ========================================
+
+LatencyRecorder::~LatencyRecorder() {
+    for (std::atomic<Stripe*>& stripe : stripes) {
+        delete stripe.load(std::memory_order_relaxed);
+    }
+}
+
+LatencyRecorder::Stripe& LatencyRecorder::localStripe() {
+    std::atomic<Stripe*>& slot = stripes[ThreadStripe() % kStripeCount];
+    Stripe* stripe = slot.load(std::memory_order_acquire);
+    if (stripe == nullptr) {
+        // Threads sharing a slot may race to allocate; the loser frees its copy
+        auto* fresh_stripe = new Stripe();
+        if (slot.compare_exchange_strong(stripe, fresh_stripe, std::memory_order_acq_rel)) {
+            stripe = fresh_stripe;
+        } else {
+            delete fresh_stripe;
+        }
+    }
+    return *stripe;
+}
+
+LatencyHistogram LatencyRecorder::histogram(LatencyOp op) const {
+    LatencyHistogram merged;
+    for (const std::atomic<Stripe*>& slot : stripes) {
+        const Stripe* stripe = slot.load(std::memory_order_acquire);
+        if (stripe == nullptr) {
+            continue;
+        }
+        const OpHistogram& histogram = stripe->ops[static_cast<size_t>(op)];
+        for (size_t index = 0; index < LatencyHistogram::kBucketCount; ++index) {
+            merged.buckets[index] += histogram.buckets[index].load(std::memory_order_relaxed);
+        }
+        merged.sum += histogram.sum.load(std::memory_order_relaxed);
+        merged.max = std::max(merged.max, histogram.max.load(std::memory_order_relaxed));
+    }
+    return merged;
+}
+
+std::vector<LatencySummary> LatencyRecorder::summaries() const {
+    std::vector<LatencySummary> op_summaries;
+    op_summaries.reserve(kOpCount);
+    for (size_t op_index = 0; op_index < kOpCount; ++op_index) {
+        LatencyOp op = static_cast<LatencyOp>(op_index);
+        LatencyHistogram merged = histogram(op);
+
+        LatencySummary summary;
+        summary.op = op;
+        summary.count = merged.count();
+        summary.sumNanos = merged.sum;
+        summary.meanNanos = summary.count == 0 ? 0 : merged.sum / summary.count;
+        summary.p50Nanos = merged.percentile(0.5);
+        summary.p90Nanos = merged.percentile(0.9);
+        summary.p99Nanos = merged.percentile(0.99);
+        summary.p999Nanos = merged.percentile(0.999);
+        summary.maxNanos = merged.max;
+        op_summaries.push_back(summary);
+    }
+    return op_summaries;
+}
+
+void LatencyRecorder::reset() {
+    for (std::atomic<Stripe*>& slot : stripes) {
+        Stripe* stripe = slot.load(std::memory_order_acquire);
+        if (stripe == nullptr) {
+            continue;
+        }
+        for (OpHistogram& histogram : stripe->ops) {
+            for (std::atomic<uint64_t>& bucket : histogram.buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            histogram.sum.store(0, std::memory_order_relaxed);
+            histogram.max.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+// ========================================
+// Prometheus exposition
+// ========================================
+
+void AppendPrometheusLatency(std::string& output, const std::vector<LatencySummary>& summaries) {
+    output += "# HELP storm_latency_seconds Operation latency.\n";
+    output += "# TYPE storm_latency_seconds summary\n";
+    char sample[160];
+    for (const LatencySummary& summary : summaries) {
+        const char* op_name = LatencyOpName(summary.op);
+        const std::pair<const char*, uint64_t> quantiles[] = {
+            {"0.5", summary.p50Nanos}, {"0.9", summary.p90Nanos},
+            {"0.99", summary.p99Nanos}, {"0.999", summary.p999Nanos}};
+        for (const auto& [quantile, nanos] : quantiles) {
+            std::snprintf(sample, sizeof(sample), "storm_latency_seconds{op=\"%s\",quantile=\"%s\"} %.9f\n",
+                          op_name, quantile, static_cast<double>(nanos) / 1e9);
+            output += sample;
+        }
+        std::snprintf(sample, sizeof(sample), "storm_latency_seconds_sum{op=\"%s\"} %.9f\n", op_name,
+                      static_cast<double>(summary.sumNanos) / 1e9);
+        output += sample;
+        std::snprintf(sample, sizeof(sample), "storm_latency_seconds_count{op=\"%s\"} %llu\n", op_name,
+                      static_cast<unsigned long long>(summary.count));
+        output += sample;
+    }
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include "store_stats.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Whether latency histograms are compiled in.
+ *
+ * Building with STORM_NO_LATENCY (CMake -DSTORM_LATENCY=OFF) removes every
+ * clock read and histogram update from the request path; LATENCY then
+ * reports that tracking is disabled.
+ */
+#ifdef STORM_NO_LATENCY
+inline constexpr bool kLatencyTracking = false;
+#else
+inline constexpr bool kLatencyTracking = true;
+#endif
+
+/**
+ * @brief Operations with their own latency histogram.
+ */
+enum class LatencyOp : size_t {
+    Get,         ///< get, both recency modes
+    Put,         ///< put, with or without a TTL
+    Del,         ///< del
+    GetMany,     ///< getMany, per batch
+    PutMany,     ///< putMany, per batch
+    DelMany,     ///< delMany, per batch
+    LockAcquire, ///< Every shard lock acquisition; 0 when the lock was free
+    Count
+};
+
+/**
+ * @brief Lower-case operation name used in replies and metric labels.
+ */
+const char* LatencyOpName(LatencyOp op);
+
+/**
+ * @brief A merged log-linear latency histogram in nanoseconds.
+ *
+ * Values below kSubBucketCount get one bucket each; above that, every power
+ * of two is split into kSubBucketCount equal buckets, so any recorded value
+ * is known to within 1/kSubBucketCount (about 6%), HDR-histogram style,
+ * below 2^(kMaxExponent + 1) ns (about 36 minutes). Larger values land in
+ * the last bucket.
+ */
+class LatencyHistogram {
+public:
+    static constexpr unsigned kSubBucketBits = 4;
+    static constexpr size_t kSubBucketCount = size_t{1} << kSubBucketBits;
+    static constexpr unsigned kMaxExponent = 40;
+    static constexpr size_t kBucketCount = (kMaxExponent - kSubBucketBits + 1) * kSubBucketCount + kSubBucketCount;
+
+    /**
+     * @brief Bucket a value falls into.
+     */
+    static size_t BucketIndex(uint64_t nanos);
+
+    /**
+     * @brief Largest value that falls into a bucket.
+     */
+    static uint64_t BucketUpperBound(size_t index);
+
+    std::array<uint64_t, kBucketCount> buckets{}; ///< Sample count per bucket
+    uint64_t sum = 0;                             ///< Sum of the recorded values
+    uint64_t max = 0;                             ///< Largest recorded value
+
+    /**
+     * @brief Number of recorded values.
+     */
+    uint64_t count() const;
+
+    /**
+     * @brief Smallest bucket bound that at least the given fraction of values do not exceed.
+     * @param fraction Quantile in [0, 1], e.g. 0.999 for p99.9.
+     * @return uint64_t Nanoseconds (capped at max), or 0 when nothing was recorded.
+     */
+    uint64_t percentile(double fraction) const;
+};
+
+/**
+ * @brief Percentiles of one histogram, as reported by LATENCY and /metrics.
+ */
+struct LatencySummary {
+    LatencyOp op = LatencyOp::Get;
+    uint64_t count = 0;      ///< Recorded values
+    uint64_t sumNanos = 0;   ///< Sum of the recorded values
+    uint64_t meanNanos = 0;  ///< sumNanos / count
+    uint64_t p50Nanos = 0;
+    uint64_t p90Nanos = 0;
+    uint64_t p99Nanos = 0;
+    uint64_t p999Nanos = 0;
+    uint64_t maxNanos = 0;
+};
+
+/**
+ * @brief Per-thread latency histograms for every LatencyOp, merged on read.
+ *
+ * Like OperationCounters, each thread records into its own stripe with
+ * relaxed atomics, so recording never contends; a stripe is allocated the
+ * first time a thread mapped to it records, which keeps idle stores small.
+ * Reads merge the stripes and see a consistent-enough snapshot.
+ */
+class LatencyRecorder {
+public:
+    static constexpr size_t kStripeCount = 64;
+
+    LatencyRecorder() = default;
+    ~LatencyRecorder();
+
+    LatencyRecorder(const LatencyRecorder&) = delete;
+    LatencyRecorder& operator=(const LatencyRecorder&) = delete;
+
+    /**
+     * @brief Record one operation's latency in the calling thread's stripe.
+     */
+    void record(LatencyOp op, uint64_t nanos) {
+        if constexpr (kLatencyTracking) {
+            Stripe& stripe = localStripe();
+            OpHistogram& histogram = stripe.ops[static_cast<size_t>(op)];
+            histogram.buckets[LatencyHistogram::BucketIndex(nanos)].fetch_add(1, std::memory_order_relaxed);
+            histogram.sum.fetch_add(nanos, std::memory_order_relaxed);
+            if (nanos > histogram.max.load(std::memory_order_relaxed)) {
+                histogram.max.store(nanos, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Merge one operation's histogram over every stripe.
+     */
+    LatencyHistogram histogram(LatencyOp op) const;
+
+    /**
+     * @brief Percentiles of every operation, in LatencyOp order.
+     */
+    std::vector<LatencySummary> summaries() const;
+
+    /**
+     * @brief Zero every histogram. Values recorded concurrently may survive.
+     */
+    void reset();
+
+private:
+    static constexpr size_t kOpCount = static_cast<size_t>(LatencyOp::Count);
+
+    struct OpHistogram {
+        std::array<std::atomic<uint64_t>, LatencyHistogram::kBucketCount> buckets{};
+        std::atomic<uint64_t> sum{0};
+        std::atomic<uint64_t> max{0};
+    };
+
+    struct alignas(64) Stripe {
+        std::array<OpHistogram, kOpCount> ops;
+    };
+
+    std::array<std::atomic<Stripe*>, kStripeCount> stripes{};
+
+    /**
+     * @brief The calling thread's stripe, allocating it on first use.
+     */
+    Stripe& localStripe();
+};
+
+/**
+ * @brief Times a scope and records it on destruction; compiles to nothing without tracking.
+ */
+class LatencyTimer {
+public:
+    LatencyTimer(LatencyRecorder& latencyRecorder, LatencyOp timedOp) : recorder(latencyRecorder), op(timedOp) {
+        if constexpr (kLatencyTracking) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~LatencyTimer() {
+        if constexpr (kLatencyTracking) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            recorder.record(op, static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        }
+    }
+
+    LatencyTimer(const LatencyTimer&) = delete;
+    LatencyTimer& operator=(const LatencyTimer&) = delete;
+
+private:
+    LatencyRecorder& recorder;
+    LatencyOp op;
+    std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * @brief Append latency percentiles as a Prometheus summary, in seconds.
+ * @param output Buffer to append to.
+ * @param summaries Percentiles from LatencyRecorder::summaries.
+ */
+void AppendPrometheusLatency(std::string& output, const std::vector<LatencySummary>& summaries);
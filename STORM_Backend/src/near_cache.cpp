@@ -0,0 +1,41 @@
+#include "near_cache.h"
+
+void KeyVersions::bumpAll() {
+    for (size_t stripe = 0; stripe < kStripeCount; ++stripe) {
+        versions[stripe].fetch_add(1, std::memory_order_release);
+    }
+}
+
+NearCache& NearCache::ForThread(uint64_t ownerId, size_t slotCount) {
+    thread_local NearCache near_cache;
+    if (near_cache.ownerId != ownerId || near_cache.slots.size() != slotCount) {
+        near_cache.slots.clear();
+        near_cache.slots.resize(slotCount);
+        near_cache.ownerId = ownerId;
+    }
+    return near_cache;
+}
+
+const ValueHandle* NearCache::find(std::string_view key, uint32_t keyHash, const KeyVersions& keyVersions) {
+    Slot& slot = slots[keyHash & (slots.size() - 1)];
+    if (!slot.value || slot.hash != keyHash || slot.key != key) {
+        return nullptr;
+    }
+    if (keyVersions.load(keyHash) != slot.version) {
+        slot.value.reset();
+        return nullptr;
+    }
+    if (--hitsUntilRefresh == 0) {
+        hitsUntilRefresh = kRefreshInterval;
+        return nullptr;
+    }
+    return &slot.value;
+}
+
+void NearCache::insert(std::string_view key, uint32_t keyHash, uint64_t version, ValueHandle value) {
+    Slot& slot = slots[keyHash & (slots.size() - 1)];
+    slot.key.assign(key.data(), key.size());
+    slot.hash = keyHash;
+    slot.version = version;
+    slot.value = std::move(value);
+}
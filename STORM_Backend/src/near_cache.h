@@ -0,0 +1,100 @@
+#pragma once
+
+#include "value.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Striped version counters that let near caches validate entries without a shard lock.
+ *
+ * Every change to a key (put, delete, eviction, expiry, TTL change) bumps
+ * the stripe its hash falls in while the shard is still locked, and clear
+ * bumps them all. A cached copy is current as long as its stripe still has
+ * the version read together with the value under the lock. Keys sharing a
+ * stripe only cost each other a spurious refetch.
+ */
+class KeyVersions {
+public:
+    static constexpr size_t kStripeCount = 16384; ///< Power of two; 128 KiB of counters
+
+    KeyVersions() : versions(new std::atomic<uint64_t>[kStripeCount]()) {}
+
+    /**
+     * @brief Current version of the stripe a key hash falls in.
+     */
+    uint64_t load(uint32_t keyHash) const {
+        return versions[keyHash & (kStripeCount - 1)].load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Invalidate cached copies of every key in the hash's stripe.
+     */
+    void bump(uint32_t keyHash) { versions[keyHash & (kStripeCount - 1)].fetch_add(1, std::memory_order_release); }
+
+    /**
+     * @brief Invalidate every cached copy.
+     */
+    void bumpAll();
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> versions;
+};
+
+/**
+ * @brief Small per-thread, direct-mapped cache of hot values in front of a store's get.
+ *
+ * Each thread has one, owned by the last store it read through; reading
+ * from another store empties it, so a thread alternating between stores
+ * gains nothing but stays correct. Entries are validated against
+ * KeyVersions on every hit, so a hit never returns a value older than the
+ * last completed write to its key. One hit in kRefreshInterval is reported
+ * as a miss, so the store still sees an occasional read of each cached key
+ * and keeps it recent for eviction. Cached values are kept alive by their
+ * handles until replaced, even after the store evicts or drops them.
+ */
+class NearCache {
+public:
+    static constexpr unsigned kRefreshInterval = 64; ///< Hits per thread between forced read-throughs
+
+    /**
+     * @brief The calling thread's cache, emptied and resized if it belonged to another store.
+     * @param ownerId Unique id of the store reading through the cache.
+     * @param slotCount Number of slots; a power of two.
+     */
+    static NearCache& ForThread(uint64_t ownerId, size_t slotCount);
+
+    /**
+     * @brief Find a current cached value.
+     * @param key Key to look up.
+     * @param keyHash Key hash, as given to KeyVersions.
+     * @param keyVersions The owning store's versions.
+     * @return const ValueHandle* Cached value, valid until the next call on this cache; nullptr on a miss.
+     */
+    const ValueHandle* find(std::string_view key, uint32_t keyHash, const KeyVersions& keyVersions);
+
+    /**
+     * @brief Cache a value read under the shard lock, replacing whatever shared its slot.
+     * @param version The key's KeyVersions version, read under the same lock as the value.
+     */
+    void insert(std::string_view key, uint32_t keyHash, uint64_t version, ValueHandle value);
+
+private:
+    /**
+     * @brief One cached key.
+     */
+    struct Slot {
+        std::string key;
+        uint32_t hash = 0;
+        uint64_t version = 0;
+        ValueHandle value; ///< Empty when the slot is unused
+    };
+
+    uint64_t ownerId = 0;                       ///< Store the slots belong to; 0 = none
+    std::vector<Slot> slots;                    ///< Indexed by the low hash bits
+    unsigned hitsUntilRefresh = kRefreshInterval; ///< Hits left before the next forced read-through
+};
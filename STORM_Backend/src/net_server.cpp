@@ -0,0 +1,559 @@
+#include "net_server.h"
+#include "numa_placement.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t kReadChunkSize = 64 * 1024;          ///< Minimum free space before each read()
+constexpr size_t kMaxBufferedInput = 64 * 1024 * 1024; ///< Unparsed bytes allowed per connection
+constexpr size_t kMaxBufferedOutput = 4 * 1024 * 1024; ///< Pending reply bytes before input is paused
+constexpr int kMaxEventsPerWait = 256;
+
+/**
+ * @brief Throw std::system_error for the current errno.
+ */
+[[noreturn]] void ThrowSystemError(const char* operation) {
+    throw std::system_error(errno, std::generic_category(), operation);
+}
+
+} // namespace
+
+// ========================================
+// Connection state
+// ========================================
+
+/**
+ * @brief Per-connection buffers and protocol session.
+ */
+struct NetServer::Connection {
+    /**
+     * @brief Wire protocol, chosen from the first byte a client sends.
+     */
+    enum class Protocol {
+        Unknown, ///< Nothing received yet
+        Text,    ///< CLI line protocol
+        Resp,    ///< RESP multibulk requests ('*' first byte)
+        Http     ///< One HTTP GET (the Prometheus /metrics endpoint), then close
+    };
+
+    Connection(int socketFd, Store& targetStore) : fd(socketFd), store(targetStore) {}
+
+    int fd = -1;                      ///< Non-blocking client socket
+    std::vector<char> input;          ///< Received bytes; [inputStart, inputEnd) is unparsed
+    size_t inputStart = 0;
+    size_t inputEnd = 0;
+    std::string output;               ///< Replies; bytes before outputStart are already sent
+    size_t outputStart = 0;
+    bool readable = false;            ///< Socket may have unread data (edge-triggered)
+    bool writable = true;             ///< Socket accepted the last write without EAGAIN
+    bool peerClosed = false;          ///< Client shut down its sending side
+    bool closing = false;             ///< Close once output is drained
+    Store& store;                     ///< Store the sessions operate on
+    Protocol protocol = Protocol::Unknown;
+    std::unique_ptr<CommandProcessor> textSession;  ///< Line-protocol session, once detected
+    std::unique_ptr<RespSession> respSession;       ///< RESP session, once detected
+    std::vector<std::string_view> arguments;        ///< Reused RESP argument views into input
+
+    size_t pendingOutput() const { return output.size() - outputStart; }
+};
+
+// ========================================
+// Lifecycle
+// ========================================
+
+NetServer::NetServer(Store& target_store, const NetServerConfig& server_config)
+    : store(target_store), config(server_config) {
+    if (config.loopCount == 0) {
+        config.loopCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+NetServer::~NetServer() {
+    stop();
+}
+
+/**
+ * @brief Open one SO_REUSEPORT listener per loop and start the loop threads.
+ *
+ * With pinLoopsToNumaNodes the loops are spread round-robin over the nodes
+ * the store placed shards on, so each node's shards have loops, connection
+ * buffers, and reply buffers on the same socket.
+ */
+void NetServer::start() {
+    stopping.store(false);
+    boundPort = config.port;
+
+    std::vector<int> shard_nodes;
+    if (config.pinLoopsToNumaNodes) {
+        for (size_t shard_index = 0; shard_index < store.shardCount(); ++shard_index) {
+            int shard_node = store.shardNode(shard_index);
+            if (shard_node >= 0 && std::find(shard_nodes.begin(), shard_nodes.end(), shard_node) == shard_nodes.end()) {
+                shard_nodes.push_back(shard_node);
+            }
+        }
+    }
+
+    for (size_t loop_index = 0; loop_index < config.loopCount; ++loop_index) {
+        auto loop = std::make_unique<EventLoop>();
+        loops.push_back(std::move(loop));
+        EventLoop& new_loop = *loops.back();
+        if (!shard_nodes.empty()) {
+            new_loop.numaNode = shard_nodes[loop_index % shard_nodes.size()];
+        }
+
+        // An ephemeral port is resolved by the first listener and shared by the rest
+        new_loop.listenFd = openListener(boundPort);
+        if (boundPort == 0) {
+            sockaddr_in bound_address{};
+            socklen_t address_length = sizeof(bound_address);
+            getsockname(new_loop.listenFd, reinterpret_cast<sockaddr*>(&bound_address), &address_length);
+            boundPort = ntohs(bound_address.sin_port);
+        }
+
+        new_loop.epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (new_loop.epollFd < 0) ThrowSystemError("epoll_create1");
+
+        new_loop.wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (new_loop.wakeFd < 0) ThrowSystemError("eventfd");
+
+        // The listener and wake fds are told apart from connections by their data pointer
+        epoll_event listen_event{};
+        listen_event.events = EPOLLIN | EPOLLET;
+        listen_event.data.ptr = &new_loop.listenFd;
+        if (epoll_ctl(new_loop.epollFd, EPOLL_CTL_ADD, new_loop.listenFd, &listen_event) < 0) {
+            ThrowSystemError("epoll_ctl");
+        }
+
+        epoll_event wake_event{};
+        wake_event.events = EPOLLIN;
+        wake_event.data.ptr = &new_loop.wakeFd;
+        if (epoll_ctl(new_loop.epollFd, EPOLL_CTL_ADD, new_loop.wakeFd, &wake_event) < 0) {
+            ThrowSystemError("epoll_ctl");
+        }
+    }
+
+    for (auto& loop : loops) {
+        EventLoop* loop_pointer = loop.get();
+        loop->thread = std::thread([this, loop_pointer]() { runLoop(*loop_pointer); });
+    }
+}
+
+/**
+ * @brief Wake every loop, join its thread, and release its sockets.
+ */
+void NetServer::stop() {
+    stopping.store(true);
+
+    for (auto& loop : loops) {
+        uint64_t wake_value = 1;
+        if (loop->wakeFd >= 0) {
+            ssize_t ignored = write(loop->wakeFd, &wake_value, sizeof(wake_value));
+            (void)ignored;
+        }
+    }
+
+    for (auto& loop : loops) {
+        if (loop->thread.joinable()) {
+            loop->thread.join();
+        }
+        closeLoop(*loop);
+    }
+    loops.clear();
+}
+
+int NetServer::openListener(uint16_t listen_port) {
+    int listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) ThrowSystemError("socket");
+
+    int enabled = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &enabled, sizeof(enabled));
+    if (setsockopt(listen_fd, SOL_SOCKET, SO_REUSEPORT, &enabled, sizeof(enabled)) < 0) {
+        close(listen_fd);
+        ThrowSystemError("setsockopt(SO_REUSEPORT)");
+    }
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(listen_port);
+    if (inet_pton(AF_INET, config.bindAddress.c_str(), &address.sin_addr) != 1) {
+        close(listen_fd);
+        throw std::system_error(EINVAL, std::generic_category(), "inet_pton(" + config.bindAddress + ")");
+    }
+
+    if (bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        int bind_error = errno;
+        close(listen_fd);
+        throw std::system_error(bind_error, std::generic_category(), "bind");
+    }
+    if (listen(listen_fd, SOMAXCONN) < 0) {
+        int listen_error = errno;
+        close(listen_fd);
+        throw std::system_error(listen_error, std::generic_category(), "listen");
+    }
+
+    return listen_fd;
+}
+
+void NetServer::closeLoop(EventLoop& loop) {
+    for (auto& fd_and_connection : loop.connections) {
+        close(fd_and_connection.first);
+    }
+    loop.connections.clear();
+
+    for (int* fd : {&loop.listenFd, &loop.epollFd, &loop.wakeFd}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+// ========================================
+// Event loop
+// ========================================
+
+void NetServer::runLoop(EventLoop& loop) {
+    RunOnNumaNode(loop.numaNode);
+    epoll_event events[kMaxEventsPerWait];
+
+    while (!stopping.load(std::memory_order_relaxed)) {
+        int ready_count = epoll_wait(loop.epollFd, events, kMaxEventsPerWait, -1);
+        if (ready_count < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        for (int event_index = 0; event_index < ready_count; ++event_index) {
+            const epoll_event& event = events[event_index];
+
+            if (event.data.ptr == &loop.wakeFd) {
+                continue; // stop() was called; the loop condition handles it
+            }
+            if (event.data.ptr == &loop.listenFd) {
+                acceptConnections(loop);
+                continue;
+            }
+
+            Connection& connection = *static_cast<Connection*>(event.data.ptr);
+            if (event.events & EPOLLIN) connection.readable = true;
+            if (event.events & EPOLLOUT) connection.writable = true;
+            if (event.events & (EPOLLERR | EPOLLHUP)) {
+                closeConnection(loop, connection);
+                continue;
+            }
+            serviceConnection(loop, connection);
+        }
+    }
+}
+
+void NetServer::acceptConnections(EventLoop& loop) {
+    // Edge-triggered: drain the whole accept queue
+    while (true) {
+        int client_fd = accept4(loop.listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            return; // EAGAIN, or out of descriptors until a connection closes
+        }
+
+        int enabled = 1;
+        setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled));
+
+        auto connection = std::make_unique<Connection>(client_fd, store);
+        epoll_event client_event{};
+        client_event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        client_event.data.ptr = connection.get();
+        if (epoll_ctl(loop.epollFd, EPOLL_CTL_ADD, client_fd, &client_event) < 0) {
+            close(client_fd);
+            continue;
+        }
+        loop.connections.emplace(client_fd, std::move(connection));
+    }
+}
+
+/**
+ * @brief Read, execute, and flush until the connection can make no more progress.
+ *
+ * With edge-triggered epoll there is no second notification for data that is
+ * already buffered, so this keeps going until it hits EAGAIN on both sides or
+ * output backpressure pauses request processing.
+ */
+void NetServer::serviceConnection(EventLoop& loop, Connection& connection) {
+    bool made_progress = true;
+    while (made_progress) {
+        made_progress = false;
+
+        if (connection.readable && !connection.peerClosed && !connection.closing) {
+            if (!readAvailable(connection)) {
+                closeConnection(loop, connection);
+                return;
+            }
+        }
+
+        if (!connection.closing) {
+            if (!processInput(connection)) {
+                closeConnection(loop, connection);
+                return;
+            }
+        }
+
+        if (connection.pendingOutput() > 0 && connection.writable) {
+            size_t pending_before = connection.pendingOutput();
+            if (!flushOutput(connection)) {
+                closeConnection(loop, connection);
+                return;
+            }
+            // Draining output may unblock requests paused by backpressure
+            made_progress = connection.pendingOutput() < pending_before &&
+                            connection.inputStart < connection.inputEnd;
+        }
+
+        // Reads stopped at the buffer limit rather than EAGAIN
+        if (connection.readable && !connection.peerClosed && !connection.closing &&
+            connection.inputEnd - connection.inputStart < kMaxBufferedInput) {
+            made_progress = true;
+        }
+    }
+
+    bool finished = connection.closing || connection.peerClosed;
+    if (finished && connection.pendingOutput() == 0) {
+        closeConnection(loop, connection);
+    }
+}
+
+/**
+ * @brief Read until EAGAIN, EOF, or the input buffer limit.
+ * @return false If the socket failed or the client sent an oversized request.
+ */
+bool NetServer::readAvailable(Connection& connection) {
+    while (true) {
+        size_t buffered_bytes = connection.inputEnd - connection.inputStart;
+        if (buffered_bytes >= kMaxBufferedInput) {
+            return true; // Keep readable set; resume after requests are consumed
+        }
+
+        // Compact consumed bytes to the front before growing the buffer
+        if (connection.inputStart > 0 && connection.input.size() - connection.inputEnd < kReadChunkSize) {
+            std::memmove(connection.input.data(), connection.input.data() + connection.inputStart, buffered_bytes);
+            connection.inputStart = 0;
+            connection.inputEnd = buffered_bytes;
+        }
+        if (connection.input.size() - connection.inputEnd < kReadChunkSize) {
+            connection.input.resize(connection.inputEnd + kReadChunkSize);
+        }
+
+        ssize_t read_count = read(connection.fd,
+                                  connection.input.data() + connection.inputEnd,
+                                  connection.input.size() - connection.inputEnd);
+        if (read_count > 0) {
+            connection.inputEnd += static_cast<size_t>(read_count);
+            continue;
+        }
+        if (read_count == 0) {
+            connection.peerClosed = true;
+            connection.readable = false;
+            return true;
+        }
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            connection.readable = false;
+            return true;
+        }
+        return false;
+    }
+}
+
+/**
+ * @brief Execute every complete request, pausing under output backpressure.
+ * @return false If a request is malformed or exceeds the input buffer limit.
+ *
+ * The protocol is fixed by the first byte of the connection: RESP clients
+ * always start with a multibulk array ('*'), anything else is the line protocol.
+ */
+bool NetServer::processInput(Connection& connection) {
+    if (connection.protocol == Connection::Protocol::Unknown) {
+        if (connection.inputStart == connection.inputEnd) {
+            return true;
+        }
+        if (connection.input[connection.inputStart] == '*') {
+            connection.protocol = Connection::Protocol::Resp;
+            connection.respSession = std::make_unique<RespSession>(connection.store, config.session);
+        } else {
+            // An HTTP request line is told apart from a text GET by its trailing version
+            std::string_view unparsed(connection.input.data() + connection.inputStart,
+                                      connection.inputEnd - connection.inputStart);
+            size_t line_end = unparsed.find('\n');
+            if (line_end == std::string_view::npos && unparsed.size() < kMaxBufferedInput) {
+                return true;
+            }
+            std::string_view first_line = unparsed.substr(0, line_end);
+            if (first_line.rfind("GET /", 0) == 0 && first_line.find(" HTTP/") != std::string_view::npos) {
+                connection.protocol = Connection::Protocol::Http;
+            } else {
+                connection.protocol = Connection::Protocol::Text;
+                connection.textSession = std::make_unique<CommandProcessor>(connection.store, false, config.session);
+            }
+        }
+    }
+
+    if (connection.protocol == Connection::Protocol::Http) {
+        return processHttpInput(connection);
+    }
+    bool input_valid = connection.protocol == Connection::Protocol::Resp
+        ? processRespInput(connection)
+        : processTextInput(connection);
+
+    if (connection.inputStart == connection.inputEnd) {
+        connection.inputStart = 0;
+        connection.inputEnd = 0;
+    }
+    return input_valid;
+}
+
+/**
+ * @brief Answer one HTTP GET once its headers are complete: /metrics, or 404.
+ * @return false If the headers exceed the input buffer limit.
+ *
+ * The whole request is consumed before replying, so closing the socket
+ * afterwards never resets the connection under an unread request.
+ */
+bool NetServer::processHttpInput(Connection& connection) {
+    std::string_view unparsed(connection.input.data() + connection.inputStart,
+                              connection.inputEnd - connection.inputStart);
+    size_t headers_end = unparsed.find("\r\n\r\n");
+    size_t terminator_bytes = 4;
+    if (headers_end == std::string_view::npos) {
+        headers_end = unparsed.find("\n\n");
+        terminator_bytes = 2;
+    }
+    if (headers_end == std::string_view::npos) {
+        return unparsed.size() < kMaxBufferedInput;
+    }
+
+    std::string_view path = unparsed.substr(4, unparsed.find(' ', 4) - 4);
+    std::string body;
+    const char* status_line = "HTTP/1.1 404 Not Found\r\n";
+    if (path == "/metrics") {
+        AppendPrometheusMetrics(body, store.stats());
+        AppendPrometheusLatency(body, store.latency());
+        status_line = "HTTP/1.1 200 OK\r\n";
+    }
+
+    connection.output += status_line;
+    connection.output += "Content-Type: text/plain; version=0.0.4\r\n";
+    connection.output += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    connection.output += "Connection: close\r\n\r\n";
+    connection.output += body;
+    connection.inputStart += headers_end + terminator_bytes;
+    connection.closing = true;
+    return true;
+}
+
+/**
+ * @brief Execute every complete RESP request in the input buffer.
+ * @return false If the client sent invalid RESP.
+ */
+bool NetServer::processRespInput(Connection& connection) {
+    while (connection.inputStart < connection.inputEnd && connection.pendingOutput() < kMaxBufferedOutput) {
+        size_t consumed = 0;
+        RespParseStatus parse_status = ParseRespRequest(connection.input.data() + connection.inputStart,
+                                                        connection.inputEnd - connection.inputStart,
+                                                        connection.arguments, consumed);
+        // A request that cannot fit in the input buffer would never complete
+        bool oversized = parse_status == RespParseStatus::Incomplete &&
+                         connection.inputEnd - connection.inputStart >= kMaxBufferedInput;
+        if (parse_status == RespParseStatus::Incomplete && !oversized) {
+            return true;
+        }
+        if (parse_status == RespParseStatus::Error || oversized) {
+            AppendRespError(connection.output, "ERR Protocol error");
+            connection.closing = true;
+            return true;
+        }
+
+        // Arguments view the input buffer, so execute before advancing past them
+        RespSession::Status status = connection.respSession->execute(connection.arguments, connection.output);
+        connection.inputStart += consumed;
+        if (status == RespSession::Status::Close) {
+            connection.closing = true;
+            break;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Execute every complete request line in the input buffer.
+ * @return false If a single line exceeds the input buffer limit.
+ */
+bool NetServer::processTextInput(Connection& connection) {
+    const char* buffer = connection.input.data();
+
+    while (connection.inputStart < connection.inputEnd && connection.pendingOutput() < kMaxBufferedOutput) {
+        const char* line_begin = buffer + connection.inputStart;
+        const char* line_end = static_cast<const char*>(
+            std::memchr(line_begin, '\n', connection.inputEnd - connection.inputStart));
+
+        if (line_end == nullptr) {
+            // Incomplete request; a line that can never fit is a protocol error
+            return connection.inputEnd - connection.inputStart < kMaxBufferedInput;
+        }
+
+        connection.inputStart = static_cast<size_t>(line_end - buffer) + 1;
+        if (line_end > line_begin && line_end[-1] == '\r') {
+            --line_end;
+        }
+
+        std::string_view request_line(line_begin, static_cast<size_t>(line_end - line_begin));
+        if (connection.textSession->execute(request_line, connection.output) == CommandProcessor::Status::Exit) {
+            connection.closing = true;
+            break;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Write pending replies until drained or EAGAIN.
+ * @return false If the socket failed.
+ */
+bool NetServer::flushOutput(Connection& connection) {
+    while (connection.pendingOutput() > 0) {
+        ssize_t write_count = send(connection.fd,
+                                   connection.output.data() + connection.outputStart,
+                                   connection.pendingOutput(),
+                                   MSG_NOSIGNAL);
+        if (write_count >= 0) {
+            connection.outputStart += static_cast<size_t>(write_count);
+            continue;
+        }
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            connection.writable = false;
+            break;
+        }
+        return false;
+    }
+
+    if (connection.pendingOutput() == 0) {
+        connection.output.clear();
+        connection.outputStart = 0;
+    }
+    return true;
+}
+
+void NetServer::closeConnection(EventLoop& loop, Connection& connection) {
+    int client_fd = connection.fd;
+    epoll_ctl(loop.epollFd, EPOLL_CTL_DEL, client_fd, nullptr);
+    close(client_fd);
+    loop.connections.erase(client_fd); // Destroys connection
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "command_processor.h"
+#include "resp.h"
+#include "store.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Configuration for the network front end.
+ */
+struct NetServerConfig {
+    std::string bindAddress = "0.0.0.0"; ///< IPv4 address to listen on
+    uint16_t port = 7379;                ///< TCP port; 0 picks an ephemeral port
+    size_t loopCount = 0;                ///< Event loops (threads); 0 = one per core
+    bool pinLoopsToNumaNodes = false;    ///< Run loops round-robin on the NUMA nodes holding shards
+    SessionOptions session;              ///< Given to every connection's session (read-only replicas)
+};
+
+/**
+ * @brief Edge-triggered epoll TCP server dispatching into a Store.
+ *
+ * Each event loop runs on its own thread with its own epoll instance and its
+ * own SO_REUSEPORT listening socket, so the kernel spreads new connections
+ * across loops and no state is shared between them except the Store.
+ *
+ * Connections are non-blocking and keep their own read and write buffers.
+ * Every complete request in the read buffer is executed before the replies
+ * are flushed together, so pipelined clients get one write per batch.
+ * Each connection speaks either the CLI line protocol (PUT key value, GET key,
+ * ...) or RESP, detected from the first byte it sends, so redis clients and
+ * redis-benchmark can talk to the store directly. A connection whose first
+ * line is an HTTP GET gets a single HTTP reply instead: Prometheus metrics
+ * from Store::stats for /metrics, 404 for anything else.
+ */
+class NetServer {
+public:
+    /**
+     * @brief Construct a server; no sockets are opened until start().
+     * @param targetStore Store that requests operate on.
+     * @param serverConfig Listening address, port, and loop count.
+     */
+    NetServer(Store& targetStore, const NetServerConfig& serverConfig);
+
+    /**
+     * @brief Stop the event loops and close every socket.
+     */
+    ~NetServer();
+
+    NetServer(const NetServer&) = delete;
+    NetServer& operator=(const NetServer&) = delete;
+
+    /**
+     * @brief Open the listening sockets and launch one thread per event loop.
+     * @throws std::system_error If a socket, epoll, or eventfd call fails.
+     */
+    void start();
+
+    /**
+     * @brief Ask every event loop to exit and wait for their threads.
+     */
+    void stop();
+
+    /**
+     * @brief Port the server is listening on (resolved after start()).
+     */
+    uint16_t port() const { return boundPort; }
+
+private:
+    struct Connection;
+
+    /**
+     * @brief One epoll instance, its listening socket, and its connections.
+     */
+    struct EventLoop {
+        int epollFd = -1;  ///< epoll instance
+        int listenFd = -1; ///< SO_REUSEPORT listening socket owned by this loop
+        int wakeFd = -1;   ///< eventfd used to interrupt epoll_wait on stop()
+        int numaNode = -1; ///< Node the loop thread runs on; -1 = unpinned
+        std::thread thread;
+        std::unordered_map<int, std::unique_ptr<Connection>> connections; ///< Open connections by fd
+    };
+
+    Store& store;
+    NetServerConfig config;
+    std::vector<std::unique_ptr<EventLoop>> loops;
+    std::atomic<bool> stopping{false};
+    uint16_t boundPort = 0;
+
+    int openListener(uint16_t listenPort);
+    void runLoop(EventLoop& loop);
+    void acceptConnections(EventLoop& loop);
+    void serviceConnection(EventLoop& loop, Connection& connection);
+    bool readAvailable(Connection& connection);
+    bool processInput(Connection& connection);
+    bool processRespInput(Connection& connection);
+    bool processTextInput(Connection& connection);
+    bool processHttpInput(Connection& connection);
+    bool flushOutput(Connection& connection);
+    void closeConnection(EventLoop& loop, Connection& connection);
+    void closeLoop(EventLoop& loop);
+};
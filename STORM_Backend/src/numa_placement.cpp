@@ -0,0 +1,73 @@
+#include "numa_placement.h"
+
+#ifdef STORM_HAVE_NUMA
+#include <numa.h>
+#include <numaif.h>
+#endif
+
+namespace {
+
+#ifdef STORM_HAVE_NUMA
+/**
+ * @brief Bits in a node mask as the kernel expects it for get_mempolicy.
+ */
+unsigned long NodeMaskBits() {
+    return static_cast<unsigned long>(numa_num_possible_nodes());
+}
+#endif
+
+} // namespace
+
+const std::vector<int>& NumaNodes() {
+    static const std::vector<int> nodes = [] {
+        std::vector<int> allowed_nodes;
+#ifdef STORM_HAVE_NUMA
+        if (numa_available() >= 0) {
+            for (int node = 0; node <= numa_max_node(); ++node) {
+                if (numa_bitmask_isbitset(numa_all_nodes_ptr, static_cast<unsigned int>(node))) {
+                    allowed_nodes.push_back(node);
+                }
+            }
+        }
+#endif
+        return allowed_nodes;
+    }();
+    return nodes;
+}
+
+bool RunOnNumaNode(int node) {
+#ifdef STORM_HAVE_NUMA
+    if (node >= 0 && !NumaNodes().empty()) {
+        return numa_run_on_node(node) == 0;
+    }
+#endif
+    (void)node;
+    return false;
+}
+
+NumaAllocationScope::NumaAllocationScope(int node) {
+#ifdef STORM_HAVE_NUMA
+    if (node < 0 || NumaNodes().empty()) {
+        return;
+    }
+
+    unsigned long mask_bits = NodeMaskBits();
+    savedMask.assign((mask_bits + 8 * sizeof(unsigned long) - 1) / (8 * sizeof(unsigned long)), 0);
+    if (get_mempolicy(&savedMode, savedMask.data(), mask_bits, nullptr, 0) != 0) {
+        return;
+    }
+    numa_set_preferred(node);
+    active = true;
+#else
+    (void)node;
+#endif
+}
+
+NumaAllocationScope::~NumaAllocationScope() {
+#ifdef STORM_HAVE_NUMA
+    if (active) {
+        // set_mempolicy drops the last bit of maxnode, hence the + 1
+        set_mempolicy(savedMode, savedMode == MPOL_DEFAULT ? nullptr : savedMask.data(), NodeMaskBits() + 1);
+    }
+#endif
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+
+/**
+ * @brief Minimal NUMA placement helpers used for shard and event-loop placement.
+ *
+ * Backed by libnuma when the build finds it (STORM_HAVE_NUMA); otherwise, or
+ * when the kernel reports no NUMA support, every helper is a no-op and no
+ * nodes are reported.
+ */
+
+/**
+ * @brief NUMA nodes this process may allocate memory on, in ascending order.
+ * @return const std::vector<int>& Node ids; empty if NUMA is unavailable.
+ */
+const std::vector<int>& NumaNodes();
+
+/**
+ * @brief Restrict the calling thread to the CPUs of a node.
+ * @param node Node id from NumaNodes(); negative is ignored.
+ * @return true If the thread now runs on that node.
+ *
+ * The default local allocation policy then places the thread's future
+ * allocations on the same node.
+ */
+bool RunOnNumaNode(int node);
+
+/**
+ * @brief Prefer one node for the calling thread's allocations while in scope.
+ *
+ * First-touch placement applies: memory allocated and written inside the
+ * scope lands on the node, and the thread's previous policy is restored on
+ * exit. A negative node leaves the policy untouched.
+ */
+class NumaAllocationScope {
+public:
+    explicit NumaAllocationScope(int node);
+    ~NumaAllocationScope();
+
+    NumaAllocationScope(const NumaAllocationScope&) = delete;
+    NumaAllocationScope& operator=(const NumaAllocationScope&) = delete;
+
+private:
+    bool active = false;                  ///< Whether a policy was changed and must be restored
+    int savedMode = 0;                    ///< Policy mode before the scope
+    std::vector<unsigned long> savedMask; ///< Node mask before the scope
+};
@@ -0,0 +1,334 @@
+#include "owned_shard_store.h"
+#include "key_hash.h"
+#include <pthread.h>
+#include <sched.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+/**
+ * @brief Empty sweeps over every channel before an idle owner starts yielding.
+ */
+constexpr unsigned kSpinSweeps = 64;
+
+/**
+ * @brief Empty sweeps before an idle owner starts sleeping between sweeps.
+ */
+constexpr unsigned kYieldSweeps = 1024;
+
+/**
+ * @brief Sleep between sweeps of an owner that has been idle for a while.
+ */
+constexpr std::chrono::microseconds kIdleSleep{50};
+
+/**
+ * @brief Polls of an empty reply ring before a waiting client starts yielding.
+ */
+constexpr unsigned kReplySpins = 256;
+
+/**
+ * @brief Restrict the calling thread to one of the CPUs it may run on, chosen round-robin.
+ * @param index Owner index; owners beyond the CPU count share cores.
+ */
+void PinToCore(size_t index) {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return;
+    }
+
+    size_t allowed_count = static_cast<size_t>(CPU_COUNT(&allowed));
+    if (allowed_count == 0) {
+        return;
+    }
+    size_t wanted = index % allowed_count;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &allowed)) {
+            continue;
+        }
+        if (wanted-- == 0) {
+            cpu_set_t pinned;
+            CPU_ZERO(&pinned);
+            CPU_SET(cpu, &pinned);
+            pthread_setaffinity_np(pthread_self(), sizeof(pinned), &pinned);
+            return;
+        }
+    }
+}
+
+} // namespace
+
+// ========================================
+// Lifecycle
+// ========================================
+
+/**
+ * @brief Start the owners and wait until every shard has been built.
+ *
+ * Each owner constructs its own single-shard Store after pinning itself, so
+ * the shard's table is allocated from the owner's core (and NUMA node).
+ */
+OwnedShardStore::OwnedShardStore(const StoreOptions& options) : hashSeed(options.hashSeed) {
+    if (hashSeed == 0) {
+        std::random_device seed_source;
+        hashSeed = (uint64_t{seed_source()} << 32) | seed_source();
+    }
+
+    size_t owner_count = std::max<size_t>(1, options.shardCount);
+    StoreOptions shard_options = options;
+    shard_options.shardCount = 1;
+    shard_options.maxShardCount = 1;
+    shard_options.numaAware = false;
+    shard_options.memoryBudget = options.memoryBudget / owner_count;
+    shard_options.hashSeed = hashSeed;
+
+    std::atomic<size_t> ready_count{0};
+    owners.resize(owner_count);
+    for (size_t shard_index = 0; shard_index < owner_count; ++shard_index) {
+        owners[shard_index].thread = std::thread(
+            [this, shard_index, shard_options, &ready_count] { ownerLoop(shard_index, shard_options, ready_count); });
+    }
+    while (ready_count.load(std::memory_order_acquire) != owner_count) {
+        std::this_thread::yield();
+    }
+}
+
+OwnedShardStore::~OwnedShardStore() {
+    stopping.store(true, std::memory_order_release);
+    for (Owner& owner : owners) {
+        owner.thread.join();
+    }
+}
+
+/**
+ * @brief Hand out a free client slot, allocating its channels on first use.
+ */
+std::unique_ptr<OwnedShardStore::Client> OwnedShardStore::connect() {
+    std::lock_guard<std::mutex> slot_lock_guard(slotLock);
+
+    size_t allocated = slotCount.load(std::memory_order_relaxed);
+    for (size_t slot_index = 0; slot_index < allocated; ++slot_index) {
+        if (!slots[slot_index]->connected) {
+            slots[slot_index]->connected = true;
+            return std::unique_ptr<Client>(new Client(*this, slot_index));
+        }
+    }
+    if (allocated == kMaxClients) {
+        throw std::runtime_error("too many clients connected");
+    }
+
+    auto slot = std::make_unique<ClientSlot>();
+    slot->channels = std::make_unique<Channel[]>(owners.size());
+    slot->connected = true;
+    slots[allocated] = std::move(slot);
+    // Publishes the slot to the owners, which only read slots below slotCount
+    slotCount.store(allocated + 1, std::memory_order_release);
+    return std::unique_ptr<Client>(new Client(*this, allocated));
+}
+
+void OwnedShardStore::disconnect(size_t slotIndex) {
+    std::lock_guard<std::mutex> slot_lock_guard(slotLock);
+    slots[slotIndex]->connected = false;
+}
+
+// ========================================
+// Owner threads
+// ========================================
+
+/**
+ * @brief Serve one shard: sweep every client's request ring and answer in place.
+ *
+ * A client has at most one message in flight per shard, so a reply ring
+ * always has room for the answer.
+ */
+void OwnedShardStore::ownerLoop(size_t shardIndex, StoreOptions shardOptions, std::atomic<size_t>& readyCount) {
+    PinToCore(shardIndex);
+    owners[shardIndex].store = std::make_unique<Store>(shardOptions);
+    Store& shard = *owners[shardIndex].store;
+    readyCount.fetch_add(1, std::memory_order_release);
+
+    Message message;
+    unsigned idle_sweeps = 0;
+    while (!stopping.load(std::memory_order_acquire)) {
+        bool served = false;
+        size_t client_count = slotCount.load(std::memory_order_acquire);
+        for (size_t slot_index = 0; slot_index < client_count; ++slot_index) {
+            Channel& channel = slots[slot_index]->channels[shardIndex];
+            while (channel.requests.tryPop(message)) {
+                Execute(shard, message);
+                channel.replies.tryPush(message);
+                served = true;
+            }
+        }
+
+        if (served) {
+            idle_sweeps = 0;
+        } else if (++idle_sweeps > kYieldSweeps) {
+            std::this_thread::sleep_for(kIdleSleep);
+        } else if (idle_sweeps > kSpinSweeps) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void OwnedShardStore::Execute(Store& shard, Message& message) {
+    switch (message.op) {
+        case Op::Put:
+            message.result = shard.put(message.key, std::move(message.value)) ? 1 : 0;
+            break;
+        case Op::Get:
+            message.value = shard.get(message.key);
+            break;
+        case Op::Del:
+            message.result = shard.del(message.key) ? 1 : 0;
+            break;
+        case Op::PutMany:
+            for (size_t index : *message.indexes) {
+                const auto& [key, value] = (*message.pairs)[index];
+                message.result += shard.put(key, std::string_view(value)) ? 1 : 0;
+            }
+            break;
+        case Op::GetMany:
+            for (size_t index : *message.indexes) {
+                ValueHandle& value = (*message.values)[index];
+                value = shard.get((*message.keys)[index]);
+                message.result += value ? 1 : 0;
+            }
+            break;
+        case Op::DelMany:
+            for (size_t index : *message.indexes) {
+                message.result += shard.del((*message.keys)[index]) ? 1 : 0;
+            }
+            break;
+    }
+}
+
+size_t OwnedShardStore::shardOf(std::string_view key) const {
+    // Multiply-shift over the high bits; the shard's own table uses the low bits
+    uint64_t high_bits = HashKey(key, hashSeed) >> 32;
+    return static_cast<size_t>((high_bits * owners.size()) >> 32);
+}
+
+// ========================================
+// Client operations
+// ========================================
+
+OwnedShardStore::Client::Client(OwnedShardStore& ownerStore, size_t clientSlot)
+    : store(ownerStore), slotIndex(clientSlot), channels(ownerStore.slots[clientSlot]->channels.get()),
+      shardIndexes(ownerStore.owners.size()) {}
+
+OwnedShardStore::Client::~Client() {
+    store.disconnect(slotIndex);
+}
+
+void OwnedShardStore::Client::PopReply(SpscRing<Message, kRingCapacity>& ring, Message& message) {
+    unsigned spins = 0;
+    while (!ring.tryPop(message)) {
+        if (++spins > kReplySpins) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+OwnedShardStore::Message OwnedShardStore::Client::call(size_t shard, Message message) {
+    Channel& channel = channels[shard];
+    channel.requests.tryPush(message);
+    PopReply(channel.replies, message);
+    return message;
+}
+
+bool OwnedShardStore::Client::put(std::string_view key, std::string_view value) {
+    Message message;
+    message.op = Op::Put;
+    message.key = key;
+    // Copy on the client so the owner only links the value in
+    message.value = ValueHandle::copyOf(value);
+    return call(store.shardOf(key), std::move(message)).result != 0;
+}
+
+bool OwnedShardStore::Client::get(std::string_view key, std::string& value) {
+    ValueHandle value_handle = get(key);
+    if (!value_handle) {
+        return false;
+    }
+    value.assign(value_handle.data(), value_handle.size());
+    return true;
+}
+
+ValueHandle OwnedShardStore::Client::get(std::string_view key) {
+    Message message;
+    message.op = Op::Get;
+    message.key = key;
+    return std::move(call(store.shardOf(key), std::move(message)).value);
+}
+
+bool OwnedShardStore::Client::del(std::string_view key) {
+    Message message;
+    message.op = Op::Del;
+    message.key = key;
+    return call(store.shardOf(key), std::move(message)).result != 0;
+}
+
+/**
+ * @brief Send every non-empty shard group in one pass, then wait for each reply.
+ *
+ * The owners work on their sub-batches concurrently; the batch's total
+ * latency is that of the slowest shard rather than the sum.
+ */
+size_t OwnedShardStore::Client::scatter(Message batch) {
+    for (size_t shard = 0; shard < shardIndexes.size(); ++shard) {
+        if (shardIndexes[shard].empty()) {
+            continue;
+        }
+        Message message = batch;
+        message.indexes = &shardIndexes[shard];
+        channels[shard].requests.tryPush(message);
+    }
+
+    size_t total = 0;
+    Message reply;
+    for (size_t shard = 0; shard < shardIndexes.size(); ++shard) {
+        if (shardIndexes[shard].empty()) {
+            continue;
+        }
+        PopReply(channels[shard].replies, reply);
+        total += reply.result;
+        shardIndexes[shard].clear();
+    }
+    return total;
+}
+
+void OwnedShardStore::Client::putMany(const std::vector<std::pair<std::string, std::string>>& keyValuePairs) {
+    for (size_t index = 0; index < keyValuePairs.size(); ++index) {
+        shardIndexes[store.shardOf(keyValuePairs[index].first)].push_back(index);
+    }
+    Message batch;
+    batch.op = Op::PutMany;
+    batch.pairs = &keyValuePairs;
+    scatter(std::move(batch));
+}
+
+size_t OwnedShardStore::Client::getMany(const std::vector<std::string_view>& keys, std::vector<ValueHandle>& values) {
+    values.assign(keys.size(), ValueHandle());
+    for (size_t index = 0; index < keys.size(); ++index) {
+        shardIndexes[store.shardOf(keys[index])].push_back(index);
+    }
+    Message batch;
+    batch.op = Op::GetMany;
+    batch.keys = &keys;
+    batch.values = &values;
+    return scatter(std::move(batch));
+}
+
+size_t OwnedShardStore::Client::delMany(const std::vector<std::string_view>& keys) {
+    for (size_t index = 0; index < keys.size(); ++index) {
+        shardIndexes[store.shardOf(keys[index])].push_back(index);
+    }
+    Message batch;
+    batch.op = Op::DelMany;
+    batch.keys = &keys;
+    return scatter(std::move(batch));
+}
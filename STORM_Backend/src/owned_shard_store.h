@@ -0,0 +1,238 @@
+#pragma once
+
+#include "spsc_ring.h"
+#include "store.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Shared-nothing store: every shard is owned by one pinned worker thread.
+ *
+ * Instead of locking a shard, callers send it a message. Each client thread
+ * connects once and gets, for every shard, a pair of single-producer/
+ * single-consumer rings (requests in, replies out), so no two threads ever
+ * write the same ring index and no shard's data is touched by more than one
+ * thread. put, get, and del are one message each; the batch operations send
+ * one message per shard carrying that shard's whole sub-batch and wait for
+ * the replies together, so the shards work on a batch in parallel.
+ *
+ * Each owner keeps its keys in a private single-shard Store built on its own
+ * thread, so the shard's memory is first touched on the owner's core. Only
+ * the owner ever calls into that Store, which leaves its lock permanently
+ * uncontended.
+ *
+ * Owners busy-poll their rings while traffic flows and back off to yielding
+ * and then short sleeps when idle. Calls block the calling client until the
+ * reply arrives.
+ */
+class OwnedShardStore {
+public:
+    /**
+     * @brief Most clients that may be connected at once.
+     */
+    static constexpr size_t kMaxClients = 512;
+
+    class Client;
+
+    /**
+     * @brief Start one owner thread per shard and build its shard.
+     * @param options Layout and limits; shardCount is the number of owner
+     *        threads, maxKeysPerShard and recencyMode apply per shard,
+     *        memoryBudget is split evenly, and numaAware and maxShardCount
+     *        are ignored (the layout is fixed).
+     */
+    explicit OwnedShardStore(const StoreOptions& options);
+
+    /**
+     * @brief Stop and join every owner thread. All clients must be gone.
+     */
+    ~OwnedShardStore();
+
+    OwnedShardStore(const OwnedShardStore&) = delete;
+    OwnedShardStore& operator=(const OwnedShardStore&) = delete;
+
+    /**
+     * @brief Register the calling thread as a client.
+     * @return std::unique_ptr<Client> Handle to issue operations through; use it from one thread at a time.
+     * @throws std::runtime_error If kMaxClients clients are already connected.
+     */
+    std::unique_ptr<Client> connect();
+
+    /**
+     * @brief Number of shards, and therefore of owner threads.
+     */
+    size_t shardCount() const { return owners.size(); }
+
+private:
+    /**
+     * @brief Operation carried by a Message.
+     */
+    enum class Op : uint8_t { Put, Get, Del, PutMany, GetMany, DelMany };
+
+    /**
+     * @brief One request, sent back unchanged apart from its result fields.
+     *
+     * Keys, values, and batches point into the client's arguments, which
+     * outlive the message because the client waits for its reply.
+     */
+    struct Message {
+        Op op = Op::Get;
+        std::string_view key;                                         ///< Single-key ops: the key
+        ValueHandle value;                                            ///< Put: value to store; Get: the result
+        const std::vector<std::pair<std::string, std::string>>* pairs = nullptr; ///< PutMany: the whole batch
+        const std::vector<std::string_view>* keys = nullptr;          ///< GetMany, DelMany: the whole batch
+        std::vector<ValueHandle>* values = nullptr;                   ///< GetMany: results, indexed like keys
+        const std::vector<size_t>* indexes = nullptr;                 ///< Batches: positions this shard owns
+        size_t result = 0;                                            ///< Put, Del: 1 on success; batches: hits
+    };
+
+    /**
+     * @brief Ring slots per direction; a client has at most one message in flight per shard.
+     */
+    static constexpr size_t kRingCapacity = 4;
+
+    /**
+     * @brief The two rings between one client and one shard.
+     */
+    struct Channel {
+        SpscRing<Message, kRingCapacity> requests; ///< Client to owner
+        SpscRing<Message, kRingCapacity> replies;  ///< Owner to client
+    };
+
+    /**
+     * @brief A client's channels to every shard; reused once the client disconnects.
+     */
+    struct ClientSlot {
+        std::unique_ptr<Channel[]> channels; ///< One per shard
+        bool connected = false;              ///< Guarded by slotLock
+    };
+
+    /**
+     * @brief One shard and the thread that owns it.
+     */
+    struct Owner {
+        std::unique_ptr<Store> store; ///< Built and used only by thread
+        std::thread thread;
+    };
+
+    uint64_t hashSeed;                                          ///< Routing hash seed
+    std::vector<Owner> owners;                                  ///< One per shard
+    std::array<std::unique_ptr<ClientSlot>, kMaxClients> slots; ///< Allocated on first use, freed by the destructor
+    std::atomic<size_t> slotCount{0};                           ///< Slots allocated so far; owners poll this many
+    std::mutex slotLock;                                        ///< Guards connect, disconnect, and slot allocation
+    std::atomic<bool> stopping{false};                          ///< Set by the destructor
+
+    /**
+     * @brief Pin to a core, build the shard, then serve every channel until stopping.
+     */
+    void ownerLoop(size_t shardIndex, StoreOptions shardOptions, std::atomic<size_t>& readyCount);
+
+    /**
+     * @brief Run one message against the owner's shard, filling in its result.
+     */
+    static void Execute(Store& shard, Message& message);
+
+    /**
+     * @brief Shard that owns a key.
+     */
+    size_t shardOf(std::string_view key) const;
+
+    /**
+     * @brief Return a client's slot for reuse.
+     */
+    void disconnect(size_t slotIndex);
+};
+
+/**
+ * @brief One thread's connection to an OwnedShardStore.
+ *
+ * Operations mirror the Store API. A client must be used by one thread at a
+ * time and destroyed before its store.
+ */
+class OwnedShardStore::Client {
+public:
+    ~Client();
+
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    /**
+     * @brief Insert or update a key-value pair.
+     * @return false If the pair is too large for the shard.
+     */
+    bool put(std::string_view key, std::string_view value);
+
+    /**
+     * @brief Retrieve the value for a key.
+     * @param key Key to look up.
+     * @param value Output: set to the value when present.
+     * @return true If the key exists.
+     */
+    bool get(std::string_view key, std::string& value);
+
+    /**
+     * @brief Retrieve a handle to the value for a key.
+     * @return ValueHandle The value, or an empty handle if the key does not exist.
+     */
+    ValueHandle get(std::string_view key);
+
+    /**
+     * @brief Delete a key.
+     * @return true If the key existed.
+     */
+    bool del(std::string_view key);
+
+    /**
+     * @brief Insert a batch, one message per shard holding its share of the batch.
+     */
+    void putMany(const std::vector<std::pair<std::string, std::string>>& keyValuePairs);
+
+    /**
+     * @brief Look up a batch, one message per shard.
+     * @param keys Keys to look up.
+     * @param values Output: resized to keys.size(); misses are empty handles.
+     * @return size_t Number of keys found.
+     */
+    size_t getMany(const std::vector<std::string_view>& keys, std::vector<ValueHandle>& values);
+
+    /**
+     * @brief Delete a batch, one message per shard.
+     * @return size_t Number of keys that existed.
+     */
+    size_t delMany(const std::vector<std::string_view>& keys);
+
+private:
+    Client(OwnedShardStore& ownerStore, size_t clientSlot);
+
+    OwnedShardStore& store;
+    size_t slotIndex;                               ///< Slot in store.slots
+    Channel* channels;                              ///< This client's channel to each shard
+    std::vector<std::vector<size_t>> shardIndexes;  ///< Reused batch grouping, one list per shard
+
+    /**
+     * @brief Send a message to a shard and wait for its reply.
+     */
+    Message call(size_t shard, Message message);
+
+    /**
+     * @brief Send one batch message to every shard with keys in it, then collect the replies.
+     * @return size_t Sum of the replies' results.
+     */
+    size_t scatter(Message batch);
+
+    /**
+     * @brief Spin, then yield, until a message leaves a ring.
+     */
+    static void PopReply(SpscRing<Message, kRingCapacity>& ring, Message& message);
+
+    friend class OwnedShardStore;
+};
@@ -0,0 +1,63 @@
+#include "reclaimer.h"
+#include <vector>
+
+Reclaimer::~Reclaimer() {
+    {
+        std::lock_guard<std::mutex> queue_lock_guard(queueLock);
+        stopping = true;
+    }
+    workQueued.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void Reclaimer::enqueue(Garbage garbage) {
+    {
+        std::lock_guard<std::mutex> queue_lock_guard(queueLock);
+        queue.push_back(garbage);
+        if (!worker.joinable()) {
+            worker = std::thread([this] { workerLoop(); });
+        }
+    }
+    workQueued.notify_one();
+}
+
+void Reclaimer::waitIdle() {
+    std::unique_lock<std::mutex> queue_lock_guard(queueLock);
+    workDone.wait(queue_lock_guard, [this] { return queue.empty() && inFlight == 0; });
+}
+
+size_t Reclaimer::pending() {
+    std::lock_guard<std::mutex> queue_lock_guard(queueLock);
+    return queue.size() + inFlight;
+}
+
+/**
+ * @brief Destroy queued objects in batches until shutdown, finishing the queue first.
+ */
+void Reclaimer::workerLoop() {
+    std::vector<Garbage> batch;
+    std::unique_lock<std::mutex> queue_lock_guard(queueLock);
+    while (true) {
+        workQueued.wait(queue_lock_guard, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) {
+            return; // Stopping with nothing left to destroy
+        }
+
+        batch.assign(queue.begin(), queue.end());
+        queue.clear();
+        inFlight = batch.size();
+        queue_lock_guard.unlock();
+
+        for (const Garbage& garbage : batch) {
+            garbage.destroy(garbage.object);
+        }
+
+        queue_lock_guard.lock();
+        inFlight = 0;
+        if (queue.empty()) {
+            workDone.notify_all();
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief Background thread that destroys objects handed to it, off the caller's critical path.
+ *
+ * Freeing a full shard calls the allocator once per entry and value, which
+ * can take seconds for millions of keys. Callers detach such containers
+ * under their lock in O(1), unlock, and retire them here; the thread then
+ * destroys them in retirement order. The thread is started by the first
+ * retire, so owners that never retire anything cost nothing.
+ */
+class Reclaimer {
+public:
+    Reclaimer() = default;
+
+    /**
+     * @brief Destroy everything still queued, then join the thread.
+     */
+    ~Reclaimer();
+
+    Reclaimer(const Reclaimer&) = delete;
+    Reclaimer& operator=(const Reclaimer&) = delete;
+
+    /**
+     * @brief Queue an object for destruction on the background thread.
+     * @param object Object to destroy; its destructor must be safe to run on another thread.
+     */
+    template <typename T>
+    void retire(std::unique_ptr<T> object) {
+        if (object) {
+            enqueue(Garbage{object.release(), [](void* garbage) { delete static_cast<T*>(garbage); }});
+        }
+    }
+
+    /**
+     * @brief Block until every object retired before the call has been destroyed.
+     */
+    void waitIdle();
+
+    /**
+     * @brief Objects retired and not yet destroyed.
+     */
+    size_t pending();
+
+private:
+    /**
+     * @brief A type-erased retired object.
+     */
+    struct Garbage {
+        void* object;
+        void (*destroy)(void*);
+    };
+
+    std::thread worker;                  ///< Started by the first retire
+    std::deque<Garbage> queue;           ///< Objects waiting to be destroyed, oldest first
+    std::mutex queueLock;                ///< Guards queue, inFlight, and stopping
+    std::condition_variable workQueued;  ///< Signalled on retire and on shutdown
+    std::condition_variable workDone;    ///< Signalled when the queue has been emptied
+    size_t inFlight = 0;                 ///< Objects taken off the queue and being destroyed
+    bool stopping = false;               ///< Set by the destructor
+
+    void enqueue(Garbage garbage);
+    void workerLoop();
+};
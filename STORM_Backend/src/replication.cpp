@@ -0,0 +1,472 @@
+#include "replication.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <system_error>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr char kReplicationMagic[8] = {'S', 'T', 'O', 'R', 'M', 'R', 'P', 'L'};
+constexpr size_t kHandshakeBytes = sizeof(kReplicationMagic) + sizeof(uint32_t);
+constexpr size_t kFullSyncHeaderBytes = sizeof(kReplicationMagic) + 2 * sizeof(uint64_t);
+constexpr size_t kFrameHeaderBytes = 3 * sizeof(uint64_t) + sizeof(uint32_t);
+constexpr size_t kMaxFrameRecordBytes = size_t{1} << 20;   ///< Soft cap on the records per frame
+constexpr size_t kTransferChunkBytes = size_t{1} << 20;
+
+[[noreturn]] void ThrowSystemError(const char* operation) {
+    throw std::system_error(errno, std::generic_category(), operation);
+}
+
+template <typename Integer>
+char* PutInteger(char* output, Integer value) {
+    std::memcpy(output, &value, sizeof(value));
+    return output + sizeof(value);
+}
+
+template <typename Integer>
+Integer GetInteger(const char* input) {
+    Integer value;
+    std::memcpy(&value, input, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Send a whole buffer on a blocking socket; a closed peer fails instead of raising SIGPIPE.
+ */
+bool SendAll(int socket_fd, const char* bytes, size_t byte_count) {
+    while (byte_count > 0) {
+        ssize_t sent = ::send(socket_fd, bytes, byte_count, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bytes += sent;
+        byte_count -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+/**
+ * @brief Receive exactly byteCount bytes from a blocking socket.
+ * @return false If the peer closed the connection or the socket failed first.
+ */
+bool ReceiveAll(int socket_fd, char* bytes, size_t byte_count) {
+    while (byte_count > 0) {
+        ssize_t received = ::recv(socket_fd, bytes, byte_count, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return false;
+        bytes += received;
+        byte_count -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+/**
+ * @brief Send a file's contents, read in large chunks.
+ */
+bool SendFile(int socket_fd, int file_fd, uint64_t byte_count) {
+    std::vector<char> chunk(kTransferChunkBytes);
+    while (byte_count > 0) {
+        size_t wanted = static_cast<size_t>(std::min<uint64_t>(byte_count, chunk.size()));
+        ssize_t read_count = ::read(file_fd, chunk.data(), wanted);
+        if (read_count < 0 && errno == EINTR) continue;
+        if (read_count <= 0 || !SendAll(socket_fd, chunk.data(), static_cast<size_t>(read_count))) {
+            return false;
+        }
+        byte_count -= static_cast<uint64_t>(read_count);
+    }
+    return true;
+}
+
+/**
+ * @brief Receive byteCount bytes into a new file.
+ */
+bool ReceiveFile(int socket_fd, const std::string& path, uint64_t byte_count) {
+    int file_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (file_fd < 0) {
+        return false;
+    }
+    std::vector<char> chunk(kTransferChunkBytes);
+    bool complete = true;
+    while (complete && byte_count > 0) {
+        size_t wanted = static_cast<size_t>(std::min<uint64_t>(byte_count, chunk.size()));
+        complete = ReceiveAll(socket_fd, chunk.data(), wanted);
+        for (size_t written = 0; complete && written < wanted;) {
+            ssize_t write_count = ::write(file_fd, chunk.data() + written, wanted - written);
+            if (write_count < 0 && errno == EINTR) continue;
+            complete = write_count > 0;
+            written += complete ? static_cast<size_t>(write_count) : 0;
+        }
+        byte_count -= complete ? wanted : 0;
+    }
+    ::close(file_fd);
+    return complete;
+}
+
+void DisableNagle(int socket_fd) {
+    int enabled = 1;
+    setsockopt(socket_fd, IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled));
+}
+
+} // namespace
+
+// ========================================
+// ReplicationPrimary
+// ========================================
+
+ReplicationPrimary::ReplicationPrimary(Store& source_store, std::shared_ptr<ReplicationLog> log,
+                                       const ReplicationPrimaryConfig& primary_config)
+    : store(source_store), replicationLog(std::move(log)), config(primary_config) {}
+
+ReplicationPrimary::~ReplicationPrimary() {
+    stop();
+}
+
+void ReplicationPrimary::start() {
+    stopping.store(false);
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) ThrowSystemError("socket");
+
+    int enabled = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &enabled, sizeof(enabled));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(config.port);
+    if (inet_pton(AF_INET, config.bindAddress.c_str(), &address.sin_addr) != 1) {
+        close(listenFd);
+        listenFd = -1;
+        throw std::system_error(EINVAL, std::generic_category(), "inet_pton(" + config.bindAddress + ")");
+    }
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        listen(listenFd, SOMAXCONN) < 0) {
+        int socket_error = errno;
+        close(listenFd);
+        listenFd = -1;
+        throw std::system_error(socket_error, std::generic_category(), "bind/listen");
+    }
+
+    sockaddr_in bound_address{};
+    socklen_t address_length = sizeof(bound_address);
+    getsockname(listenFd, reinterpret_cast<sockaddr*>(&bound_address), &address_length);
+    boundPort = ntohs(bound_address.sin_port);
+
+    acceptor = std::thread([this] { acceptLoop(); });
+}
+
+void ReplicationPrimary::stop() {
+    stopping.store(true);
+
+    // shutdown wakes the blocked accept and any send or recv on a replica socket
+    if (listenFd >= 0) {
+        shutdown(listenFd, SHUT_RDWR);
+    }
+    if (acceptor.joinable()) {
+        acceptor.join();
+    }
+    if (listenFd >= 0) {
+        close(listenFd);
+        listenFd = -1;
+    }
+
+    std::list<std::unique_ptr<ReplicaLink>> stopped_links;
+    {
+        std::lock_guard<std::mutex> links_lock_guard(linksLock);
+        stopped_links.swap(links);
+    }
+    for (auto& link : stopped_links) {
+        shutdown(link->fd, SHUT_RDWR);
+    }
+    for (auto& link : stopped_links) {
+        link->worker.join();
+        close(link->fd);
+    }
+}
+
+ReplicationStatus ReplicationPrimary::status() const {
+    ReplicationStatus current;
+    current.connectedReplicas = streamingReplicas.load();
+    current.fullSyncs = fullSyncs.load();
+    current.primaryOffset = replicationLog->endOffset();
+    return current;
+}
+
+void ReplicationPrimary::acceptLoop() {
+    while (!stopping.load()) {
+        int replica_fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (replica_fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;
+        }
+        DisableNagle(replica_fd);
+        reapFinishedLinks();
+
+        auto link = std::make_unique<ReplicaLink>();
+        link->fd = replica_fd;
+        ReplicaLink* link_pointer = link.get();
+        std::lock_guard<std::mutex> links_lock_guard(linksLock);
+        links.push_back(std::move(link));
+        link_pointer->worker = std::thread([this, link_pointer] {
+            serveReplica(*link_pointer);
+            link_pointer->finished.store(true);
+        });
+    }
+}
+
+void ReplicationPrimary::reapFinishedLinks() {
+    std::list<std::unique_ptr<ReplicaLink>> finished_links;
+    {
+        std::lock_guard<std::mutex> links_lock_guard(linksLock);
+        for (auto link = links.begin(); link != links.end();) {
+            auto current = link++;
+            if ((*current)->finished.load()) {
+                finished_links.splice(finished_links.end(), links, current);
+            }
+        }
+    }
+    for (auto& link : finished_links) {
+        link->worker.join();
+        close(link->fd);
+    }
+}
+
+void ReplicationPrimary::serveReplica(ReplicaLink& link) {
+    char handshake[kHandshakeBytes];
+    if (!ReceiveAll(link.fd, handshake, sizeof(handshake)) ||
+        std::memcmp(handshake, kReplicationMagic, sizeof(kReplicationMagic)) != 0 ||
+        GetInteger<uint32_t>(handshake + sizeof(kReplicationMagic)) != kProtocolVersion) {
+        return;
+    }
+
+    // Full sync: everything from stream_offset on is streamed, so the snapshot may only be newer
+    uint64_t stream_offset = 0;
+    {
+        std::lock_guard<std::mutex> full_sync_lock_guard(fullSyncLock);
+        stream_offset = replicationLog->endOffset();
+        try {
+            store.snapshot(config.snapshotPath);
+        } catch (const std::system_error&) {
+            return;
+        }
+
+        int snapshot_fd = ::open(config.snapshotPath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (snapshot_fd < 0) {
+            return;
+        }
+        off_t snapshot_bytes = ::lseek(snapshot_fd, 0, SEEK_END);
+        ::lseek(snapshot_fd, 0, SEEK_SET);
+
+        char header[kFullSyncHeaderBytes];
+        std::memcpy(header, kReplicationMagic, sizeof(kReplicationMagic));
+        char* cursor = PutInteger<uint64_t>(header + sizeof(kReplicationMagic), stream_offset);
+        PutInteger<uint64_t>(cursor, static_cast<uint64_t>(snapshot_bytes));
+        bool sent = snapshot_bytes >= 0 && SendAll(link.fd, header, sizeof(header)) &&
+                    SendFile(link.fd, snapshot_fd, static_cast<uint64_t>(snapshot_bytes));
+        ::close(snapshot_fd);
+        ::unlink(config.snapshotPath.c_str());
+        if (!sent) {
+            return;
+        }
+    }
+    fullSyncs.fetch_add(1);
+    streamingReplicas.fetch_add(1);
+
+    // Stream; an idle wait doubles as the heartbeat interval
+    std::string frame(kFrameHeaderBytes, '\0');
+    std::string records;
+    while (!stopping.load()) {
+        ReplicationLog::ReadStatus read_status = replicationLog->read(
+            stream_offset, kMaxFrameRecordBytes, std::chrono::milliseconds(kHeartbeatMillis), records);
+        if (read_status == ReplicationLog::ReadStatus::Lost || read_status == ReplicationLog::ReadStatus::Closed) {
+            break;
+        }
+
+        stream_offset += records.size();
+        char* cursor = PutInteger<uint64_t>(&frame[0], stream_offset);
+        cursor = PutInteger<uint64_t>(cursor, replicationLog->endOffset());
+        cursor = PutInteger<uint64_t>(cursor, WallClockMillis());
+        PutInteger<uint32_t>(cursor, static_cast<uint32_t>(records.size()));
+        if (!SendAll(link.fd, frame.data(), frame.size()) || !SendAll(link.fd, records.data(), records.size())) {
+            break;
+        }
+    }
+    streamingReplicas.fetch_sub(1);
+}
+
+// ========================================
+// ReplicaClient
+// ========================================
+
+ReplicaClient::ReplicaClient(Store& target_store, std::string primary_host, uint16_t primary_port,
+                             std::string snapshot_path)
+    : store(target_store), host(std::move(primary_host)), port(primary_port), scratchPath(std::move(snapshot_path)) {}
+
+ReplicaClient::~ReplicaClient() {
+    stop();
+}
+
+void ReplicaClient::start() {
+    stopping.store(false);
+    follower = std::thread([this] { followLoop(); });
+}
+
+void ReplicaClient::stop() {
+    {
+        std::lock_guard<std::mutex> socket_lock_guard(socketLock);
+        stopping.store(true);
+        if (socketFd >= 0) {
+            shutdown(socketFd, SHUT_RDWR);
+        }
+    }
+    reconnectWait.notify_all();
+    if (follower.joinable()) {
+        follower.join();
+    }
+}
+
+ReplicationStatus ReplicaClient::status() const {
+    ReplicationStatus current;
+    current.replica = true;
+    current.connected = connected.load();
+    current.fullSyncs = fullSyncs.load();
+    current.appliedOffset = appliedOffset.load();
+    current.primaryOffset = primaryOffset.load();
+    if (current.primaryOffset > current.appliedOffset) {
+        current.lagBytes = current.primaryOffset - current.appliedOffset;
+        uint64_t sent_at = lastFrameSentAt.load();
+        uint64_t now = WallClockMillis();
+        current.lagMillis = now > sent_at ? now - sent_at : 0;
+    }
+    return current;
+}
+
+void ReplicaClient::followLoop() {
+    while (!stopping.load()) {
+        int connection_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (connection_fd >= 0) {
+            {
+                std::lock_guard<std::mutex> socket_lock_guard(socketLock);
+                socketFd = connection_fd;
+            }
+
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(port);
+            if (!stopping.load() && inet_pton(AF_INET, host.c_str(), &address.sin_addr) == 1 &&
+                connect(connection_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+                DisableNagle(connection_fd);
+                followOnce(connection_fd);
+            }
+            connected.store(false);
+
+            std::lock_guard<std::mutex> socket_lock_guard(socketLock);
+            socketFd = -1;
+            close(connection_fd);
+        }
+
+        std::unique_lock<std::mutex> socket_lock_guard(socketLock);
+        reconnectWait.wait_for(socket_lock_guard, std::chrono::milliseconds(kReconnectMillis),
+                               [this] { return stopping.load(); });
+    }
+}
+
+void ReplicaClient::followOnce(int connected_fd) {
+    char handshake[kHandshakeBytes];
+    std::memcpy(handshake, kReplicationMagic, sizeof(kReplicationMagic));
+    PutInteger<uint32_t>(handshake + sizeof(kReplicationMagic), ReplicationPrimary::kProtocolVersion);
+    char header[kFullSyncHeaderBytes];
+    if (!SendAll(connected_fd, handshake, sizeof(handshake)) ||
+        !ReceiveAll(connected_fd, header, sizeof(header)) ||
+        std::memcmp(header, kReplicationMagic, sizeof(kReplicationMagic)) != 0) {
+        return;
+    }
+    uint64_t stream_offset = GetInteger<uint64_t>(header + sizeof(kReplicationMagic));
+    uint64_t snapshot_bytes = GetInteger<uint64_t>(header + sizeof(kReplicationMagic) + sizeof(uint64_t));
+    if (!ReceiveFile(connected_fd, scratchPath, snapshot_bytes)) {
+        ::unlink(scratchPath.c_str());
+        return;
+    }
+
+    // Replace the contents wholesale; keys the primary dropped meanwhile must go too
+    try {
+        SnapshotReader snapshot_reader(scratchPath);
+        store.clear();
+        store.loadSnapshot(snapshot_reader);
+    } catch (const std::system_error&) {
+        ::unlink(scratchPath.c_str());
+        return;
+    }
+    ::unlink(scratchPath.c_str());
+    appliedOffset.store(stream_offset);
+    primaryOffset.store(stream_offset);
+    fullSyncs.fetch_add(1);
+    connected.store(true);
+
+    char frame[kFrameHeaderBytes];
+    std::string records;
+    while (!stopping.load() && ReceiveAll(connected_fd, frame, sizeof(frame))) {
+        uint64_t records_end = GetInteger<uint64_t>(frame);
+        uint64_t primary_end = GetInteger<uint64_t>(frame + sizeof(uint64_t));
+        uint64_t sent_at = GetInteger<uint64_t>(frame + 2 * sizeof(uint64_t));
+        uint32_t record_bytes = GetInteger<uint32_t>(frame + 3 * sizeof(uint64_t));
+        records.resize(record_bytes);
+        if (!ReceiveAll(connected_fd, &records[0], records.size()) ||
+            records_end != appliedOffset.load() + record_bytes || !applyRecords(records)) {
+            return;
+        }
+        lastFrameSentAt.store(sent_at);
+        primaryOffset.store(primary_end);
+        appliedOffset.store(records_end);
+    }
+}
+
+bool ReplicaClient::applyRecords(const std::string& records) {
+    std::vector<std::pair<std::string, std::string>> put_run;
+    std::vector<std::string_view> delete_run;
+    auto flush_puts = [&] {
+        if (!put_run.empty()) {
+            store.putMany(put_run);
+            put_run.clear();
+        }
+    };
+    auto flush_deletes = [&] {
+        if (!delete_run.empty()) {
+            store.delMany(delete_run);
+            delete_run.clear();
+        }
+    };
+
+    LogRecord record;
+    size_t position = 0;
+    while (position < records.size()) {
+        size_t record_bytes = 0;
+        if (DecodeLogRecord(records.data() + position, records.size() - position, record, record_bytes) !=
+            LogDecodeStatus::Complete) {
+            return false;
+        }
+        position += record_bytes;
+
+        // Batches only ever hold consecutive records, so the primary's order is kept
+        if (record.type == LogRecordType::Put && record.expiresAtWallMillis == 0) {
+            flush_deletes();
+            put_run.emplace_back(record.key, record.value);
+        } else if (record.type == LogRecordType::Delete) {
+            flush_puts();
+            delete_run.push_back(record.key);
+        } else {
+            flush_puts();
+            flush_deletes();
+            store.apply(record);
+        }
+    }
+    flush_puts();
+    flush_deletes();
+    return true;
+}
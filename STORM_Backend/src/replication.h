@@ -0,0 +1,226 @@
+#pragma once
+
+#include "replication_log.h"
+#include "store.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Asynchronous primary-to-replica replication over TCP.
+ *
+ * A replica connects to the primary's replication port and sends the 8
+ * bytes "STORMRPL" and a uint32 protocol version. The primary notes the
+ * current end of its ReplicationLog, writes a snapshot, and sends the magic,
+ * the noted uint64 stream offset, a uint64 byte count, and the snapshot
+ * file. From the noted offset on it then streams frames (all integers
+ * little-endian):
+ *   uint64 stream offset after the frame's records, uint64 primary's stream
+ *   end, uint64 primary wall-clock send time, uint32 record bytes, records.
+ * Records use the append-only log encoding. An idle link gets an empty
+ * frame every kHeartbeatMillis so the replica can tell lag from silence.
+ *
+ * Records between the noted offset and the snapshot may be replayed over
+ * state that already contains them; that is safe because every record sets
+ * a key's state outright (put, delete, clear) or only adjusts a key that
+ * exists (expire). A replica that falls out of the backlog, or loses the
+ * connection, starts over with a fresh snapshot.
+ */
+
+/**
+ * @brief Replication state reported by REPLICATION and INFO replication.
+ */
+struct ReplicationStatus {
+    bool replica = false;         ///< This node follows a primary
+    bool connected = false;       ///< Replica: the link to the primary is up
+    size_t connectedReplicas = 0; ///< Primary: replicas currently streaming
+    uint64_t fullSyncs = 0;       ///< Replica: snapshots loaded; Primary: snapshots sent
+    uint64_t appliedOffset = 0;   ///< Replica: stream offset applied so far
+    uint64_t primaryOffset = 0;   ///< Stream end on the primary (last reported, on a replica)
+    uint64_t lagBytes = 0;        ///< Replica: primaryOffset - appliedOffset
+    uint64_t lagMillis = 0;       ///< Replica: age of the newest applied frame while behind; 0 when caught up
+};
+
+/**
+ * @brief Per-session behaviour shared by the CLI and network sessions.
+ */
+struct SessionOptions {
+    bool readOnly = false;                                 ///< Reject writes (a replica)
+    std::function<ReplicationStatus()> replicationStatus; ///< Source of REPLICATION / INFO; empty = standalone
+};
+
+/**
+ * @brief Configuration of the primary side.
+ */
+struct ReplicationPrimaryConfig {
+    std::string bindAddress = "0.0.0.0"; ///< IPv4 address to listen on
+    uint16_t port = 7380;                ///< TCP port; 0 picks an ephemeral port
+    std::string snapshotPath;            ///< Scratch file for full syncs
+};
+
+/**
+ * @brief Serves replicas: a full sync from a snapshot, then the mutation stream.
+ *
+ * One thread accepts replicas and one thread serves each of them, so a
+ * slow replica only delays itself; the store never waits for replicas.
+ */
+class ReplicationPrimary {
+public:
+    static constexpr uint32_t kProtocolVersion = 1;
+    static constexpr int64_t kHeartbeatMillis = 100;
+
+    /**
+     * @brief Construct the primary; nothing listens until start().
+     * @param sourceStore Store whose snapshots are sent; must have log attached with setReplicationLog.
+     * @param log Backlog the store appends to.
+     * @param primaryConfig Listening address, port, and snapshot scratch path.
+     */
+    ReplicationPrimary(Store& sourceStore, std::shared_ptr<ReplicationLog> log,
+                       const ReplicationPrimaryConfig& primaryConfig);
+
+    /**
+     * @brief Stop serving and join every thread.
+     */
+    ~ReplicationPrimary();
+
+    ReplicationPrimary(const ReplicationPrimary&) = delete;
+    ReplicationPrimary& operator=(const ReplicationPrimary&) = delete;
+
+    /**
+     * @brief Open the listening socket and start accepting replicas.
+     * @throws std::system_error If the socket cannot be opened.
+     */
+    void start();
+
+    /**
+     * @brief Disconnect every replica and stop listening.
+     */
+    void stop();
+
+    /**
+     * @brief Port the primary listens on (resolved after start()).
+     */
+    uint16_t port() const { return boundPort; }
+
+    /**
+     * @brief Current state, for REPLICATION and INFO.
+     */
+    ReplicationStatus status() const;
+
+private:
+    /**
+     * @brief One connected replica and the thread serving it.
+     */
+    struct ReplicaLink {
+        int fd = -1;                       ///< Socket to the replica
+        std::thread worker;                ///< Runs serveReplica
+        std::atomic<bool> finished{false}; ///< serveReplica returned
+    };
+
+    Store& store;
+    std::shared_ptr<ReplicationLog> replicationLog;
+    ReplicationPrimaryConfig config;
+    uint16_t boundPort = 0;
+    int listenFd = -1;
+    std::atomic<bool> stopping{false};
+    std::thread acceptor;
+    mutable std::mutex linksLock;                    ///< Guards links
+    std::list<std::unique_ptr<ReplicaLink>> links;   ///< Connected and finished replicas not yet joined
+    std::mutex fullSyncLock;                         ///< Serialises full syncs (they share the scratch file)
+    std::atomic<size_t> streamingReplicas{0};        ///< Replicas past their full sync
+    std::atomic<uint64_t> fullSyncs{0};              ///< Snapshots sent
+
+    void acceptLoop();
+
+    /**
+     * @brief Handshake, full sync, and stream to one replica until it or the primary goes away.
+     */
+    void serveReplica(ReplicaLink& link);
+
+    /**
+     * @brief Join the threads of replicas that disconnected.
+     */
+    void reapFinishedLinks();
+};
+
+/**
+ * @brief Follows a primary: loads its snapshot, then applies its mutation stream.
+ *
+ * Runs on one background thread that reconnects every second while the
+ * primary is unreachable. Records are applied in batches: runs of plain
+ * puts go through putMany and runs of deletes through delMany, so each
+ * shard is locked once per run instead of once per record. Readers are
+ * served from the local store the whole time; during a full sync the store
+ * is cleared and refilled, so reads briefly miss.
+ */
+class ReplicaClient {
+public:
+    /**
+     * @brief Construct the client; nothing connects until start().
+     * @param targetStore Store to keep in sync; nothing else should write to it.
+     * @param primaryHost IPv4 address of the primary.
+     * @param primaryPort Primary's replication port.
+     * @param snapshotPath Scratch file for received snapshots.
+     */
+    ReplicaClient(Store& targetStore, std::string primaryHost, uint16_t primaryPort, std::string snapshotPath);
+
+    /**
+     * @brief Disconnect and join the background thread.
+     */
+    ~ReplicaClient();
+
+    ReplicaClient(const ReplicaClient&) = delete;
+    ReplicaClient& operator=(const ReplicaClient&) = delete;
+
+    /**
+     * @brief Start following the primary.
+     */
+    void start();
+
+    /**
+     * @brief Disconnect and stop.
+     */
+    void stop();
+
+    /**
+     * @brief Current state, for REPLICATION and INFO.
+     */
+    ReplicationStatus status() const;
+
+private:
+    static constexpr int64_t kReconnectMillis = 1000;
+
+    Store& store;
+    std::string host;
+    uint16_t port;
+    std::string scratchPath;
+    std::thread follower;
+    std::atomic<bool> stopping{false};
+    std::mutex socketLock;                   ///< Guards socketFd against stop()
+    std::condition_variable reconnectWait;   ///< Cut short by stop()
+    int socketFd = -1;                       ///< Current connection, or -1
+    std::atomic<bool> connected{false};
+    std::atomic<uint64_t> fullSyncs{0};
+    std::atomic<uint64_t> appliedOffset{0};
+    std::atomic<uint64_t> primaryOffset{0};
+    std::atomic<uint64_t> lastFrameSentAt{0}; ///< Primary wall-clock time of the newest applied frame
+
+    void followLoop();
+
+    /**
+     * @brief Run one connection: handshake, full sync, then frames until it fails.
+     */
+    void followOnce(int connectedFd);
+
+    /**
+     * @brief Apply a frame's records in order, batching runs of puts and deletes.
+     * @return false If the records are corrupt.
+     */
+    bool applyRecords(const std::string& records);
+};
@@ -0,0 +1,98 @@
+#include "replication_log.h"
+#include <algorithm>
+
+// ========================================
+// Appending
+// ========================================
+
+ReplicationLog::ReplicationLog(size_t backlog_bytes) : backlogLimit(backlog_bytes) {}
+
+void ReplicationLog::appendRecord(const LogRecord& record) {
+    size_t record_bytes = EncodedLogRecordSize(record);
+    {
+        std::lock_guard<std::mutex> backlog_lock_guard(backlogLock);
+        if (chunks.empty() || (!chunks.back().bytes.empty() &&
+                               chunks.back().bytes.size() + record_bytes > kChunkBytes)) {
+            Chunk chunk;
+            chunk.startOffset = streamEnd;
+            chunk.bytes.reserve(std::max(kChunkBytes, record_bytes));
+            chunks.push_back(std::move(chunk));
+        }
+
+        std::string& chunk_bytes = chunks.back().bytes;
+        size_t record_start = chunk_bytes.size();
+        chunk_bytes.resize(record_start + record_bytes);
+        EncodeLogRecord(record, &chunk_bytes[record_start]);
+        backlogBytes += record_bytes;
+        streamEnd += record_bytes;
+
+        // Whole chunks go, so every chunk still starts at a record boundary
+        while (backlogBytes > backlogLimit && chunks.size() > 1) {
+            backlogBytes -= chunks.front().bytes.size();
+            chunks.pop_front();
+        }
+    }
+    appended.notify_all();
+}
+
+void ReplicationLog::appendPut(std::string_view key, std::string_view value, uint64_t expires_at_wall_millis) {
+    appendRecord(LogRecord{LogRecordType::Put, key, value, expires_at_wall_millis});
+}
+
+void ReplicationLog::appendDelete(std::string_view key) {
+    appendRecord(LogRecord{LogRecordType::Delete, key, {}, 0});
+}
+
+void ReplicationLog::appendExpire(std::string_view key, uint64_t expires_at_wall_millis) {
+    appendRecord(LogRecord{LogRecordType::Expire, key, {}, expires_at_wall_millis});
+}
+
+void ReplicationLog::appendClear() {
+    appendRecord(LogRecord{LogRecordType::Clear, {}, {}, 0});
+}
+
+// ========================================
+// Reading
+// ========================================
+
+uint64_t ReplicationLog::endOffset() const {
+    std::lock_guard<std::mutex> backlog_lock_guard(backlogLock);
+    return streamEnd;
+}
+
+ReplicationLog::ReadStatus ReplicationLog::read(uint64_t offset, size_t max_bytes, std::chrono::milliseconds wait,
+                                                std::string& records) {
+    records.clear();
+    std::unique_lock<std::mutex> backlog_lock_guard(backlogLock);
+    appended.wait_for(backlog_lock_guard, wait, [&] { return closed || streamEnd != offset; });
+    if (closed) {
+        return ReadStatus::Closed;
+    }
+    if (offset == streamEnd) {
+        return ReadStatus::Idle;
+    }
+    if (offset > streamEnd || chunks.empty() || offset < chunks.front().startOffset) {
+        return ReadStatus::Lost;
+    }
+
+    // Find the chunk holding offset, then copy it and its successors up to the cap
+    auto chunk = std::upper_bound(chunks.begin(), chunks.end(), offset,
+                                  [](uint64_t target, const Chunk& candidate) {
+                                      return target < candidate.startOffset;
+                                  });
+    --chunk;
+    size_t skip = static_cast<size_t>(offset - chunk->startOffset);
+    records.append(chunk->bytes, skip, std::string::npos);
+    for (++chunk; chunk != chunks.end() && records.size() + chunk->bytes.size() <= max_bytes; ++chunk) {
+        records.append(chunk->bytes);
+    }
+    return ReadStatus::Data;
+}
+
+void ReplicationLog::close() {
+    {
+        std::lock_guard<std::mutex> backlog_lock_guard(backlogLock);
+        closed = true;
+    }
+    appended.notify_all();
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "append_log.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief In-memory backlog of recent mutations, for streaming to replicas.
+ *
+ * Records are encoded exactly as in the append-only log (see AppendLog) and
+ * addressed by a byte offset into the stream of every record ever appended,
+ * starting at 0. The backlog keeps whole chunks of about kChunkBytes; once it
+ * holds more than its limit, the oldest chunks are dropped, and a replica
+ * that has fallen behind them must resynchronise from a snapshot.
+ *
+ * Like the append-only log, the store appends while holding the lock that
+ * orders the mutation, so the stream is a valid replay order. Thread-safe.
+ */
+class ReplicationLog {
+public:
+    /**
+     * @brief Default number of backlog bytes kept for replicas that fall behind.
+     */
+    static constexpr size_t kDefaultBacklogBytes = size_t{64} << 20;
+
+    /**
+     * @brief Outcome of a read.
+     */
+    enum class ReadStatus {
+        Data,  ///< Records were copied out
+        Idle,  ///< Nothing new arrived before the wait ran out
+        Lost,  ///< The offset is no longer (or not yet) in the backlog
+        Closed ///< close() was called
+    };
+
+    /**
+     * @brief Create an empty backlog.
+     * @param backlogBytes Bytes of records to keep; at least one chunk is always kept.
+     */
+    explicit ReplicationLog(size_t backlogBytes = kDefaultBacklogBytes);
+
+    ReplicationLog(const ReplicationLog&) = delete;
+    ReplicationLog& operator=(const ReplicationLog&) = delete;
+
+    /**
+     * @brief Add an insert or overwrite; same meaning as AppendLog::appendPut.
+     */
+    void appendPut(std::string_view key, std::string_view value, uint64_t expiresAtWallMillis);
+
+    /**
+     * @brief Add a delete of a key that existed.
+     */
+    void appendDelete(std::string_view key);
+
+    /**
+     * @brief Add a TTL change of an existing key; 0 = the key no longer expires.
+     */
+    void appendExpire(std::string_view key, uint64_t expiresAtWallMillis);
+
+    /**
+     * @brief Add a removal of every key.
+     */
+    void appendClear();
+
+    /**
+     * @brief Stream offset just past the last record appended.
+     */
+    uint64_t endOffset() const;
+
+    /**
+     * @brief Copy out the records that follow an offset, waiting for some if there are none yet.
+     * @param offset Stream offset to read from; a record boundary returned by endOffset() or an earlier read.
+     * @param maxBytes Soft cap on the bytes copied; whole chunks are copied, so a read may exceed it.
+     * @param wait How long to wait for new records.
+     * @param records Output; replaced with complete records starting at offset.
+     * @return ReadStatus Data when records were copied; the new offset is offset + records.size().
+     */
+    ReadStatus read(uint64_t offset, size_t maxBytes, std::chrono::milliseconds wait, std::string& records);
+
+    /**
+     * @brief Wake every reader and make further reads return Closed.
+     */
+    void close();
+
+private:
+    static constexpr size_t kChunkBytes = size_t{64} << 10;
+
+    /**
+     * @brief A run of whole records.
+     */
+    struct Chunk {
+        uint64_t startOffset = 0; ///< Stream offset of the first byte
+        std::string bytes;        ///< Encoded records
+    };
+
+    size_t backlogLimit;                 ///< Bytes of records to keep
+    mutable std::mutex backlogLock;      ///< Guards everything below
+    std::condition_variable appended;    ///< Signalled when records arrive or the log closes
+    std::deque<Chunk> chunks;            ///< Backlog, oldest first
+    size_t backlogBytes = 0;             ///< Bytes held in chunks
+    uint64_t streamEnd = 0;              ///< Stream offset just past the last record
+    bool closed = false;                 ///< Set by close()
+
+    /**
+     * @brief Encode one record at the end of the backlog and drop chunks over the limit.
+     */
+    void appendRecord(const LogRecord& record);
+};
@@ -0,0 +1,769 @@
+#include "resp.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <system_error>
+#include <utility>
+
+namespace {
+
+constexpr size_t kMaxBulkLength = 32 * 1024 * 1024;  ///< Largest accepted argument; fits NetServer's 64 MiB input limit
+constexpr int64_t kMaxArgumentCount = 1024 * 1024;    ///< Largest accepted multibulk count
+constexpr size_t kMaxHeaderLength = 32;               ///< Longest "*N" / "$N" header line
+constexpr size_t kMaxInlineLength = 64 * 1024;        ///< Longest inline command line
+
+/**
+ * @brief Parse a "<prefix><integer>\r\n" header line.
+ * @param data Buffer starting at the prefix byte.
+ * @param length Bytes available.
+ * @param value Output: the parsed integer.
+ * @param header_length Output: bytes used including CRLF.
+ * @return RespParseStatus Complete, Incomplete, or Error for malformed headers.
+ */
+RespParseStatus ParseHeaderLine(const char* data, size_t length, int64_t& value, size_t& header_length) {
+    size_t search_length = std::min(length, kMaxHeaderLength);
+    const char* line_feed = static_cast<const char*>(std::memchr(data, '\n', search_length));
+    if (line_feed == nullptr) {
+        return length < kMaxHeaderLength ? RespParseStatus::Incomplete : RespParseStatus::Error;
+    }
+    if (line_feed - data < 2 || line_feed[-1] != '\r') {
+        return RespParseStatus::Error;
+    }
+
+    auto conversion = std::from_chars(data + 1, line_feed - 1, value);
+    if (conversion.ec != std::errc() || conversion.ptr != line_feed - 1) {
+        return RespParseStatus::Error;
+    }
+
+    header_length = static_cast<size_t>(line_feed - data) + 1;
+    return RespParseStatus::Complete;
+}
+
+/**
+ * @brief Parse a whitespace-separated inline command ("GET key\r\n").
+ */
+RespParseStatus ParseInlineRequest(const char* data, size_t length,
+                                   std::vector<std::string_view>& arguments, size_t& consumed) {
+    const char* line_feed = static_cast<const char*>(std::memchr(data, '\n', std::min(length, kMaxInlineLength)));
+    if (line_feed == nullptr) {
+        return length < kMaxInlineLength ? RespParseStatus::Incomplete : RespParseStatus::Error;
+    }
+
+    const char* line_end = line_feed;
+    if (line_end > data && line_end[-1] == '\r') {
+        --line_end;
+    }
+
+    for (const char* cursor = data; cursor < line_end;) {
+        while (cursor < line_end && (*cursor == ' ' || *cursor == '\t')) ++cursor;
+        const char* token_begin = cursor;
+        while (cursor < line_end && *cursor != ' ' && *cursor != '\t') ++cursor;
+        if (cursor > token_begin) {
+            arguments.emplace_back(token_begin, static_cast<size_t>(cursor - token_begin));
+        }
+    }
+
+    consumed = static_cast<size_t>(line_feed - data) + 1;
+    return RespParseStatus::Complete;
+}
+
+/**
+ * @brief Case-insensitive comparison against an upper-case command name.
+ */
+bool CommandIs(std::string_view argument, const char* upper_case_name) {
+    size_t name_length = std::strlen(upper_case_name);
+    if (argument.size() != name_length) {
+        return false;
+    }
+    for (size_t index = 0; index < name_length; ++index) {
+        if (std::toupper(static_cast<unsigned char>(argument[index])) != upper_case_name[index]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Parse a whole argument as a signed decimal integer.
+ * @return true If every byte was consumed and the value fits in int64_t.
+ */
+bool ParseInteger(std::string_view argument, int64_t& value) {
+    auto conversion = std::from_chars(argument.data(), argument.data() + argument.size(), value);
+    return conversion.ec == std::errc() && conversion.ptr == argument.data() + argument.size();
+}
+
+/**
+ * @brief The prefix a SCAN MATCH pattern selects, for the "prefix*" form the store can filter by.
+ * @return false If the pattern uses any other glob syntax.
+ */
+bool MatchPrefix(std::string_view pattern, std::string_view& prefix) {
+    if (pattern.empty() || pattern.back() != '*') {
+        return false;
+    }
+    prefix = pattern.substr(0, pattern.size() - 1);
+    return prefix.find_first_of("*?[\\") == std::string_view::npos;
+}
+
+/**
+ * @brief Parse the cursor and options of SCAN cursor [MATCH prefix*] [COUNT count].
+ * @return const char* nullptr on success, otherwise the error to reply with.
+ */
+const char* ParseScanArguments(const std::vector<std::string_view>& arguments, uint64_t& cursor, size_t& count,
+                               std::string_view& prefix) {
+    std::string_view cursor_argument = arguments[1];
+    auto conversion = std::from_chars(cursor_argument.data(), cursor_argument.data() + cursor_argument.size(), cursor);
+    if (conversion.ec != std::errc() || conversion.ptr != cursor_argument.data() + cursor_argument.size()) {
+        return "ERR invalid cursor";
+    }
+
+    for (size_t option_index = 2; option_index < arguments.size(); option_index += 2) {
+        if (option_index + 1 == arguments.size()) {
+            return "ERR syntax error";
+        }
+        std::string_view option_value = arguments[option_index + 1];
+        if (CommandIs(arguments[option_index], "COUNT")) {
+            int64_t parsed_count = 0;
+            if (!ParseInteger(option_value, parsed_count) || parsed_count < 1) {
+                return "ERR value is out of range, must be positive";
+            }
+            count = static_cast<size_t>(parsed_count);
+        } else if (CommandIs(arguments[option_index], "MATCH")) {
+            if (!MatchPrefix(option_value, prefix)) {
+                return "ERR only MATCH patterns of the form prefix* are supported";
+            }
+        } else {
+            return "ERR syntax error";
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Append the reply for a TTL or PTTL query, scaling milliseconds to seconds for TTL.
+ */
+void AppendTtlReply(std::string& reply, int64_t remaining_millis, bool in_seconds) {
+    if (remaining_millis < 0 || !in_seconds) {
+        AppendRespInteger(reply, remaining_millis);
+    } else {
+        // Round up like Redis so a key with time left never reports 0
+        AppendRespInteger(reply, (remaining_millis + 999) / 1000);
+    }
+}
+
+/**
+ * @brief Append the standard wrong-arity error for a command.
+ */
+void AppendArityError(std::string& reply, std::string_view command_name) {
+    std::string message = "ERR wrong number of arguments for '";
+    for (char character : command_name) {
+        message += static_cast<char>(std::tolower(static_cast<unsigned char>(character)));
+    }
+    message += "' command";
+    AppendRespError(reply, message);
+}
+
+/**
+ * @brief Whether a command changes the store, and so is refused on a replica.
+ */
+bool IsWriteCommand(std::string_view command_name) {
+    for (const char* write_command : {"SET", "MSET", "DEL", "EXPIRE", "PEXPIRE", "PERSIST", "INCR", "INCRBY", "DECR",
+                                      "DECRBY", "APPEND", "CAS", "FLUSHALL", "FLUSHDB"}) {
+        if (CommandIs(command_name, write_command)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Append the replication section of INFO, in the field names Redis tools expect.
+ */
+void AppendReplicationInfo(std::string& info, const ReplicationStatus& status) {
+    info += "# Replication\r\n";
+    if (status.replica) {
+        info += "role:slave\r\n";
+        info += status.connected ? "master_link_status:up\r\n" : "master_link_status:down\r\n";
+        info += "slave_repl_offset:" + std::to_string(status.appliedOffset) + "\r\n";
+        info += "master_repl_offset:" + std::to_string(status.primaryOffset) + "\r\n";
+        info += "repl_lag_bytes:" + std::to_string(status.lagBytes) + "\r\n";
+        info += "repl_lag_ms:" + std::to_string(status.lagMillis) + "\r\n";
+        info += "full_syncs:" + std::to_string(status.fullSyncs) + "\r\n";
+    } else {
+        info += "role:master\r\n";
+        info += "connected_slaves:" + std::to_string(status.connectedReplicas) + "\r\n";
+        info += "master_repl_offset:" + std::to_string(status.primaryOffset) + "\r\n";
+        info += "full_syncs:" + std::to_string(status.fullSyncs) + "\r\n";
+    }
+}
+
+/**
+ * @brief Append the stats section shared by STATS and INFO, one field per line.
+ */
+void AppendStatsInfo(std::string& info, const StoreStats& stats) {
+    char hit_ratio[32];
+    std::snprintf(hit_ratio, sizeof(hit_ratio), "%.4f", stats.hitRatio());
+
+    info += "# Stats\r\n";
+    info += "gets:" + std::to_string(stats.gets) + "\r\n";
+    info += "keyspace_hits:" + std::to_string(stats.hits) + "\r\n";
+    info += "keyspace_misses:" + std::to_string(stats.misses) + "\r\n";
+    info += "hit_ratio:" + std::string(hit_ratio) + "\r\n";
+    info += "puts:" + std::to_string(stats.puts) + "\r\n";
+    info += "deletes:" + std::to_string(stats.deletes) + "\r\n";
+    info += "evicted_keys:" + std::to_string(stats.evictions) + "\r\n";
+    info += "expired_keys:" + std::to_string(stats.expirations) + "\r\n";
+    info += "keys:" + std::to_string(stats.keys) + "\r\n";
+    info += "used_memory:" + std::to_string(stats.bytes) + "\r\n";
+    info += "lock_contentions:" + std::to_string(stats.lockContentions) + "\r\n";
+    info += "lock_wait_us:" + std::to_string(stats.lockWaitNanos / 1000) + "\r\n";
+    char fragmentation[32];
+    std::snprintf(fragmentation, sizeof(fragmentation), "%.4f", stats.slab.fragmentation());
+    info += "slab_page_bytes:" + std::to_string(stats.slab.pageBytes) + "\r\n";
+    info += "slab_chunk_bytes:" + std::to_string(stats.slab.chunkBytes) + "\r\n";
+    info += "slab_requested_bytes:" + std::to_string(stats.slab.requestedBytes) + "\r\n";
+    info += "slab_heap_bytes:" + std::to_string(stats.slab.heapBytes) + "\r\n";
+    info += "slab_fragmentation:" + std::string(fragmentation) + "\r\n";
+    char compression_ratio[32];
+    std::snprintf(compression_ratio, sizeof(compression_ratio), "%.4f", stats.compression.ratio());
+    info += "compressed_values:" + std::to_string(stats.compression.compressedValues) + "\r\n";
+    info += "incompressible_values:" + std::to_string(stats.compression.incompressibleValues) + "\r\n";
+    info += "compression_input_bytes:" + std::to_string(stats.compression.inputBytes) + "\r\n";
+    info += "compression_output_bytes:" + std::to_string(stats.compression.outputBytes) + "\r\n";
+    info += "compression_ratio:" + std::string(compression_ratio) + "\r\n";
+    info += "compress_us:" + std::to_string(stats.compression.compressNanos / 1000) + "\r\n";
+    info += "decompressions:" + std::to_string(stats.compression.decompressions) + "\r\n";
+    info += "decompress_us:" + std::to_string(stats.compression.decompressNanos / 1000) + "\r\n";
+    info += "near_cache_hits:" + std::to_string(stats.nearCacheHits) + "\r\n";
+    info += "near_cache_fills:" + std::to_string(stats.nearCacheFills) + "\r\n";
+    for (size_t key_index = 0; key_index < stats.hotKeys.size(); ++key_index) {
+        info += "hot_key" + std::to_string(key_index) + ":key=" + stats.hotKeys[key_index].key;
+        info += ",reads=" + std::to_string(stats.hotKeys[key_index].reads) + "\r\n";
+    }
+    for (size_t shard_index = 0; shard_index < stats.shards.size(); ++shard_index) {
+        const ShardStats& shard = stats.shards[shard_index];
+        info += "shard" + std::to_string(shard_index) + ":keys=" + std::to_string(shard.keys);
+        info += ",bytes=" + std::to_string(shard.bytes);
+        info += ",evictions=" + std::to_string(shard.evictions);
+        info += ",expirations=" + std::to_string(shard.expirations);
+        info += ",lock_contentions=" + std::to_string(shard.lockContentions);
+        info += ",lock_wait_us=" + std::to_string(shard.lockWaitNanos / 1000);
+        info += ",slab_page_bytes=" + std::to_string(shard.slab.pageBytes);
+        info += ",slab_requested_bytes=" + std::to_string(shard.slab.requestedBytes) + "\r\n";
+    }
+}
+
+/**
+ * @brief Append the latency section shared by LATENCY and INFO, one operation per line.
+ */
+void AppendLatencyInfo(std::string& info, const std::vector<LatencySummary>& summaries) {
+    info += "# Latencystats\r\n";
+    info += kLatencyTracking ? "latency_tracking:enabled\r\n" : "latency_tracking:disabled\r\n";
+    char line[256];
+    for (const LatencySummary& summary : summaries) {
+        std::snprintf(line, sizeof(line),
+                      "latency_percentiles_usec_%s:p50=%.3f,p90=%.3f,p99=%.3f,p99.9=%.3f,max=%.3f,count=%llu\r\n",
+                      LatencyOpName(summary.op), static_cast<double>(summary.p50Nanos) / 1000.0,
+                      static_cast<double>(summary.p90Nanos) / 1000.0, static_cast<double>(summary.p99Nanos) / 1000.0,
+                      static_cast<double>(summary.p999Nanos) / 1000.0, static_cast<double>(summary.maxNanos) / 1000.0,
+                      static_cast<unsigned long long>(summary.count));
+        info += line;
+    }
+}
+
+} // namespace
+
+// ========================================
+// Request parsing
+// ========================================
+
+RespParseStatus ParseRespRequest(const char* data, size_t length,
+                                 std::vector<std::string_view>& arguments, size_t& consumed) {
+    arguments.clear();
+    if (length == 0) {
+        return RespParseStatus::Incomplete;
+    }
+    if (data[0] != '*') {
+        RespParseStatus inline_status = ParseInlineRequest(data, length, arguments, consumed);
+        if (inline_status != RespParseStatus::Complete) {
+            arguments.clear();
+        }
+        return inline_status;
+    }
+
+    int64_t argument_count = 0;
+    size_t position = 0;
+    RespParseStatus header_status = ParseHeaderLine(data, length, argument_count, position);
+    if (header_status != RespParseStatus::Complete) {
+        return header_status;
+    }
+    if (argument_count > kMaxArgumentCount) {
+        return RespParseStatus::Error;
+    }
+
+    for (int64_t argument_index = 0; argument_index < argument_count; ++argument_index) {
+        if (position >= length) {
+            arguments.clear();
+            return RespParseStatus::Incomplete;
+        }
+        if (data[position] != '$') {
+            arguments.clear();
+            return RespParseStatus::Error;
+        }
+
+        int64_t bulk_length = 0;
+        size_t header_length = 0;
+        header_status = ParseHeaderLine(data + position, length - position, bulk_length, header_length);
+        if (header_status != RespParseStatus::Complete) {
+            arguments.clear();
+            return header_status;
+        }
+        if (bulk_length < 0 || static_cast<size_t>(bulk_length) > kMaxBulkLength) {
+            arguments.clear();
+            return RespParseStatus::Error;
+        }
+
+        position += header_length;
+        size_t payload_length = static_cast<size_t>(bulk_length);
+        if (length - position < payload_length + 2) {
+            arguments.clear();
+            return RespParseStatus::Incomplete;
+        }
+        if (data[position + payload_length] != '\r' || data[position + payload_length + 1] != '\n') {
+            arguments.clear();
+            return RespParseStatus::Error;
+        }
+
+        arguments.emplace_back(data + position, payload_length);
+        position += payload_length + 2;
+    }
+
+    consumed = position;
+    return RespParseStatus::Complete;
+}
+
+// ========================================
+// Reply encoding
+// ========================================
+
+void AppendRespSimpleString(std::string& reply, std::string_view text) {
+    reply += '+';
+    reply.append(text.data(), text.size());
+    reply += "\r\n";
+}
+
+void AppendRespError(std::string& reply, std::string_view message) {
+    reply += '-';
+    reply.append(message.data(), message.size());
+    reply += "\r\n";
+}
+
+void AppendRespInteger(std::string& reply, int64_t value) {
+    char digits[24];
+    auto conversion = std::to_chars(digits, digits + sizeof(digits), value);
+    reply += ':';
+    reply.append(digits, conversion.ptr);
+    reply += "\r\n";
+}
+
+void AppendRespBulkString(std::string& reply, std::string_view payload) {
+    AppendRespAggregateHeader(reply, '$', payload.size());
+    reply.append(payload.data(), payload.size());
+    reply += "\r\n";
+}
+
+void AppendRespAggregateHeader(std::string& reply, char type_prefix, size_t count) {
+    char digits[24];
+    auto conversion = std::to_chars(digits, digits + sizeof(digits), count);
+    reply += type_prefix;
+    reply.append(digits, conversion.ptr);
+    reply += "\r\n";
+}
+
+// ========================================
+// RespSession
+// ========================================
+
+RespSession::RespSession(Store& target_store, SessionOptions options)
+    : store(target_store), sessionOptions(std::move(options)) {}
+
+void RespSession::appendNull(std::string& reply) const {
+    reply += respVersion >= 3 ? "_\r\n" : "$-1\r\n";
+}
+
+void RespSession::appendEmptyMap(std::string& reply) const {
+    reply += respVersion >= 3 ? "%0\r\n" : "*0\r\n";
+}
+
+void RespSession::appendHello(std::string& reply) const {
+    // RESP3 clients expect a map; RESP2 gets the same pairs as a flat array
+    AppendRespAggregateHeader(reply, respVersion >= 3 ? '%' : '*', respVersion >= 3 ? 6 : 12);
+    AppendRespBulkString(reply, "server");
+    AppendRespBulkString(reply, "storm");
+    AppendRespBulkString(reply, "version");
+    AppendRespBulkString(reply, "1.0.0");
+    AppendRespBulkString(reply, "proto");
+    AppendRespInteger(reply, respVersion);
+    AppendRespBulkString(reply, "mode");
+    AppendRespBulkString(reply, "standalone");
+    AppendRespBulkString(reply, "role");
+    AppendRespBulkString(reply, sessionOptions.readOnly ? "replica" : "master");
+    AppendRespBulkString(reply, "modules");
+    AppendRespAggregateHeader(reply, '*', 0);
+}
+
+/**
+ * @brief Execute one parsed request and append its encoded reply.
+ * @param arguments Command name followed by its arguments.
+ * @param reply Output buffer.
+ * @return Status Close after QUIT, Continue otherwise.
+ */
+RespSession::Status RespSession::execute(const std::vector<std::string_view>& arguments, std::string& reply) {
+    if (arguments.empty()) {
+        return Status::Continue; // Blank inline line or *0
+    }
+
+    std::string_view command_name = arguments[0];
+    size_t argument_count = arguments.size();
+
+    if (sessionOptions.readOnly && IsWriteCommand(command_name)) {
+        AppendRespError(reply, "READONLY You can't write against a read only replica.");
+        return Status::Continue;
+    }
+
+    // ===========================
+    // Command: GET key
+    // ===========================
+    if (CommandIs(command_name, "GET")) {
+        if (argument_count != 2) {
+            AppendArityError(reply, command_name);
+        } else {
+            ValueHandle value = store.get(arguments[1]);
+            if (value) {
+                AppendRespBulkString(reply, value.view());
+            } else {
+                appendNull(reply);
+            }
+        }
+    }
+    // ===========================
+    // Command: SET key value
+    // ===========================
+    else if (CommandIs(command_name, "SET")) {
+        int64_t expire_amount = 0;
+        if (argument_count < 3) {
+            AppendArityError(reply, command_name);
+        } else if (argument_count == 3) {
+            if (store.put(arguments[1], arguments[2])) {
+                AppendRespSimpleString(reply, "OK");
+            } else {
+                AppendRespError(reply, "ERR object too large");
+            }
+        } else if (argument_count != 5 || !(CommandIs(arguments[3], "EX") || CommandIs(arguments[3], "PX"))) {
+            AppendRespError(reply, "ERR syntax error");
+        } else if (!ParseInteger(arguments[4], expire_amount)) {
+            AppendRespError(reply, "ERR value is not an integer or out of range");
+        } else if (expire_amount <= 0 || (CommandIs(arguments[3], "EX") && expire_amount > INT64_MAX / 1000)) {
+            AppendRespError(reply, "ERR invalid expire time in 'set' command");
+        } else {
+            // SET key value EX seconds | PX milliseconds
+            int64_t ttl_millis = CommandIs(arguments[3], "EX") ? expire_amount * 1000 : expire_amount;
+            if (store.put(arguments[1], arguments[2], std::chrono::milliseconds(ttl_millis))) {
+                AppendRespSimpleString(reply, "OK");
+            } else {
+                AppendRespError(reply, "ERR object too large");
+            }
+        }
+    }
+    // ===========================
+    // Commands: EXPIRE key seconds, PEXPIRE key milliseconds
+    // ===========================
+    else if (CommandIs(command_name, "EXPIRE") || CommandIs(command_name, "PEXPIRE")) {
+        int64_t expire_amount = 0;
+        bool in_seconds = CommandIs(command_name, "EXPIRE");
+        if (argument_count != 3) {
+            AppendArityError(reply, command_name);
+        } else if (!ParseInteger(arguments[2], expire_amount) ||
+                   (in_seconds && (expire_amount > INT64_MAX / 1000 || expire_amount < INT64_MIN / 1000))) {
+            AppendRespError(reply, "ERR value is not an integer or out of range");
+        } else {
+            int64_t ttl_millis = in_seconds ? expire_amount * 1000 : expire_amount;
+            AppendRespInteger(reply, store.expire(arguments[1], std::chrono::milliseconds(ttl_millis)) ? 1 : 0);
+        }
+    }
+    // ===========================
+    // Commands: TTL key, PTTL key
+    // ===========================
+    else if (CommandIs(command_name, "TTL") || CommandIs(command_name, "PTTL")) {
+        if (argument_count != 2) {
+            AppendArityError(reply, command_name);
+        } else {
+            AppendTtlReply(reply, store.ttl(arguments[1]), CommandIs(command_name, "TTL"));
+        }
+    }
+    // ===========================
+    // Command: PERSIST key
+    // ===========================
+    else if (CommandIs(command_name, "PERSIST")) {
+        if (argument_count != 2) {
+            AppendArityError(reply, command_name);
+        } else {
+            AppendRespInteger(reply, store.persist(arguments[1]) ? 1 : 0);
+        }
+    }
+    // ===========================
+    // Commands: INCR key, DECR key, INCRBY key delta, DECRBY key delta
+    // ===========================
+    else if (CommandIs(command_name, "INCR") || CommandIs(command_name, "DECR") ||
+             CommandIs(command_name, "INCRBY") || CommandIs(command_name, "DECRBY")) {
+        bool by_amount = CommandIs(command_name, "INCRBY") || CommandIs(command_name, "DECRBY");
+        bool decrement = CommandIs(command_name, "DECR") || CommandIs(command_name, "DECRBY");
+        int64_t delta = 1;
+        int64_t new_value = 0;
+        if (argument_count != (by_amount ? 3u : 2u)) {
+            AppendArityError(reply, command_name);
+        } else if (by_amount && (!ParseInteger(arguments[2], delta) || (decrement && delta == INT64_MIN))) {
+            AppendRespError(reply, "ERR value is not an integer or out of range");
+        } else if (!store.incrBy(arguments[1], decrement ? -delta : delta, new_value)) {
+            AppendRespError(reply, "ERR value is not an integer or out of range");
+        } else {
+            AppendRespInteger(reply, new_value);
+        }
+    }
+    // ===========================
+    // Command: APPEND key value
+    // ===========================
+    else if (CommandIs(command_name, "APPEND")) {
+        size_t new_length = 0;
+        if (argument_count != 3) {
+            AppendArityError(reply, command_name);
+        } else if (!store.append(arguments[1], arguments[2], new_length)) {
+            AppendRespError(reply, "ERR object too large");
+        } else {
+            AppendRespInteger(reply, static_cast<int64_t>(new_length));
+        }
+    }
+    // ===========================
+    // Command: CAS key expected desired (not in Redis; replies 1 if swapped, else 0)
+    // ===========================
+    else if (CommandIs(command_name, "CAS")) {
+        if (argument_count != 4) {
+            AppendArityError(reply, command_name);
+        } else {
+            AppendRespInteger(reply, store.compareAndSet(arguments[1], arguments[2], arguments[3]) ? 1 : 0);
+        }
+    }
+    // ===========================
+    // Command: DEL key [key ...]
+    // ===========================
+    else if (CommandIs(command_name, "DEL")) {
+        if (argument_count < 2) {
+            AppendArityError(reply, command_name);
+        } else {
+            keyScratch.assign(arguments.begin() + 1, arguments.end());
+            AppendRespInteger(reply, static_cast<int64_t>(store.delMany(keyScratch)));
+        }
+    }
+    // ===========================
+    // Command: EXISTS key [key ...]
+    // ===========================
+    else if (CommandIs(command_name, "EXISTS")) {
+        if (argument_count < 2) {
+            AppendArityError(reply, command_name);
+        } else {
+            keyScratch.assign(arguments.begin() + 1, arguments.end());
+            AppendRespInteger(reply, static_cast<int64_t>(store.getMany(keyScratch, valueScratch)));
+            valueScratch.clear();
+        }
+    }
+    // ===========================
+    // Command: MGET key [key ...]
+    // ===========================
+    else if (CommandIs(command_name, "MGET")) {
+        if (argument_count < 2) {
+            AppendArityError(reply, command_name);
+        } else {
+            keyScratch.assign(arguments.begin() + 1, arguments.end());
+            store.getMany(keyScratch, valueScratch);
+
+            AppendRespAggregateHeader(reply, '*', argument_count - 1);
+            for (const ValueHandle& value : valueScratch) {
+                if (value) {
+                    AppendRespBulkString(reply, value.view());
+                } else {
+                    appendNull(reply);
+                }
+            }
+            valueScratch.clear();
+        }
+    }
+    // ===========================
+    // Command: MSET key value [key value ...]
+    // ===========================
+    else if (CommandIs(command_name, "MSET")) {
+        if (argument_count < 3 || argument_count % 2 == 0) {
+            AppendArityError(reply, command_name);
+        } else {
+            batchScratch.resize((argument_count - 1) / 2);
+            for (size_t pair_index = 0; pair_index < batchScratch.size(); ++pair_index) {
+                batchScratch[pair_index].first.assign(arguments[1 + pair_index * 2]);
+                batchScratch[pair_index].second.assign(arguments[2 + pair_index * 2]);
+            }
+            store.putMany(batchScratch);
+            AppendRespSimpleString(reply, "OK");
+        }
+    }
+    // ===========================
+    // Command: SCAN cursor [MATCH prefix*] [COUNT count]
+    // ===========================
+    else if (CommandIs(command_name, "SCAN")) {
+        uint64_t cursor = 0;
+        size_t count = Store::kDefaultScanCount;
+        std::string_view prefix;
+        if (argument_count < 2) {
+            AppendArityError(reply, command_name);
+        } else if (const char* error = ParseScanArguments(arguments, cursor, count, prefix)) {
+            AppendRespError(reply, error);
+        } else {
+            ScanResult scan_result = store.scan(cursor, count, prefix);
+            AppendRespAggregateHeader(reply, '*', 2);
+            AppendRespBulkString(reply, std::to_string(scan_result.cursor));
+            AppendRespAggregateHeader(reply, '*', scan_result.keys.size());
+            for (const std::string& key : scan_result.keys) {
+                AppendRespBulkString(reply, key);
+            }
+        }
+    }
+    // ===========================
+    // Command: PING [message]
+    // ===========================
+    else if (CommandIs(command_name, "PING")) {
+        if (argument_count == 1) {
+            AppendRespSimpleString(reply, "PONG");
+        } else if (argument_count == 2) {
+            AppendRespBulkString(reply, arguments[1]);
+        } else {
+            AppendArityError(reply, command_name);
+        }
+    }
+    // ===========================
+    // Command: ECHO message
+    // ===========================
+    else if (CommandIs(command_name, "ECHO")) {
+        if (argument_count != 2) {
+            AppendArityError(reply, command_name);
+        } else {
+            AppendRespBulkString(reply, arguments[1]);
+        }
+    }
+    // ===========================
+    // Command: HELLO [protover]
+    // ===========================
+    else if (CommandIs(command_name, "HELLO")) {
+        if (argument_count >= 2) {
+            if (arguments[1] == "2" || arguments[1] == "3") {
+                respVersion = arguments[1][0] - '0';
+            } else {
+                AppendRespError(reply, "NOPROTO unsupported protocol version");
+                return Status::Continue;
+            }
+        }
+        appendHello(reply);
+    }
+    // ===========================
+    // Commands: COMMAND, CONFIG GET (client handshakes)
+    // ===========================
+    else if (CommandIs(command_name, "COMMAND")) {
+        AppendRespAggregateHeader(reply, '*', 0);
+    } else if (CommandIs(command_name, "CONFIG")) {
+        if (argument_count >= 2 && CommandIs(arguments[1], "GET")) {
+            appendEmptyMap(reply);
+        } else {
+            AppendRespError(reply, "ERR unsupported CONFIG subcommand");
+        }
+    }
+    // ===========================
+    // Command: STATS
+    // ===========================
+    else if (CommandIs(command_name, "STATS")) {
+        std::string info;
+        AppendStatsInfo(info, store.stats());
+        AppendRespBulkString(reply, info);
+    }
+    // ===========================
+    // Command: LATENCY [RESET]
+    // ===========================
+    else if (CommandIs(command_name, "LATENCY")) {
+        if (argument_count == 1) {
+            std::string info;
+            AppendLatencyInfo(info, store.latency());
+            AppendRespBulkString(reply, info);
+        } else if (argument_count == 2 && CommandIs(arguments[1], "RESET")) {
+            store.resetLatency();
+            AppendRespSimpleString(reply, "OK");
+        } else {
+            AppendRespError(reply, "ERR unsupported LATENCY subcommand");
+        }
+    }
+    // ===========================
+    // Command: INFO [section]
+    // ===========================
+    else if (CommandIs(command_name, "INFO")) {
+        if (argument_count > 2) {
+            AppendArityError(reply, command_name);
+        } else {
+            // Sections: stats, latencystats, and replication; asking for any other yields an empty report
+            std::string info;
+            bool every_section = argument_count == 1 || CommandIs(arguments[1], "ALL") ||
+                                 CommandIs(arguments[1], "EVERYTHING") || CommandIs(arguments[1], "DEFAULT");
+            if (every_section || CommandIs(arguments[1], "STATS")) {
+                AppendStatsInfo(info, store.stats());
+            }
+            if (every_section || CommandIs(arguments[1], "LATENCYSTATS")) {
+                AppendLatencyInfo(info, store.latency());
+            }
+            if (every_section || CommandIs(arguments[1], "REPLICATION")) {
+                AppendReplicationInfo(info, sessionOptions.replicationStatus ? sessionOptions.replicationStatus()
+                                                                             : ReplicationStatus{});
+            }
+            AppendRespBulkString(reply, info);
+        }
+    }
+    // ===========================
+    // Commands: FLUSHALL [ASYNC|SYNC], FLUSHDB [ASYNC|SYNC]
+    // ===========================
+    else if (CommandIs(command_name, "FLUSHALL") || CommandIs(command_name, "FLUSHDB")) {
+        bool asynchronous = argument_count == 2 && CommandIs(arguments[1], "ASYNC");
+        if (argument_count > 2 || (argument_count == 2 && !asynchronous && !CommandIs(arguments[1], "SYNC"))) {
+            AppendRespError(reply, "ERR syntax error");
+        } else {
+            // Either way the keys are gone on return; SYNC also waits for their memory to be freed
+            store.clear();
+            if (!asynchronous) {
+                store.waitForReclamation();
+            }
+            AppendRespSimpleString(reply, "OK");
+        }
+    }
+    // ===========================
+    // Command: QUIT
+    // ===========================
+    else if (CommandIs(command_name, "QUIT")) {
+        AppendRespSimpleString(reply, "OK");
+        return Status::Close;
+    }
+    // ===========================
+    // Unknown command
+    // ===========================
+    else {
+        std::string message = "ERR unknown command '";
+        message.append(command_name.data(), command_name.size());
+        message += "'";
+        AppendRespError(reply, message);
+    }
+
+    return Status::Continue;
+}
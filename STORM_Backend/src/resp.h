@@ -0,0 +1,114 @@
+#pragma once
+
+#include "replication.h"
+#include "store.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief RESP (REdis Serialization Protocol) support for the network front end.
+ *
+ * Requests are parsed in place: argument views point straight into the
+ * connection's receive buffer and stay valid until that buffer is consumed.
+ * Replies are appended to a caller-owned output buffer in RESP2 or, after
+ * HELLO 3, RESP3 encoding.
+ */
+
+/**
+ * @brief Outcome of parsing one request from a buffer.
+ */
+enum class RespParseStatus {
+    Complete,   ///< A full request was parsed; arguments and consumed are set
+    Incomplete, ///< More bytes are needed; nothing was consumed
+    Error       ///< The bytes are not valid RESP; the connection should be closed
+};
+
+/**
+ * @brief Parse one request (multibulk array or inline command) from a buffer.
+ * @param data Start of unparsed bytes.
+ * @param length Number of unparsed bytes.
+ * @param arguments Output; cleared and filled with views into data on Complete.
+ * @param consumed Output; number of bytes making up the request on Complete.
+ * @return RespParseStatus Whether a complete request was found.
+ *
+ * The parser keeps no state between calls, so an Incomplete request is simply
+ * parsed again from its first byte once more data has arrived. Bulk lengths
+ * let the retry skip over payload bytes without scanning them.
+ */
+RespParseStatus ParseRespRequest(const char* data, size_t length,
+                                 std::vector<std::string_view>& arguments, size_t& consumed);
+
+/**
+ * @brief Executes RESP commands against a Store for one connection.
+ *
+ * Supported commands: GET, SET (with EX/PX), DEL, MGET, MSET, EXISTS, SCAN,
+ * EXPIRE, PEXPIRE, TTL, PTTL, PERSIST, INCR, INCRBY, DECR, DECRBY, APPEND,
+ * CAS key expected desired (an extension; 1 if swapped, else 0), PING,
+ * ECHO, HELLO, COMMAND,
+ * CONFIG GET, FLUSHALL and FLUSHDB [ASYNC|SYNC], STATS, LATENCY [RESET],
+ * INFO [stats|latencystats|replication], and QUIT. A read-only session (a replica) answers writes with a READONLY error.
+ */
+class RespSession {
+public:
+    /**
+     * @brief Outcome of executing a command.
+     */
+    enum class Status {
+        Continue, ///< Connection stays open
+        Close     ///< QUIT was received; close after flushing the reply
+    };
+
+    /**
+     * @brief Construct a session; connections start in RESP2.
+     * @param targetStore Store that commands operate on.
+     * @param options Read-only mode and replication status source.
+     */
+    explicit RespSession(Store& targetStore, SessionOptions options = {});
+
+    /**
+     * @brief Execute one parsed request.
+     * @param arguments Command name followed by its arguments.
+     * @param reply Output buffer; the encoded reply is appended to it.
+     * @return Status Whether the connection should stay open.
+     */
+    Status execute(const std::vector<std::string_view>& arguments, std::string& reply);
+
+    /**
+     * @brief Protocol version negotiated with HELLO (2 or 3).
+     */
+    int protocolVersion() const { return respVersion; }
+
+private:
+    Store& store;                                         ///< Store shared by all sessions
+    SessionOptions sessionOptions;                        ///< Read-only mode and replication status
+    int respVersion = 2;                                  ///< Reply encoding in use
+    std::vector<std::pair<std::string, std::string>> batchScratch; ///< Reused MSET batch
+    std::vector<std::string_view> keyScratch;             ///< Reused key list for MGET, DEL, EXISTS
+    std::vector<ValueHandle> valueScratch;                ///< Reused MGET results; cleared after each reply
+
+    void appendNull(std::string& reply) const;
+    void appendEmptyMap(std::string& reply) const;
+    void appendHello(std::string& reply) const;
+};
+
+// ========================================
+// Reply encoding helpers
+// ========================================
+
+/** @brief Append +text\r\n. */
+void AppendRespSimpleString(std::string& reply, std::string_view text);
+
+/** @brief Append -message\r\n. */
+void AppendRespError(std::string& reply, std::string_view message);
+
+/** @brief Append :value\r\n. */
+void AppendRespInteger(std::string& reply, int64_t value);
+
+/** @brief Append $length\r\npayload\r\n. */
+void AppendRespBulkString(std::string& reply, std::string_view payload);
+
+/** @brief Append an aggregate header such as *count\r\n or %count\r\n. */
+void AppendRespAggregateHeader(std::string& reply, char typePrefix, size_t count);
@@ -1,65 +1,339 @@
+#include "command_processor.h"
+#include "net_server.h"
+#include "replication.h"
 #include "store.h"
-#include <iostream>
-#include <sstream>
-#include <deque>
 #include <algorithm>
-#include <cctype>
+#include <csignal>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <pthread.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+
+/**
+ * @brief Command-line configuration for the server binary.
+ */
+struct ServerOptions {
+    bool listenMode = false;          ///< Serve over TCP instead of stdin
+    bool batchMode = false;           ///< Execute stdin in bulk with batched PUTs, without a prompt
+    bool quiet = false;               ///< Batch mode: discard replies instead of writing them
+    NetServerConfig network;          ///< Listener settings for listen mode
+    size_t shardCapacity = 100;       ///< Maximum keys per shard
+    size_t shardCount = 16;           ///< Number of shards
+    size_t batchWorkers = 0;          ///< Threads for large batch operations; 0 = run inline
+    size_t memoryBudget = 0;          ///< Total bytes for entries; 0 = bounded by key count only
+    size_t maxValueBytes = 0;         ///< Largest accepted value; 0 = no limit
+    size_t compressionThreshold = 0;  ///< Smallest value stored LZ4-compressed; 0 = off
+    size_t nearCacheSlots = 0;        ///< Per-thread near-cache slots for hot keys; 0 = off
+    bool numaAware = false;           ///< Place shards and event loops on NUMA nodes
+    std::string appendLogPath;        ///< Append-only log to replay and extend; empty = no persistence
+    FsyncPolicy fsyncPolicy = FsyncPolicy::EverySecond; ///< When the log is fsynced
+    std::string snapshotPath;         ///< Snapshot to load at startup and write at shutdown; empty = none
+    uint16_t replicatePort = 0;       ///< Port that serves replicas; 0 = not a primary
+    std::string primaryHost;          ///< Primary to follow; empty = not a replica
+    uint16_t primaryPort = 0;         ///< Replication port of primaryHost
+};
+
+/**
+ * @brief Print command-line usage.
+ * @param programName argv[0].
+ */
+void PrintUsage(const char* programName) {
+    std::cerr << "Usage: " << programName << " [options]\n"
+              << "  --listen PORT      serve the line protocol over TCP instead of stdin\n"
+              << "  --batch            execute stdin non-interactively, batching PUTs (mmaps a redirected file)\n"
+              << "  --quiet            with --batch, discard replies\n"
+              << "  --bind ADDRESS     IPv4 address to listen on (default 0.0.0.0)\n"
+              << "  --threads N        event loops in listen mode (default: one per core)\n"
+              << "  --shards N         number of shards (default 16)\n"
+              << "  --capacity N       maximum keys per shard (default 100; 0 = bounded by --memory only)\n"
+              << "  --workers N        threads that split large MSET/MGET/DEL batches across shards (default 0: off)\n"
+              << "  --memory BYTES     memory budget for keys and values, e.g. 512M or 2G (default 0: unlimited)\n"
+              << "  --max-value BYTES  reject values larger than this, e.g. 1M (default 0: no limit)\n"
+              << "  --compress BYTES   store values of at least BYTES LZ4-compressed, e.g. 1K (default 0: off)\n"
+              << "  --near-cache N     serve hot keys from an N-slot cache per thread, lock-free (default 0: off)\n"
+              << "  --numa             spread shards over NUMA nodes and pin event loops next to them\n"
+              << "  --aof PATH         replay PATH at startup and append every write to it\n"
+              << "  --fsync POLICY     when the log is fsynced: always, everysec (default), or no\n"
+              << "  --snapshot PATH    load PATH at startup and rewrite it on shutdown (compacting the log)\n"
+              << "  --replicate-port P stream every write to replicas that connect to port P\n"
+              << "  --replica-of H:P   follow the primary at H:P; serves reads only\n";
+}
 
 /**
- * @brief Trim leading and trailing whitespace from a string.
- * @param inputString String to trim.
- * @return std::string Trimmed string.
+ * @brief Parse a byte count with an optional K, M, or G suffix (powers of 1024).
+ * @param text Argument text.
+ * @param bytes Output parameter for the parsed count.
+ * @return true If text was a valid byte count.
  */
-std::string TrimWhitespace(const std::string& inputString) {
-    std::string trimmedString = inputString;
-
-    // Trim leading whitespace
-    trimmedString.erase(
-        trimmedString.begin(),
-        std::find_if(
-            trimmedString.begin(),
-            trimmedString.end(),
-            [](unsigned char character) { return !std::isspace(character); }
-        )
-    );
-
-    // Trim trailing whitespace
-    trimmedString.erase(
-        std::find_if(
-            trimmedString.rbegin(),
-            trimmedString.rend(),
-            [](unsigned char character) { return !std::isspace(character); }
-        ).base(),
-        trimmedString.end()
-    );
-
-    return trimmedString;
+bool ParseByteSize(const char* text, size_t& bytes) {
+    char* suffix = nullptr;
+    unsigned long long count = std::strtoull(text, &suffix, 10);
+    if (suffix == text) {
+        return false;
+    }
+
+    size_t shift = 0;
+    switch (*suffix) {
+        case '\0': break;
+        case 'k': case 'K': shift = 10; break;
+        case 'm': case 'M': shift = 20; break;
+        case 'g': case 'G': shift = 30; break;
+        default: return false;
+    }
+    if (*suffix != '\0' && suffix[1] != '\0') {
+        return false;
+    }
+
+    bytes = static_cast<size_t>(count) << shift;
+    return true;
 }
 
 /**
- * @brief Main entry point for the interactive Store CLI.
+ * @brief Parse command-line arguments.
+ * @param argc Argument count.
+ * @param argv Argument vector.
+ * @param options Output parameter for the parsed options.
+ * @return true If arguments were valid.
+ */
+bool ParseArguments(int argc, char** argv, ServerOptions& options) {
+    for (int index = 1; index < argc; ++index) {
+        std::string argument = argv[index];
+        bool has_value = index + 1 < argc;
+
+        if (argument == "--listen" && has_value) {
+            options.listenMode = true;
+            options.network.port = static_cast<uint16_t>(std::strtoul(argv[++index], nullptr, 10));
+        } else if (argument == "--bind" && has_value) {
+            options.network.bindAddress = argv[++index];
+        } else if (argument == "--threads" && has_value) {
+            options.network.loopCount = std::strtoul(argv[++index], nullptr, 10);
+        } else if (argument == "--shards" && has_value) {
+            options.shardCount = std::strtoul(argv[++index], nullptr, 10);
+        } else if (argument == "--capacity" && has_value) {
+            options.shardCapacity = std::strtoul(argv[++index], nullptr, 10);
+        } else if (argument == "--workers" && has_value) {
+            options.batchWorkers = std::strtoul(argv[++index], nullptr, 10);
+        } else if (argument == "--memory" && has_value) {
+            if (!ParseByteSize(argv[++index], options.memoryBudget)) return false;
+        } else if (argument == "--max-value" && has_value) {
+            if (!ParseByteSize(argv[++index], options.maxValueBytes)) return false;
+        } else if (argument == "--compress" && has_value) {
+            if (!ParseByteSize(argv[++index], options.compressionThreshold)) return false;
+        } else if (argument == "--near-cache" && has_value) {
+            options.nearCacheSlots = std::strtoul(argv[++index], nullptr, 10);
+        } else if (argument == "--aof" && has_value) {
+            options.appendLogPath = argv[++index];
+        } else if (argument == "--snapshot" && has_value) {
+            options.snapshotPath = argv[++index];
+        } else if (argument == "--fsync" && has_value) {
+            std::string policy = argv[++index];
+            if (policy == "always") {
+                options.fsyncPolicy = FsyncPolicy::Always;
+            } else if (policy == "everysec") {
+                options.fsyncPolicy = FsyncPolicy::EverySecond;
+            } else if (policy == "no") {
+                options.fsyncPolicy = FsyncPolicy::Never;
+            } else {
+                return false;
+            }
+        } else if (argument == "--replicate-port" && has_value) {
+            options.replicatePort = static_cast<uint16_t>(std::strtoul(argv[++index], nullptr, 10));
+            if (options.replicatePort == 0) return false;
+        } else if (argument == "--replica-of" && has_value) {
+            std::string primary = argv[++index];
+            size_t colon = primary.rfind(':');
+            if (colon == std::string::npos) return false;
+            options.primaryHost = primary.substr(0, colon);
+            options.primaryPort = static_cast<uint16_t>(std::strtoul(primary.c_str() + colon + 1, nullptr, 10));
+            if (options.primaryHost.empty() || options.primaryPort == 0) return false;
+        } else if (argument == "--batch") {
+            options.batchMode = true;
+        } else if (argument == "--quiet") {
+            options.quiet = true;
+        } else if (argument == "--numa") {
+            options.numaAware = true;
+            options.network.pinLoopsToNumaNodes = true;
+        } else {
+            return false;
+        }
+    }
+    return options.shardCount > 0 && (options.replicatePort == 0 || options.primaryHost.empty()) &&
+           !(options.batchMode && options.listenMode) && (options.batchMode || !options.quiet);
+}
+
+/**
+ * @brief Replay one log file into the store, cutting off a torn tail left by a crash.
+ * @param keyValueStore Store to apply the records to.
+ * @param path Log file.
+ * @throws std::system_error If the file cannot be read or truncated.
+ */
+void ReplayLogFile(Store& keyValueStore, const std::string& path) {
+    uint64_t valid_bytes = 0;
+    bool torn_tail = false;
+    {
+        AppendLogReader logReader(path);
+        size_t replayed_count = keyValueStore.replay(logReader);
+        valid_bytes = logReader.validBytes();
+        torn_tail = logReader.tornTail();
+        std::cout << "Replayed " << replayed_count << " log records from " << path << std::endl;
+    }
+    if (torn_tail) {
+        std::cerr << "Discarding torn log tail of " << path << " after byte " << valid_bytes << "\n";
+        if (::truncate(path.c_str(), static_cast<off_t>(valid_bytes)) != 0) {
+            throw std::system_error(errno, std::generic_category(), "truncate " + path);
+        }
+    }
+}
+
+/**
+ * @brief Rebuild the store from its append-only log, then log every later write to it.
+ * @param keyValueStore Store, already loaded from the snapshot if there is one.
+ * @param options Log path and fsync policy.
+ * @return true If the log is attached; false if it could not be read or opened.
  *
- * Provides commands:
- *  - PUT key value    : Insert or update a key-value pair
- *  - GET key          : Retrieve the value for a key
- *  - DEL key          : Delete a key
- *  - LIST             : Display all keys and values
- *  - CLEAR            : Remove all keys
- *  - HELP             : Show available commands
- *  - HISTORY          : Show recent commands
- *  - EXIT             : Exit CLI
+ * A PATH.next file is what a compaction interrupted by a crash left behind:
+ * it is replayed after the log with the log already attached, so its
+ * records are carried into the log before it is removed.
  */
-int main() {
-    // Create the in-memory key-value store
-    Store keyValueStore;
+bool AttachAppendLog(Store& keyValueStore, const ServerOptions& options) {
+    const std::string& path = options.appendLogPath;
+    std::string next_path = path + ".next";
+    try {
+        if (::access(path.c_str(), F_OK) == 0) {
+            ReplayLogFile(keyValueStore, path);
+        }
+        auto appendLog = std::make_shared<AppendLog>(path, options.fsyncPolicy);
+        keyValueStore.setAppendLog(appendLog);
+
+        if (::access(next_path.c_str(), F_OK) == 0) {
+            ReplayLogFile(keyValueStore, next_path);
+            if (!appendLog->sync()) {
+                return false;
+            }
+            ::unlink(next_path.c_str());
+            SyncParentDirectory(next_path);
+        }
+    } catch (const std::system_error& error) {
+        std::cerr << "Failed to open append log: " << error.what() << "\n";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Load the startup snapshot, if one exists, into a store built with its hash seed.
+ * @param options Server options; the snapshot path may be empty.
+ * @param storeOptions Store options; hashSeed is taken from the snapshot.
+ * @return std::unique_ptr<SnapshotReader> Mapped snapshot, or nullptr if there is none.
+ * @throws std::system_error If the file exists but is not a valid snapshot.
+ */
+std::unique_ptr<SnapshotReader> OpenSnapshot(const ServerOptions& options, StoreOptions& storeOptions) {
+    if (options.snapshotPath.empty() || ::access(options.snapshotPath.c_str(), F_OK) != 0) {
+        return nullptr;
+    }
+    auto snapshotReader = std::make_unique<SnapshotReader>(options.snapshotPath);
+
+    // Same seed and shard count: every section loads into one shard under one lock per run
+    storeOptions.hashSeed = snapshotReader->hashSeed();
+    return snapshotReader;
+}
+
+/**
+ * @brief Start serving replicas or following a primary, as the options say.
+ * @param keyValueStore Store, fully loaded.
+ * @param options Server options; the network session options are filled in.
+ * @param primary Output; set when serving replicas.
+ * @param replica Output; set when following a primary.
+ * @return true Unless the replication port could not be opened.
+ *
+ * Full syncs go through a scratch snapshot file next to the --snapshot path
+ * (or "storm" in the working directory).
+ */
+bool StartReplication(Store& keyValueStore, ServerOptions& options, std::unique_ptr<ReplicationPrimary>& primary,
+                      std::unique_ptr<ReplicaClient>& replica) {
+    std::string scratch_base = options.snapshotPath.empty() ? "storm" : options.snapshotPath;
+    if (options.replicatePort != 0) {
+        auto replicationLog = std::make_shared<ReplicationLog>();
+        keyValueStore.setReplicationLog(replicationLog);
 
-    // Command history buffer
-    std::deque<std::string> commandHistory;
-    const size_t kMaximumHistorySize = 50;
+        ReplicationPrimaryConfig primary_config;
+        primary_config.bindAddress = options.network.bindAddress;
+        primary_config.port = options.replicatePort;
+        primary_config.snapshotPath = scratch_base + ".sync";
+        primary = std::make_unique<ReplicationPrimary>(keyValueStore, replicationLog, primary_config);
+        try {
+            primary->start();
+        } catch (const std::system_error& error) {
+            std::cerr << "Failed to start replication: " << error.what() << "\n";
+            return false;
+        }
+        ReplicationPrimary* primary_pointer = primary.get();
+        options.network.session.replicationStatus = [primary_pointer] { return primary_pointer->status(); };
+        std::cout << "Serving replicas on port " << primary->port() << std::endl;
+    } else if (!options.primaryHost.empty()) {
+        replica = std::make_unique<ReplicaClient>(keyValueStore, options.primaryHost, options.primaryPort,
+                                                  scratch_base + ".sync-in");
+        replica->start();
+        ReplicaClient* replica_pointer = replica.get();
+        options.network.session.readOnly = true;
+        options.network.session.replicationStatus = [replica_pointer] { return replica_pointer->status(); };
+        std::cout << "Following " << options.primaryHost << ":" << options.primaryPort << std::endl;
+    }
+    return true;
+}
+
+/**
+ * @brief Serve the store over TCP until SIGINT or SIGTERM.
+ * @param keyValueStore Store to serve.
+ * @param config Listener settings.
+ * @return int Process exit code.
+ */
+int RunNetworkServer(Store& keyValueStore, const NetServerConfig& config) {
+    // Block termination signals before any loop thread starts so only sigwait sees them
+    sigset_t termination_signals;
+    sigemptyset(&termination_signals);
+    sigaddset(&termination_signals, SIGINT);
+    sigaddset(&termination_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &termination_signals, nullptr);
+
+    NetServer networkServer(keyValueStore, config);
+    try {
+        networkServer.start();
+    } catch (const std::system_error& error) {
+        std::cerr << "Failed to start server: " << error.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "Store server listening on " << config.bindAddress << ":" << networkServer.port() << std::endl;
+
+    int received_signal = 0;
+    sigwait(&termination_signals, &received_signal);
+
+    networkServer.stop();
+    return 0;
+}
+
+/**
+ * @brief Run the interactive Store CLI on stdin/stdout.
+ * @param keyValueStore Store to operate on.
+ * @param sessionOptions Read-only mode and replication status.
+ * @return int Process exit code.
+ */
+int RunInteractiveCli(Store& keyValueStore, const SessionOptions& sessionOptions) {
+    CommandProcessor commandProcessor(keyValueStore, true, sessionOptions);
 
     std::cout << "Store CLI started. Commands: PUT, GET, DEL, LIST, CLEAR, HELP, HISTORY, EXIT\n";
 
     std::string userInputLine;
+    std::string replyBuffer;
 
     while (true) {
         std::cout << "> ";
@@ -69,129 +343,208 @@ int main() {
             break; // Exit on EOF
         }
 
-        // Trim whitespace from user input
-        std::string trimmedInputLine = TrimWhitespace(userInputLine);
+        replyBuffer.clear();
+        CommandProcessor::Status status = commandProcessor.execute(userInputLine, replyBuffer);
+        std::cout << replyBuffer;
 
-        // Save command in history if not empty
-        if (!trimmedInputLine.empty()) {
-            commandHistory.push_back(trimmedInputLine);
-            if (commandHistory.size() > kMaximumHistorySize) {
-                commandHistory.pop_front();
-            }
+        if (status == CommandProcessor::Status::Exit) {
+            break;
         }
+    }
 
-        // Parse input into command keyword and arguments
-        std::istringstream inputStream(trimmedInputLine);
-        std::string commandKeyword;
-        inputStream >> commandKeyword;
-
-        // ===========================
-        // Command: PUT
-        // ===========================
-        if (commandKeyword == "PUT") {
-            std::string keyArgument;
-            std::string valueArgument;
-            inputStream >> keyArgument >> valueArgument;
-
-            if (keyArgument.empty() || valueArgument.empty()) {
-                std::cout << "{ \"success\": false, \"error\": \"PUT requires key and value\" }\n";
-                continue;
-            }
+    return 0;
+}
 
-            keyValueStore.put(keyArgument, valueArgument);
-            std::cout << "{ \"success\": true }\n";
-        }
-        // ===========================
-        // Command: GET
-        // ===========================
-        else if (commandKeyword == "GET") {
-            std::string keyArgument;
-            inputStream >> keyArgument;
-
-            if (keyArgument.empty()) {
-                std::cout << "{ \"success\": false, \"error\": \"GET requires key\" }\n";
-                continue;
-            }
+/**
+ * @brief Input consumed per BatchProcessor call in batch mode, and the initial read buffer size.
+ */
+constexpr size_t kBatchBlockBytes = 1 << 20;
 
-            std::string retrievedValue;
-            if (keyValueStore.get(keyArgument, retrievedValue)) {
-                std::cout << "{ \"success\": true, \"value\": \"" << retrievedValue << "\" }\n";
-            } else {
-                std::cout << "{ \"success\": false, \"error\": \"Key not found\" }\n";
-            }
-        }
-        // ===========================
-        // Command: DEL
-        // ===========================
-        else if (commandKeyword == "DEL") {
-            std::string keyArgument;
-            inputStream >> keyArgument;
-
-            if (keyArgument.empty()) {
-                std::cout << "{ \"success\": false, \"error\": \"DEL requires key\" }\n";
-                continue;
-            }
+/**
+ * @brief Replies buffered in batch mode before they are written out.
+ */
+constexpr size_t kBatchOutputBytes = 64 * 1024;
 
-            if (keyValueStore.del(keyArgument)) {
-                std::cout << "{ \"success\": true }\n";
-            } else {
-                std::cout << "{ \"success\": false, \"error\": \"Key not found\" }\n";
+/**
+ * @brief Execute one block through the batch processor and write out replies once enough are buffered.
+ * @return CommandProcessor::Status Exit if the block held an EXIT line.
+ */
+CommandProcessor::Status ExecuteBatchBlock(BatchProcessor& batchProcessor, std::string_view block, bool end_of_input,
+                                           size_t& consumed, std::string& reply_buffer, bool quiet) {
+    CommandProcessor::Status status = batchProcessor.execute(block, end_of_input, consumed, reply_buffer);
+    if (quiet) {
+        reply_buffer.clear();
+    } else if (reply_buffer.size() >= kBatchOutputBytes || end_of_input || status == CommandProcessor::Status::Exit) {
+        std::cout.write(reply_buffer.data(), static_cast<std::streamsize>(reply_buffer.size()));
+        reply_buffer.clear();
+    }
+    return status;
+}
+
+/**
+ * @brief Execute stdin as a non-interactive command stream.
+ * @param keyValueStore Store to operate on.
+ * @param sessionOptions Read-only mode and replication status.
+ * @param quiet Discard replies instead of writing them to stdout.
+ * @return int Process exit code.
+ *
+ * A regular file redirected to stdin is mapped and walked in place;
+ * anything else is read in blocks of at least kBatchBlockBytes. There is
+ * no prompt and no history. A read error stops the run with exit code 1,
+ * so a truncated import is not reported as a success.
+ */
+int RunBatch(Store& keyValueStore, const SessionOptions& sessionOptions, bool quiet) {
+    BatchProcessor batchProcessor(keyValueStore, sessionOptions);
+    std::string replyBuffer;
+    size_t consumed = 0;
+
+    struct stat input_stat;
+    if (fstat(STDIN_FILENO, &input_stat) == 0 && S_ISREG(input_stat.st_mode) && input_stat.st_size > 0) {
+        size_t input_size = static_cast<size_t>(input_stat.st_size);
+        void* mapping = mmap(nullptr, input_size, PROT_READ, MAP_PRIVATE, STDIN_FILENO, 0);
+        if (mapping != MAP_FAILED) {
+            madvise(mapping, input_size, MADV_SEQUENTIAL);
+            std::string_view input(static_cast<const char*>(mapping), input_size);
+
+            size_t window = kBatchBlockBytes;
+            while (!input.empty()) {
+                bool end_of_input = window >= input.size();
+                std::string_view block = input.substr(0, window);
+                if (ExecuteBatchBlock(batchProcessor, block, end_of_input, consumed, replyBuffer, quiet) ==
+                    CommandProcessor::Status::Exit) {
+                    break;
+                }
+                input.remove_prefix(consumed);
+                // A line longer than the window: widen it until the line fits
+                window = consumed == 0 ? window * 2 : kBatchBlockBytes;
             }
+            munmap(mapping, input_size);
+            std::cout.flush();
+            return 0;
         }
-        // ===========================
-        // Command: LIST
-        // ===========================
-        else if (commandKeyword == "LIST") {
-            keyValueStore.list();
-        }
-        // ===========================
-        // Command: CLEAR
-        // ===========================
-        else if (commandKeyword == "CLEAR") {
-            keyValueStore.clear();
-            std::cout << "{ \"success\": true }\n";
-        }
-        // ===========================
-        // Command: HELP
-        // ===========================
-        else if (commandKeyword == "HELP") {
-            std::cout << "Commands:\n";
-            std::cout << "  PUT key value    - store key with value\n";
-            std::cout << "  GET key          - retrieve value for key\n";
-            std::cout << "  DEL key          - delete key\n";
-            std::cout << "  LIST             - list all keys (most recent first)\n";
-            std::cout << "  CLEAR            - remove all keys\n";
-            std::cout << "  HISTORY          - show recent commands\n";
-            std::cout << "  HELP             - show this message\n";
-            std::cout << "  EXIT             - quit\n";
+    }
+
+    std::string input_buffer(kBatchBlockBytes, '\0');
+    size_t buffered = 0;
+    while (true) {
+        if (buffered == input_buffer.size()) {
+            input_buffer.resize(input_buffer.size() * 2); // A line longer than the buffer
         }
-        // ===========================
-        // Command: HISTORY
-        // ===========================
-        else if (commandKeyword == "HISTORY") {
-            std::cout << "{ \"history\": [\n";
-            for (size_t index = 0; index < commandHistory.size(); ++index) {
-                std::cout << "  \"" << commandHistory[index] << "\"";
-                if (index + 1 < commandHistory.size()) {
-                    std::cout << ",";
-                }
-                std::cout << "\n";
-            }
-            std::cout << "] }\n";
+        ssize_t read_count = read(STDIN_FILENO, &input_buffer[buffered], input_buffer.size() - buffered);
+        int read_error = errno;
+        if (read_count < 0 && read_error == EINTR) {
+            continue;
         }
-        // ===========================
-        // Command: EXIT
-        // ===========================
-        else if (commandKeyword == "EXIT") {
+        bool read_failed = read_count < 0;
+        bool end_of_input = read_count == 0;
+        buffered += read_count > 0 ? static_cast<size_t>(read_count) : 0;
+
+        // After a failed read only the complete lines run; the last one may have been cut short
+        std::string_view block(input_buffer.data(), buffered);
+        if (ExecuteBatchBlock(batchProcessor, block, end_of_input, consumed, replyBuffer, quiet) ==
+                CommandProcessor::Status::Exit ||
+            end_of_input) {
             break;
         }
-        // ===========================
-        // Unknown command
-        // ===========================
-        else if (!commandKeyword.empty()) {
-            std::cout << "{ \"error\": \"Unknown command\" }\n";
+        if (read_failed) {
+            std::cout.write(replyBuffer.data(), static_cast<std::streamsize>(replyBuffer.size()));
+            std::cout.flush();
+            std::cerr << "Failed to read input: " << std::strerror(read_error) << "\n";
+            return 1;
         }
+        // Keep the incomplete last line for the next read
+        std::memmove(&input_buffer[0], &input_buffer[consumed], buffered - consumed);
+        buffered -= consumed;
     }
-
+    std::cout.flush();
     return 0;
 }
+
+/**
+ * @brief Main entry point for the Store server.
+ *
+ * Without options, runs the interactive CLI. With --listen, serves the same
+ * line protocol over TCP; with --batch, executes stdin in bulk. Commands:
+ *  - PUT key value    : Insert or update a key-value pair
+ *  - GET key          : Retrieve the value for a key
+ *  - DEL key          : Delete a key
+ *  - LIST             : Display all keys and values
+ *  - CLEAR [ASYNC]    : Remove all keys; ASYNC frees their memory in the background
+ *  - REPLICATION      : Show replication role, offsets, and lag
+ *  - HELP             : Show available commands
+ *  - HISTORY          : Show recent commands
+ *  - EXIT             : Exit CLI
+ */
+int main(int argc, char** argv) {
+    ServerOptions options;
+    if (!ParseArguments(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+
+    // Create the in-memory key-value store
+    StoreOptions store_options;
+    store_options.maxKeysPerShard = options.shardCapacity;
+    store_options.shardCount = options.shardCount;
+    store_options.memoryBudget = options.memoryBudget;
+    store_options.maxValueBytes = options.maxValueBytes;
+    store_options.compressionThreshold = options.compressionThreshold;
+    store_options.nearCacheSlots = options.nearCacheSlots;
+    store_options.numaAware = options.numaAware;
+
+    std::unique_ptr<SnapshotReader> snapshotReader;
+    try {
+        snapshotReader = OpenSnapshot(options, store_options);
+    } catch (const std::system_error& error) {
+        std::cerr << "Failed to open snapshot: " << error.what() << "\n";
+        return 1;
+    }
+
+    Store keyValueStore(store_options);
+    // Batch mode spreads its putMany runs over every core unless told otherwise
+    size_t batch_workers = options.batchWorkers;
+    if (options.batchMode && batch_workers == 0) {
+        batch_workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (batch_workers > 0) {
+        keyValueStore.setExecutor(std::make_shared<WorkerPool>(batch_workers));
+    }
+    if (snapshotReader != nullptr) {
+        try {
+            size_t loaded_count = keyValueStore.loadSnapshot(*snapshotReader);
+            std::cout << "Loaded " << loaded_count << " keys from " << options.snapshotPath << std::endl;
+        } catch (const std::system_error& error) {
+            std::cerr << "Failed to load snapshot: " << error.what() << "\n";
+            return 1;
+        }
+        snapshotReader.reset();
+    }
+    if (!options.appendLogPath.empty() && !AttachAppendLog(keyValueStore, options)) {
+        return 1;
+    }
+
+    std::unique_ptr<ReplicationPrimary> replicationPrimary;
+    std::unique_ptr<ReplicaClient> replicaClient;
+    if (!StartReplication(keyValueStore, options, replicationPrimary, replicaClient)) {
+        return 1;
+    }
+
+    int exit_code = options.listenMode ? RunNetworkServer(keyValueStore, options.network)
+                    : options.batchMode ? RunBatch(keyValueStore, options.network.session, options.quiet)
+                                        : RunInteractiveCli(keyValueStore, options.network.session);
+
+    // Stop replicating first so the shutdown snapshot sees a settled store
+    replicaClient.reset();
+    replicationPrimary.reset();
+
+    // A fresh snapshot makes the next start fast and lets the log start over
+    if (exit_code == 0 && !options.snapshotPath.empty()) {
+        try {
+            keyValueStore.compactLog(options.snapshotPath);
+        } catch (const std::system_error& error) {
+            std::cerr << "Failed to write snapshot: " << error.what() << "\n";
+            return 1;
+        }
+    }
+    return exit_code;
+}
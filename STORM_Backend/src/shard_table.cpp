@@ -0,0 +1,398 @@
+#include "shard_table.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// ========================================
+// ListShardTable
+// ========================================
+
+ListShardTable::ListShardTable(size_t max_entries) : maxEntries(max_entries) {}
+
+ListShardTable::Node* ListShardTable::find(std::string_view key, uint32_t /*hash*/) {
+    auto entry_iterator = entries.find(key);
+    return entry_iterator == entries.end() ? nullptr : &entry_iterator->second;
+}
+
+ListShardTable::Node* ListShardTable::insert(std::string_view key, uint32_t hash, ValueHandle value) {
+    // Insert new key at front of segment 0; the map key views the list's copy
+    std::list<std::string>& recency_list = recencyLists[0];
+    recency_list.emplace_front(key);
+    size_t bucket_count = entries.bucket_count();
+    Node& node = entries[recency_list.front()];
+    if (entries.bucket_count() != bucket_count) {
+        ++rehashCount;
+    }
+    node.value = std::move(value);
+    node.recencyIt = recency_list.begin();
+    node.state.reset();
+    node.hash = hash;
+    return &node;
+}
+
+void ListShardTable::erase(Node* node) {
+    // Copy the iterator first: erasing the map entry destroys *node. The list
+    // node owns the key bytes, so it must outlive the map erase.
+    auto recency_iterator = node->recencyIt;
+    std::list<std::string>& recency_list = recencyLists[node->state.segment()];
+    entries.erase(std::string_view(*recency_iterator));
+    recency_list.erase(recency_iterator);
+}
+
+void ListShardTable::touch(Node* node) {
+    std::list<std::string>& recency_list = recencyLists[node->state.segment()];
+    recency_list.splice(recency_list.begin(), recency_list, node->recencyIt);
+}
+
+ListShardTable::Node* ListShardTable::leastRecent(size_t segment_index) {
+    const std::list<std::string>& recency_list = recencyLists[segment_index];
+    if (recency_list.empty()) {
+        return nullptr;
+    }
+    return &entries.find(recency_list.back())->second;
+}
+
+void ListShardTable::moveToSegment(Node* node, size_t segment_index) {
+    // Splicing keeps the key's list node, so the map key and recencyIt stay valid
+    std::list<std::string>& destination = recencyLists[segment_index];
+    destination.splice(destination.begin(), recencyLists[node->state.segment()], node->recencyIt);
+    node->state.setSegment(segment_index);
+}
+
+void ListShardTable::clear() {
+    entries.clear();
+    for (std::list<std::string>& recency_list : recencyLists) {
+        recency_list.clear();
+    }
+}
+
+// ========================================
+// SlabShardTable
+// ========================================
+
+namespace {
+
+/**
+ * @brief Smallest power of two greater than or equal to value (minimum 16, one probe group).
+ */
+size_t RoundUpToPowerOfTwo(size_t value) {
+    size_t rounded = 16;
+    while (rounded < value) {
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+/**
+ * @brief log2 of a power of two.
+ */
+size_t Log2(size_t power_of_two) {
+    size_t shift = 0;
+    while ((size_t{1} << shift) < power_of_two) {
+        ++shift;
+    }
+    return shift;
+}
+
+// Capacities up to this are indexed in full up front so the index never grows
+// under the shard lock; larger (effectively unbounded) tables start at
+// kUnboundedInitialEntries and double as entries arrive.
+constexpr size_t kMaxPresizedEntries = size_t{1} << 23;
+constexpr size_t kUnboundedInitialEntries = size_t{1} << 12;
+
+/**
+ * @brief Bucket count keeping entryCount entries at or below a 3/4 load factor.
+ */
+size_t BucketCountFor(size_t entry_count) {
+    return RoundUpToPowerOfTwo(entry_count + entry_count / 3 + 1);
+}
+
+/**
+ * @brief Bit i set for every byte i of 16 control bytes that may equal a value.
+ *
+ * One probe group: 16 control bytes loaded from any bucket index, compared
+ * with a single SSE2 instruction where available. The portable fallback
+ * works on two 64-bit words and may report false matches on full buckets,
+ * which the caller's key comparison filters out; empty buckets are never
+ * reported by match().
+ */
+class ProbeGroup {
+public:
+    explicit ProbeGroup(const uint8_t* controls) {
+#if defined(__SSE2__)
+        bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(controls));
+#else
+        std::memcpy(words, controls, sizeof(words));
+#endif
+    }
+
+    /**
+     * @brief Positions whose control byte may equal a fingerprint.
+     */
+    uint32_t match(uint8_t control) const {
+#if defined(__SSE2__)
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(static_cast<char>(control)))));
+#else
+        uint64_t pattern = kLowBits * control;
+        return ByteMask(ZeroBytes(words[0] ^ pattern)) | (ByteMask(ZeroBytes(words[1] ^ pattern)) << 8);
+#endif
+    }
+
+    /**
+     * @brief Positions holding an empty bucket (the only control bytes with the high bit set).
+     */
+    uint32_t matchEmpty() const {
+#if defined(__SSE2__)
+        return static_cast<uint32_t>(_mm_movemask_epi8(bytes));
+#else
+        return ByteMask(words[0] & kHighBits) | (ByteMask(words[1] & kHighBits) << 8);
+#endif
+    }
+
+private:
+#if defined(__SSE2__)
+    __m128i bytes;
+#else
+    static constexpr uint64_t kLowBits = 0x0101010101010101ull;
+    static constexpr uint64_t kHighBits = 0x8080808080808080ull;
+
+    uint64_t words[2]; ///< Control bytes in memory order (little-endian byte i = bucket i)
+
+    /**
+     * @brief High bit set in each zero byte; may also flag a byte just above a zero byte.
+     */
+    static uint64_t ZeroBytes(uint64_t word) { return (word - kLowBits) & ~word & kHighBits; }
+
+    /**
+     * @brief Gather the high bit of each byte into bits 0..7.
+     */
+    static uint32_t ByteMask(uint64_t high_bits) {
+        return static_cast<uint32_t>(((high_bits >> 7) * 0x0102040810204080ull) >> 56);
+    }
+#endif
+};
+
+} // namespace
+
+SlabShardTable::SlabShardTable(size_t max_entries)
+    : maxEntries(std::min<size_t>(max_entries, kNoSlot - 1)) {
+    segmentHeads.fill(kNoSlot);
+    segmentTails.fill(kNoSlot);
+
+    size_t presized_entries = maxEntries <= kMaxPresizedEntries ? maxEntries : kUnboundedInitialEntries;
+    resetIndex(BucketCountFor(presized_entries));
+}
+
+void SlabShardTable::resetIndex(size_t bucket_count) {
+    controls.assign(bucket_count + kGroupWidth - 1, kEmptyControl);
+    bucketSlots.assign(bucket_count, kNoSlot);
+    bucketMask = bucket_count - 1;
+    bucketShift = 64 - Log2(bucket_count);
+}
+
+void SlabShardTable::setControl(size_t bucket_index, uint8_t control) {
+    controls[bucket_index] = control;
+
+    // The first kGroupWidth - 1 bytes are mirrored after the end, so a group
+    // load starting near the end sees the wrapped-around buckets
+    if (bucket_index < kGroupWidth - 1) {
+        controls[bucketMask + 1 + bucket_index] = control;
+    }
+}
+
+size_t SlabShardTable::homeBucket(uint32_t hash) const {
+    // Multiplicative hashing: the top product bits pick the bucket, independent of the fingerprint bits
+    return static_cast<size_t>((static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ull) >> bucketShift);
+}
+
+SlabShardTable::Node* SlabShardTable::find(std::string_view key, uint32_t hash) {
+    uint8_t control = controlOf(hash);
+
+    // Linear probing, one group of buckets per step. No key's probe run
+    // extends past an empty bucket, so a group with an empty one ends the search.
+    for (size_t group_start = homeBucket(hash);; group_start = (group_start + kGroupWidth) & bucketMask) {
+        ProbeGroup group(&controls[group_start]);
+
+        for (uint32_t matches = group.match(control); matches != 0; matches &= matches - 1) {
+            size_t bucket_index = (group_start + static_cast<size_t>(__builtin_ctz(matches))) & bucketMask;
+            Node& node = nodeAt(bucketSlots[bucket_index]);
+            if (node.key == key) {
+                return &node;
+            }
+        }
+
+        if (group.matchEmpty() != 0) {
+            return nullptr;
+        }
+    }
+}
+
+SlabShardTable::Node* SlabShardTable::insert(std::string_view key, uint32_t hash, ValueHandle value) {
+    Node& node = nodeAt(allocateSlot());
+    node.key = key;
+    node.value = std::move(value);
+    node.hash = hash;
+    node.state.reset();
+
+    // Only tables too large to presize ever get here with a full index
+    if ((liveCount + 1) * 4 > (bucketMask + 1) * 3) {
+        growIndex();
+    }
+    indexInsert(node);
+    linkFront(node, 0);
+    ++liveCount;
+    return &node;
+}
+
+void SlabShardTable::erase(Node* node) {
+    indexErase(*node);
+    unlink(*node);
+
+    // Drop the value eagerly but keep the key buffer around for the next occupant
+    node->key.clear();
+    node->value.reset();
+    node->state.reset();
+
+    node->next = freeSlot;
+    freeSlot = node->slot;
+    --liveCount;
+}
+
+void SlabShardTable::touch(Node* node) {
+    size_t segment_index = node->state.segment();
+    if (node->slot == segmentHeads[segment_index]) {
+        return;
+    }
+    unlink(*node);
+    linkFront(*node, segment_index);
+}
+
+void SlabShardTable::moveToSegment(Node* node, size_t segment_index) {
+    unlink(*node);
+    linkFront(*node, segment_index);
+}
+
+void SlabShardTable::clear() {
+    for (uint32_t head_slot : segmentHeads) {
+        for (uint32_t slot = head_slot; slot != kNoSlot;) {
+            Node& node = nodeAt(slot);
+            slot = node.next;
+            node.key.clear();
+            node.value.reset();
+            node.state.reset();
+        }
+    }
+
+    std::fill(controls.begin(), controls.end(), kEmptyControl);
+
+    // Every slot handed out so far becomes free again; rebuild the free list in order
+    freeSlot = kNoSlot;
+    for (uint32_t slot = usedSlots; slot-- > 0;) {
+        nodeAt(slot).next = freeSlot;
+        freeSlot = slot;
+    }
+
+    segmentHeads.fill(kNoSlot);
+    segmentTails.fill(kNoSlot);
+    segmentSizes.fill(0);
+    liveCount = 0;
+}
+
+uint32_t SlabShardTable::allocateSlot() {
+    if (freeSlot != kNoSlot) {
+        uint32_t slot = freeSlot;
+        freeSlot = nodeAt(slot).next;
+        return slot;
+    }
+
+    uint32_t slot = usedSlots++;
+
+    // Allocate the next slab chunk on first use, never larger than the capacity needs
+    if ((slot & kChunkMask) == 0) {
+        size_t chunk_size = std::min<size_t>(kChunkMask + 1, maxEntries - slot);
+        chunks.push_back(std::make_unique<Node[]>(chunk_size));
+    }
+
+    nodeAt(slot).slot = slot;
+    return slot;
+}
+
+void SlabShardTable::linkFront(Node& node, size_t segment_index) {
+    uint32_t& head_slot = segmentHeads[segment_index];
+    node.prev = kNoSlot;
+    node.next = head_slot;
+    if (head_slot != kNoSlot) {
+        nodeAt(head_slot).prev = node.slot;
+    } else {
+        segmentTails[segment_index] = node.slot;
+    }
+    head_slot = node.slot;
+    node.state.setSegment(segment_index);
+    ++segmentSizes[segment_index];
+}
+
+void SlabShardTable::unlink(Node& node) {
+    size_t segment_index = node.state.segment();
+    if (node.prev != kNoSlot) {
+        nodeAt(node.prev).next = node.next;
+    } else {
+        segmentHeads[segment_index] = node.next;
+    }
+
+    if (node.next != kNoSlot) {
+        nodeAt(node.next).prev = node.prev;
+    } else {
+        segmentTails[segment_index] = node.prev;
+    }
+    --segmentSizes[segment_index];
+}
+
+void SlabShardTable::indexInsert(Node& node) {
+    // The first empty bucket at or after the home bucket; the load factor guarantees one
+    for (size_t group_start = homeBucket(node.hash);; group_start = (group_start + kGroupWidth) & bucketMask) {
+        uint32_t empty_buckets = ProbeGroup(&controls[group_start]).matchEmpty();
+        if (empty_buckets != 0) {
+            size_t bucket_index = (group_start + static_cast<size_t>(__builtin_ctz(empty_buckets))) & bucketMask;
+            setControl(bucket_index, controlOf(node.hash));
+            bucketSlots[bucket_index] = node.slot;
+            return;
+        }
+    }
+}
+
+void SlabShardTable::indexErase(const Node& node) {
+    uint8_t control = controlOf(node.hash);
+    size_t hole = homeBucket(node.hash);
+
+    // Find the node's bucket by slot index, so no other node is touched
+    while (controls[hole] != control || bucketSlots[hole] != node.slot) {
+        hole = (hole + 1) & bucketMask;
+    }
+
+    // Backward-shift deletion: pull later members of the probe run into the hole
+    // so lookups never need tombstones
+    for (size_t probe = (hole + 1) & bucketMask; controls[probe] != kEmptyControl; probe = (probe + 1) & bucketMask) {
+        size_t home = homeBucket(nodeAt(bucketSlots[probe]).hash);
+        bool home_in_gap = ((probe - home) & bucketMask) >= ((probe - hole) & bucketMask);
+        if (home_in_gap) {
+            setControl(hole, controls[probe]);
+            bucketSlots[hole] = bucketSlots[probe];
+            hole = probe;
+        }
+    }
+    setControl(hole, kEmptyControl);
+}
+
+void SlabShardTable::growIndex() {
+    resetIndex((bucketMask + 1) * 2);
+
+    for (uint32_t head_slot : segmentHeads) {
+        for (uint32_t slot = head_slot; slot != kNoSlot; slot = nodeAt(slot).next) {
+            indexInsert(nodeAt(slot));
+        }
+    }
+}
@@ -0,0 +1,509 @@
+#pragma once
+
+#include "value.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Shard storage policies used by BasicStore.
+ *
+ * A shard table owns the key-value entries of one shard together with their
+ * recency order. Both tables expose the same interface so BasicStore can be
+ * instantiated with either one and the two layouts benchmarked side by side:
+ *  - find / insert / erase: key lookup and entry lifetime. The caller passes
+ *    the key's hash (the low half of the store's seeded HashKey), so each
+ *    operation hashes the key once for shard selection and lookup together.
+ *  - touch / leastRecent: recency maintenance for LRU eviction.
+ *  - moveToSegment / segmentSize: recency segments for segmented eviction policies.
+ *  - forEachByRecency: ordered traversal, most recent first.
+ *  - forEachAtPositions / positionCount / positionEpoch: resumable traversal
+ *    in storage order, used to migrate entries a slice at a time.
+ *
+ * The recency order is split into kSegmentCount independent LRU lists. New
+ * entries start in segment 0; plain LRU never leaves it, while segmented
+ * policies (see eviction_policy.h) move entries between segments.
+ *
+ * Tables are not thread-safe; the owning shard's mutex must be held exclusively
+ * for everything except find, which only reads.
+ */
+
+/**
+ * @brief Number of recency segments each shard table maintains.
+ */
+constexpr size_t kSegmentCount = 3;
+
+/**
+ * @brief Per-entry state word: expiry deadline, recency segment, and the CLOCK reference bit.
+ *
+ * The low 48 bits hold the absolute expiry time in steady-clock milliseconds
+ * (0 = no expiry), the next two bits the recency segment, and the top bit is
+ * the reference bit. Packing them into one atomic word keeps slab nodes at
+ * 64 bytes, so keys without a TTL pay nothing for TTL support. Shared-lock
+ * readers only load the word and set the reference bit; every other change
+ * happens under the exclusive lock.
+ */
+class EntryState {
+public:
+    static constexpr uint64_t kMaxExpiresAt = (uint64_t{1} << 48) - 1; ///< Latest representable deadline
+
+    /**
+     * @brief Expiry deadline in steady-clock milliseconds, or 0 if the entry never expires.
+     */
+    uint64_t expiresAt() const { return word.load(std::memory_order_relaxed) & kExpiresAtMask; }
+
+    /**
+     * @brief Set the expiry deadline, keeping the reference bit; requires the exclusive lock.
+     * @param deadline Milliseconds on the steady clock, or 0 for no expiry.
+     */
+    void setExpiresAt(uint64_t deadline) {
+        uint64_t current = word.load(std::memory_order_relaxed);
+        word.store((current & ~kExpiresAtMask) | (deadline & kExpiresAtMask), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Recency segment the entry is linked into.
+     */
+    size_t segment() const {
+        return static_cast<size_t>((word.load(std::memory_order_relaxed) & kSegmentMask) >> kSegmentShift);
+    }
+
+    /**
+     * @brief Record the entry's recency segment; requires the exclusive lock.
+     * @param segmentIndex Segment below kSegmentCount.
+     */
+    void setSegment(size_t segmentIndex) {
+        uint64_t current = word.load(std::memory_order_relaxed);
+        word.store((current & ~kSegmentMask) | (static_cast<uint64_t>(segmentIndex) << kSegmentShift),
+                   std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Whether a shared-lock reader has referenced the entry since the bit was last cleared.
+     */
+    bool referenced() const { return (word.load(std::memory_order_relaxed) & kReferencedBit) != 0; }
+
+    /**
+     * @brief Set the reference bit; safe under a shared lock. Skips the write if already set.
+     */
+    void markReferenced() {
+        if (!referenced()) {
+            word.fetch_or(kReferencedBit, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Clear the reference bit; requires the exclusive lock.
+     */
+    void clearReferenced() { word.fetch_and(~kReferencedBit, std::memory_order_relaxed); }
+
+    /**
+     * @brief Clear the deadline, segment, and reference bit for a new occupant.
+     */
+    void reset() { word.store(0, std::memory_order_relaxed); }
+
+private:
+    static constexpr uint64_t kExpiresAtMask = kMaxExpiresAt;
+    static constexpr size_t kSegmentShift = 48;
+    static constexpr uint64_t kSegmentMask = uint64_t{3} << kSegmentShift;
+    static constexpr uint64_t kReferencedBit = uint64_t{1} << 63;
+
+    std::atomic<uint64_t> word{0}; ///< Deadline bits and reference bit
+};
+
+/**
+ * @brief Original shard layout: std::unordered_map plus a std::list of keys.
+ *
+ * Each insert allocates both a map node and a list node. Keys are owned by the
+ * list nodes, whose addresses are stable, and the map is keyed by views of
+ * them so string_view lookups work without C++20 heterogeneous find. Kept as
+ * the reference implementation.
+ */
+class ListShardTable {
+public:
+    /**
+     * @brief Entry stored in the hash map.
+     */
+    struct Node {
+        ValueHandle value;                          ///< The value associated with the key
+        std::list<std::string>::iterator recencyIt; ///< Iterator into the segment's recency list
+        EntryState state;                           ///< Expiry deadline, segment, and CLOCK reference bit
+        uint32_t hash = 0;                          ///< Key hash passed to insert
+    };
+
+    /**
+     * @brief How the expiry wheel names an entry: by key, since map nodes are freed on erase.
+     */
+    using ExpiryRef = std::string;
+
+    /**
+     * @brief Construct an empty table.
+     * @param maxEntries Maximum number of entries the owning shard will hold.
+     */
+    explicit ListShardTable(size_t maxEntries);
+
+    /**
+     * @brief Find the entry for a key.
+     * @param key Key to look up.
+     * @param hash Key hash; unused here, as std::unordered_map hashes the key itself.
+     * @return Node* Entry for the key, or nullptr if absent.
+     *
+     * Does not modify the table, so concurrent finds under a shared lock are safe.
+     */
+    Node* find(std::string_view key, uint32_t hash);
+
+    /**
+     * @brief Insert a new key at the most recent position of segment 0.
+     * @param key Key to insert; must not already be present.
+     * @param hash Key hash, kept in the entry for hashOf.
+     * @param value Value to associate with the key.
+     * @return Node* The newly inserted entry.
+     */
+    Node* insert(std::string_view key, uint32_t hash, ValueHandle value);
+
+    /**
+     * @brief Remove an entry from the table.
+     * @param node Entry to remove.
+     */
+    void erase(Node* node);
+
+    /**
+     * @brief Mark an entry as most recently used within its segment.
+     * @param node Entry to move to the front of its segment.
+     */
+    void touch(Node* node);
+
+    /**
+     * @brief Least recently used entry of a segment.
+     * @param segmentIndex Segment to inspect.
+     * @return Node* The segment's eviction candidate, or nullptr if the segment is empty.
+     */
+    Node* leastRecent(size_t segmentIndex = 0);
+
+    /**
+     * @brief Move an entry to the most recent position of another (or the same) segment.
+     * @param node Entry to move.
+     * @param segmentIndex Destination segment.
+     */
+    void moveToSegment(Node* node, size_t segmentIndex);
+
+    /**
+     * @brief Number of entries in a segment.
+     */
+    size_t segmentSize(size_t segmentIndex) const { return recencyLists[segmentIndex].size(); }
+
+    /**
+     * @brief Remove every entry.
+     */
+    void clear();
+
+    /**
+     * @brief Number of entries currently stored.
+     */
+    size_t size() const { return entries.size(); }
+
+    /**
+     * @brief Maximum number of entries the table is sized for.
+     */
+    size_t capacity() const { return maxEntries; }
+
+    /**
+     * @brief Key of an entry.
+     */
+    static const std::string& keyOf(const Node& node) { return *node.recencyIt; }
+
+    /**
+     * @brief Hash an entry was inserted with, so policies need not rehash its key.
+     */
+    static uint32_t hashOf(const Node& node) { return node.hash; }
+
+    /**
+     * @brief Reference to an entry that stays safe to resolve after the entry is gone.
+     */
+    static ExpiryRef expiryRefOf(const Node& node) { return *node.recencyIt; }
+
+    /**
+     * @brief Approximate bytes each entry costs beyond its key and its value block.
+     *
+     * Map node and bucket pointer, and list node with its std::string. Used
+     * for byte-budget accounting, together with SlabAllocator::ChargeFor.
+     */
+    static constexpr size_t entryOverhead() {
+        return sizeof(Node) + sizeof(std::string_view) + 3 * sizeof(void*) +
+               sizeof(std::string) + 2 * sizeof(void*);
+    }
+
+    /**
+     * @brief Entry currently named by an expiry reference.
+     * @return Node* Entry, or nullptr if nothing lives there any more.
+     *
+     * The entry may be a different one than when the reference was taken, so
+     * callers must check that it still carries the deadline they expect.
+     */
+    Node* resolveExpiryRef(const ExpiryRef& reference) {
+        auto entry_iterator = entries.find(reference);
+        return entry_iterator == entries.end() ? nullptr : &entry_iterator->second;
+    }
+
+    /**
+     * @brief Visit every entry segment by segment, each from most to least recently used.
+     * @param visitor Callable invoked as visitor(const std::string& key, const Node& node).
+     */
+    template <typename Visitor>
+    void forEachByRecency(Visitor&& visitor) const {
+        for (const std::list<std::string>& recency_list : recencyLists) {
+            for (const std::string& key : recency_list) {
+                visitor(key, entries.find(key)->second);
+            }
+        }
+    }
+
+    /**
+     * @brief Visit the entries stored at a run of storage positions.
+     * @param position First position to visit.
+     * @param count Number of positions to visit; empty positions count too.
+     * @param visitor Callable invoked as visitor(const std::string& key, const Node& node).
+     * @return size_t The position after the last one visited.
+     *
+     * Positions are hash map buckets. Walking from 0 to positionCount() in
+     * several calls visits every entry that stays in the table meanwhile, as
+     * long as positionEpoch() does not change; a rehash renumbers them.
+     */
+    template <typename Visitor>
+    size_t forEachAtPositions(size_t position, size_t count, Visitor&& visitor) const {
+        size_t end_position = std::min(entries.bucket_count(), position + count);
+        for (; position < end_position; ++position) {
+            for (auto entry_iterator = entries.begin(position); entry_iterator != entries.end(position); ++entry_iterator) {
+                visitor(*entry_iterator->second.recencyIt, entry_iterator->second);
+            }
+        }
+        return end_position;
+    }
+
+    /**
+     * @brief Number of storage positions.
+     */
+    size_t positionCount() const { return entries.bucket_count(); }
+
+    /**
+     * @brief Changes whenever positions are renumbered, which invalidates a walk in progress.
+     *
+     * Counts rehashes rather than reporting the bucket count, so the low bits
+     * differ after every growth step; consecutive bucket counts need not.
+     */
+    size_t positionEpoch() const { return rehashCount; }
+
+private:
+    std::unordered_map<std::string_view, Node> entries; ///< Map from key (viewing a recency list) to entry
+    std::array<std::list<std::string>, kSegmentCount> recencyLists; ///< Keys per segment (front = most recent)
+    size_t maxEntries = 0;                         ///< Maximum number of entries
+    size_t rehashCount = 0;                        ///< Times insert grew the bucket array
+};
+
+/**
+ * @brief Intrusive, slab-allocated shard layout.
+ *
+ * Entries live in fixed-size slab chunks allocated on demand up to the shard
+ * capacity and never released until the table is destroyed. Recency links
+ * are slot indices stored inside each entry, and keys are stored once, in the
+ * entry itself.
+ *
+ * A flat open-addressing index maps keys to slots, SwissTable style: one
+ * control byte per bucket holds a 7-bit fingerprint of the key hash (or the
+ * empty marker) next to a parallel array of slot indices. Lookups compare 16
+ * control bytes at a time (SSE2, or SWAR on other targets) and only touch a
+ * slab node on a fingerprint match, so a hit usually costs one control-byte
+ * line, one slot line, and the node itself. Probing is linear with
+ * backward-shift deletion, so there are no tombstones and erases never force
+ * a rehash. The index is sized for the full capacity up front (up to a few
+ * million entries per shard) and only grows for tables beyond that.
+ *
+ * Erased slots go onto a LIFO free list and evicting the least recent entry
+ * hands its slot straight to the next insert, so once the shard has filled up
+ * a put of a new key performs no node allocations under the shard lock (the
+ * key buffer is reused when the new key fits).
+ */
+class SlabShardTable {
+public:
+    /**
+     * @brief Entry stored in a slab slot.
+     */
+    struct Node {
+        std::string key;    ///< Key owned by this slot
+        ValueHandle value;  ///< The value associated with the key
+        uint32_t hash = 0;  ///< Key hash from insert; picks the home bucket and the control-byte fingerprint
+        uint32_t slot = 0;  ///< Index of this slot in the slab
+        uint32_t prev = 0;  ///< More recent neighbour in the segment (kNoSlot at the head)
+        uint32_t next = 0;  ///< Less recent neighbour (kNoSlot at the tail); free-list link when unused
+        EntryState state;   ///< Expiry deadline, segment, and CLOCK reference bit
+    };
+
+    /**
+     * @brief How the expiry wheel names an entry: by slot, since slots are never freed.
+     */
+    using ExpiryRef = uint32_t;
+
+    /**
+     * @brief Construct an empty table.
+     * @param maxEntries Maximum number of entries; slab chunks are allocated lazily up to it.
+     */
+    explicit SlabShardTable(size_t maxEntries);
+
+    /**
+     * @brief Find the entry for a key.
+     * @param key Key to look up.
+     * @param hash Key hash; must be the one the key was inserted with.
+     * @return Node* Entry for the key, or nullptr if absent.
+     *
+     * Does not modify the table, so concurrent finds under a shared lock are safe.
+     */
+    Node* find(std::string_view key, uint32_t hash);
+
+    /** @copydoc ListShardTable::insert */
+    Node* insert(std::string_view key, uint32_t hash, ValueHandle value);
+
+    /** @copydoc ListShardTable::erase */
+    void erase(Node* node);
+
+    /** @copydoc ListShardTable::touch */
+    void touch(Node* node);
+
+    /** @copydoc ListShardTable::leastRecent */
+    Node* leastRecent(size_t segmentIndex = 0) {
+        uint32_t tail_slot = segmentTails[segmentIndex];
+        return tail_slot == kNoSlot ? nullptr : &nodeAt(tail_slot);
+    }
+
+    /** @copydoc ListShardTable::moveToSegment */
+    void moveToSegment(Node* node, size_t segmentIndex);
+
+    /** @copydoc ListShardTable::segmentSize */
+    size_t segmentSize(size_t segmentIndex) const { return segmentSizes[segmentIndex]; }
+
+    /**
+     * @brief Remove every entry. Slab chunks are kept for reuse.
+     */
+    void clear();
+
+    /** @copydoc ListShardTable::size */
+    size_t size() const { return liveCount; }
+
+    /** @copydoc ListShardTable::capacity */
+    size_t capacity() const { return maxEntries; }
+
+    /** @copydoc ListShardTable::keyOf */
+    static const std::string& keyOf(const Node& node) { return node.key; }
+
+    /** @copydoc ListShardTable::hashOf */
+    static uint32_t hashOf(const Node& node) { return node.hash; }
+
+    /** @copydoc ListShardTable::expiryRefOf */
+    static ExpiryRef expiryRefOf(const Node& node) { return node.slot; }
+
+    /**
+     * @brief Approximate bytes each entry costs beyond its key and its value block.
+     *
+     * The slab node and two index buckets (control byte + slot index; the
+     * index is at least 3/8 full once the shard is). Used for byte-budget
+     * accounting, together with SlabAllocator::ChargeFor.
+     */
+    static constexpr size_t entryOverhead() {
+        return sizeof(Node) + 2 * (sizeof(uint8_t) + sizeof(uint32_t));
+    }
+
+    /**
+     * @copydoc ListShardTable::resolveExpiryRef
+     *
+     * Free slots have a cleared state, so they never match a pending deadline.
+     */
+    Node* resolveExpiryRef(ExpiryRef reference) { return reference < usedSlots ? &nodeAt(reference) : nullptr; }
+
+    /** @copydoc ListShardTable::forEachByRecency */
+    template <typename Visitor>
+    void forEachByRecency(Visitor&& visitor) const {
+        for (uint32_t head_slot : segmentHeads) {
+            for (uint32_t slot = head_slot; slot != kNoSlot; slot = nodeAt(slot).next) {
+                const Node& node = nodeAt(slot);
+                visitor(node.key, node);
+            }
+        }
+    }
+
+    /**
+     * @copydoc ListShardTable::forEachAtPositions
+     *
+     * Positions are slab slots. An entry keeps its slot for life, so slots
+     * are never renumbered; free slots are recognised by not being indexed.
+     * Only reads, like find.
+     */
+    template <typename Visitor>
+    size_t forEachAtPositions(size_t position, size_t count, Visitor&& visitor) {
+        size_t end_position = std::min<size_t>(usedSlots, position + count);
+        for (; position < end_position; ++position) {
+            Node& node = nodeAt(static_cast<uint32_t>(position));
+            if (find(node.key, node.hash) == &node) {
+                visitor(node.key, static_cast<const Node&>(node));
+            }
+        }
+        return end_position;
+    }
+
+    /** @copydoc ListShardTable::positionCount */
+    size_t positionCount() const { return usedSlots; }
+
+    /** @copydoc ListShardTable::positionEpoch */
+    size_t positionEpoch() const { return 0; }
+
+private:
+    static constexpr uint32_t kNoSlot = UINT32_MAX;   ///< Null slot index
+    static constexpr size_t kChunkShift = 10;         ///< log2 of slots per slab chunk
+    static constexpr size_t kChunkMask = (size_t{1} << kChunkShift) - 1;
+
+    static constexpr size_t kGroupWidth = 16;      ///< Control bytes compared per probe step
+    static constexpr uint8_t kEmptyControl = 0x80; ///< Control byte of an empty bucket
+
+    std::vector<std::unique_ptr<Node[]>> chunks; ///< Slab chunks of kChunkMask + 1 nodes
+    std::vector<uint8_t> controls;               ///< Fingerprint or kEmptyControl per bucket, then
+                                                 ///< kGroupWidth - 1 copies of the first bytes for wrap-around loads
+    std::vector<uint32_t> bucketSlots;           ///< Slot index per bucket; meaningful where the control byte is full
+    size_t bucketMask = 0;                       ///< Bucket count - 1 (a power of two)
+    size_t bucketShift = 0;                      ///< 64 - log2(bucket count)
+    size_t maxEntries = 0;                       ///< Maximum number of live entries
+    size_t liveCount = 0;                        ///< Number of live entries
+    uint32_t usedSlots = 0;                      ///< Slots handed out at least once
+    uint32_t freeSlot = kNoSlot;                 ///< Head of the free-slot list
+    std::array<uint32_t, kSegmentCount> segmentHeads; ///< Most recently used slot per segment
+    std::array<uint32_t, kSegmentCount> segmentTails; ///< Least recently used slot per segment
+    std::array<size_t, kSegmentCount> segmentSizes{}; ///< Entries per segment
+
+    Node& nodeAt(uint32_t slot) { return chunks[slot >> kChunkShift][slot & kChunkMask]; }
+    const Node& nodeAt(uint32_t slot) const { return chunks[slot >> kChunkShift][slot & kChunkMask]; }
+
+    size_t homeBucket(uint32_t hash) const;
+
+    /**
+     * @brief 7-bit fingerprint stored in the control byte; independent of the home bucket bits.
+     */
+    static uint8_t controlOf(uint32_t hash) { return static_cast<uint8_t>(hash & 0x7F); }
+
+    void setControl(size_t bucketIndex, uint8_t control);
+    void resetIndex(size_t bucketCount);
+
+    uint32_t allocateSlot();
+    void linkFront(Node& node, size_t segmentIndex);
+    void unlink(Node& node);
+    void indexInsert(Node& node);
+    void indexErase(const Node& node);
+    void growIndex();
+};
+
+static_assert(sizeof(SlabShardTable::Node) <= 64, "slab nodes should fit in one cache line");
@@ -0,0 +1,233 @@
+#include "slab_allocator.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace {
+
+/**
+ * @brief Chunk sizes are rounded up to this, which keeps every block header aligned.
+ */
+constexpr size_t kChunkAlignment = 8;
+
+/**
+ * @brief Chunk size of the class after one with the given size.
+ */
+constexpr size_t NextChunkBytes(size_t chunk_bytes) {
+    size_t grown = static_cast<size_t>(static_cast<double>(chunk_bytes) * SlabAllocator::kGrowthFactor);
+    grown = (grown + kChunkAlignment - 1) / kChunkAlignment * kChunkAlignment;
+    return std::min(grown, SlabAllocator::kMaxChunkBytes);
+}
+
+constexpr size_t CountClasses() {
+    size_t class_count = 1;
+    for (size_t chunk_bytes = SlabAllocator::kMinChunkBytes; chunk_bytes < SlabAllocator::kMaxChunkBytes;
+         chunk_bytes = NextChunkBytes(chunk_bytes)) {
+        ++class_count;
+    }
+    return class_count;
+}
+
+constexpr size_t kClassCount = CountClasses();
+
+constexpr std::array<size_t, kClassCount> MakeChunkSizes() {
+    std::array<size_t, kClassCount> chunk_sizes{};
+    chunk_sizes[0] = SlabAllocator::kMinChunkBytes;
+    for (size_t class_index = 1; class_index < kClassCount; ++class_index) {
+        chunk_sizes[class_index] = NextChunkBytes(chunk_sizes[class_index - 1]);
+    }
+    return chunk_sizes;
+}
+
+/**
+ * @brief Chunk size of every class, ascending; the last is kMaxChunkBytes.
+ */
+constexpr std::array<size_t, kClassCount> kChunkSizes = MakeChunkSizes();
+
+/**
+ * @brief Size class marking a block allocated from the heap.
+ */
+constexpr uint32_t kHeapClass = UINT32_MAX;
+
+/**
+ * @brief Smallest class whose chunks hold block_bytes; block_bytes must not exceed kMaxChunkBytes.
+ */
+uint32_t ClassFor(size_t block_bytes) {
+    return static_cast<uint32_t>(std::lower_bound(kChunkSizes.begin(), kChunkSizes.end(), block_bytes) -
+                                 kChunkSizes.begin());
+}
+
+} // namespace
+
+// ========================================
+// Arena
+// ========================================
+
+/**
+ * @brief Pages and free lists, kept alive by the owning allocator and by every chunk in use.
+ *
+ * references counts the owner, each class with chunks in use, and each heap
+ * block; whoever drops it to zero deletes the arena.
+ */
+struct SlabAllocator::Arena {
+    /**
+     * @brief Header of a value block allocated by the arena; the bytes follow it.
+     */
+    struct Block : ValueBlock {
+        Arena* arena = nullptr;   ///< Arena to return the block to
+        uint32_t sizeClass = 0;   ///< Class the chunk belongs to, or kHeapClass
+    };
+
+    /**
+     * @brief What a free chunk holds: the next free chunk of its class.
+     */
+    struct FreeChunk {
+        FreeChunk* next;
+    };
+
+    /**
+     * @brief One size class; on its own cache line so classes never false-share.
+     */
+    struct alignas(64) SizeClass {
+        std::mutex lock;                 ///< Guards every field below
+        FreeChunk* freeChunks = nullptr; ///< Released chunks, most recent first
+        char* bumpNext = nullptr;        ///< Next never-used chunk in the newest page
+        char* bumpEnd = nullptr;         ///< End of the newest page's whole chunks
+        size_t usedChunks = 0;           ///< Chunks holding a value
+        size_t requestedBytes = 0;       ///< Header and value bytes in those chunks
+        std::vector<char*> pages;        ///< Every page carved for this class
+    };
+
+    std::atomic<size_t> references{1}; ///< See above; starts with the owner's
+    std::atomic<size_t> heapBytes{0};  ///< Bytes of live heap blocks
+    std::array<SizeClass, kClassCount> classes;
+
+    ~Arena() {
+        for (SizeClass& size_class : classes) {
+            for (char* page : size_class.pages) {
+                ::operator delete(page);
+            }
+        }
+    }
+
+    void release() {
+        if (references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    /**
+     * @brief Take a chunk of a class from its free list, or carve a new one.
+     */
+    void* allocateChunk(uint32_t class_index, size_t block_bytes) {
+        SizeClass& size_class = classes[class_index];
+        size_t chunk_bytes = kChunkSizes[class_index];
+        std::lock_guard<std::mutex> class_lock_guard(size_class.lock);
+
+        void* chunk = size_class.freeChunks;
+        if (chunk != nullptr) {
+            size_class.freeChunks = size_class.freeChunks->next;
+        } else {
+            if (size_class.bumpNext == size_class.bumpEnd) {
+                char* page = static_cast<char*>(::operator new(kPageBytes));
+                size_class.pages.push_back(page);
+                size_class.bumpNext = page;
+                size_class.bumpEnd = page + kPageBytes / chunk_bytes * chunk_bytes;
+            }
+            chunk = size_class.bumpNext;
+            size_class.bumpNext += chunk_bytes;
+        }
+
+        if (size_class.usedChunks++ == 0) {
+            references.fetch_add(1, std::memory_order_relaxed);
+        }
+        size_class.requestedBytes += block_bytes;
+        return chunk;
+    }
+
+    /**
+     * @brief ValueBlock::destroy of arena blocks: put the chunk back on its free list.
+     */
+    static void DestroyBlock(ValueBlock* value_block) {
+        auto* block = static_cast<Block*>(value_block);
+        Arena* arena = block->arena;
+        uint32_t class_index = block->sizeClass;
+        size_t block_bytes = sizeof(Block) + block->size;
+        block->~Block();
+
+        if (class_index == kHeapClass) {
+            ::operator delete(static_cast<void*>(block));
+            arena->heapBytes.fetch_sub(block_bytes, std::memory_order_relaxed);
+            arena->release();
+            return;
+        }
+
+        SizeClass& size_class = arena->classes[class_index];
+        bool class_emptied = false;
+        {
+            std::lock_guard<std::mutex> class_lock_guard(size_class.lock);
+            size_class.freeChunks = new (static_cast<void*>(block)) FreeChunk{size_class.freeChunks};
+            size_class.requestedBytes -= block_bytes;
+            class_emptied = --size_class.usedChunks == 0;
+        }
+        // Outside the class lock: this may delete the arena
+        if (class_emptied) {
+            arena->release();
+        }
+    }
+};
+
+// ========================================
+// Allocation
+// ========================================
+
+SlabAllocator::SlabAllocator() : arena(new Arena()) {}
+
+SlabAllocator::~SlabAllocator() {
+    arena->release();
+}
+
+ValueHandle SlabAllocator::copy(std::string_view bytes, uint32_t decompressedSize) {
+    size_t block_bytes = sizeof(Arena::Block) + bytes.size();
+    uint32_t class_index = kHeapClass;
+    void* storage = nullptr;
+    if (block_bytes > kMaxChunkBytes) {
+        storage = ::operator new(block_bytes);
+        arena->heapBytes.fetch_add(block_bytes, std::memory_order_relaxed);
+        arena->references.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        class_index = ClassFor(block_bytes);
+        storage = arena->allocateChunk(class_index, block_bytes);
+    }
+
+    auto* block = new (storage) Arena::Block();
+    char* inline_bytes = static_cast<char*>(storage) + sizeof(Arena::Block);
+    if (!bytes.empty()) {
+        std::memcpy(inline_bytes, bytes.data(), bytes.size());
+    }
+    block->decompressedSize = decompressedSize;
+    block->size = bytes.size();
+    block->bytes = inline_bytes;
+    block->destroy = Arena::DestroyBlock;
+    block->arena = arena;
+    block->sizeClass = class_index;
+    return ValueHandle(block);
+}
+
+size_t SlabAllocator::ChargeFor(size_t valueSize) {
+    size_t block_bytes = sizeof(Arena::Block) + valueSize;
+    return block_bytes > kMaxChunkBytes ? block_bytes : kChunkSizes[ClassFor(block_bytes)];
+}
+
+SlabStats SlabAllocator::stats() const {
+    SlabStats slab_stats;
+    for (size_t class_index = 0; class_index < kClassCount; ++class_index) {
+        Arena::SizeClass& size_class = arena->classes[class_index];
+        std::lock_guard<std::mutex> class_lock_guard(size_class.lock);
+        slab_stats.pageBytes += size_class.pages.size() * kPageBytes;
+        slab_stats.chunkBytes += size_class.usedChunks * kChunkSizes[class_index];
+        slab_stats.requestedBytes += size_class.requestedBytes;
+    }
+    slab_stats.heapBytes = arena->heapBytes.load(std::memory_order_relaxed);
+    return slab_stats;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "value.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Memory held by one slab allocator, as reported in ShardStats.
+ */
+struct SlabStats {
+    size_t pageBytes = 0;      ///< Pages carved into chunks; never returned until the allocator is gone
+    size_t chunkBytes = 0;     ///< Chunks currently holding a value
+    size_t requestedBytes = 0; ///< Block headers and value bytes in those chunks
+    size_t heapBytes = 0;      ///< Blocks too large for a size class, allocated from the heap
+
+    /**
+     * @brief Share of the page bytes not holding a live value: free chunks plus chunk slack.
+     */
+    double fragmentation() const {
+        return pageBytes == 0 ? 0.0 : 1.0 - static_cast<double>(requestedBytes) / static_cast<double>(pageBytes);
+    }
+};
+
+/**
+ * @brief Per-shard slab allocator for value blocks, with memcached-style size classes.
+ *
+ * Chunk sizes start at kMinChunkBytes and grow by kGrowthFactor (rounded to
+ * 8 bytes) up to kMaxChunkBytes. A value block (header plus bytes) goes in
+ * the smallest chunk that fits; each class carves its chunks from
+ * kPageBytes pages, bump-allocating through the newest page so untouched
+ * chunks cost no resident memory. When the last handle to a value drops, its
+ * chunk goes back on the class's free list for the next value of that size
+ * instead of to free(), so a full shard recycles its memory and the global
+ * allocator sees one page allocation per 64 KiB of values rather than one
+ * call per value. Larger values fall back to the heap.
+ *
+ * copy and the release of a block can run on any thread: every class has its
+ * own small lock, held only to pop or push a chunk. Values may outlive the
+ * allocator; its pages are freed once the owner and every chunk are gone.
+ */
+class SlabAllocator {
+public:
+    static constexpr size_t kPageBytes = 64 * 1024;   ///< Size of the pages chunks are carved from
+    static constexpr size_t kMinChunkBytes = 64;      ///< Smallest chunk; room for the header and 16 value bytes
+    static constexpr size_t kMaxChunkBytes = 8 * 1024; ///< Largest chunk; bigger blocks use the heap
+    static constexpr double kGrowthFactor = 1.25;     ///< Ratio between consecutive chunk sizes
+
+    SlabAllocator();
+
+    /**
+     * @brief Drop the owner's reference; pages are freed once no value uses them.
+     */
+    ~SlabAllocator();
+
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    /**
+     * @brief Create a value holding a copy of bytes in a chunk of this allocator.
+     * @param bytes Value contents.
+     * @param decompressedSize Length before compression if bytes are an LZ4 block; 0 otherwise.
+     * @return ValueHandle Handle whose release returns the chunk to this allocator.
+     */
+    ValueHandle copy(std::string_view bytes, uint32_t decompressedSize = 0);
+
+    /**
+     * @brief Bytes a value of the given size occupies: its chunk, or header plus bytes on the heap.
+     *
+     * Used for byte-budget accounting, so an entry is charged for its slack too.
+     */
+    static size_t ChargeFor(size_t valueSize);
+
+    /**
+     * @brief Current page, chunk, and heap usage.
+     */
+    SlabStats stats() const;
+
+private:
+    struct Arena;
+    Arena* arena; ///< Shared with every live chunk
+};
@@ -0,0 +1,251 @@
+#include "snapshot.h"
+#include "append_log.h"
+#include "key_hash.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace {
+
+constexpr char kSnapshotMagic[8] = {'S', 'T', 'O', 'R', 'M', 'S', 'N', 'P'};
+constexpr uint32_t kSnapshotVersion = 1;
+constexpr size_t kHeaderBytes = sizeof(kSnapshotMagic) + 2 * sizeof(uint32_t) + 2 * sizeof(uint64_t);
+constexpr size_t kSectionTableEntryBytes = 3 * sizeof(uint64_t);
+constexpr size_t kEntryHeaderBytes = 3 * sizeof(uint32_t) + sizeof(uint64_t);
+constexpr uint64_t kChecksumSeed = 0x53544f524d534e50ull;
+
+[[noreturn]] void ThrowSystemError(int error, const std::string& what) {
+    throw std::system_error(error, std::generic_category(), what);
+}
+
+template <typename Integer>
+char* PutInteger(char* output, Integer value) {
+    std::memcpy(output, &value, sizeof(value));
+    return output + sizeof(value);
+}
+
+template <typename Integer>
+Integer GetInteger(const char* input) {
+    Integer value;
+    std::memcpy(&value, input, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Checksum of an entry: everything after its checksum field.
+ */
+uint32_t EntryChecksum(const char* checked, size_t checked_bytes) {
+    return static_cast<uint32_t>(HashKey(std::string_view(checked, checked_bytes), kChecksumSeed));
+}
+
+/**
+ * @brief Write a whole buffer at an offset, retrying short writes and EINTR.
+ */
+bool WriteAllAt(int file_descriptor, const char* bytes, size_t byte_count, uint64_t offset) {
+    while (byte_count > 0) {
+        ssize_t written = ::pwrite(file_descriptor, bytes, byte_count, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bytes += written;
+        byte_count -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+} // namespace
+
+// ========================================
+// SnapshotWriter
+// ========================================
+
+SnapshotWriter::SnapshotWriter(const std::string& path, uint64_t hash_seed, size_t section_count)
+    : finalPath(path), temporaryPath(path + ".tmp"), hashSeed(hash_seed) {
+    fileDescriptor = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fileDescriptor < 0) ThrowSystemError(errno, "open " + temporaryPath);
+
+    // Entries start after the header and table, which commit fills in
+    sections.reserve(section_count);
+    fileOffset = kHeaderBytes + section_count * kSectionTableEntryBytes;
+    buffer.reserve(kWriteChunkBytes);
+}
+
+SnapshotWriter::~SnapshotWriter() {
+    if (fileDescriptor >= 0) {
+        ::close(fileDescriptor);
+    }
+    if (!committed) {
+        ::unlink(temporaryPath.c_str());
+    }
+}
+
+void SnapshotWriter::beginSection() {
+    SectionExtent extent;
+    extent.offset = fileOffset;
+    sections.push_back(extent);
+}
+
+void SnapshotWriter::addEntry(std::string_view key, std::string_view value, uint64_t expires_at_wall_millis) {
+    size_t entry_bytes = kEntryHeaderBytes + key.size() + value.size();
+    if (buffer.size() + entry_bytes > kWriteChunkBytes) {
+        flush();
+    }
+
+    size_t entry_start = buffer.size();
+    buffer.resize(entry_start + entry_bytes);
+    char* entry = &buffer[entry_start];
+    char* cursor = PutInteger<uint32_t>(entry + sizeof(uint32_t), static_cast<uint32_t>(key.size()));
+    cursor = PutInteger<uint32_t>(cursor, static_cast<uint32_t>(value.size()));
+    cursor = PutInteger<uint64_t>(cursor, expires_at_wall_millis);
+    std::memcpy(cursor, key.data(), key.size());
+    std::memcpy(cursor + key.size(), value.data(), value.size());
+    PutInteger<uint32_t>(entry, EntryChecksum(entry + sizeof(uint32_t), entry_bytes - sizeof(uint32_t)));
+
+    fileOffset += entry_bytes;
+    sections.back().byteLength += entry_bytes;
+    sections.back().entryCount += 1;
+
+    // A single entry larger than the chunk goes out on its own
+    if (buffer.size() >= kWriteChunkBytes) {
+        flush();
+    }
+}
+
+void SnapshotWriter::flush() {
+    uint64_t buffer_offset = fileOffset - buffer.size();
+    if (!WriteAllAt(fileDescriptor, buffer.data(), buffer.size(), buffer_offset)) {
+        ThrowSystemError(errno, "write " + temporaryPath);
+    }
+    buffer.clear();
+}
+
+void SnapshotWriter::commit() {
+    flush();
+
+    // Header and section table go in last, once every extent is known
+    std::string front(kHeaderBytes + sections.size() * kSectionTableEntryBytes, '\0');
+    char* cursor = &front[0];
+    std::memcpy(cursor, kSnapshotMagic, sizeof(kSnapshotMagic));
+    cursor = PutInteger<uint32_t>(cursor + sizeof(kSnapshotMagic), kSnapshotVersion);
+    cursor = PutInteger<uint32_t>(cursor, static_cast<uint32_t>(sections.size()));
+    cursor = PutInteger<uint64_t>(cursor, hashSeed);
+    cursor = PutInteger<uint64_t>(cursor, WallClockMillis());
+    for (const SectionExtent& extent : sections) {
+        cursor = PutInteger<uint64_t>(cursor, extent.offset);
+        cursor = PutInteger<uint64_t>(cursor, extent.byteLength);
+        cursor = PutInteger<uint64_t>(cursor, extent.entryCount);
+    }
+    if (!WriteAllAt(fileDescriptor, front.data(), front.size(), 0) || ::fsync(fileDescriptor) != 0) {
+        ThrowSystemError(errno, "write " + temporaryPath);
+    }
+
+    ::close(fileDescriptor);
+    fileDescriptor = -1;
+    if (::rename(temporaryPath.c_str(), finalPath.c_str()) != 0) {
+        ThrowSystemError(errno, "rename " + temporaryPath);
+    }
+    committed = true;
+    SyncParentDirectory(finalPath);
+}
+
+// ========================================
+// SnapshotSection
+// ========================================
+
+bool SnapshotSection::next(SnapshotEntry& entry) {
+    if (remaining == 0 || damaged) {
+        return false;
+    }
+
+    size_t available = static_cast<size_t>(end - cursor);
+    if (available < kEntryHeaderBytes) {
+        damaged = true;
+        return false;
+    }
+    uint32_t checksum = GetInteger<uint32_t>(cursor);
+    uint32_t key_size = GetInteger<uint32_t>(cursor + sizeof(uint32_t));
+    uint32_t value_size = GetInteger<uint32_t>(cursor + 2 * sizeof(uint32_t));
+    size_t entry_bytes = kEntryHeaderBytes + size_t{key_size} + value_size;
+    if (available < entry_bytes ||
+        EntryChecksum(cursor + sizeof(uint32_t), entry_bytes - sizeof(uint32_t)) != checksum) {
+        damaged = true;
+        return false;
+    }
+
+    const char* key = cursor + kEntryHeaderBytes;
+    entry.expiresAtWallMillis = GetInteger<uint64_t>(cursor + 3 * sizeof(uint32_t));
+    entry.key = std::string_view(key, key_size);
+    entry.value = std::string_view(key + key_size, value_size);
+    cursor += entry_bytes;
+    --remaining;
+    return true;
+}
+
+// ========================================
+// SnapshotReader
+// ========================================
+
+SnapshotReader::SnapshotReader(const std::string& path) {
+    int file_descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file_descriptor < 0) ThrowSystemError(errno, "open " + path);
+
+    struct stat file_status;
+    if (::fstat(file_descriptor, &file_status) != 0) {
+        int error = errno;
+        ::close(file_descriptor);
+        ThrowSystemError(error, "stat " + path);
+    }
+    mappingBytes = static_cast<size_t>(file_status.st_size);
+    if (mappingBytes < kHeaderBytes) {
+        ::close(file_descriptor);
+        ThrowSystemError(EINVAL, "not a store snapshot: " + path);
+    }
+
+    // The mapping keeps the file alive; loading reads it front to back per section
+    void* mapped = ::mmap(nullptr, mappingBytes, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+    int map_error = errno;
+    ::close(file_descriptor);
+    if (mapped == MAP_FAILED) ThrowSystemError(map_error, "mmap " + path);
+    mapping = static_cast<const char*>(mapped);
+    ::madvise(mapped, mappingBytes, MADV_SEQUENTIAL);
+    ::madvise(mapped, mappingBytes, MADV_WILLNEED);
+
+    bool valid = std::memcmp(mapping, kSnapshotMagic, sizeof(kSnapshotMagic)) == 0 &&
+                 GetInteger<uint32_t>(mapping + sizeof(kSnapshotMagic)) == kSnapshotVersion;
+    if (valid) {
+        const char* cursor = mapping + sizeof(kSnapshotMagic) + sizeof(uint32_t);
+        sectionCountValue = GetInteger<uint32_t>(cursor);
+        seed = GetInteger<uint64_t>(cursor + sizeof(uint32_t));
+        createdAt = GetInteger<uint64_t>(cursor + sizeof(uint32_t) + sizeof(uint64_t));
+        valid = (mappingBytes - kHeaderBytes) / kSectionTableEntryBytes >= sectionCountValue;
+    }
+
+    // Every section must lie inside the file
+    for (size_t section_index = 0; valid && section_index < sectionCountValue; ++section_index) {
+        const char* extent = mapping + kHeaderBytes + section_index * kSectionTableEntryBytes;
+        uint64_t offset = GetInteger<uint64_t>(extent);
+        uint64_t byte_length = GetInteger<uint64_t>(extent + sizeof(uint64_t));
+        valid = offset <= mappingBytes && byte_length <= mappingBytes - offset;
+    }
+    if (!valid) {
+        ::munmap(mapped, mappingBytes);
+        ThrowSystemError(EINVAL, "not a store snapshot: " + path);
+    }
+}
+
+SnapshotReader::~SnapshotReader() {
+    ::munmap(const_cast<char*>(mapping), mappingBytes);
+}
+
+SnapshotSection SnapshotReader::section(size_t section_index) const {
+    const char* extent = mapping + kHeaderBytes + section_index * kSectionTableEntryBytes;
+    const char* begin = mapping + GetInteger<uint64_t>(extent);
+    return SnapshotSection(begin, begin + GetInteger<uint64_t>(extent + sizeof(uint64_t)),
+                           GetInteger<uint64_t>(extent + 2 * sizeof(uint64_t)));
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Point-in-time snapshot file of a store's contents, for fast startup.
+ *
+ * File layout (all integers little-endian):
+ *  - Header: the 8 bytes "STORMSNP", uint32 format version, uint32 section
+ *    count, uint64 hash seed of the store, uint64 wall-clock creation time.
+ *  - Section table: per section a uint64 file offset, uint64 byte length,
+ *    and uint64 entry count.
+ *  - Sections, one per shard, each a run of entries from least to most
+ *    recently used: uint32 checksum, uint32 key length, uint32 value length,
+ *    uint64 wall-clock deadline (0 = none), key, value. The checksum covers
+ *    everything after it in the entry.
+ *
+ * The writer fills a temporary file and renames it over the target only
+ * once it is complete and fsynced, so a snapshot file is never half-written.
+ * The reader maps the file and hands out independent section cursors, so
+ * every shard can be loaded on its own thread straight from the page cache.
+ */
+
+/**
+ * @brief Sequential writer for a snapshot file.
+ */
+class SnapshotWriter {
+public:
+    /**
+     * @brief Start writing a snapshot next to its final path.
+     * @param path Final snapshot path; the data goes to path + ".tmp" until commit.
+     * @param hashSeed Seed of the store being saved, so a store built with it sees the same shard layout.
+     * @param sectionCount Number of sections that will be written.
+     * @throws std::system_error If the temporary file cannot be created.
+     */
+    SnapshotWriter(const std::string& path, uint64_t hashSeed, size_t sectionCount);
+
+    /**
+     * @brief Remove the temporary file unless commit succeeded.
+     */
+    ~SnapshotWriter();
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    /**
+     * @brief Start the next section; sections are written in index order, and
+     *        each ends where the next one (or commit) begins.
+     */
+    void beginSection();
+
+    /**
+     * @brief Append an entry to the current section.
+     * @param key Key.
+     * @param value Value bytes.
+     * @param expiresAtWallMillis Wall-clock deadline in milliseconds, or 0 for none.
+     * @throws std::system_error If writing fails.
+     */
+    void addEntry(std::string_view key, std::string_view value, uint64_t expiresAtWallMillis);
+
+    /**
+     * @brief Write the header and section table, fsync, and rename the file into place.
+     * @throws std::system_error If any step fails; the previous snapshot at path is then untouched.
+     */
+    void commit();
+
+private:
+    /**
+     * @brief Where one section landed in the file.
+     */
+    struct SectionExtent {
+        uint64_t offset = 0;     ///< File offset of the first entry
+        uint64_t byteLength = 0; ///< Bytes of entries
+        uint64_t entryCount = 0; ///< Entries in the section
+    };
+
+    static constexpr size_t kWriteChunkBytes = size_t{1} << 20;
+
+    std::string finalPath;                ///< Snapshot path after commit
+    std::string temporaryPath;            ///< File being written
+    int fileDescriptor = -1;              ///< Open temporary file
+    uint64_t hashSeed;                    ///< Recorded in the header
+    std::vector<SectionExtent> sections;  ///< Extent of every section written so far
+    std::string buffer;                   ///< Encoded bytes not yet written
+    uint64_t fileOffset = 0;              ///< Bytes written plus buffered
+    bool committed = false;               ///< Whether the file was renamed into place
+
+    /**
+     * @brief Write out the buffered bytes.
+     */
+    void flush();
+};
+
+/**
+ * @brief One entry of a snapshot section; the views point into the mapped file.
+ */
+struct SnapshotEntry {
+    std::string_view key;             ///< Key
+    std::string_view value;           ///< Value
+    uint64_t expiresAtWallMillis = 0; ///< Wall-clock deadline; 0 = none
+};
+
+/**
+ * @brief Cursor over the entries of one section, least recently used first.
+ *
+ * Cursors only read the mapping, so several can run on different threads.
+ */
+class SnapshotSection {
+public:
+    SnapshotSection(const char* sectionBegin, const char* sectionEnd, uint64_t entryCount)
+        : cursor(sectionBegin), end(sectionEnd), remaining(entryCount) {}
+
+    /**
+     * @brief Decode the next entry.
+     * @param entry Output; its views stay valid while the SnapshotReader lives.
+     * @return true If an entry was read; false at the end of the section or at a corrupt entry.
+     */
+    bool next(SnapshotEntry& entry);
+
+    /**
+     * @brief Whether reading stopped at a corrupt or truncated entry.
+     */
+    bool corrupt() const { return damaged; }
+
+private:
+    const char* cursor;    ///< Next entry
+    const char* end;       ///< End of the section
+    uint64_t remaining;    ///< Entries not yet read
+    bool damaged = false;  ///< A checksum or length check failed
+};
+
+/**
+ * @brief Read-only memory mapping of a snapshot file.
+ */
+class SnapshotReader {
+public:
+    /**
+     * @brief Map a snapshot and check its header and section table.
+     * @param path Snapshot file.
+     * @throws std::system_error If the file cannot be mapped or is not a valid snapshot.
+     */
+    explicit SnapshotReader(const std::string& path);
+
+    ~SnapshotReader();
+
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    /**
+     * @brief Hash seed of the store that wrote the snapshot.
+     */
+    uint64_t hashSeed() const { return seed; }
+
+    /**
+     * @brief Number of sections (the writer's shard count).
+     */
+    size_t sectionCount() const { return sectionCountValue; }
+
+    /**
+     * @brief Wall-clock time the snapshot was taken, in milliseconds since the Unix epoch.
+     */
+    uint64_t createdAtWallMillis() const { return createdAt; }
+
+    /**
+     * @brief Cursor over one section.
+     * @param sectionIndex Index below sectionCount().
+     */
+    SnapshotSection section(size_t sectionIndex) const;
+
+private:
+    const char* mapping = nullptr; ///< Whole file, mapped read-only
+    size_t mappingBytes = 0;       ///< Length of the mapping
+    uint64_t seed = 0;             ///< From the header
+    size_t sectionCountValue = 0;  ///< From the header
+    uint64_t createdAt = 0;        ///< From the header
+};
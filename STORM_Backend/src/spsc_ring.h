@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/**
+ * @brief Bounded single-producer/single-consumer ring buffer.
+ *
+ * One thread may call tryPush and one other thread tryPop; neither ever
+ * blocks or takes a lock. The producer and consumer indices live on
+ * separate cache lines, and each side keeps a cached copy of the other's
+ * index, so a transfer touches the shared line only when the cached view
+ * says the ring looks full (producer) or empty (consumer).
+ *
+ * @tparam T Element type; moved in and out, so slots keep moved-from values.
+ * @tparam Capacity Number of slots; a power of two.
+ */
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    /**
+     * @brief Append an element if there is room (producer only).
+     * @return false If the ring is full; element is left untouched.
+     */
+    bool tryPush(T& element) {
+        size_t tail = producer.index.load(std::memory_order_relaxed);
+        if (tail - producer.cachedOther == Capacity) {
+            producer.cachedOther = consumer.index.load(std::memory_order_acquire);
+            if (tail - producer.cachedOther == Capacity) {
+                return false;
+            }
+        }
+        slots[tail & (Capacity - 1)] = std::move(element);
+        producer.index.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Remove the oldest element if there is one (consumer only).
+     * @return false If the ring is empty.
+     */
+    bool tryPop(T& element) {
+        size_t head = consumer.index.load(std::memory_order_relaxed);
+        if (head == consumer.cachedOther) {
+            consumer.cachedOther = producer.index.load(std::memory_order_acquire);
+            if (head == consumer.cachedOther) {
+                return false;
+            }
+        }
+        element = std::move(slots[head & (Capacity - 1)]);
+        consumer.index.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    /**
+     * @brief One side's index and its last view of the other side's.
+     */
+    struct alignas(64) Side {
+        std::atomic<size_t> index{0}; ///< Next slot this side will use
+        size_t cachedOther = 0;       ///< Other side's index when last read
+    };
+
+    Side producer;
+    Side consumer;
+    std::array<T, Capacity> slots{};
+};
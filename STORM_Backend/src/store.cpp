@@ -1,7 +1,153 @@
 #include "store.h"
+#include "compression.h"
+#include "numa_placement.h"
 #include <iostream>
 #include <algorithm>
+#include <charconv>
 #include <memory>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+namespace {
+
+/**
+ * @brief Snapshot entries decoded and copied ahead of each shard lock during a load.
+ */
+constexpr size_t kSnapshotLoadChunk = 4096;
+
+/**
+ * @brief Nanoseconds elapsed since a steady-clock time point, for the compression counters.
+ */
+uint64_t NanosSince(std::chrono::steady_clock::time_point start) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+/**
+ * @brief A fresh id for a store's near cache, never reused, so a thread's cache can tell which store filled it.
+ */
+uint64_t NextNearCacheId() {
+    static std::atomic<uint64_t> next_id{1};
+    return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Smallest power of two greater than or equal to value.
+ */
+size_t RoundUpToPowerOfTwo(size_t value) {
+    size_t rounded = 1;
+    while (rounded < value) {
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+/**
+ * @brief Current steady-clock time in milliseconds; the time base of every TTL deadline.
+ */
+uint64_t NowMillis() {
+    auto since_epoch = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(since_epoch).count());
+}
+
+/**
+ * @brief Absolute deadline for a positive time to live, clamped to what EntryState can hold.
+ */
+uint64_t DeadlineAfter(std::chrono::milliseconds ttl) {
+    uint64_t now = NowMillis();
+    uint64_t ttl_millis = static_cast<uint64_t>(ttl.count());
+    if (ttl_millis > EntryState::kMaxExpiresAt - now) {
+        return EntryState::kMaxExpiresAt;
+    }
+    return now + ttl_millis;
+}
+
+/**
+ * @brief Whether an entry carries a deadline that has passed.
+ */
+template <typename Entry>
+bool IsExpired(const Entry& entry) {
+    uint64_t expires_at = entry.state.expiresAt();
+    return expires_at != 0 && expires_at <= NowMillis();
+}
+
+/**
+ * @brief Wall-clock form of a steady-clock deadline, for the append log (0 stays 0).
+ */
+uint64_t WallDeadline(uint64_t expires_at) {
+    if (expires_at == 0) {
+        return 0;
+    }
+    uint64_t now = NowMillis();
+    return WallClockMillis() + (expires_at > now ? expires_at - now : 0);
+}
+
+/**
+ * @brief Times evictToFit moves the entry it must keep away from the eviction tail before giving up.
+ */
+constexpr unsigned kProtectedVictimRetries = 4;
+
+/**
+ * @brief Attempts update makes with the shard unlocked for compression before it does that work under the lock.
+ */
+constexpr unsigned kUnlockedUpdateAttempts = 4;
+
+/**
+ * @brief Whether two handles share one value block, or are both empty.
+ *
+ * The caller holds both handles, so a block cannot be freed and its address
+ * reused by another value while they are compared.
+ */
+bool SameValue(const ValueHandle& first, const ValueHandle& second) {
+    return static_cast<bool>(first) == static_cast<bool>(second) && (!first || first.data() == second.data());
+}
+
+/**
+ * @brief Time left until a logged wall-clock deadline; non-positive once it has passed.
+ */
+std::chrono::milliseconds TimeUntilWall(uint64_t expires_at_wall_millis) {
+    return std::chrono::milliseconds(static_cast<int64_t>(expires_at_wall_millis) -
+                                     static_cast<int64_t>(WallClockMillis()));
+}
+
+/**
+ * @brief Fields of a scan cursor, packed as bits 0-3 layout tag, 4-7 table tag,
+ *        8-39 table position, and 40-63 the shard's place in the visiting order.
+ */
+struct ScanCursor {
+    static constexpr uint64_t kTagMask = 0xF;
+
+    size_t shardOrder = 0; ///< Index into the visiting order, not the shard index itself
+    size_t position = 0;   ///< Next table position of that shard
+    uint64_t layoutTag = 0; ///< Low bits of the layout epoch the scan runs under
+    uint64_t tableTag = 0;  ///< Low bits of the shard table's positionEpoch
+
+    static ScanCursor Unpack(uint64_t cursor) {
+        ScanCursor fields;
+        fields.layoutTag = cursor & kTagMask;
+        fields.tableTag = (cursor >> 4) & kTagMask;
+        fields.position = static_cast<size_t>((cursor >> 8) & UINT32_MAX);
+        fields.shardOrder = static_cast<size_t>(cursor >> 40);
+        return fields;
+    }
+
+    uint64_t pack() const {
+        return layoutTag | (tableTag << 4) | (static_cast<uint64_t>(position) << 8) |
+               (static_cast<uint64_t>(shardOrder) << 40);
+    }
+
+    /**
+     * @brief Tag of a table's positionEpoch, a rehash count; it only repeats after 16 rehashes,
+     *        a 65536-fold growth of the table between two scan calls.
+     */
+    static uint64_t TableTag(size_t position_epoch) {
+        return static_cast<uint64_t>(position_epoch) & kTagMask;
+    }
+};
+
+} // namespace
 
 // ========================================
 // Constructor
@@ -11,20 +157,116 @@
  * @brief Construct a new Store object with multiple shards.
  * @param shard_capacity Maximum number of key-value pairs per shard.
  * @param total_shards Total number of independent shards to create.
+ * @param read_recency_mode How get records recency.
  * 
  * Each shard maintains its own LRU list, hash map, and mutex to
  * reduce lock contention in concurrent operations.
  */
-Store::Store(size_t shard_capacity, size_t total_shards) {
-    // Reserve space for all shards to avoid repeated allocations
-    shards.reserve(total_shards);
+template <typename ShardTable, typename EvictionPolicy>
+BasicStore<ShardTable, EvictionPolicy>::BasicStore(size_t shard_capacity, size_t total_shards, RecencyMode read_recency_mode)
+    : BasicStore(StoreOptions{shard_capacity, total_shards, read_recency_mode}) {}
+
+/**
+ * @brief Construct a new Store from a full set of options.
+ * @param options Shard layout, recency mode, and memory limits.
+ *
+ * The byte budget is split evenly across shards (see makeShard). Without an
+ * explicit hash seed a random one is drawn, so key placement differs from
+ * store to store. Slots for up to maxShardCount shards are reserved so that
+ * reshard can add shards later.
+ *
+ * In NUMA-aware mode the shards are divided into one contiguous block per
+ * node, and each shard, its index, and its policy state are allocated while
+ * that node is preferred. Entries and values added later are placed by the
+ * writing thread, so callers should run writers on the shard's node.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+BasicStore<ShardTable, EvictionPolicy>::BasicStore(const StoreOptions& options)
+    : recencyMode(options.recencyMode), maxValueBytes(options.maxValueBytes), hashSeed(options.hashSeed),
+      keysPerShard(options.maxKeysPerShard == 0 ? SIZE_MAX : options.maxKeysPerShard),
+      memoryBudget(options.memoryBudget), numaAware(options.numaAware),
+      compressionThreshold(options.compressionThreshold) {
+    if (hashSeed == 0) {
+        std::random_device seed_source;
+        hashSeed = (uint64_t{seed_source()} << 32) | seed_source();
+    }
+    if (options.nearCacheSlots != 0) {
+        nearCacheSlots = RoundUpToPowerOfTwo(options.nearCacheSlots);
+        nearCacheId = NextNearCacheId();
+        keyVersions = std::make_unique<KeyVersions>();
+    }
+
+    size_t total_shards = std::min(std::max<size_t>(1, options.shardCount), kMaxShardCount);
+    size_t slot_count = std::min(std::max(total_shards, options.maxShardCount), kMaxShardCount);
 
-    // Initialize each shard with its capacity
+    // Every slot exists from the start so the vector never reallocates under concurrent readers
+    shards.resize(slot_count);
     for (size_t shard_index = 0; shard_index < total_shards; ++shard_index) {
-        auto shard_pointer = std::make_unique<Shard>();
-        shard_pointer->capacity = shard_capacity;
-        shards.push_back(std::move(shard_pointer));
+        shards[shard_index] = makeShard(shard_index, total_shards);
+    }
+    constructedShards = total_shards;
+
+    shardByteBudget.store(budgetShare(total_shards), std::memory_order_relaxed);
+    shardLayout.store(PackLayout(total_shards, total_shards, 0), std::memory_order_release);
+}
+
+/**
+ * @brief Destroy the store once no drain task can touch it any more.
+ *
+ * A drain task posted to a shared executor may still be running its last
+ * batch; it signals completion as its final access to the store.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+BasicStore<ShardTable, EvictionPolicy>::~BasicStore() {
+    while (pendingDrains.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+}
+
+/**
+ * @brief Each shard's share of the memory budget.
+ * @param shard_count Number of shards sharing it.
+ * @return size_t Bytes per shard, or 0 for unlimited.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+size_t BasicStore<ShardTable, EvictionPolicy>::budgetShare(size_t shard_count) const {
+    if (memoryBudget == 0) {
+        return 0;
+    }
+    // Tiny budgets still mean bounded, not unlimited
+    return std::max<size_t>(1, memoryBudget / shard_count);
+}
+
+/**
+ * @brief Build a shard sized for its share of a layout.
+ * @param shard_index Slot the shard will occupy.
+ * @param shard_count Shard count of the layout.
+ * @return std::unique_ptr<Shard> The new shard.
+ *
+ * When a byte budget is set, the key capacity is further capped at the most
+ * entries that could fit in the shard's share, so slab and index sizing
+ * follow the budget. In NUMA-aware mode the slot's block of the layout picks
+ * the node, and the shard is built while that node is preferred.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+std::unique_ptr<typename BasicStore<ShardTable, EvictionPolicy>::Shard>
+BasicStore<ShardTable, EvictionPolicy>::makeShard(size_t shard_index, size_t shard_count) const {
+    size_t shard_byte_budget = budgetShare(shard_count);
+    size_t shard_capacity = keysPerShard;
+    if (shard_byte_budget != 0) {
+        shard_capacity = std::min(shard_capacity, shard_byte_budget / EntryCharge(0, 0));
+    }
+
+    const std::vector<int>& numa_nodes = NumaNodes();
+    int shard_node = -1;
+    if (numaAware && !numa_nodes.empty()) {
+        shard_node = numa_nodes[shard_index * numa_nodes.size() / shard_count];
     }
+
+    NumaAllocationScope allocation_scope(shard_node);
+    auto shard = std::make_unique<Shard>(shard_capacity, shard_byte_budget);
+    shard->numaNode = shard_node;
+    return shard;
 }
 
 // ========================================
@@ -35,16 +277,127 @@ Store::Store(size_t shard_capacity, size_t total_shards) {
  * @brief Insert or update a key-value pair in the store.
  * @param key Key to insert/update.
  * @param value Value to associate with the key.
- * @return true Always returns true after operation.
+ * @return true If the pair was stored; false if it is too large to admit.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+bool BasicStore<ShardTable, EvictionPolicy>::put(std::string_view key, std::string_view value) {
+    // Reject before copying, then copy the bytes into the shard's slab before taking the lock
+    if (!admitsCopy(key.size(), value.size())) {
+        return false;
+    }
+    uint64_t key_hash = keyHash(key);
+    return putWithDeadline(key, key_hash, copyValue(key_hash, value), 0, value);
+}
+
+/**
+ * @brief Insert or update a key with an already-built value handle.
+ * @param key Key to insert/update.
+ * @param value Value to associate with the key.
+ * @return true If the pair was stored; false if it is too large to admit.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+bool BasicStore<ShardTable, EvictionPolicy>::put(std::string_view key, ValueHandle value) {
+    return putWithDeadline(key, keyHash(key), std::move(value), 0);
+}
+
+/**
+ * @brief Lock the key's shard and insert or update it with an absolute deadline.
+ * @param key Key to insert/update.
+ * @param key_hash Key hash from keyHash.
+ * @param value Value to store.
+ * @param expires_at Deadline in steady-clock milliseconds, or 0 for no expiry.
+ * @param plain_value Uncompressed bytes, logged in place of a compressed value.
+ * @return true If the pair was stored.
+ * @return false If the value is larger than the store admits.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+bool BasicStore<ShardTable, EvictionPolicy>::putWithDeadline(std::string_view key, uint64_t key_hash, ValueHandle value,
+                                                             uint64_t expires_at, std::string_view plain_value) {
+    LatencyTimer latency_timer(latencyRecorder, LatencyOp::Put);
+    if (!admits(key.size(), value.size())) {
+        return false;
+    }
+
+    // Declared before the guard so overwritten and evicted values are freed after unlocking
+    DisplacedValues displaced_values;
+    std::unique_lock<std::shared_mutex> shard_lock_guard;
+    Shard& target_shard = lockKeyShard(key, key_hash, shard_lock_guard);
+    reapExpired(target_shard);
+
+    // Perform the insertion/update in the shard; the bytes outlive the lock via the entry or displaced_values
+    std::string_view value_bytes = value.compressed() ? plain_value : value.view();
+    if (!putInShard(target_shard, key, key_hash, std::move(value), expires_at, displaced_values)) {
+        return false;
+    }
+    operationCounters.add(StoreCounter::Puts);
+    if (logging()) {
+        logPut(key, value_bytes, WallDeadline(expires_at));
+    }
+    return true;
+}
+
+/**
+ * @brief Copy a value into its shard's slab, compressed if it is large enough and shrinks enough.
+ * @param key_hash Key hash from keyHash.
+ * @param value Bytes to store.
+ * @return ValueHandle The stored value; compressed() tells which form it took.
+ *
+ * The compressor writes into a per-thread buffer an eighth smaller than the
+ * value, so data that would not save at least that much is detected by the
+ * compressor running out of room and is stored verbatim.
  */
-bool Store::put(const std::string& key, const std::string& value) {
-    Shard& target_shard = *shards[shardIndex(key)];
+template <typename ShardTable, typename EvictionPolicy>
+ValueHandle BasicStore<ShardTable, EvictionPolicy>::copyValue(uint64_t key_hash, std::string_view value) {
+    SlabAllocator& value_slab =
+        shards[ShardFor(key_hash, LayoutShards(shardLayout.load(std::memory_order_acquire)))]->valueSlab;
+    if (compressionThreshold == 0 || value.size() < compressionThreshold || value.size() > UINT32_MAX) {
+        return value_slab.copy(value);
+    }
+
+    thread_local std::vector<char> compressed_buffer;
+    size_t capacity = value.size() - value.size() / 8;
+    if (compressed_buffer.size() < capacity) {
+        compressed_buffer.resize(capacity);
+    }
+
+    auto compress_start = std::chrono::steady_clock::now();
+    size_t compressed_size = Lz4Compress(value.data(), value.size(), compressed_buffer.data(), capacity);
+    operationCounters.add(StoreCounter::CompressNanos, NanosSince(compress_start));
+    if (compressed_size == 0) {
+        operationCounters.add(StoreCounter::IncompressibleValues);
+        return value_slab.copy(value);
+    }
+
+    operationCounters.add(StoreCounter::CompressedValues);
+    operationCounters.add(StoreCounter::CompressInputBytes, value.size());
+    operationCounters.add(StoreCounter::CompressOutputBytes, compressed_size);
+    return value_slab.copy(std::string_view(compressed_buffer.data(), compressed_size),
+                           static_cast<uint32_t>(value.size()));
+}
 
-    // Lock the shard to ensure thread safety
-    std::lock_guard<std::mutex> shard_lock_guard(target_shard.shardLock);
+/**
+ * @brief Decompress a compressed value into a new handle; other values are returned as they are.
+ * @param value Value taken from an entry.
+ * @return ValueHandle The original bytes.
+ * @throws std::runtime_error If the stored block is corrupt, which only memory corruption could cause.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+ValueHandle BasicStore<ShardTable, EvictionPolicy>::decodeValue(ValueHandle value) {
+    if (!value.compressed()) {
+        return value;
+    }
 
-    // Perform the insertion/update in the shard
-    return putInShard(target_shard, key, value);
+    auto decompress_start = std::chrono::steady_clock::now();
+    bool decoded = false;
+    ValueHandle plain_value = ValueHandle::build(value.decompressedSize(), [&](char* bytes) {
+        decoded = Lz4Decompress(value.data(), value.size(), bytes, value.decompressedSize());
+    });
+    operationCounters.add(StoreCounter::DecompressNanos, NanosSince(decompress_start));
+    operationCounters.add(StoreCounter::Decompressions);
+    if (!decoded) {
+        throw std::runtime_error("corrupt compressed value");
+    }
+    return plain_value;
 }
 
 /**
@@ -54,11 +407,115 @@ bool Store::put(const std::string& key, const std::string& value) {
  * @return true If key exists and value is retrieved.
  * @return false If key does not exist.
  */
-bool Store::get(const std::string& key, std::string& value) {
-    Shard& target_shard = *shards[shardIndex(key)];
-    std::lock_guard<std::mutex> shard_lock_guard(target_shard.shardLock);
+template <typename ShardTable, typename EvictionPolicy>
+bool BasicStore<ShardTable, EvictionPolicy>::get(std::string_view key, std::string& value) {
+    LatencyTimer latency_timer(latencyRecorder, LatencyOp::Get);
+    uint64_t key_hash = keyHash(key);
+
+    // Copied from the near cache without taking a reference on the shared value
+    if (const ValueHandle* cached_value = findNearCached(key, key_hash)) {
+        value.assign(cached_value->data(), cached_value->size());
+        return true;
+    }
+
+    ValueHandle value_handle = readThrough(key, key_hash);
+    if (!value_handle) {
+        return false;
+    }
+
+    // Copy outside the shard lock
+    value.assign(value_handle.data(), value_handle.size());
+    return true;
+}
+
+/**
+ * @brief Retrieve a shared handle to the value for a given key.
+ * @param key Key to retrieve.
+ * @return ValueHandle Current value, or an empty handle if the key does not exist.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+ValueHandle BasicStore<ShardTable, EvictionPolicy>::get(std::string_view key) {
+    LatencyTimer latency_timer(latencyRecorder, LatencyOp::Get);
+    uint64_t key_hash = keyHash(key);
+    if (const ValueHandle* cached_value = findNearCached(key, key_hash)) {
+        return *cached_value;
+    }
+    return readThrough(key, key_hash);
+}
+
+/**
+ * @brief Sample the read for its shard's hot-key tracker, then probe the thread's near cache.
+ *
+ * Sampling comes first so that keys served from near caches stay hot.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+const ValueHandle* BasicStore<ShardTable, EvictionPolicy>::findNearCached(std::string_view key, uint64_t key_hash) {
+    if (HotKeyTracker::ShouldSample()) {
+        size_t shard_count = LayoutShards(shardLayout.load(std::memory_order_acquire));
+        shards[ShardFor(key_hash, shard_count)]->hotKeys.record(key, key_hash);
+    }
+    if (keyVersions == nullptr) {
+        return nullptr;
+    }
+
+    NearCache& near_cache = NearCache::ForThread(nearCacheId, nearCacheSlots);
+    const ValueHandle* cached_value = near_cache.find(key, TableHash(key_hash), *keyVersions);
+    if (cached_value != nullptr) {
+        operationCounters.add(StoreCounter::Hits);
+        operationCounters.add(StoreCounter::NearCacheHits);
+    }
+    return cached_value;
+}
+
+/**
+ * @brief Look the key up under its shard lock, and near-cache the value if the key is hot.
+ *
+ * The key's version is read under the same lock as the value, so any later
+ * change to the key invalidates the cached copy. Keys with a TTL are not
+ * cached, since a hit does not check deadlines.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+ValueHandle BasicStore<ShardTable, EvictionPolicy>::readThrough(std::string_view key, uint64_t key_hash) {
+    ValueHandle value_handle;
+    bool cacheable = false;
+    uint64_t key_version = 0;
+    auto note_cacheable = [&](Shard& target_shard) {
+        if (keyVersions == nullptr || !target_shard.hotKeys.isHot(key_hash)) {
+            return;
+        }
+        Entry* entry = target_shard.table.find(key, TableHash(key_hash));
+        if (entry != nullptr && entry->state.expiresAt() == 0) {
+            cacheable = true;
+            key_version = keyVersions->load(TableHash(key_hash));
+        }
+    };
+
+    if (recencyMode == RecencyMode::Clock) {
+        std::shared_lock<std::shared_mutex> shard_lock_guard;
+        Shard& target_shard = lockKeyShard(key, key_hash, shard_lock_guard);
+        bool found = peekFromShard(target_shard, key, key_hash, value_handle);
+        operationCounters.add(found ? StoreCounter::Hits : StoreCounter::Misses);
+        if (found) {
+            note_cacheable(target_shard);
+        }
+    } else {
+        std::unique_lock<std::shared_mutex> shard_lock_guard;
+        Shard& target_shard = lockKeyShard(key, key_hash, shard_lock_guard);
+        reapExpired(target_shard);
+        bool found = getFromShard(target_shard, key, key_hash, value_handle);
+        operationCounters.add(found ? StoreCounter::Hits : StoreCounter::Misses);
+        if (found) {
+            note_cacheable(target_shard);
+        }
+    }
 
-    return getFromShard(target_shard, key, value);
+    // Decompressed after the lock is released, and cached decompressed
+    value_handle = decodeValue(std::move(value_handle));
+    if (cacheable) {
+        NearCache::ForThread(nearCacheId, nearCacheSlots).insert(key, TableHash(key_hash), key_version, value_handle);
+        operationCounters.add(StoreCounter::NearCacheFills);
+    }
+    return value_handle;
 }
 
 /**
@@ -67,174 +524,1906 @@ bool Store::get(const std::string& key, std::string& value) {
  * @return true If key existed and was deleted.
  * @return false If key does not exist.
  */
-bool Store::del(const std::string& key) {
-    Shard& target_shard = *shards[shardIndex(key)];
-    std::lock_guard<std::mutex> shard_lock_guard(target_shard.shardLock);
+template <typename ShardTable, typename EvictionPolicy>
+bool BasicStore<ShardTable, EvictionPolicy>::del(std::string_view key) {
+    LatencyTimer latency_timer(latencyRecorder, LatencyOp::Del);
+    uint64_t key_hash = keyHash(key);
+
+    // Declared before the guard so the removed value is freed after unlocking
+    ValueHandle removed_value;
+    std::unique_lock<std::shared_mutex> shard_lock_guard;
+    Shard& target_shard = lockKeyShard(key, key_hash, shard_lock_guard);
+    reapExpired(target_shard);
 
-    return delFromShard(target_shard, key);
+    if (!delFromShard(target_shard, key, key_hash, removed_value)) {
+        return false;
+    }
+    operationCounters.add(StoreCounter::Deletes);
+    if (logging()) {
+        logDelete(key);
+    }
+    return true;
 }
 
 // ========================================
-// Per-shard operations
+// Expiration
 // ========================================
 
 /**
- * @brief Insert or update a key-value pair within a specific shard.
- * @param shard Target shard to perform the operation.
+ * @brief Insert or update a key that expires after ttl.
  * @param key Key to insert/update.
  * @param value Value to associate with the key.
- * @return true Always returns true after operation.
- * 
- * Handles LRU eviction if shard exceeds capacity.
- */
-bool Store::putInShard(Shard& shard, const std::string& key, const std::string& value) {
-    auto entry_iterator = shard.store.find(key);
-
-    // Key exists: update value and move to front of LRU
-    if (entry_iterator != shard.store.end()) {
-        entry_iterator->second.value = value;
-        shard.recencyList.splice(
-            shard.recencyList.begin(),
-            shard.recencyList,
-            entry_iterator->second.recencyIt
-        );
-        entry_iterator->second.recencyIt = shard.recencyList.begin();
-    } 
-    // Key does not exist: insert new entry
-    else {
-        // Evict least recently used item if shard capacity exceeded
-        if (shard.store.size() >= shard.capacity) {
-            const std::string& lru_key = shard.recencyList.back();
-            shard.store.erase(lru_key);
-            shard.recencyList.pop_back();
-        }
-
-        // Insert new key at front of LRU list
-        shard.recencyList.push_front(key);
-        shard.store.emplace(key, Entry{value, shard.recencyList.begin()});
+ * @param ttl Time to live; non-positive deletes the key.
+ * @return true If the pair was stored; false if it is too large to admit.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+bool BasicStore<ShardTable, EvictionPolicy>::put(std::string_view key, std::string_view value, std::chrono::milliseconds ttl) {
+    if (ttl.count() <= 0) {
+        del(key);
+        return true;
+    }
+    if (!admitsCopy(key.size(), value.size())) {
+        return false;
     }
+    uint64_t key_hash = keyHash(key);
+    return putWithDeadline(key, key_hash, copyValue(key_hash, value), DeadlineAfter(ttl), value);
+}
 
-    return true;
+/**
+ * @brief Insert or update a key with a value handle that expires after ttl.
+ * @param key Key to insert/update.
+ * @param value Value to associate with the key.
+ * @param ttl Time to live; non-positive deletes the key.
+ * @return true If the pair was stored; false if it is too large to admit.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+bool BasicStore<ShardTable, EvictionPolicy>::put(std::string_view key, ValueHandle value, std::chrono::milliseconds ttl) {
+    if (ttl.count() <= 0) {
+        del(key);
+        return true;
+    }
+    return putWithDeadline(key, keyHash(key), std::move(value), DeadlineAfter(ttl));
 }
 
 /**
- * @brief Retrieve the value for a key within a specific shard.
- * @param shard Target shard.
- * @param key Key to retrieve.
- * @param value Output parameter for value.
- * @return true If key exists and value retrieved.
- * @return false If key does not exist.
- * 
- * Updates recency list on access to maintain LRU ordering.
+ * @brief Set or replace the time to live of an existing key.
+ * @param key Key to update.
+ * @param ttl Time to live from now; non-positive deletes the key.
+ * @return true If the key exists.
+ * @return false If the key does not exist.
  */
-bool Store::getFromShard(Shard& shard, const std::string& key, std::string& value) {
-    auto entry_iterator = shard.store.find(key);
+template <typename ShardTable, typename EvictionPolicy>
+bool BasicStore<ShardTable, EvictionPolicy>::expire(std::string_view key, std::chrono::milliseconds ttl) {
+    if (ttl.count() <= 0) {
+        return del(key);
+    }
 
-    if (entry_iterator == shard.store.end()) {
+    uint64_t key_hash = keyHash(key);
+    std::unique_lock<std::shared_mutex> shard_lock_guard;
+    Shard& target_shard = lockKeyShard(key, key_hash, shard_lock_guard);
+    reapExpired(target_shard);
+
+    Entry* entry = findLive(target_shard, key, key_hash);
+    if (entry == nullptr) {
         return false;
     }
 
-    // Move key to front of LRU list to mark it as recently used
-    shard.recencyList.splice(
-        shard.recencyList.begin(),
-        shard.recencyList,
-        entry_iterator->second.recencyIt
-    );
-    entry_iterator->second.recencyIt = shard.recencyList.begin();
-
-    value = entry_iterator->second.value;
+    uint64_t expires_at = DeadlineAfter(ttl);
+    setDeadline(target_shard, *entry, expires_at);
+    invalidateNearCaches(TableHash(key_hash));
+    if (logging()) {
+        logExpire(key, WallDeadline(expires_at));
+    }
     return true;
 }
 
 /**
- * @brief Delete a key-value pair from a specific shard.
- * @param shard Target shard.
- * @param key Key to delete.
- * @return true If key existed and was deleted.
- * @return false If key does not exist.
+ * @brief Remove the time to live of a key.
+ * @param key Key to update.
+ * @return true If the key existed and had a TTL.
+ * @return false Otherwise.
  */
-bool Store::delFromShard(Shard& shard, const std::string& key) {
-    auto entry_iterator = shard.store.find(key);
+template <typename ShardTable, typename EvictionPolicy>
+bool BasicStore<ShardTable, EvictionPolicy>::persist(std::string_view key) {
+    uint64_t key_hash = keyHash(key);
+    std::unique_lock<std::shared_mutex> shard_lock_guard;
+    Shard& target_shard = lockKeyShard(key, key_hash, shard_lock_guard);
+    reapExpired(target_shard);
 
-    if (entry_iterator == shard.store.end()) {
+    Entry* entry = findLive(target_shard, key, key_hash);
+    if (entry == nullptr || entry->state.expiresAt() == 0) {
         return false;
     }
 
-    shard.recencyList.erase(entry_iterator->second.recencyIt);
-    shard.store.erase(entry_iterator);
+    // The wheel record goes stale and is discarded when it comes due
+    setDeadline(target_shard, *entry, 0);
+    if (logging()) {
+        logExpire(key, 0);
+    }
     return true;
 }
 
-// ========================================
-// Batch operations
-// ========================================
+/**
+ * @brief Remaining time to live of a key.
+ * @param key Key to inspect.
+ * @return int64_t Milliseconds left, kTtlPersistent, or kTtlMissing.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+int64_t BasicStore<ShardTable, EvictionPolicy>::ttl(std::string_view key) {
+    uint64_t key_hash = keyHash(key);
+    std::shared_lock<std::shared_mutex> shard_lock_guard;
+    Shard& target_shard = lockKeyShard(key, key_hash, shard_lock_guard);
+
+    Entry* entry = target_shard.table.find(key, TableHash(key_hash));
+    if (entry == nullptr) {
+        return kTtlMissing;
+    }
+
+    uint64_t expires_at = entry->state.expiresAt();
+    if (expires_at == 0) {
+        return kTtlPersistent;
+    }
+
+    uint64_t now = NowMillis();
+    return expires_at <= now ? kTtlMissing : static_cast<int64_t>(expires_at - now);
+}
 
 /**
- * @brief Insert multiple key-value pairs into the store efficiently.
- * @param key_value_pairs Vector of key-value pairs to insert.
- * 
- * Groups keys by shard to minimize lock acquisitions.
+ * @brief Find a key, erasing it first if it has expired.
+ * @param shard Target shard, locked exclusively.
+ * @param key Key to look up.
+ * @param key_hash Key hash from keyHash.
+ * @return Entry* Live entry, or nullptr.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+typename BasicStore<ShardTable, EvictionPolicy>::Entry* BasicStore<ShardTable, EvictionPolicy>::findLive(
+    Shard& shard, std::string_view key, uint64_t key_hash) {
+    Entry* entry = shard.table.find(key, TableHash(key_hash));
+
+    // Lazy expiry: an expired entry is reclaimed by whoever touches it first
+    if (entry != nullptr && IsExpired(*entry)) {
+        eraseEntry(shard, entry);
+        ++shard.expirations;
+        return nullptr;
+    }
+    return entry;
+}
+
+/**
+ * @brief Set an entry's deadline and schedule it on the shard's wheel.
+ * @param shard Shard owning the entry, locked exclusively.
+ * @param entry Entry to update.
+ * @param expires_at Deadline in steady-clock milliseconds, or 0 for no expiry.
  */
-void Store::putMany(const std::vector<std::pair<std::string, std::string>>& key_value_pairs) {
-    std::vector<std::vector<std::pair<std::string, std::string>>> shard_batches(shards.size());
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::setDeadline(Shard& shard, Entry& entry, uint64_t expires_at) {
+    if (entry.state.expiresAt() == expires_at) {
+        return;
+    }
+    entry.state.setExpiresAt(expires_at);
+
+    if (expires_at == 0) {
+        return;
+    }
+    if (shard.expiryWheel == nullptr) {
+        shard.expiryWheel = std::make_unique<ExpiryWheel>(NowMillis());
+    }
+    shard.expiryWheel->schedule(ShardTable::expiryRefOf(entry), expires_at);
+}
 
-    // Assign keys to their respective shard batches
-    for (const auto& key_value_pair : key_value_pairs) {
-        size_t target_shard_index = shardIndex(key_value_pair.first);
-        shard_batches[target_shard_index].push_back(key_value_pair);
+/**
+ * @brief Reclaim a bounded number of expired entries from the shard's wheel.
+ * @param shard Shard to reap, locked exclusively.
+ *
+ * Called by every writer after taking the lock, so reclamation is spread
+ * across foreground operations and never scans the shard. Shards that have
+ * never seen a TTL only pay a null check.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::reapExpired(Shard& shard) {
+    if (shard.expiryWheel == nullptr || shard.expiryWheel->empty()) {
+        return;
     }
 
-    // Insert batch into each shard while holding a single lock per shard
-    for (size_t shard_index = 0; shard_index < shards.size(); ++shard_index) {
-        if (shard_batches[shard_index].empty()) continue;
+    uint64_t now = NowMillis();
+    ShardTable& table = shard.table;
+    ExpiryWheel& expiry_wheel = *shard.expiryWheel;
 
-        Shard& target_shard = *shards[shard_index];
-        std::lock_guard<std::mutex> shard_lock_guard(target_shard.shardLock);
+    expiry_wheel.advance(now, kExpiryReapBudget, [&](const typename ExpiryWheel::Record& record) {
+        Entry* entry = table.resolveExpiryRef(record.entry);
 
-        for (const auto& key_value_pair : shard_batches[shard_index]) {
-            putInShard(target_shard, key_value_pair.first, key_value_pair.second);
+        // Records left behind by deletes, overwrites, and TTL changes no longer match
+        if (entry == nullptr || entry->state.expiresAt() != record.expiresAt) {
+            return;
         }
-    }
+        if (record.expiresAt > now) {
+            expiry_wheel.schedule(record.entry, record.expiresAt);
+            return;
+        }
+        eraseEntry(shard, entry);
+        ++shard.expirations;
+    });
 }
 
 // ========================================
-// Utility operations
+// Read-modify-write operations
 // ========================================
 
 /**
- * @brief Clear all shards, removing every key-value pair.
+ * @brief Apply an update function to a key under its shard lock.
+ * @param key Key to update.
+ * @param update_function Decides the new value; runs with the shard locked.
+ * @return UpdateStatus What was done.
+ *
+ * Small values are decided, copied, and stored in one lock hold, and the
+ * entry found is handed straight to storeInShard, so the key is looked up
+ * once. Decompressing a compressed current value and compressing a new
+ * value of at least compressionThreshold bytes happen with the lock
+ * released, like in put. The shard is then locked again, and the work is
+ * used only if the key still holds the same value block. Otherwise it is
+ * redone, and after kUnlockedUpdateAttempts conflicts it is done under the
+ * lock, so a busy key cannot starve the update.
  */
-void Store::clear() {
-    for (auto& shard_pointer : shards) {
-        Shard& shard = *shard_pointer;
-        std::lock_guard<std::mutex> shard_lock_guard(shard.shardLock);
+template <typename ShardTable, typename EvictionPolicy>
+UpdateStatus BasicStore<ShardTable, EvictionPolicy>::update(std::string_view key, const UpdateFunction& update_function) {
+    LatencyTimer latency_timer(latencyRecorder, LatencyOp::Put);
+    uint64_t key_hash = keyHash(key);
+
+    // Work done while unlocked belongs to observed_value, the stored handle it started from
+    ValueHandle observed_value;
+    ValueHandle current_value;
+    ValueHandle prepared_value;
+    std::string next_value;
+    bool observed = false;
+    bool prepared = false;
+
+    for (unsigned attempt = 0;; ++attempt) {
+        bool may_unlock = attempt < kUnlockedUpdateAttempts;
 
-        shard.store.clear();
-        shard.recencyList.clear();
+        // Declared before the guard so replaced and evicted values are freed after unlocking
+        DisplacedValues displaced_values;
+        std::unique_lock<std::shared_mutex> shard_lock_guard;
+        Shard& target_shard = lockKeyShard(key, key_hash, shard_lock_guard);
+        reapExpired(target_shard);
+
+        Entry* entry = findLive(target_shard, key, key_hash);
+        ValueHandle stored_value = entry != nullptr ? entry->value : ValueHandle();
+        if (!observed || !SameValue(stored_value, observed_value)) {
+            // First look, or the key changed while the lock was released
+            displaced_values.add(std::move(observed_value));
+            displaced_values.add(std::move(current_value));
+            displaced_values.add(std::move(prepared_value));
+            observed_value = stored_value;
+            observed = true;
+            prepared = false;
+            if (stored_value.compressed() && may_unlock) {
+                shard_lock_guard.unlock();
+                current_value = decodeValue(std::move(stored_value));
+                continue;
+            }
+            current_value = decodeValue(std::move(stored_value));
+        }
+
+        if (!prepared) {
+            next_value.clear();
+            UpdateAction update_action = update_function(current_value, next_value);
+            if (update_action == UpdateAction::Keep) {
+                return UpdateStatus::Unchanged;
+            }
+            if (update_action == UpdateAction::Delete) {
+                if (entry == nullptr) {
+                    return UpdateStatus::Unchanged;
+                }
+                displaced_values.add(eraseEntry(target_shard, entry));
+                operationCounters.add(StoreCounter::Deletes);
+                if (logging()) {
+                    logDelete(key);
+                }
+                return UpdateStatus::Deleted;
+            }
+
+            if (!admitsCopy(key.size(), next_value.size())) {
+                return UpdateStatus::Rejected;
+            }
+            bool compresses = compressionThreshold != 0 && next_value.size() >= compressionThreshold;
+            if (compresses && may_unlock) {
+                shard_lock_guard.unlock();
+                prepared_value = copyValue(key_hash, next_value);
+                prepared = true;
+                continue;
+            }
+            prepared_value = copyValue(key_hash, next_value);
+        }
+
+        uint64_t expires_at = entry != nullptr ? entry->state.expiresAt() : 0;
+        if (!admits(key.size(), prepared_value.size()) ||
+            !storeInShard(target_shard, entry, key, key_hash, std::move(prepared_value), expires_at,
+                          displaced_values)) {
+            return UpdateStatus::Rejected;
+        }
+        operationCounters.add(StoreCounter::Puts);
+        if (logging()) {
+            logPut(key, next_value, WallDeadline(expires_at));
+        }
+        return UpdateStatus::Stored;
     }
 }
 
+template <typename ShardTable, typename EvictionPolicy>
+bool BasicStore<ShardTable, EvictionPolicy>::compareAndSet(std::string_view key, std::string_view expected,
+                                                           std::string_view desired) {
+    UpdateStatus update_status = update(key, [&](const ValueHandle& current, std::string& next) {
+        if (!current || current.view() != expected) {
+            return UpdateAction::Keep;
+        }
+        next.assign(desired.data(), desired.size());
+        return UpdateAction::Store;
+    });
+    return update_status == UpdateStatus::Stored;
+}
+
 /**
- * @brief Print the contents of all shards for debugging.
+ * @brief Add delta to a decimal integer value, refusing non-integers and overflow.
  */
-void Store::list() {
-    for (size_t shard_index = 0; shard_index < shards.size(); ++shard_index) {
-        Shard& shard = *shards[shard_index];
-        std::lock_guard<std::mutex> shard_lock_guard(shard.shardLock);
-
-        std::cout << "{ \"shard_" << shard_index << "\": {\n";
-
-        for (auto it = shard.recencyList.begin(); it != shard.recencyList.end(); ++it) {
-            const std::string& key = *it;
-            const Entry& entry = shard.store.at(key);
-
-            std::cout << "  \"" << key << "\": \"" << entry.value << "\"";
-            if (std::next(it) != shard.recencyList.end()) {
-                std::cout << ",";
+template <typename ShardTable, typename EvictionPolicy>
+bool BasicStore<ShardTable, EvictionPolicy>::incrBy(std::string_view key, int64_t delta, int64_t& result) {
+    int64_t sum = 0;
+    UpdateStatus update_status = update(key, [&](const ValueHandle& current, std::string& next) {
+        int64_t current_number = 0;
+        if (current) {
+            std::string_view digits = current.view();
+            auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), current_number);
+            if (digits.empty() || error != std::errc() || end != digits.data() + digits.size()) {
+                return UpdateAction::Keep;
             }
-            std::cout << "\n";
         }
+        if (__builtin_add_overflow(current_number, delta, &sum)) {
+            return UpdateAction::Keep;
+        }
+        next = std::to_string(sum);
+        return UpdateAction::Store;
+    });
+    if (update_status != UpdateStatus::Stored) {
+        return false;
+    }
+    result = sum;
+    return true;
+}
 
-        std::cout << "} }\n";
+template <typename ShardTable, typename EvictionPolicy>
+bool BasicStore<ShardTable, EvictionPolicy>::append(std::string_view key, std::string_view suffix, size_t& length) {
+    size_t new_length = 0;
+    UpdateStatus update_status = update(key, [&](const ValueHandle& current, std::string& next) {
+        next.reserve((current ? current.size() : 0) + suffix.size());
+        if (current) {
+            next.assign(current.data(), current.size());
+        }
+        next.append(suffix.data(), suffix.size());
+        new_length = next.size();
+        return UpdateAction::Store;
+    });
+    if (update_status != UpdateStatus::Stored) {
+        return false;
     }
+    length = new_length;
+    return true;
 }
+
+// ========================================
+// Per-shard operations
+// ========================================
+
+/**
+ * @brief Insert or update a key-value pair within a specific shard, given the key's table entry.
+ * @param shard Target shard to perform the operation.
+ * @param entry The key's entry as found by the caller, or nullptr.
+ * @param key Key to insert/update.
+ * @param value Value to associate with the key.
+ * @param expires_at Deadline in steady-clock milliseconds, or 0 for no expiry.
+ * @param displaced Collects the overwritten and evicted values so the caller
+ *                  can release them after unlocking the shard.
+ * @return true If the pair is now stored.
+ * @return false If the shard could not make room; the key keeps its old value or stays absent.
+ *
+ * Evicts as many least recently used entries as it takes to stay within
+ * both the key count and the byte budget.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+bool BasicStore<ShardTable, EvictionPolicy>::storeInShard(Shard& shard, Entry* entry, std::string_view key,
+                                                          uint64_t key_hash, ValueHandle value, uint64_t expires_at,
+                                                          DisplacedValues& displaced) {
+    ShardTable& table = shard.table;
+    size_t new_charge = EntryCharge(key.size(), value.size());
+
+    // Key exists (expired or not): update value and count the write as an access
+    if (entry != nullptr) {
+        size_t old_charge = EntryCharge(key.size(), entry->value.size());
+        shard.residentBytes -= old_charge;
+        entry->state.clearReferenced();
+        shard.policy.onAccess(table, entry);
+
+        // A larger value may push the shard over budget; never evict the entry itself
+        if (!evictToFit(shard, new_charge, false, entry, displaced)) {
+            // Keep the old value rather than exceed the budget
+            shard.residentBytes += old_charge;
+            return false;
+        }
+        std::swap(entry->value, value);
+        displaced.add(std::move(value));
+        shard.residentBytes += new_charge;
+    }
+    // Key does not exist: make room, then insert and let the policy place it
+    else if (evictToFit(shard, new_charge, true, nullptr, displaced)) {
+        entry = table.insert(key, TableHash(key_hash), std::move(value));
+        shard.policy.onInsert(table, entry);
+        shard.residentBytes += new_charge;
+    }
+
+    if (entry == nullptr) {
+        return false;
+    }
+    setDeadline(shard, *entry, expires_at);
+    invalidateNearCaches(TableHash(key_hash));
+    return true;
+}
+
+/**
+ * @brief Evict least recently used entries until a new charge fits the shard.
+ * @param shard Target shard, locked exclusively.
+ * @param incoming_charge Bytes about to be added.
+ * @param needs_slot Whether the incoming entry also needs a free key slot.
+ * @param protected_entry Entry that must not be evicted (the one being overwritten), or nullptr.
+ * @param displaced Collects the evicted values.
+ * @return true If the charge now fits.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+bool BasicStore<ShardTable, EvictionPolicy>::evictToFit(Shard& shard, size_t incoming_charge, bool needs_slot,
+                                        Entry* protected_entry, DisplacedValues& displaced) {
+    auto fits = [&] {
+        bool bytes_fit = shard.byteBudget == 0 || shard.residentBytes + incoming_charge <= shard.byteBudget;
+        bool slot_fits = !needs_slot || shard.table.size() < shard.table.capacity();
+        return bytes_fit && slot_fits;
+    };
+
+    unsigned protected_picks = 0;
+    while (!fits()) {
+        Entry* victim_entry = selectVictim(shard);
+        if (victim_entry == nullptr) {
+            return false;
+        }
+        if (victim_entry == protected_entry) {
+            // Promoting referenced entries can leave the protected one at the tail; move it and pick again
+            if (++protected_picks > kProtectedVictimRetries) {
+                return false;
+            }
+            shard.policy.onAccess(shard.table, victim_entry);
+            continue;
+        }
+        displaced.add(eraseEntry(shard, victim_entry));
+        ++shard.evictions;
+    }
+    return true;
+}
+
+/**
+ * @brief Remove an entry and release its share of the shard's byte budget.
+ * @param shard Shard owning the entry, locked exclusively.
+ * @param entry Entry to remove.
+ * @return ValueHandle The removed value, so the caller decides where it is released.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+ValueHandle BasicStore<ShardTable, EvictionPolicy>::eraseEntry(Shard& shard, Entry* entry) {
+    shard.residentBytes -= EntryCharge(ShardTable::keyOf(*entry).size(), entry->value.size());
+    invalidateNearCaches(ShardTable::hashOf(*entry));
+    ValueHandle removed_value = std::move(entry->value);
+    shard.table.erase(entry);
+    return removed_value;
+}
+
+/**
+ * @brief Retrieve the value for a key within a specific shard.
+ * @param shard Target shard.
+ * @param key Key to retrieve.
+ * @param value Output parameter for value.
+ * @return true If key exists and value retrieved.
+ * @return false If key does not exist.
+ * 
+ * Updates recency list on access to maintain LRU ordering.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+bool BasicStore<ShardTable, EvictionPolicy>::getFromShard(Shard& shard, std::string_view key, uint64_t key_hash,
+                                                          ValueHandle& value) {
+    Entry* entry = findLive(shard, key, key_hash);
+
+    if (entry == nullptr) {
+        return false;
+    }
+
+    // Record the access so the eviction policy sees the key as recently used
+    shard.policy.onAccess(shard.table, entry);
+
+    value = entry->value;
+    return true;
+}
+
+/**
+ * @brief Retrieve the value for a key within a specific shard without reordering it.
+ * @param shard Target shard, locked shared or exclusive.
+ * @param key Key to retrieve.
+ * @param value Output parameter for value.
+ * @return true If key exists and value retrieved.
+ * @return false If key does not exist.
+ * 
+ * Marks the entry as referenced; the promotion is applied later by a writer.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+bool BasicStore<ShardTable, EvictionPolicy>::peekFromShard(Shard& shard, std::string_view key, uint64_t key_hash,
+                                                           ValueHandle& value) {
+    Entry* entry = shard.table.find(key, TableHash(key_hash));
+
+    if (entry == nullptr) {
+        return false;
+    }
+
+    // Expired entries read as missing; the next writer reclaims them
+    if (IsExpired(*entry)) {
+        return false;
+    }
+
+    // Only store when the bit is clear to avoid dirtying the cache line on every hit
+    entry->state.markReferenced();
+
+    value = entry->value;
+    return true;
+}
+
+/**
+ * @brief Select the eviction victim of a full shard.
+ * @param shard Target shard, locked exclusively.
+ * @return Entry* Entry to evict, or nullptr if the shard is empty.
+ * 
+ * Referenced candidates have their deferred access replayed through the
+ * policy and their bit cleared, so the loop terminates after at most one
+ * pass over the shard.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+typename BasicStore<ShardTable, EvictionPolicy>::Entry* BasicStore<ShardTable, EvictionPolicy>::selectVictim(Shard& shard) {
+    Entry* victim_entry = shard.policy.selectVictim(shard.table);
+
+    while (victim_entry != nullptr && victim_entry->state.referenced()) {
+        victim_entry->state.clearReferenced();
+        shard.policy.onAccess(shard.table, victim_entry);
+        victim_entry = shard.policy.selectVictim(shard.table);
+    }
+
+    return victim_entry;
+}
+
+/**
+ * @brief Delete a key-value pair from a specific shard.
+ * @param shard Target shard.
+ * @param key Key to delete.
+ * @param removed_value Receives the deleted value so it can be released after unlocking.
+ * @return true If key existed and was deleted.
+ * @return false If key does not exist.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+bool BasicStore<ShardTable, EvictionPolicy>::delFromShard(Shard& shard, std::string_view key, uint64_t key_hash,
+                                                          ValueHandle& removed_value) {
+    Entry* entry = findLive(shard, key, key_hash);
+
+    if (entry == nullptr) {
+        return false;
+    }
+
+    removed_value = eraseEntry(shard, entry);
+    return true;
+}
+
+// ========================================
+// Batch operations
+// ========================================
+
+/**
+ * @brief Bucket a batch of keys by shard using a counting sort over input indices.
+ * @param key_count Number of keys in the batch.
+ * @param key_at Callable returning the key at an input index.
+ * @param groups Output offsets and positions; input order is kept within each shard.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+template <typename KeyAt>
+void BasicStore<ShardTable, EvictionPolicy>::groupByShard(size_t key_count, KeyAt key_at, ShardGroups& groups) {
+    groups.layout = shardLayout.load(std::memory_order_acquire);
+    size_t shard_count = LayoutShards(groups.layout);
+
+    std::vector<size_t> key_shards(key_count);
+    groups.offsets.assign(shard_count + 1, 0);
+    groups.hashes.resize(key_count);
+
+    // Hash every key once, count keys per shard, then turn the counts into run offsets
+    for (size_t position = 0; position < key_count; ++position) {
+        groups.hashes[position] = keyHash(key_at(position));
+        key_shards[position] = ShardFor(groups.hashes[position], shard_count);
+        ++groups.offsets[key_shards[position] + 1];
+
+        if (LayoutMigrating(groups.layout)) {
+            migrateKey(key_at(position), groups.hashes[position], groups.layout);
+        }
+    }
+    for (size_t shard_index = 0; shard_index < shard_count; ++shard_index) {
+        groups.offsets[shard_index + 1] += groups.offsets[shard_index];
+    }
+
+    // Scatter input indices into their shard's run
+    std::vector<size_t> next_slot(groups.offsets.begin(), groups.offsets.end() - 1);
+    groups.positions.resize(key_count);
+    for (size_t position = 0; position < key_count; ++position) {
+        groups.positions[next_slot[key_shards[position]]++] = position;
+    }
+}
+
+/**
+ * @brief Run per-shard work for every shard that has keys in the batch.
+ * @param groups Batch grouped by shard.
+ * @param batch_size Number of keys in the batch.
+ * @param shard_work Callable taking (shard index, first group index, end group index).
+ *
+ * Batches of at least parallelBatchThreshold keys are spread over the executor,
+ * one task per non-empty shard; smaller batches run on the caller's thread.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+template <typename ShardWork>
+void BasicStore<ShardTable, EvictionPolicy>::forEachShardGroup(const ShardGroups& groups, size_t batch_size, ShardWork shard_work) {
+    size_t shard_count = groups.offsets.size() - 1;
+    if (executor == nullptr || batch_size < parallelBatchThreshold) {
+        for (size_t shard_index = 0; shard_index < shard_count; ++shard_index) {
+            if (groups.offsets[shard_index] == groups.offsets[shard_index + 1]) continue;
+            shard_work(shard_index, groups.offsets[shard_index], groups.offsets[shard_index + 1]);
+        }
+        return;
+    }
+
+    std::vector<size_t> busy_shards;
+    for (size_t shard_index = 0; shard_index < shard_count; ++shard_index) {
+        if (groups.offsets[shard_index] != groups.offsets[shard_index + 1]) {
+            busy_shards.push_back(shard_index);
+        }
+    }
+
+    executor->parallelFor(busy_shards.size(), [&](size_t task_index) {
+        size_t shard_index = busy_shards[task_index];
+        shard_work(shard_index, groups.offsets[shard_index], groups.offsets[shard_index + 1]);
+    });
+}
+
+/**
+ * @brief Insert multiple key-value pairs into the store efficiently.
+ * @param key_value_pairs Vector of key-value pairs to insert.
+ * @return size_t Number of pairs stored.
+ * 
+ * Groups keys by shard to minimize lock acquisitions.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+size_t BasicStore<ShardTable, EvictionPolicy>::putMany(const std::vector<std::pair<std::string, std::string>>& key_value_pairs) {
+    LatencyTimer latency_timer(latencyRecorder, LatencyOp::PutMany);
+    ShardGroups shard_groups;
+    groupByShard(key_value_pairs.size(),
+                 [&](size_t position) { return std::string_view(key_value_pairs[position].first); },
+                 shard_groups);
+
+    std::vector<ValueHandle> values(key_value_pairs.size());
+    std::atomic<size_t> total_stored_count{0};
+
+    forEachShardGroup(shard_groups, key_value_pairs.size(),
+                      [&](size_t shard_index, size_t group_begin, size_t group_end) {
+        // Copy this shard's values before its lock is taken; oversized values stay empty and are skipped
+        for (size_t group_index = group_begin; group_index < group_end; ++group_index) {
+            size_t position = shard_groups.positions[group_index];
+            const auto& key_value_pair = key_value_pairs[position];
+            if (!admitsCopy(key_value_pair.first.size(), key_value_pair.second.size())) {
+                continue;
+            }
+            values[position] = copyValue(shard_groups.hashes[position], key_value_pair.second);
+            // A value that did not compress enough to fit is dropped like any oversized one
+            if (compressionThreshold != 0 && !admits(key_value_pair.first.size(), values[position].size())) {
+                values[position] = ValueHandle();
+            }
+        }
+
+        // Freed after the guard below is released; sized up front so the lock is never held across an allocation
+        DisplacedValues displaced_values;
+        displaced_values.reserve(group_end - group_begin);
+
+        // Insert the shard's sub-batch while holding a single lock
+        Shard& target_shard = *shards[shard_index];
+        auto shard_lock_guard = lockShard<std::unique_lock<std::shared_mutex>>(target_shard);
+
+        // A reshard started or finished since grouping; route each key again
+        if (shardLayout.load(std::memory_order_acquire) != shard_groups.layout) {
+            shard_lock_guard.unlock();
+            size_t rerouted_count = 0;
+            for (size_t group_index = group_begin; group_index < group_end; ++group_index) {
+                size_t position = shard_groups.positions[group_index];
+                if (values[position] &&
+                    putWithDeadline(key_value_pairs[position].first, shard_groups.hashes[position],
+                                    std::move(values[position]), 0, key_value_pairs[position].second)) {
+                    ++rerouted_count;
+                }
+            }
+            total_stored_count.fetch_add(rerouted_count, std::memory_order_relaxed);
+            return;
+        }
+        reapExpired(target_shard);
+
+        uint64_t stored_count = 0;
+        for (size_t group_index = group_begin; group_index < group_end; ++group_index) {
+            size_t position = shard_groups.positions[group_index];
+            if (!values[position]) continue;
+            std::string_view key = key_value_pairs[position].first;
+            if (!putInShard(target_shard, key, shard_groups.hashes[position], std::move(values[position]), 0,
+                            displaced_values)) {
+                continue;
+            }
+            ++stored_count;
+            if (logging()) {
+                logPut(key, key_value_pairs[position].second, 0);
+            }
+        }
+        operationCounters.add(StoreCounter::Puts, stored_count);
+        total_stored_count.fetch_add(stored_count, std::memory_order_relaxed);
+    });
+
+    return total_stored_count.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Retrieve multiple keys, locking each shard at most once.
+ * @param keys Keys to retrieve.
+ * @param values Output handles in input order; empty for missing keys.
+ * @return size_t Number of keys found.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+size_t BasicStore<ShardTable, EvictionPolicy>::getMany(const std::vector<std::string_view>& keys,
+                                       std::vector<ValueHandle>& values) {
+    LatencyTimer latency_timer(latencyRecorder, LatencyOp::GetMany);
+    ShardGroups shard_groups;
+    groupByShard(keys.size(), [&](size_t position) { return keys[position]; }, shard_groups);
+
+    values.clear();
+    values.resize(keys.size());
+    std::atomic<size_t> found_count{0};
+
+    forEachShardGroup(shard_groups, keys.size(), [&](size_t shard_index, size_t group_begin, size_t group_end) {
+        Shard& target_shard = *shards[shard_index];
+        size_t shard_found_count = 0;
+
+        // Keys whose shard may have changed since grouping are fetched one by one
+        auto get_each = [&] {
+            for (size_t group_index = group_begin; group_index < group_end; ++group_index) {
+                size_t position = shard_groups.positions[group_index];
+                values[position] = get(keys[position]);
+                shard_found_count += values[position] ? 1 : 0;
+            }
+        };
+
+        if (recencyMode == RecencyMode::Clock) {
+            auto shard_lock_guard = lockShard<std::shared_lock<std::shared_mutex>>(target_shard);
+            if (shardLayout.load(std::memory_order_acquire) != shard_groups.layout) {
+                shard_lock_guard.unlock();
+                get_each();
+                found_count.fetch_add(shard_found_count, std::memory_order_relaxed);
+                return;
+            }
+            for (size_t group_index = group_begin; group_index < group_end; ++group_index) {
+                size_t position = shard_groups.positions[group_index];
+                shard_found_count +=
+                    peekFromShard(target_shard, keys[position], shard_groups.hashes[position], values[position]) ? 1 : 0;
+            }
+        } else {
+            auto shard_lock_guard = lockShard<std::unique_lock<std::shared_mutex>>(target_shard);
+            if (shardLayout.load(std::memory_order_acquire) != shard_groups.layout) {
+                shard_lock_guard.unlock();
+                get_each();
+                found_count.fetch_add(shard_found_count, std::memory_order_relaxed);
+                return;
+            }
+            reapExpired(target_shard);
+            for (size_t group_index = group_begin; group_index < group_end; ++group_index) {
+                size_t position = shard_groups.positions[group_index];
+                shard_found_count +=
+                    getFromShard(target_shard, keys[position], shard_groups.hashes[position], values[position]) ? 1 : 0;
+            }
+        }
+
+        // The shard is unlocked again; decompress what was found
+        if (compressionThreshold != 0) {
+            for (size_t group_index = group_begin; group_index < group_end; ++group_index) {
+                size_t position = shard_groups.positions[group_index];
+                values[position] = decodeValue(std::move(values[position]));
+            }
+        }
+
+        operationCounters.add(StoreCounter::Hits, shard_found_count);
+        operationCounters.add(StoreCounter::Misses, (group_end - group_begin) - shard_found_count);
+        found_count.fetch_add(shard_found_count, std::memory_order_relaxed);
+    });
+
+    return found_count.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Delete multiple keys, locking each shard at most once.
+ * @param keys Keys to delete.
+ * @return size_t Number of keys that existed and were deleted.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+size_t BasicStore<ShardTable, EvictionPolicy>::delMany(const std::vector<std::string_view>& keys) {
+    LatencyTimer latency_timer(latencyRecorder, LatencyOp::DelMany);
+    ShardGroups shard_groups;
+    groupByShard(keys.size(), [&](size_t position) { return keys[position]; }, shard_groups);
+
+    // Removed values are parked here and freed after every lock is released
+    std::vector<ValueHandle> removed_values(keys.size());
+    std::atomic<size_t> deleted_count{0};
+
+    forEachShardGroup(shard_groups, keys.size(), [&](size_t shard_index, size_t group_begin, size_t group_end) {
+        Shard& target_shard = *shards[shard_index];
+        size_t shard_deleted_count = 0;
+        auto shard_lock_guard = lockShard<std::unique_lock<std::shared_mutex>>(target_shard);
+
+        // A reshard started or finished since grouping; route each key again
+        if (shardLayout.load(std::memory_order_acquire) != shard_groups.layout) {
+            shard_lock_guard.unlock();
+            for (size_t group_index = group_begin; group_index < group_end; ++group_index) {
+                shard_deleted_count += del(keys[shard_groups.positions[group_index]]) ? 1 : 0;
+            }
+            deleted_count.fetch_add(shard_deleted_count, std::memory_order_relaxed);
+            return;
+        }
+        reapExpired(target_shard);
+
+        for (size_t group_index = group_begin; group_index < group_end; ++group_index) {
+            size_t position = shard_groups.positions[group_index];
+            if (delFromShard(target_shard, keys[position], shard_groups.hashes[position], removed_values[position])) {
+                ++shard_deleted_count;
+                if (logging()) {
+                    logDelete(keys[position]);
+                }
+            }
+        }
+
+        operationCounters.add(StoreCounter::Deletes, shard_deleted_count);
+        deleted_count.fetch_add(shard_deleted_count, std::memory_order_relaxed);
+    });
+
+    return deleted_count.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Run large batches' per-shard work on a thread pool.
+ * @param pool Pool to use, or nullptr to keep every batch on the caller's thread.
+ * @param minimum_batch_size Smallest batch that is handed to the pool.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::setExecutor(std::shared_ptr<WorkerPool> pool, size_t minimum_batch_size) {
+    executor = std::move(pool);
+    parallelBatchThreshold = minimum_batch_size;
+}
+
+// ========================================
+// Asynchronous operations
+// ========================================
+
+/**
+ * @brief Look up a key, queueing the lookup if its shard is contended.
+ * @param key Key to retrieve.
+ * @param done Receives the value, or an empty handle.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::getAsync(std::string_view key, GetCallback done) {
+    AsyncOp operation;
+    operation.type = AsyncOp::Type::Get;
+    operation.key.assign(key);
+    operation.keyHash = keyHash(key);
+    operation.onGet = std::move(done);
+    submitAsync(std::move(operation));
+}
+
+/**
+ * @brief Store a key, queueing the write if its shard is contended.
+ * @param key Key to insert or update.
+ * @param value Value to store.
+ * @param done Optional; receives whether the pair was stored.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::putAsync(std::string_view key, std::string_view value, WriteCallback done) {
+    // Oversized values are refused here, like put(), and never reach a queue
+    if (!admitsCopy(key.size(), value.size())) {
+        if (done) {
+            done(false);
+        }
+        return;
+    }
+
+    AsyncOp operation;
+    operation.type = AsyncOp::Type::Put;
+    operation.key.assign(key);
+    operation.keyHash = keyHash(key);
+    operation.value = copyValue(operation.keyHash, value);
+    // admitsCopy skips the byte budget for values that may compress; hold the stored size to it now
+    if (compressionThreshold != 0 && !admits(key.size(), operation.value.size())) {
+        if (done) {
+            done(false);
+        }
+        return;
+    }
+    if (operation.value.compressed() && logging()) {
+        operation.plainValue.assign(value);
+    }
+    operation.onWrite = std::move(done);
+    submitAsync(std::move(operation));
+}
+
+/**
+ * @brief Delete a key, queueing the delete if its shard is contended.
+ * @param key Key to delete.
+ * @param done Optional; receives whether the key existed.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::delAsync(std::string_view key, WriteCallback done) {
+    AsyncOp operation;
+    operation.type = AsyncOp::Type::Del;
+    operation.key.assign(key);
+    operation.keyHash = keyHash(key);
+    operation.onWrite = std::move(done);
+    submitAsync(std::move(operation));
+}
+
+/**
+ * @brief Run an operation inline when its shard lock is free, otherwise queue it for a drain task.
+ * @param operation Filled-in operation.
+ *
+ * The fast path is skipped while the shard has a drain scheduled, so an
+ * operation never overtakes one the same thread queued earlier, and while
+ * a reshard migrates, since the key may still live in its old shard.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::submitAsync(AsyncOp operation) {
+    if constexpr (kLatencyTracking) {
+        operation.submittedAt = std::chrono::steady_clock::now();
+    }
+
+    std::shared_ptr<WorkerPool> pool = executor;
+    if (pool == nullptr) {
+        // Nobody could drain a queue, so block like the synchronous forms
+        if (operation.type == AsyncOp::Type::Get) {
+            operation.value = get(operation.key);
+        } else if (operation.type == AsyncOp::Type::Put) {
+            operation.succeeded = putWithDeadline(operation.key, operation.keyHash, std::move(operation.value), 0,
+                                                  operation.plainValue);
+        } else {
+            operation.succeeded = del(operation.key);
+        }
+        completeAsync(operation, false);
+        return;
+    }
+
+    uint64_t layout = shardLayout.load(std::memory_order_acquire);
+    size_t shard_index = ShardFor(operation.keyHash, LayoutShards(layout));
+    Shard& target_shard = *shards[shard_index];
+
+    if (!LayoutMigrating(layout) && !target_shard.drainScheduled.load(std::memory_order_acquire)) {
+        // Declared before the guard so displaced values are freed after unlocking
+        DisplacedValues displaced_values;
+        std::unique_lock<std::shared_mutex> shard_lock_guard(target_shard.shardLock, std::try_to_lock);
+        if (shard_lock_guard.owns_lock() && shardLayout.load(std::memory_order_acquire) == layout) {
+            latencyRecorder.record(LatencyOp::LockAcquire, 0);
+            reapExpired(target_shard);
+            runLockedAsync(target_shard, operation, displaced_values);
+            shard_lock_guard.unlock();
+            completeAsync(operation, true);
+            return;
+        }
+    }
+
+    bool schedule_drain = false;
+    {
+        std::lock_guard<std::mutex> submission_lock_guard(target_shard.submissionLock);
+        target_shard.submissions.push_back(std::move(operation));
+        schedule_drain = !target_shard.drainScheduled.exchange(true, std::memory_order_acq_rel);
+    }
+    if (schedule_drain) {
+        pendingDrains.fetch_add(1, std::memory_order_relaxed);
+        pool->post([this, shard_index] {
+            drainSubmissions(shard_index);
+            pendingDrains.fetch_sub(1, std::memory_order_release);
+        });
+    }
+}
+
+/**
+ * @brief Perform one async operation under its shard's exclusive lock.
+ * @param shard The key's shard.
+ * @param operation Operation; receives the value or success flag.
+ * @param displaced_values Receives values that must outlive the lock.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::runLockedAsync(Shard& shard, AsyncOp& operation,
+                                                            DisplacedValues& displaced_values) {
+    if (operation.type == AsyncOp::Type::Get) {
+        bool found = getFromShard(shard, operation.key, operation.keyHash, operation.value);
+        operationCounters.add(found ? StoreCounter::Hits : StoreCounter::Misses);
+        return;
+    }
+
+    if (operation.type == AsyncOp::Type::Put) {
+        std::string_view value_bytes = operation.value.compressed() ? std::string_view(operation.plainValue)
+                                                                    : operation.value.view();
+        operation.succeeded = putInShard(shard, operation.key, operation.keyHash, std::move(operation.value), 0,
+                                         displaced_values);
+        if (operation.succeeded) {
+            operationCounters.add(StoreCounter::Puts);
+            if (logging()) {
+                logPut(operation.key, value_bytes, WallDeadline(0));
+            }
+        }
+        return;
+    }
+
+    ValueHandle removed_value;
+    operation.succeeded = delFromShard(shard, operation.key, operation.keyHash, removed_value);
+    displaced_values.add(std::move(removed_value));
+    if (operation.succeeded) {
+        operationCounters.add(StoreCounter::Deletes);
+        if (logging()) {
+            logDelete(operation.key);
+        }
+    }
+}
+
+/**
+ * @brief Drain a shard's submission queue until it stays empty.
+ * @param shard_index Shard to drain.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::drainSubmissions(size_t shard_index) {
+    Shard& target_shard = *shards[shard_index];
+    std::vector<AsyncOp> batch;
+    std::vector<bool> rerouted;
+
+    while (true) {
+        {
+            std::lock_guard<std::mutex> submission_lock_guard(target_shard.submissionLock);
+            if (target_shard.submissions.empty()) {
+                target_shard.drainScheduled.store(false, std::memory_order_release);
+                return;
+            }
+            batch.swap(target_shard.submissions);
+        }
+
+        rerouted.assign(batch.size(), false);
+        {
+            // Declared before the guard so displaced values are freed after unlocking
+            DisplacedValues displaced_values;
+            auto shard_lock_guard = lockShard<std::unique_lock<std::shared_mutex>>(target_shard);
+            uint64_t layout = shardLayout.load(std::memory_order_acquire);
+            bool stable_layout = !LayoutMigrating(layout);
+            reapExpired(target_shard);
+            for (size_t position = 0; position < batch.size(); ++position) {
+                if (stable_layout && ShardFor(batch[position].keyHash, LayoutShards(layout)) == shard_index) {
+                    runLockedAsync(target_shard, batch[position], displaced_values);
+                } else {
+                    rerouted[position] = true;
+                }
+            }
+        }
+
+        // Callbacks run unlocked; rerouted operations take the normal path in queue order
+        for (size_t position = 0; position < batch.size(); ++position) {
+            AsyncOp& operation = batch[position];
+            if (rerouted[position]) {
+                if (operation.type == AsyncOp::Type::Get) {
+                    operation.value = get(operation.key);
+                } else if (operation.type == AsyncOp::Type::Put) {
+                    operation.succeeded = putWithDeadline(operation.key, operation.keyHash,
+                                                          std::move(operation.value), 0, operation.plainValue);
+                } else {
+                    operation.succeeded = del(operation.key);
+                }
+            }
+            completeAsync(operation, !rerouted[position]);
+        }
+        batch.clear();
+    }
+}
+
+/**
+ * @brief Finish an async operation: record its latency and hand over the result.
+ * @param operation Completed operation.
+ * @param record_latency false if a synchronous form ran it and already recorded it.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::completeAsync(AsyncOp& operation, bool record_latency) {
+    if (kLatencyTracking && record_latency) {
+        auto elapsed = std::chrono::steady_clock::now() - operation.submittedAt;
+        LatencyOp latency_op = operation.type == AsyncOp::Type::Get   ? LatencyOp::Get
+                               : operation.type == AsyncOp::Type::Put ? LatencyOp::Put
+                                                                      : LatencyOp::Del;
+        latencyRecorder.record(latency_op, static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    if (operation.type == AsyncOp::Type::Get) {
+        if (operation.onGet) {
+            operation.onGet(decodeValue(std::move(operation.value)));
+        }
+    } else if (operation.onWrite) {
+        operation.onWrite(operation.succeeded);
+    }
+}
+
+// ========================================
+// Persistence
+// ========================================
+
+/**
+ * @brief Log every later mutation to an append-only log.
+ * @param log Log to append to, or nullptr to stop logging.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::setAppendLog(std::shared_ptr<AppendLog> log) {
+    appendLog = std::move(log);
+}
+
+/**
+ * @brief Stream every later mutation to a replication backlog.
+ * @param log Backlog to append to, or nullptr to stop.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::setReplicationLog(std::shared_ptr<ReplicationLog> log) {
+    replicationLog = std::move(log);
+}
+
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::logPut(std::string_view key, std::string_view value,
+                                                    uint64_t expires_at_wall_millis) {
+    if (appendLog) appendLog->appendPut(key, value, expires_at_wall_millis);
+    if (replicationLog) replicationLog->appendPut(key, value, expires_at_wall_millis);
+}
+
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::logDelete(std::string_view key) {
+    if (appendLog) appendLog->appendDelete(key);
+    if (replicationLog) replicationLog->appendDelete(key);
+}
+
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::logExpire(std::string_view key, uint64_t expires_at_wall_millis) {
+    if (appendLog) appendLog->appendExpire(key, expires_at_wall_millis);
+    if (replicationLog) replicationLog->appendExpire(key, expires_at_wall_millis);
+}
+
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::logClear() {
+    if (appendLog) appendLog->appendClear();
+    if (replicationLog) replicationLog->appendClear();
+}
+
+/**
+ * @brief Apply one logged mutation.
+ * @param record Decoded record.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::apply(const LogRecord& record) {
+    switch (record.type) {
+        case LogRecordType::Put:
+            if (record.expiresAtWallMillis == 0) {
+                put(record.key, record.value);
+            } else {
+                put(record.key, record.value, TimeUntilWall(record.expiresAtWallMillis));
+            }
+            break;
+        case LogRecordType::Delete:
+            del(record.key);
+            break;
+        case LogRecordType::Expire:
+            if (record.expiresAtWallMillis == 0) {
+                persist(record.key);
+            } else {
+                expire(record.key, TimeUntilWall(record.expiresAtWallMillis));
+            }
+            break;
+        case LogRecordType::Clear:
+            clear();
+            break;
+    }
+}
+
+/**
+ * @brief Re-apply a log's records in order through the public operations.
+ * @param reader Reader positioned after the header.
+ * @return size_t Number of records applied.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+size_t BasicStore<ShardTable, EvictionPolicy>::replay(AppendLogReader& reader) {
+    LogRecord record;
+    size_t applied_count = 0;
+    while (reader.next(record)) {
+        apply(record);
+        ++applied_count;
+    }
+    return applied_count;
+}
+
+/**
+ * @brief Save every live entry, shard by shard, least recently used first.
+ * @param path Snapshot file.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::snapshot(const std::string& path) {
+    struct SavedEntry {
+        std::string key;
+        ValueHandle value;
+        uint64_t expiresAt;
+    };
+    std::vector<SavedEntry> saved_entries;
+
+    while (true) {
+        uint64_t layout = shardLayout.load(std::memory_order_acquire);
+        size_t shard_span = LayoutSpan(layout);
+        // Keys only move towards shards still to be visited, as in scan
+        bool descending = LayoutSources(layout) > LayoutShards(layout);
+        SnapshotWriter snapshot_writer(path, hashSeed, shard_span);
+
+        for (size_t shard_order = 0; shard_order < shard_span; ++shard_order) {
+            Shard& shard = *shards[descending ? shard_span - 1 - shard_order : shard_order];
+            saved_entries.clear();
+            {
+                // Only keys and handles are taken under the lock; the bytes are written after it
+                std::shared_lock<std::shared_mutex> shard_lock_guard(shard.shardLock);
+                saved_entries.reserve(shard.table.size());
+                shard.table.forEachByRecency([&saved_entries](const std::string& key, const Entry& entry) {
+                    if (!IsExpired(entry)) {
+                        saved_entries.push_back(SavedEntry{key, entry.value, entry.state.expiresAt()});
+                    }
+                });
+            }
+
+            snapshot_writer.beginSection();
+            for (auto saved_entry = saved_entries.rbegin(); saved_entry != saved_entries.rend(); ++saved_entry) {
+                // Snapshots hold plain values, so any store can load them
+                ValueHandle value = decodeValue(std::move(saved_entry->value));
+                snapshot_writer.addEntry(saved_entry->key, value.view(), WallDeadline(saved_entry->expiresAt));
+            }
+        }
+        saved_entries.clear();
+
+        // The migration under way may have settled; a reshard started since may have moved keys behind the walk
+        uint64_t final_layout = shardLayout.load(std::memory_order_acquire);
+        bool settled_only = LayoutMigrating(layout) && !LayoutMigrating(final_layout) &&
+                            LayoutEpoch(final_layout) == LayoutEpoch(layout) + 1;
+        if (final_layout == layout || settled_only) {
+            snapshot_writer.commit();
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Load a snapshot's sections in parallel.
+ * @param reader Mapped snapshot.
+ * @return size_t Number of entries stored.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+size_t BasicStore<ShardTable, EvictionPolicy>::loadSnapshot(const SnapshotReader& reader) {
+    std::atomic<size_t> loaded_count{0};
+    std::atomic<bool> found_corruption{false};
+    auto load_section = [&](size_t section_index) {
+        SnapshotSection section = reader.section(section_index);
+        loaded_count.fetch_add(loadSnapshotSection(section), std::memory_order_relaxed);
+        if (section.corrupt()) {
+            found_corruption.store(true, std::memory_order_relaxed);
+        }
+    };
+
+    std::shared_ptr<WorkerPool> pool = executor;
+    if (pool == nullptr && reader.sectionCount() > 1) {
+        pool = std::make_shared<WorkerPool>();
+    }
+    if (pool != nullptr) {
+        pool->parallelFor(reader.sectionCount(), load_section);
+    } else {
+        for (size_t section_index = 0; section_index < reader.sectionCount(); ++section_index) {
+            load_section(section_index);
+        }
+    }
+
+    if (found_corruption.load(std::memory_order_relaxed)) {
+        throw std::system_error(EINVAL, std::generic_category(), "corrupt snapshot section");
+    }
+    return loaded_count.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Store one section's entries in order, copying values before each lock.
+ * @param section Cursor over the section.
+ * @return size_t Number of entries stored.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+size_t BasicStore<ShardTable, EvictionPolicy>::loadSnapshotSection(SnapshotSection& section) {
+    struct LoadedEntry {
+        std::string_view key;
+        uint64_t hash;
+        ValueHandle value;
+        uint64_t expiresAt;
+    };
+    std::vector<LoadedEntry> chunk;
+    chunk.reserve(kSnapshotLoadChunk);
+    size_t stored_count = 0;
+
+    SnapshotEntry entry;
+    bool has_entry = section.next(entry);
+    while (has_entry) {
+        // Decode, hash, and copy a run of entries before any lock is taken
+        chunk.clear();
+        for (; has_entry && chunk.size() < kSnapshotLoadChunk; has_entry = section.next(entry)) {
+            std::chrono::milliseconds time_left = TimeUntilWall(entry.expiresAtWallMillis);
+            bool expired = entry.expiresAtWallMillis != 0 && time_left.count() <= 0;
+            if (expired || !admitsCopy(entry.key.size(), entry.value.size())) {
+                continue;
+            }
+            uint64_t expires_at = entry.expiresAtWallMillis == 0 ? 0 : DeadlineAfter(time_left);
+            uint64_t entry_hash = keyHash(entry.key);
+            ValueHandle value = copyValue(entry_hash, entry.value);
+            if (compressionThreshold != 0 && !admits(entry.key.size(), value.size())) {
+                continue;
+            }
+            chunk.push_back(LoadedEntry{entry.key, entry_hash, std::move(value), expires_at});
+        }
+
+        // Consecutive keys that route to the same shard share one lock
+        size_t next_entry = 0;
+        while (next_entry < chunk.size()) {
+            DisplacedValues displaced_values;
+            std::unique_lock<std::shared_mutex> shard_lock_guard;
+            Shard& target_shard = lockKeyShard(chunk[next_entry].key, chunk[next_entry].hash, shard_lock_guard);
+            uint64_t layout = shardLayout.load(std::memory_order_acquire);
+            do {
+                LoadedEntry& loaded_entry = chunk[next_entry++];
+                stored_count += putInShard(target_shard, loaded_entry.key, loaded_entry.hash,
+                                           std::move(loaded_entry.value), loaded_entry.expiresAt, displaced_values)
+                                    ? 1
+                                    : 0;
+            } while (next_entry < chunk.size() && !LayoutMigrating(layout) &&
+                     shards[ShardFor(chunk[next_entry].hash, LayoutShards(layout))].get() == &target_shard);
+        }
+    }
+    return stored_count;
+}
+
+/**
+ * @brief Snapshot the store, letting the log drop the history before it.
+ * @param snapshot_path Snapshot file.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::compactLog(const std::string& snapshot_path) {
+    if (appendLog == nullptr) {
+        snapshot(snapshot_path);
+        return;
+    }
+    appendLog->compact([&] { snapshot(snapshot_path); });
+}
+
+// ========================================
+// Utility operations
+// ========================================
+
+/**
+ * @brief Clear all shards, removing every key-value pair.
+ *
+ * Without a log each shard is cleared under its own lock in turn. With one
+ * (append-only or replication), every shard is locked (in index order)
+ * before the Clear record is appended, so no mutation logged after the
+ * record can be wiped by it on replay. Either way a locked shard only has
+ * its containers swapped out; they are retired to the reclaimer once the
+ * shard is unlocked. Near-cache versions are bumped before the first
+ * unlock of each emptied shard, so no cleared key is served afterwards.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::clear() {
+    size_t shard_span = LayoutSpan(shardLayout.load(std::memory_order_acquire));
+
+    // Building the empty replacements allocates (a slab index is presized), so do it unlocked
+    std::vector<std::unique_ptr<RetiredShard>> retired_shards;
+    retired_shards.reserve(shard_span);
+    for (size_t shard_index = 0; shard_index < shard_span; ++shard_index) {
+        retired_shards.push_back(std::make_unique<RetiredShard>(shards[shard_index]->table.capacity()));
+    }
+
+    std::vector<std::unique_lock<std::shared_mutex>> held_locks;
+    if (logging()) {
+        held_locks.reserve(shard_span);
+        for (size_t shard_index = 0; shard_index < shard_span; ++shard_index) {
+            held_locks.emplace_back(shards[shard_index]->shardLock);
+        }
+        logClear();
+    }
+
+    for (size_t shard_index = 0; shard_index < shard_span; ++shard_index) {
+        Shard& shard = *shards[shard_index];
+        RetiredShard& retired_shard = *retired_shards[shard_index];
+        {
+            std::unique_lock<std::shared_mutex> shard_lock_guard;
+            if (held_locks.empty()) {
+                shard_lock_guard = std::unique_lock<std::shared_mutex>(shard.shardLock);
+            }
+
+            std::swap(shard.table, retired_shard.table);
+            std::swap(shard.policy, retired_shard.policy);
+            retired_shard.expiryWheel = std::move(shard.expiryWheel);
+            shard.residentBytes = 0;
+            if (held_locks.empty() && keyVersions != nullptr) {
+                // Stripes span shards, so every cached copy dies before this shard is unlocked
+                keyVersions->bumpAll();
+            }
+        }
+        if (held_locks.empty()) {
+            reclaimer.retire(std::move(retired_shards[shard_index]));
+        }
+    }
+
+    // Before any lock is released in the logged case; cached copies of the old keys die at once
+    if (!held_locks.empty() && keyVersions != nullptr) {
+        keyVersions->bumpAll();
+    }
+    held_locks.clear();
+    for (std::unique_ptr<RetiredShard>& retired_shard : retired_shards) {
+        reclaimer.retire(std::move(retired_shard));
+    }
+}
+
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::waitForReclamation() {
+    reclaimer.waitIdle();
+}
+
+/**
+ * @brief Bytes charged against the byte budget across all shards.
+ * @return size_t Sum of key, value, and per-entry overhead bytes.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+size_t BasicStore<ShardTable, EvictionPolicy>::memoryUsage() {
+    size_t resident_bytes = 0;
+    size_t shard_span = LayoutSpan(shardLayout.load(std::memory_order_acquire));
+    for (size_t shard_index = 0; shard_index < shard_span; ++shard_index) {
+        Shard& shard = *shards[shard_index];
+        std::shared_lock<std::shared_mutex> shard_lock_guard(shard.shardLock);
+        resident_bytes += shard.residentBytes;
+    }
+    return resident_bytes;
+}
+
+/**
+ * @brief Sum the striped counters and every shard's occupancy and counters.
+ * @return StoreStats Totals and per-shard figures.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+StoreStats BasicStore<ShardTable, EvictionPolicy>::stats() {
+    StoreStats store_stats;
+    store_stats.hits = operationCounters.total(StoreCounter::Hits);
+    store_stats.misses = operationCounters.total(StoreCounter::Misses);
+    store_stats.gets = store_stats.hits + store_stats.misses;
+    store_stats.puts = operationCounters.total(StoreCounter::Puts);
+    store_stats.deletes = operationCounters.total(StoreCounter::Deletes);
+
+    CompressionStats& compression = store_stats.compression;
+    compression.compressedValues = operationCounters.total(StoreCounter::CompressedValues);
+    compression.incompressibleValues = operationCounters.total(StoreCounter::IncompressibleValues);
+    compression.inputBytes = operationCounters.total(StoreCounter::CompressInputBytes);
+    compression.outputBytes = operationCounters.total(StoreCounter::CompressOutputBytes);
+    compression.compressNanos = operationCounters.total(StoreCounter::CompressNanos);
+    compression.decompressions = operationCounters.total(StoreCounter::Decompressions);
+    compression.decompressNanos = operationCounters.total(StoreCounter::DecompressNanos);
+    store_stats.nearCacheHits = operationCounters.total(StoreCounter::NearCacheHits);
+    store_stats.nearCacheFills = operationCounters.total(StoreCounter::NearCacheFills);
+
+    size_t shard_count = shardCount();
+    store_stats.shards.resize(shard_count);
+    for (size_t shard_index = 0; shard_index < shard_count; ++shard_index) {
+        Shard& shard = *shards[shard_index];
+        ShardStats& shard_stats = store_stats.shards[shard_index];
+        {
+            std::shared_lock<std::shared_mutex> shard_lock_guard(shard.shardLock);
+            shard_stats.keys = shard.table.size();
+            shard_stats.bytes = shard.residentBytes;
+            shard_stats.evictions = shard.evictions;
+            shard_stats.expirations = shard.expirations;
+        }
+        shard_stats.lockContentions = shard.lockContentions.load(std::memory_order_relaxed);
+        shard_stats.lockWaitNanos = shard.lockWaitNanos.load(std::memory_order_relaxed);
+        shard_stats.slab = shard.valueSlab.stats();
+        shard_stats.hotKeys = shard.hotKeys.hotKeys();
+
+        store_stats.keys += shard_stats.keys;
+        store_stats.bytes += shard_stats.bytes;
+        store_stats.evictions += shard_stats.evictions;
+        store_stats.expirations += shard_stats.expirations;
+        store_stats.lockContentions += shard_stats.lockContentions;
+        store_stats.lockWaitNanos += shard_stats.lockWaitNanos;
+        store_stats.slab.pageBytes += shard_stats.slab.pageBytes;
+        store_stats.slab.chunkBytes += shard_stats.slab.chunkBytes;
+        store_stats.slab.requestedBytes += shard_stats.slab.requestedBytes;
+        store_stats.slab.heapBytes += shard_stats.slab.heapBytes;
+        store_stats.hotKeys.insert(store_stats.hotKeys.end(), shard_stats.hotKeys.begin(), shard_stats.hotKeys.end());
+    }
+
+    std::sort(store_stats.hotKeys.begin(), store_stats.hotKeys.end(),
+              [](const HotKey& left, const HotKey& right) { return left.reads > right.reads; });
+    if (store_stats.hotKeys.size() > HotKeyTracker::kTrackedKeys) {
+        store_stats.hotKeys.resize(HotKeyTracker::kTrackedKeys);
+    }
+    return store_stats;
+}
+
+/**
+ * @brief Print the contents of all shards for debugging.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::list() {
+    list(std::cout);
+}
+
+/**
+ * @brief Write the contents of all shards to a stream.
+ * @param output Stream receiving the listing.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::list(std::ostream& output) {
+    std::vector<std::pair<std::string, ValueHandle>> listed_entries;
+    size_t shard_span = LayoutSpan(shardLayout.load(std::memory_order_acquire));
+    for (size_t shard_index = 0; shard_index < shard_span; ++shard_index) {
+        Shard& shard = *shards[shard_index];
+        listed_entries.clear();
+        {
+            // As in snapshot, only keys and handles are taken under the lock
+            std::shared_lock<std::shared_mutex> shard_lock_guard(shard.shardLock);
+            listed_entries.reserve(shard.table.size());
+            shard.table.forEachByRecency([&listed_entries](const std::string& key, const Entry& entry) {
+                // Expired entries that have not been reclaimed yet are hidden
+                if (!IsExpired(entry)) {
+                    listed_entries.emplace_back(key, entry.value);
+                }
+            });
+        }
+
+        output << "{ \"shard_" << shard_index << "\": {\n";
+
+        bool first_entry = true;
+        for (std::pair<std::string, ValueHandle>& listed_entry : listed_entries) {
+            if (!first_entry) {
+                output << ",\n";
+            }
+            ValueHandle value = decodeValue(std::move(listed_entry.second));
+            output << "  \"" << listed_entry.first << "\": \"" << value.view() << "\"";
+            first_entry = false;
+        }
+        if (!first_entry) {
+            output << "\n";
+        }
+
+        output << "} }\n";
+    }
+}
+
+// ========================================
+// Routing and resharding
+// ========================================
+
+/**
+ * @brief Lock the key's shard, moving the key there first if a migration left it behind.
+ * @param key Key being operated on.
+ * @param key_hash Key hash from keyHash.
+ * @param shard_lock_guard Empty lock object; owns the shard's lock on return.
+ * @return Shard& The key's shard under the current layout.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+template <typename Lock>
+typename BasicStore<ShardTable, EvictionPolicy>::Shard& BasicStore<ShardTable, EvictionPolicy>::lockKeyShard(
+    std::string_view key, uint64_t key_hash, Lock& shard_lock_guard) {
+    while (true) {
+        uint64_t layout = shardLayout.load(std::memory_order_acquire);
+        if (LayoutMigrating(layout)) {
+            migrateKey(key, key_hash, layout);
+        }
+
+        Shard& target_shard = *shards[ShardFor(key_hash, LayoutShards(layout))];
+        shard_lock_guard = lockShard<Lock>(target_shard);
+
+        // A reshard that starts after this check scans the shard only once this lock is released
+        if (shardLayout.load(std::memory_order_acquire) == layout) {
+            return target_shard;
+        }
+        shard_lock_guard.unlock();
+    }
+}
+
+/**
+ * @brief Take a shard's lock, timing the wait only when the lock was not free.
+ * @param target_shard Shard to lock.
+ * @return Lock Guard owning the lock.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+template <typename Lock>
+Lock BasicStore<ShardTable, EvictionPolicy>::lockShard(Shard& target_shard) {
+    Lock shard_lock_guard(target_shard.shardLock, std::try_to_lock);
+    if (shard_lock_guard.owns_lock()) {
+        latencyRecorder.record(LatencyOp::LockAcquire, 0);
+        return shard_lock_guard;
+    }
+
+    auto wait_start = std::chrono::steady_clock::now();
+    shard_lock_guard.lock();
+    uint64_t waited_nanos = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - wait_start).count());
+    target_shard.lockContentions.fetch_add(1, std::memory_order_relaxed);
+    target_shard.lockWaitNanos.fetch_add(waited_nanos, std::memory_order_relaxed);
+    latencyRecorder.record(LatencyOp::LockAcquire, waited_nanos);
+    return shard_lock_guard;
+}
+
+/**
+ * @brief Move a key from its old shard to its new one.
+ * @param key Key to move.
+ * @param key_hash Key hash from keyHash.
+ * @param layout Migrating layout the key was routed under.
+ *
+ * The entry keeps its value and deadline and is inserted as most recent in
+ * the target shard, which may evict to make room for it.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+void BasicStore<ShardTable, EvictionPolicy>::migrateKey(std::string_view key, uint64_t key_hash, uint64_t layout) {
+    size_t source_index = ShardFor(key_hash, LayoutSources(layout));
+    size_t target_index = ShardFor(key_hash, LayoutShards(layout));
+    if (source_index == target_index) {
+        return;
+    }
+    Shard& source_shard = *shards[source_index];
+    Shard& target_shard = *shards[target_index];
+
+    // Declared before the guards so displaced values are freed after unlocking
+    DisplacedValues displaced_values;
+    std::lock_guard<std::shared_mutex> first_lock_guard(shards[std::min(source_index, target_index)]->shardLock);
+    std::lock_guard<std::shared_mutex> second_lock_guard(shards[std::max(source_index, target_index)]->shardLock);
+
+    // Once the migration has finished, every key has reached its new shard
+    if (shardLayout.load(std::memory_order_acquire) != layout) {
+        return;
+    }
+
+    Entry* entry = findLive(source_shard, key, key_hash);
+    if (entry == nullptr) {
+        return;
+    }
+    uint64_t expires_at = entry->state.expiresAt();
+    ValueHandle moved_value = eraseEntry(source_shard, entry);
+
+    // Writers always move a key before touching it, so the target never has a newer copy
+    if (target_shard.table.find(key, TableHash(key_hash)) != nullptr) {
+        displaced_values.add(std::move(moved_value));
+        return;
+    }
+    putInShard(target_shard, key, key_hash, std::move(moved_value), expires_at, displaced_values);
+    migratedKeys.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Switch routing to a new shard count and start migrating keys.
+ * @param new_shard_count Shard count to move to.
+ * @return true If the reshard started or the count already matches.
+ * @return false If the count is out of range or a migration is still running.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+bool BasicStore<ShardTable, EvictionPolicy>::reshard(size_t new_shard_count) {
+    std::lock_guard<std::mutex> reshard_lock_guard(reshardLock);
+    uint64_t layout = shardLayout.load(std::memory_order_acquire);
+    size_t shard_count = LayoutShards(layout);
+
+    if (new_shard_count == 0 || new_shard_count > shards.size() || LayoutMigrating(layout)) {
+        return false;
+    }
+    if (new_shard_count == shard_count) {
+        return true;
+    }
+
+    // Shards are built before the layout that routes to them is published
+    for (size_t shard_index = constructedShards; shard_index < new_shard_count; ++shard_index) {
+        shards[shard_index] = makeShard(shard_index, new_shard_count);
+    }
+    constructedShards = std::max(constructedShards, new_shard_count);
+
+    // Shards that remain or return take their share of the budget for the new count
+    size_t shard_byte_budget = budgetShare(new_shard_count);
+    for (size_t shard_index = 0; shard_index < new_shard_count; ++shard_index) {
+        std::lock_guard<std::shared_mutex> shard_lock_guard(shards[shard_index]->shardLock);
+        shards[shard_index]->byteBudget = shard_byte_budget;
+    }
+    shardByteBudget.store(shard_byte_budget, std::memory_order_relaxed);
+
+    // Growing moves keys out of every old shard; shrinking only out of the removed ones
+    migrationCursor = MigrationCursor{};
+    migrationCursor.firstShard = new_shard_count < shard_count ? new_shard_count : 0;
+    migrationCursor.shard = migrationCursor.firstShard;
+    migratedKeys.store(0, std::memory_order_relaxed);
+
+    shardLayout.store(PackLayout(new_shard_count, shard_count, LayoutEpoch(layout) + 1), std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Scan the next slice of the source shards and move the keys found there.
+ * @param position_budget Table positions to scan in this call.
+ * @return true If keys remain to be moved.
+ *
+ * The scan holds each source shard's lock shared only while it copies out
+ * the keys to move; the moves themselves go through migrateKey. Moving keys
+ * are never inserted into a source shard after the layout is published, so
+ * one pass over each source's positions finds all of them. Once the pass is
+ * complete the layout is published as settled.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+bool BasicStore<ShardTable, EvictionPolicy>::migrateSome(size_t position_budget) {
+    std::lock_guard<std::mutex> reshard_lock_guard(reshardLock);
+    uint64_t layout = shardLayout.load(std::memory_order_acquire);
+    if (!LayoutMigrating(layout)) {
+        return false;
+    }
+
+    size_t shard_count = LayoutShards(layout);
+    size_t source_count = LayoutSources(layout);
+    std::vector<std::pair<std::string, uint64_t>> moving_keys;
+    size_t positions_left = std::max<size_t>(1, position_budget);
+
+    while (positions_left > 0 && migrationCursor.shard < source_count) {
+        Shard& source_shard = *shards[migrationCursor.shard];
+        bool shard_done = false;
+        {
+            std::shared_lock<std::shared_mutex> shard_lock_guard(source_shard.shardLock);
+            ShardTable& table = source_shard.table;
+
+            // A rehash renumbers the positions; start this shard's scan over
+            if (table.positionEpoch() != migrationCursor.positionEpoch) {
+                migrationCursor.position = 0;
+                migrationCursor.positionEpoch = table.positionEpoch();
+            }
+
+            size_t next_position = table.forEachAtPositions(
+                migrationCursor.position, positions_left, [&](const std::string& key, const Entry& /*entry*/) {
+                    uint64_t key_hash = keyHash(key);
+                    if (ShardFor(key_hash, shard_count) != migrationCursor.shard) {
+                        moving_keys.emplace_back(key, key_hash);
+                    }
+                });
+            positions_left -= std::min(positions_left, next_position - migrationCursor.position);
+            migrationCursor.position = next_position;
+            shard_done = next_position >= table.positionCount();
+        }
+
+        for (const auto& moving_key : moving_keys) {
+            migrateKey(moving_key.first, moving_key.second, layout);
+        }
+        moving_keys.clear();
+
+        if (shard_done) {
+            ++migrationCursor.shard;
+            migrationCursor.position = 0;
+            migrationCursor.positionEpoch = SIZE_MAX;
+        }
+    }
+
+    if (migrationCursor.shard < source_count) {
+        return true;
+    }
+    shardLayout.store(PackLayout(shard_count, shard_count, LayoutEpoch(layout) + 1), std::memory_order_release);
+    return false;
+}
+
+// ========================================
+// Iteration
+// ========================================
+
+/**
+ * @brief Walk shards in visiting order from the cursor until count keys or the position budget is used up.
+ * @param cursor 0 or the cursor of the previous call.
+ * @param count Keys to aim for.
+ * @param prefix Keys must start with it to be returned.
+ * @return ScanResult Keys found and the next cursor.
+ *
+ * Each slice of positions asks for no more than the keys still wanted, so
+ * SlabShardTable (one entry per position) never overshoots count.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+ScanResult BasicStore<ShardTable, EvictionPolicy>::scan(uint64_t cursor, size_t count, std::string_view prefix) {
+    uint64_t layout = shardLayout.load(std::memory_order_acquire);
+    size_t shard_span = LayoutSpan(layout);
+    bool descending = LayoutSources(layout) > LayoutShards(layout);
+    uint64_t layout_tag = LayoutEpoch(layout) & ScanCursor::kTagMask;
+
+    ScanCursor scan_cursor = ScanCursor::Unpack(cursor);
+    if (cursor == 0 || scan_cursor.layoutTag != layout_tag) {
+        // A reshard may have moved keys behind the cursor; start over
+        scan_cursor = ScanCursor{};
+        scan_cursor.layoutTag = layout_tag;
+    }
+
+    ScanResult scan_result;
+    size_t keys_wanted = std::min(std::max<size_t>(1, count), SIZE_MAX / kScanPositionsPerKey);
+    size_t positions_left = keys_wanted * kScanPositionsPerKey;
+    while (scan_cursor.shardOrder < shard_span && positions_left > 0 && scan_result.keys.size() < keys_wanted) {
+        size_t shard_index = descending ? shard_span - 1 - scan_cursor.shardOrder : scan_cursor.shardOrder;
+        Shard& shard = *shards[shard_index];
+        bool shard_done = false;
+        {
+            auto shard_lock_guard = lockShard<std::shared_lock<std::shared_mutex>>(shard);
+            ShardTable& table = shard.table;
+
+            // A rehash renumbered this shard's positions; walk it again
+            uint64_t table_tag = ScanCursor::TableTag(table.positionEpoch());
+            if (scan_cursor.tableTag != table_tag) {
+                scan_cursor.position = 0;
+                scan_cursor.tableTag = table_tag;
+            }
+
+            while (positions_left > 0 && scan_result.keys.size() < keys_wanted &&
+                   scan_cursor.position < table.positionCount()) {
+                size_t slice = std::min(positions_left, keys_wanted - scan_result.keys.size());
+                size_t next_position = table.forEachAtPositions(
+                    scan_cursor.position, slice, [&](const std::string& key, const Entry& entry) {
+                        if (!IsExpired(entry) && key.compare(0, prefix.size(), prefix) == 0) {
+                            scan_result.keys.push_back(key);
+                        }
+                    });
+                positions_left -= next_position - scan_cursor.position;
+                scan_cursor.position = next_position;
+            }
+            shard_done = scan_cursor.position >= table.positionCount();
+        }
+
+        if (shard_done) {
+            ++scan_cursor.shardOrder;
+            scan_cursor.position = 0;
+        }
+    }
+
+    scan_result.cursor = scan_cursor.shardOrder >= shard_span ? 0 : scan_cursor.pack();
+    return scan_result;
+}
+
+/**
+ * @brief Report how far the current or most recent reshard has got.
+ * @return ReshardProgress Shard counts, scanned source shards, and moved keys.
+ */
+template <typename ShardTable, typename EvictionPolicy>
+ReshardProgress BasicStore<ShardTable, EvictionPolicy>::reshardProgress() {
+    std::lock_guard<std::mutex> reshard_lock_guard(reshardLock);
+    uint64_t layout = shardLayout.load(std::memory_order_acquire);
+
+    ReshardProgress progress;
+    progress.active = LayoutMigrating(layout);
+    progress.sourceShardCount = LayoutSources(layout);
+    progress.targetShardCount = LayoutShards(layout);
+    if (progress.active) {
+        progress.shardsToScan = progress.sourceShardCount - migrationCursor.firstShard;
+        progress.shardsScanned = migrationCursor.shard - migrationCursor.firstShard;
+    }
+    progress.keysMoved = migratedKeys.load(std::memory_order_relaxed);
+    return progress;
+}
+
+// ========================================
+// Explicit instantiations
+// ========================================
+
+template class BasicStore<SlabShardTable>;
+template class BasicStore<ListShardTable>;
+template class BasicStore<SlabShardTable, SlruPolicy>;
+template class BasicStore<SlabShardTable, TinyLfuPolicy>;
@@ -1,32 +1,158 @@
 #pragma once
 
+#include "append_log.h"
+#include "eviction_policy.h"
+#include "hot_keys.h"
+#include "key_hash.h"
+#include "latency_histogram.h"
+#include "near_cache.h"
+#include "reclaimer.h"
+#include "replication_log.h"
+#include "shard_table.h"
+#include "slab_allocator.h"
+#include "snapshot.h"
+#include "store_stats.h"
+#include "timing_wheel.h"
+#include "worker_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
 #include <string>
-#include <unordered_map>
-#include <list>
+#include <string_view>
 #include <vector>
 #include <mutex>
+#include <shared_mutex>
 #include <memory>
+#include <type_traits>
 
 /**
- * @brief Thread-safe in-memory key-value store with per-shard LRU eviction.
+ * @brief How reads record recency for LRU eviction.
+ */
+enum class RecencyMode {
+    /// get takes the shard mutex exclusively and moves the key to the front immediately.
+    Exact,
+    /// get takes the shard mutex shared and only sets the entry's CLOCK reference bit;
+    /// writers promote referenced entries when they reach the LRU tail during eviction.
+    Clock
+};
+
+/**
+ * @brief Construction parameters for BasicStore.
+ */
+struct StoreOptions {
+    size_t maxKeysPerShard = 100;                ///< Key capacity per shard; 0 = bounded only by memoryBudget
+    size_t shardCount = 16;                      ///< Number of independent shards
+    RecencyMode recencyMode = RecencyMode::Exact; ///< How get records recency
+    size_t memoryBudget = 0;                     ///< Total bytes for keys, values, and entry overhead; 0 = unlimited
+    size_t maxValueBytes = 0;                    ///< Largest value put accepts; 0 = no limit beyond the budget
+    uint64_t hashSeed = 0;                       ///< Key hash seed; 0 = a random seed per store
+    bool numaAware = false;                      ///< Spread shards over NUMA nodes in contiguous blocks
+    size_t maxShardCount = 1024;                 ///< Most shards reshard() may grow to (at least shardCount)
+    size_t compressionThreshold = 0;             ///< Smallest value stored LZ4-compressed; 0 = never compress
+    size_t nearCacheSlots = 0;                   ///< Per-thread near-cache slots for hot keys (rounded up to a power of two); 0 = off
+};
+
+/**
+ * @brief Progress of a live reshard, as reported by BasicStore::reshardProgress.
+ */
+struct ReshardProgress {
+    bool active = false;         ///< Whether keys are still being moved
+    size_t sourceShardCount = 0; ///< Shard count keys are moving from (the current count when idle)
+    size_t targetShardCount = 0; ///< Shard count keys are moving to (the current count when idle)
+    size_t shardsScanned = 0;    ///< Source shards whose keys have all been moved
+    size_t shardsToScan = 0;     ///< Source shards that hold keys to move
+    size_t keysMoved = 0;        ///< Keys moved by the current or most recent reshard
+};
+
+/**
+ * @brief One page of a cursor scan, as returned by BasicStore::scan.
+ */
+struct ScanResult {
+    uint64_t cursor = 0;           ///< Cursor to pass to the next call; 0 once the scan is complete
+    std::vector<std::string> keys; ///< Live keys found in this page
+};
+
+/**
+ * @brief What an update function asks BasicStore::update to do with its key.
+ */
+enum class UpdateAction {
+    Keep,   ///< Leave the key as it is
+    Store,  ///< Store the new value the function wrote
+    Delete  ///< Remove the key
+};
+
+/**
+ * @brief Outcome of BasicStore::update.
+ */
+enum class UpdateStatus {
+    Unchanged, ///< The function kept the key, or asked to delete a missing one
+    Stored,    ///< The new value was stored
+    Deleted,   ///< The key was removed
+    Rejected   ///< The new value was too large to admit, or the shard could not make room; nothing changed
+};
+
+/**
+ * @brief Thread-safe in-memory key-value store with per-shard eviction.
+ * @tparam ShardTable Storage policy for each shard (SlabShardTable or ListShardTable).
+ * @tparam EvictionPolicy Which entry a full shard evicts (LruPolicy, SlruPolicy, or TinyLfuPolicy).
+ *
+ * Keys are taken as std::string_view all the way down to the shard table, so
+ * lookups from protocol buffers or string literals never build a temporary
+ * std::string; hits and misses allocate nothing.
  *
  * Features:
  *  - Sharding: divides store into multiple independent shards to reduce mutex contention.
  *  - Single-key operations: put, get, del.
  *  - Batch operations: insert multiple key-value pairs efficiently per shard.
- *  - LRU eviction per shard: evicts least recently used key when capacity is exceeded.
+ *  - Eviction per shard: evicts keys chosen by the eviction policy (LRU by
+ *    default) when the key capacity or the shard's share of the byte budget
+ *    would be exceeded.
+ *  - Per-key TTL: expired keys read as missing and are reclaimed by a per-shard timing wheel.
+ *  - Seeded hashing: each key is hashed once; the high bits pick the shard
+ *    and the low bits drive the shard's index.
+ *  - Live resharding: shards are chosen by jump consistent hashing, so
+ *    changing the shard count moves only the keys that must move, and they
+ *    are migrated incrementally while traffic continues.
+ *
+ * The shard table and the eviction policy are compile-time parameters so
+ * layouts and policies can be benchmarked against each other; the supported
+ * combinations are explicitly instantiated in store.cpp.
  */
-class Store {
+template <typename ShardTable, typename EvictionPolicy = LruPolicy>
+class BasicStore {
 public:
     /**
      * @brief Construct a new Store object with shard configuration.
      * @param maxKeysPerShard Maximum number of key-value pairs per shard.
      * @param totalShardCount Total number of independent shards in the store.
+     * @param readRecencyMode How get records recency (see RecencyMode).
      *
      * Each shard maintains its own LRU list, hash map, and mutex to allow
      * concurrent access with minimal contention.
      */
-    explicit Store(size_t maxKeysPerShard = 100, size_t totalShardCount = 16);
+    explicit BasicStore(size_t maxKeysPerShard = 100, size_t totalShardCount = 16,
+                        RecencyMode readRecencyMode = RecencyMode::Exact);
+
+    /**
+     * @brief Construct a new Store object from a full set of options.
+     * @param options Shard layout, recency mode, and memory limits (see StoreOptions).
+     *
+     * With a memoryBudget each shard gets an equal share and tracks its
+     * resident bytes (key + value + a fixed per-entry overhead), so mixed
+     * value sizes are bounded by memory rather than by key count.
+     */
+    explicit BasicStore(const StoreOptions& options);
+
+    /**
+     * @brief Wait for drain tasks of queued asynchronous operations to finish.
+     */
+    ~BasicStore();
+
+    BasicStore(const BasicStore&) = delete;
+    BasicStore& operator=(const BasicStore&) = delete;
 
     // ========================================
     // Single-key operations
@@ -36,9 +162,39 @@ public:
      * @brief Insert or update a key-value pair in the store.
      * @param key Key to insert or update.
      * @param value Value to associate with the key.
-     * @return true Always returns true after operation.
+     * @return true If the pair was stored.
+     * @return false If the value exceeds maxValueBytes or the pair cannot fit in a shard's byte budget.
+     *
+     * The value is copied into a new ValueHandle before the shard is locked.
+     * As many least recently used entries are evicted as it takes to make room.
+     * With a compressionThreshold, values at least that long are compressed
+     * during the copy and kept compressed if that saves an eighth or more;
+     * the budget is charged for the stored size, and every read returns the
+     * original bytes.
+     */
+    bool put(std::string_view key, std::string_view value);
+
+    /**
+     * @brief Insert or update a key with an already-built value.
+     * @param key Key to insert or update.
+     * @param value Shared value to store; no bytes are copied, so it is never compressed.
+     * @return true If the pair was stored; false if it is too large (see above).
      */
-    bool put(const std::string& key, const std::string& value);
+    bool put(std::string_view key, ValueHandle value);
+
+    /**
+     * @brief Insert or update a key, moving a std::string in as the value.
+     * @param key Key to insert or update.
+     * @param value Freshly built string; its buffer is adopted without a copy.
+     * @return true If the pair was stored; false if it is too large.
+     *
+     * Only binds to std::string rvalues; lvalues and literals use the
+     * string_view overload.
+     */
+    template <typename String, typename = std::enable_if_t<std::is_same<String, std::string>::value>>
+    bool put(std::string_view key, String&& value) {
+        return put(key, ValueHandle::adopt(std::move(value)));
+    }
 
     /**
      * @brief Retrieve the value for a given key from the store.
@@ -46,8 +202,30 @@ public:
      * @param value Output parameter for the value associated with the key.
      * @return true If key exists and value was retrieved.
      * @return false If key does not exist.
+     *
+     * In RecencyMode::Clock only a shared lock is taken, so reads of the same
+     * shard proceed in parallel. The copy into value happens after the lock
+     * is released. With a near cache, hot keys are usually copied straight
+     * from the calling thread's cache without locking anything.
+     */
+    bool get(std::string_view key, std::string& value);
+
+    /**
+     * @brief Retrieve a shared handle to the value for a given key.
+     * @param key Key to retrieve.
+     * @return ValueHandle Handle to the current value, or an empty handle if the key does not exist.
+     *
+     * The shard lock covers only the lookup and the recency update; the value
+     * bytes are never copied and remain valid for as long as the handle lives.
+     *
+     * Every get feeds the hot-key sample of its shard. With
+     * StoreOptions::nearCacheSlots set, a get of a hot key without a TTL
+     * also leaves the value in a small cache private to the calling thread,
+     * and later gets are served from it, lock-free, until a put, delete,
+     * expiry, eviction, or clear of the key (or of a key sharing its version
+     * stripe) invalidates it. Batch and async gets bypass the near cache.
      */
-    bool get(const std::string& key, std::string& value);
+    ValueHandle get(std::string_view key);
 
     /**
      * @brief Delete a key-value pair from the store.
@@ -55,7 +233,125 @@ public:
      * @return true If the key existed and was deleted.
      * @return false If the key does not exist.
      */
-    bool del(const std::string& key);
+    bool del(std::string_view key);
+
+    // ========================================
+    // Expiration
+    // ========================================
+
+    /**
+     * @brief ttl() result for a key that does not exist.
+     */
+    static constexpr int64_t kTtlMissing = -2;
+
+    /**
+     * @brief ttl() result for a key that exists but never expires.
+     */
+    static constexpr int64_t kTtlPersistent = -1;
+
+    /**
+     * @brief Insert or update a key that expires after ttl.
+     * @param key Key to insert or update.
+     * @param value Value to associate with the key.
+     * @param ttl Time to live; a non-positive ttl deletes the key instead.
+     * @return true If the pair was stored (or deleted); false if it is too large.
+     *
+     * Plain put clears any TTL, like SET in Redis.
+     */
+    bool put(std::string_view key, std::string_view value, std::chrono::milliseconds ttl);
+
+    /**
+     * @brief Insert or update a key with an already-built value that expires after ttl.
+     * @param key Key to insert or update.
+     * @param value Shared value to store; no bytes are copied.
+     * @param ttl Time to live; a non-positive ttl deletes the key instead.
+     * @return true If the pair was stored (or deleted); false if it is too large.
+     */
+    bool put(std::string_view key, ValueHandle value, std::chrono::milliseconds ttl);
+
+    /**
+     * @brief Set or replace the time to live of an existing key.
+     * @param key Key to update.
+     * @param ttl Time to live from now; a non-positive ttl deletes the key.
+     * @return true If the key exists.
+     * @return false If the key does not exist.
+     */
+    bool expire(std::string_view key, std::chrono::milliseconds ttl);
+
+    /**
+     * @brief Remove the time to live of a key so it never expires.
+     * @param key Key to update.
+     * @return true If the key existed and had a TTL.
+     * @return false If the key does not exist or had no TTL.
+     */
+    bool persist(std::string_view key);
+
+    /**
+     * @brief Remaining time to live of a key.
+     * @param key Key to inspect.
+     * @return int64_t Milliseconds left, kTtlPersistent, or kTtlMissing.
+     *
+     * Takes the shard lock shared and does not count as an access for LRU.
+     */
+    int64_t ttl(std::string_view key);
+
+    // ========================================
+    // Read-modify-write operations
+    // ========================================
+
+    /**
+     * @brief Decides a key's new value from its current one, under the key's shard lock.
+     *
+     * Receives the current value (an empty handle if the key is missing or
+     * expired) and a string to write the new value into, and returns what to
+     * do. It runs with the shard locked exclusively, so it must be short and
+     * must not call back into the store. It may run more than once if the
+     * key changes while update works unlocked; only the last decision is
+     * applied.
+     */
+    using UpdateFunction = std::function<UpdateAction(const ValueHandle& current, std::string& next)>;
+
+    /**
+     * @brief Atomically replace a key's value with one computed from it.
+     * @param key Key to update.
+     * @param updateFunction Computes the new value; see UpdateFunction.
+     * @return UpdateStatus What was done.
+     *
+     * One lock acquisition and one table lookup cover the read and the
+     * write, which go through the same recency, eviction, and logging path
+     * as put. A stored value keeps the key's TTL. Decompressing the current
+     * value and compressing a new one of at least compressionThreshold bytes
+     * happen with the lock released, and are redone if the key changed
+     * meanwhile.
+     */
+    UpdateStatus update(std::string_view key, const UpdateFunction& updateFunction);
+
+    /**
+     * @brief Store desired only if the key currently holds expected.
+     * @param key Key to update.
+     * @param expected Value the key must have; a missing key never matches.
+     * @param desired New value.
+     * @return true If the value matched and desired was stored; the TTL is kept.
+     */
+    bool compareAndSet(std::string_view key, std::string_view expected, std::string_view desired);
+
+    /**
+     * @brief Add to the decimal integer stored at a key, like Redis INCRBY.
+     * @param key Key to update; a missing key counts as 0.
+     * @param delta Amount to add; may be negative.
+     * @param result Receives the new value.
+     * @return false If the current value is not a 64-bit decimal integer or the sum would overflow; nothing changed.
+     */
+    bool incrBy(std::string_view key, int64_t delta, int64_t& result);
+
+    /**
+     * @brief Append bytes to a key's value, like Redis APPEND.
+     * @param key Key to update; a missing key is created with suffix as its value.
+     * @param suffix Bytes to append.
+     * @param length Receives the value's new length.
+     * @return false If the result would be too large to admit; nothing changed.
+     */
+    bool append(std::string_view key, std::string_view suffix, size_t& length);
 
     // ========================================
     // Batch operations
@@ -66,9 +362,247 @@ public:
      * @param keyValuePairs Vector of key-value pairs to insert.
      *
      * Groups keys by shard to minimize lock acquisitions. Each shard is
-     * locked once per batch.
+     * locked once per batch. Pairs that put would reject are skipped.
+     * @return size_t Number of pairs stored.
      */
-    void putMany(const std::vector<std::pair<std::string, std::string>>& keyValuePairs);
+    size_t putMany(const std::vector<std::pair<std::string, std::string>>& keyValuePairs);
+
+    /**
+     * @brief Retrieve multiple keys, locking each shard at most once.
+     * @param keys Keys to retrieve.
+     * @param values Output; resized to keys.size() and filled in input order,
+     *               with an empty handle for every missing key.
+     * @return size_t Number of keys found.
+     */
+    size_t getMany(const std::vector<std::string_view>& keys, std::vector<ValueHandle>& values);
+
+    /**
+     * @brief Delete multiple keys, locking each shard at most once.
+     * @param keys Keys to delete.
+     * @return size_t Number of keys that existed and were deleted.
+     */
+    size_t delMany(const std::vector<std::string_view>& keys);
+
+    /**
+     * @brief Default smallest batch worth spreading across an executor.
+     */
+    static constexpr size_t kDefaultParallelBatchSize = 4096;
+
+    /**
+     * @brief Run the per-shard parts of large batches concurrently on a thread pool.
+     * @param pool Pool to use, or nullptr to keep every batch on the caller's thread.
+     * @param minimumBatchSize Batches with fewer keys than this always run inline.
+     *
+     * putMany, getMany, and delMany hand one task per touched shard to the
+     * pool; each task still locks its shard once. The pool may be shared with
+     * other stores. Call before the store is shared between threads.
+     */
+    void setExecutor(std::shared_ptr<WorkerPool> pool, size_t minimumBatchSize = kDefaultParallelBatchSize);
+
+    // ========================================
+    // Asynchronous operations
+    // ========================================
+
+    using GetCallback = std::function<void(ValueHandle)>; ///< Receives the value, or an empty handle
+    using WriteCallback = std::function<void(bool)>;      ///< Receives the synchronous form's result
+
+    /**
+     * @brief Look up a key without blocking on a contended shard.
+     * @param key Key to retrieve.
+     * @param done Called with the value, or an empty handle if the key does not exist.
+     *
+     * If the key's shard lock is free, the lookup runs at once and done is
+     * called before getAsync returns. If the lock is held, the lookup joins
+     * the shard's submission queue and getAsync returns immediately: the
+     * first operation to queue posts one drain task to the executor, which
+     * takes the shard lock once for everything queued by then and calls
+     * each callback after unlocking, on the executor's thread. Async
+     * operations a thread issues on one shard complete in order. Without an
+     * executor (see setExecutor) the operation blocks like get().
+     */
+    void getAsync(std::string_view key, GetCallback done);
+
+    /**
+     * @brief Insert or update a key without blocking on a contended shard; see getAsync.
+     * @param key Key to insert or update.
+     * @param value Value to store; copied before returning.
+     * @param done Optional; called with put()'s result.
+     */
+    void putAsync(std::string_view key, std::string_view value, WriteCallback done = {});
+
+    /**
+     * @brief Delete a key without blocking on a contended shard; see getAsync.
+     * @param key Key to delete.
+     * @param done Optional; called with del()'s result.
+     */
+    void delAsync(std::string_view key, WriteCallback done = {});
+
+    // ========================================
+    // Persistence
+    // ========================================
+
+    /**
+     * @brief Record every successful mutation in an append-only log.
+     * @param log Log to append to, or nullptr to stop logging.
+     *
+     * Puts, deletes, TTL changes, and clears are appended while their shard
+     * is locked, so replaying the log reproduces the same final state.
+     * Evictions and expirations are not logged; replay re-applies the budget
+     * and skips deadlines that have passed. Appends only buffer the record;
+     * the log's flusher thread writes and fsyncs in groups (see AppendLog).
+     * Call before the store is shared between threads.
+     */
+    void setAppendLog(std::shared_ptr<AppendLog> log);
+
+    /**
+     * @brief Stream every successful mutation to a replication backlog as well.
+     * @param log Backlog to append to, or nullptr to stop.
+     *
+     * Records go in under the same locks and in the same order as with
+     * setAppendLog, and the two can be used together.
+     * Call before the store is shared between threads.
+     */
+    void setReplicationLog(std::shared_ptr<ReplicationLog> log);
+
+    /**
+     * @brief Apply one logged mutation through the public operations.
+     * @param record Decoded record.
+     *
+     * Logged deadlines are wall-clock times: a put or TTL whose deadline has
+     * passed deletes the key, exactly as if it had expired in the meantime.
+     */
+    void apply(const LogRecord& record);
+
+    /**
+     * @brief Apply every record of a log, in order, to rebuild the store's contents.
+     * @param reader Reader positioned after the header.
+     * @return size_t Number of records applied.
+     *
+     * Call before setAppendLog, or the replayed mutations would be logged again.
+     */
+    size_t replay(AppendLogReader& reader);
+
+    /**
+     * @brief Write a point-in-time snapshot of every shard to a file.
+     * @param path Snapshot file; replaced atomically once the new one is complete.
+     * @throws std::system_error If the file cannot be written.
+     *
+     * Shards are visited one at a time, and each is locked shared only while
+     * its keys and value handles are collected; the values themselves are
+     * shared rather than copied and are written after the lock is released.
+     * Each shard's entries are saved least recently used first, so loading
+     * rebuilds its LRU order (segmented policies start with every key back
+     * in their first segment). Expired entries are left out. While a reshard
+     * migrates, shards are visited in the order keys move (descending when
+     * shrinking) so no key slips behind the walk; if a new reshard starts
+     * during the snapshot, it starts over.
+     */
+    void snapshot(const std::string& path);
+
+    /**
+     * @brief Load every entry of a snapshot into the store.
+     * @param reader Mapped snapshot.
+     * @return size_t Number of entries stored.
+     * @throws std::system_error If a section is corrupt; the entries before the damage are kept.
+     *
+     * Sections are loaded in parallel on the executor, or on a temporary
+     * pool if none is set, each locking its shard once per run of keys
+     * instead of once per key. A store built with the snapshot's hashSeed and
+     * shard count gets each section into a single shard; any other layout
+     * works too and routes every key. Deadlines that passed are skipped.
+     * Loaded entries are not logged. Readers may run meanwhile (a replica
+     * keeps serving while it resynchronises), but writers should not.
+     */
+    size_t loadSnapshot(const SnapshotReader& reader);
+
+    /**
+     * @brief Write a snapshot and drop the log history it makes redundant.
+     * @param snapshotPath Snapshot file to write.
+     * @throws std::system_error If the snapshot or the new log file cannot be written.
+     *
+     * Startup then loads the snapshot and replays only the writes made since
+     * it began (see AppendLog::compact). Without a log this just writes the
+     * snapshot. Traffic continues throughout.
+     */
+    void compactLog(const std::string& snapshotPath);
+
+    // ========================================
+    // Resharding
+    // ========================================
+
+    /**
+     * @brief Default number of storage positions migrateSome scans per call.
+     */
+    static constexpr size_t kDefaultMigrationBatch = 1024;
+
+    /**
+     * @brief Start changing the number of shards while the store stays online.
+     * @param newShardCount Shard count to move to, up to StoreOptions::maxShardCount.
+     * @return true If the reshard started (or the count already matches).
+     * @return false If the count is out of range or another reshard is still migrating.
+     *
+     * Routing switches to the new count at once. A key that has not been
+     * moved yet is carried to its new shard by the first operation that
+     * touches it, and migrateSome moves the rest in the background. With
+     * jump hashing, growing from n to m shards moves only (m - n) / m of the
+     * keys, all into the new shards; shrinking empties the removed shards.
+     * Each shard's share of the memory budget follows the new count.
+     * Removed shards stay allocated (and empty) for reuse.
+     */
+    bool reshard(size_t newShardCount);
+
+    /**
+     * @brief Move a slice of the keys a reshard has left to move.
+     * @param positionBudget Table positions (slots or buckets) to scan in this call.
+     * @return true If the migration is still in progress afterwards.
+     *
+     * Source shards are only locked shared while a slice is scanned, and each
+     * key is moved under its two shards' locks, so readers and writers keep
+     * running throughout. Safe to call from any thread; calls are serialised.
+     */
+    bool migrateSome(size_t positionBudget = kDefaultMigrationBatch);
+
+    /**
+     * @brief Snapshot of the current or most recent reshard.
+     */
+    ReshardProgress reshardProgress();
+
+    // ========================================
+    // Iteration
+    // ========================================
+
+    /**
+     * @brief Default number of keys scan aims to return per call.
+     */
+    static constexpr size_t kDefaultScanCount = 10;
+
+    /**
+     * @brief Return the next page of keys of an incremental scan over every shard.
+     * @param cursor 0 to start a scan, then the cursor the previous call returned.
+     * @param count Keys to aim for; a page may hold fewer (or, in ListStore, a few more).
+     * @param prefix Only keys starting with it are returned; empty = every key.
+     * @return ScanResult Matching keys and the cursor to continue from, 0 when done.
+     *
+     * Like Redis SCAN: a key present from the first call to the last is
+     * returned at least once, while keys added or removed meanwhile may or may
+     * not be, and a key may be returned twice. Each call holds one shard lock
+     * at a time, shared, and visits at most kScanPositionsPerKey table
+     * positions per requested key, so a scan never stalls a shard for long.
+     * The prefix is checked under the lock and only matching keys are
+     * copied. Expired keys are skipped, and recency is left untouched.
+     *
+     * The cursor is stateless: it packs the shard being walked, the position
+     * within that shard's table, and short tags of the routing layout and
+     * of the table's positionEpoch. Positions of SlabShardTable are slab
+     * slots, which entries keep for life, so a plain position counter is
+     * stable where Redis needs its reverse-binary cursor to survive a
+     * rehash. If a reshard changes the layout the scan starts over (keys may
+     * have moved to shards it already visited). If a ListShardTable rehashes,
+     * only that shard is walked again. Shards are visited in ascending order,
+     * or descending while a shrinking reshard migrates, so that keys only
+     * move towards shards the scan has yet to visit.
+     */
+    ScanResult scan(uint64_t cursor, size_t count = kDefaultScanCount, std::string_view prefix = {});
 
     // ========================================
     // Utility operations
@@ -76,14 +610,96 @@ public:
 
     /**
      * @brief Clear all key-value pairs from every shard in the store.
+     *
+     * Each shard's table, policy state, and expiry wheel are swapped for
+     * empty ones built before the lock is taken, so a shard is locked only
+     * for a few pointer swaps however many keys it held. The old containers
+     * are destroyed on a background thread; until then their memory still
+     * counts against the process, though not against the byte budget.
      */
     void clear();
 
+    /**
+     * @brief Block until the containers detached by earlier clears have been destroyed.
+     *
+     * Together with clear, this gives a synchronous flush that frees the
+     * memory before returning, without holding any shard lock meanwhile.
+     */
+    void waitForReclamation();
+
+    /**
+     * @brief Bytes currently charged against the byte budget, summed over shards.
+     *
+     * Counted as key bytes + value bytes + a fixed per-entry overhead for the
+     * table node, index, and value header, whether or not a budget is set.
+     */
+    size_t memoryUsage();
+
+    /**
+     * @brief Operation counters, occupancy, and lock contention, globally and per shard.
+     *
+     * Lookup, put, and delete counts live in per-thread striped counters
+     * (see OperationCounters); evictions and expirations are counted per
+     * shard under the shard's own lock; lock waits are counted per shard,
+     * and only by acquisitions that could not take the lock at once, so the
+     * uncontended path pays nothing. Everything is summed here, taking each
+     * shard's lock shared in turn. Counters of shards a reshard retires are
+     * dropped.
+     */
+    StoreStats stats();
+
+    /**
+     * @brief Latency percentiles of get, put, del, the batch operations, and shard lock acquisition.
+     *
+     * Each operation is timed from entry to return on the calling thread and
+     * recorded in that thread's stripe of a log-linear histogram (see
+     * LatencyRecorder); lock acquisitions that found the lock free record 0
+     * without reading the clock. Empty counts when built with STORM_NO_LATENCY.
+     */
+    std::vector<LatencySummary> latency() const { return latencyRecorder.summaries(); }
+
+    /**
+     * @brief Forget every recorded latency.
+     */
+    void resetLatency() { latencyRecorder.reset(); }
+
+    /**
+     * @brief Number of shards.
+     */
+    size_t shardCount() const { return LayoutShards(shardLayout.load(std::memory_order_acquire)); }
+
+    /**
+     * @brief Shard that holds a key.
+     * @param key Key to locate.
+     * @return size_t Index in 0..shardCount() - 1; fixed until the next reshard.
+     */
+    size_t shardOf(std::string_view key) const { return ShardFor(keyHash(key), shardCount()); }
+
+    /**
+     * @brief NUMA node a shard's memory was placed on.
+     * @param shard Index in 0..shardCount() - 1.
+     * @return int Node id, or -1 if the store is not NUMA-aware or NUMA is unavailable.
+     *
+     * Together with shardOf this lets the network layer run requests for a
+     * key on the socket that holds it.
+     */
+    int shardNode(size_t shard) const { return shards[shard]->numaNode; }
+
     /**
      * @brief Print the contents of all shards to stdout for debugging.
      */
     void list();
 
+    /**
+     * @brief Write the contents of all shards to a stream, most recent first per shard.
+     * @param output Stream to write the JSON-like listing to.
+     *
+     * Each shard's lock is held shared only while its keys and value handles
+     * are collected; values are decoded and written after it is released.
+     * Use scan to walk a large store a page at a time.
+     */
+    void list(std::ostream& output);
+
 private:
     // ========================================
     // Internal types
@@ -92,31 +708,180 @@ private:
     /**
      * @brief Represents a single key-value entry stored within a shard.
      */
-    struct Entry {
-        std::string value;                         ///< The value associated with the key
-        std::list<std::string>::iterator recencyIt;///< Iterator into shard's recency list
+    using Entry = typename ShardTable::Node;
+
+    /**
+     * @brief Per-shard wheel of TTL deadlines, naming entries the way the shard table does.
+     */
+    using ExpiryWheel = TimingWheel<typename ShardTable::ExpiryRef>;
+
+    /**
+     * @brief Alignment of each Shard, so neighbouring shards' locks never share a cache line.
+     *
+     * Fixed rather than std::hardware_destructive_interference_size, whose
+     * value follows -mtune and would change the layout between builds.
+     */
+    static constexpr size_t kCacheLineSize = 64;
+
+    /**
+     * @brief Most expired records a writer reclaims each time it takes a shard lock.
+     */
+    static constexpr size_t kExpiryReapBudget = 32;
+
+    /**
+     * @brief Table positions a scan call may visit per key it was asked for, as in Redis.
+     */
+    static constexpr size_t kScanPositionsPerKey = 10;
+
+    /**
+     * @brief An asynchronous operation waiting in a shard's submission queue.
+     */
+    struct AsyncOp {
+        enum class Type : uint8_t { Get, Put, Del };
+
+        Type type = Type::Get;
+        std::string key;                           ///< Owned copy; the caller's view may not outlive the call
+        uint64_t keyHash = 0;                      ///< Key hash from keyHash
+        ValueHandle value;                         ///< Put: value to store; Get: the result
+        std::string plainValue;                    ///< Put: uncompressed bytes, kept only for the log
+        bool succeeded = false;                    ///< Put and Del: the result
+        GetCallback onGet;                         ///< Get's completion
+        WriteCallback onWrite;                     ///< Put's and Del's completion; may be empty
+        std::chrono::steady_clock::time_point submittedAt; ///< For the latency histograms
     };
 
     /**
      * @brief Represents a shard, which stores part of the overall key-value store.
      *
      * Each shard maintains:
-     *  - A hash map for key-value storage
-     *  - A recency list for LRU eviction
-     *  - A mutex to allow concurrent safe access
-     */
-    struct Shard {
-        std::unordered_map<std::string, Entry> store; ///< Map from key to entry
-        std::list<std::string> recencyList;           ///< Keys ordered by recency (front = most recent)
-        std::mutex shardLock;                         ///< Mutex to protect shard
-        size_t capacity = 0;                          ///< Maximum number of entries in this shard
+     *  - A shard table holding entries in recency segments
+     *  - The eviction policy's per-shard state (segment limits, frequency sketch)
+     *  - A reader-writer mutex to allow concurrent safe access
+     *  - A timing wheel of TTL deadlines, created on the shard's first TTL
+     *  - Resident byte accounting against the shard's share of the memory budget
+     *  - A slab allocator for the values of keys routed to it
+     *  - A sampled sketch of its keys' read frequencies, to detect hot keys
+     *
+     * Shards are cache-line aligned, since every operation writes its shard's
+     * lock and adjacent heap blocks would otherwise false-share.
+     */
+    struct alignas(kCacheLineSize) Shard {
+        Shard(size_t capacity, size_t maxBytes) : table(capacity), policy(capacity), byteBudget(maxBytes) {}
+
+        ShardTable table;            ///< Entries and recency order; capacity is the maximum entry count
+        EvictionPolicy policy;       ///< Placement and victim selection for this shard's entries
+        std::shared_mutex shardLock; ///< Exclusive for writers, shared for RecencyMode::Clock readers
+        std::unique_ptr<ExpiryWheel> expiryWheel; ///< Pending deadlines; null until a TTL is set
+        size_t byteBudget = 0;       ///< Maximum resident bytes; 0 = unlimited
+        size_t residentBytes = 0;    ///< Bytes charged by the entries currently stored
+        int numaNode = -1;           ///< Node the shard was allocated on; -1 = not placed
+        uint64_t evictions = 0;      ///< Entries evicted to make room; written under the exclusive lock
+        uint64_t expirations = 0;    ///< Expired entries reclaimed; written under the exclusive lock
+        std::atomic<uint64_t> lockContentions{0}; ///< Acquisitions that found the lock taken
+        std::atomic<uint64_t> lockWaitNanos{0};   ///< Time those acquisitions waited
+        std::mutex submissionLock;                ///< Guards submissions; held only to push or swap
+        std::vector<AsyncOp> submissions;         ///< Async operations that found the shard lock taken
+        std::atomic<bool> drainScheduled{false};  ///< A drain task owns the queue; set under submissionLock
+        SlabAllocator valueSlab;                  ///< Size-class chunks for values copied in for this shard
+        HotKeyTracker hotKeys;                    ///< Sampled read frequencies; updated without the lock
+    };
+
+    /**
+     * @brief A shard's containers detached by clear, handed to the reclaimer to destroy.
+     *
+     * Constructed empty, with the shard's capacity, before the shard is
+     * locked; clear then swaps them with the shard's own.
+     */
+    struct RetiredShard {
+        explicit RetiredShard(size_t capacity) : table(capacity), policy(capacity) {}
+
+        ShardTable table;                         ///< The shard's former entries
+        EvictionPolicy policy;                    ///< The shard's former policy state
+        std::unique_ptr<ExpiryWheel> expiryWheel; ///< The shard's former deadlines
+    };
+
+    /**
+     * @brief Values displaced while a shard is locked, released once the caller unlocks.
+     *
+     * The first value is kept inline, so a put that overwrites or evicts a
+     * single entry never allocates; larger evictions spill into a vector.
+     * Declare it before the lock guard so it is destroyed after the unlock.
+     */
+    struct DisplacedValues {
+        ValueHandle first;             ///< First displaced value
+        std::vector<ValueHandle> more; ///< Any further displaced values
+
+        void add(ValueHandle value) {
+            if (!value) return;
+            if (!first) {
+                first = std::move(value);
+            } else {
+                more.push_back(std::move(value));
+            }
+        }
+
+        void reserve(size_t count) { more.reserve(count); }
+    };
+
+    /**
+     * @brief Positions of a batch's keys grouped by shard.
+     *
+     * positions[offsets[s]] up to positions[offsets[s + 1]] are the input
+     * indices that map to shard s, in input order.
+     */
+    struct ShardGroups {
+        std::vector<size_t> offsets;   ///< Start of each shard's run; shard count + 1 entries
+        std::vector<size_t> positions; ///< Input indices ordered by shard
+        std::vector<uint64_t> hashes;  ///< Key hash per input index, reused for the table lookup
+        uint64_t layout = 0;           ///< Shard layout the batch was grouped under
     };
 
+    /**
+     * @brief Where the migration scan of a reshard resumes; guarded by reshardLock.
+     */
+    struct MigrationCursor {
+        size_t firstShard = 0;             ///< First source shard that holds keys to move
+        size_t shard = 0;                  ///< Source shard being scanned
+        size_t position = 0;               ///< Next table position within it
+        size_t positionEpoch = SIZE_MAX;   ///< Table's positionEpoch when its scan (re)started
+    };
+
+    /**
+     * @brief Largest shard count a layout word can describe.
+     */
+    static constexpr size_t kMaxShardCount = (size_t{1} << 24) - 1;
+
     // ========================================
     // Internal members
     // ========================================
 
-    std::vector<std::unique_ptr<Shard>> shards; ///< Vector of shards (unique_ptr avoids copy/mutex issues)
+    /// One slot per possible shard, constructed on first use and never reallocated,
+    /// so operations index it without a lock while reshard adds shards
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::atomic<uint64_t> shardLayout{0};          ///< Routing: shard count, source count, epoch (see PackLayout)
+    std::atomic<size_t> shardByteBudget{0};        ///< Per-shard byte budget of the current layout, for admits
+    RecencyMode recencyMode = RecencyMode::Exact; ///< Read path locking and recency strategy
+    size_t maxValueBytes = 0;                      ///< Largest accepted value; 0 = no limit
+    uint64_t hashSeed = 0;                         ///< Seed for HashKey
+    size_t keysPerShard = SIZE_MAX;                ///< Key capacity of each new shard before the budget cap
+    size_t memoryBudget = 0;                       ///< Total byte budget shared by the shards; 0 = unlimited
+    bool numaAware = false;                        ///< Whether new shards are placed on NUMA nodes
+    std::mutex reshardLock;                        ///< Serialises reshard, migrateSome, and reshardProgress
+    MigrationCursor migrationCursor;               ///< Scan position of the running migration
+    size_t constructedShards = 0;                  ///< Slots of shards that hold a Shard; guarded by reshardLock
+    std::atomic<size_t> migratedKeys{0};           ///< Keys moved by the current or last reshard
+    std::shared_ptr<WorkerPool> executor;         ///< Optional pool for large batches
+    size_t parallelBatchThreshold = kDefaultParallelBatchSize; ///< Smallest batch handed to executor
+    std::shared_ptr<AppendLog> appendLog;          ///< Optional log of mutations
+    std::shared_ptr<ReplicationLog> replicationLog; ///< Optional backlog streamed to replicas
+    OperationCounters operationCounters;           ///< Striped hit, miss, put, and delete counts
+    LatencyRecorder latencyRecorder;               ///< Striped per-operation latency histograms
+    std::atomic<size_t> pendingDrains{0};          ///< Drain tasks posted to the executor and not yet finished
+    size_t compressionThreshold = 0;               ///< Smallest value copyValue compresses; 0 = off
+    size_t nearCacheSlots = 0;                     ///< Slots of each thread's near cache; 0 = no near cache
+    uint64_t nearCacheId = 0;                      ///< Identifies this store to the thread-local near caches
+    std::unique_ptr<KeyVersions> keyVersions;      ///< Near-cache invalidation; null without a near cache
+    Reclaimer reclaimer;                           ///< Destroys the containers detached by clear
 
     // ========================================
     // Per-shard helper functions
@@ -126,42 +891,402 @@ private:
      * @brief Insert or update a key-value pair within a specific shard.
      * @param targetShard Shard to perform operation on.
      * @param key Key to insert/update.
+     * @param hash Key hash from keyHash.
      * @param value Value associated with key.
-     * @return true Always returns true after operation.
+     * @param expiresAt Deadline in steady-clock milliseconds, or 0 for no expiry.
+     * @param displaced Collects overwritten and evicted values for release after unlocking.
+     * @return true If the pair is stored; false if no room could be made, leaving an existing key's old value.
+     */
+    bool putInShard(Shard& targetShard, std::string_view key, uint64_t hash, ValueHandle value,
+                    uint64_t expiresAt, DisplacedValues& displaced) {
+        Entry* entry = targetShard.table.find(key, TableHash(hash));
+        return storeInShard(targetShard, entry, key, hash, std::move(value), expiresAt, displaced);
+    }
+
+    /**
+     * @brief putInShard for a caller that has already looked the key up.
+     * @param entry The key's entry (expired or not), or nullptr if the table has none.
+     *
+     * Other parameters and the result as for putInShard.
+     */
+    bool storeInShard(Shard& targetShard, Entry* entry, std::string_view key, uint64_t hash, ValueHandle value,
+                      uint64_t expiresAt, DisplacedValues& displaced);
+
+    // ========================================
+    // Mutation logging (appendLog and replicationLog)
+    // ========================================
+
+    bool logging() const { return appendLog != nullptr || replicationLog != nullptr; }
+    void logPut(std::string_view key, std::string_view value, uint64_t expiresAtWallMillis);
+    void logDelete(std::string_view key);
+    void logExpire(std::string_view key, uint64_t expiresAtWallMillis);
+    void logClear();
+
+    /**
+     * @brief Store the entries of one snapshot section.
+     * @param section Cursor over the section.
+     * @return size_t Number of entries stored.
+     */
+    size_t loadSnapshotSection(SnapshotSection& section);
+
+    /**
+     * @brief Evict the policy's victims until an incoming charge fits.
+     * @param targetShard Shard to evict from; must be locked exclusively.
+     * @param incomingCharge Bytes about to be added to the shard.
+     * @param needsSlot Whether the incoming entry also needs a free key slot.
+     * @param protectedEntry Entry that must not be evicted, or nullptr.
+     * @param displaced Collects the evicted values.
+     * @return true If the charge fits now.
+     */
+    bool evictToFit(Shard& targetShard, size_t incomingCharge, bool needsSlot, Entry* protectedEntry,
+                    DisplacedValues& displaced);
+
+    /**
+     * @brief Look up a key in the calling thread's near cache, after sampling the read for hot-key detection.
+     * @param key Key to look up.
+     * @param hash Key hash from keyHash.
+     * @return const ValueHandle* Current cached value, or nullptr (always, without a near cache).
+     */
+    const ValueHandle* findNearCached(std::string_view key, uint64_t hash);
+
+    /**
+     * @brief get's path through the shard; fills the near cache if the key is hot.
+     * @param key Key to retrieve.
+     * @param hash Key hash from keyHash.
+     * @return ValueHandle Decoded value, or an empty handle.
+     */
+    ValueHandle readThrough(std::string_view key, uint64_t hash);
+
+    /**
+     * @brief Invalidate near-cached copies of a key; a no-op without a near cache.
+     * @param tableHash The key's TableHash. Call with the key's shard locked exclusively.
+     */
+    void invalidateNearCaches(uint32_t tableHash) {
+        if (keyVersions != nullptr) {
+            keyVersions->bump(tableHash);
+        }
+    }
+
+    /**
+     * @brief Remove an entry, updating the shard's resident bytes.
+     * @param targetShard Shard owning the entry; must be locked exclusively.
+     * @param entry Entry to remove.
+     * @return ValueHandle The removed value.
+     */
+    ValueHandle eraseEntry(Shard& targetShard, Entry* entry);
+
+    /**
+     * @brief Bytes an entry is charged against its shard's byte budget.
+     * @param keySize Key length in bytes.
+     * @param valueSize Value length in bytes.
+     *
+     * The value is charged for its whole slab chunk, slack included.
+     */
+    static size_t EntryCharge(size_t keySize, size_t valueSize) {
+        return keySize + SlabAllocator::ChargeFor(valueSize) + ShardTable::entryOverhead();
+    }
+
+    /**
+     * @brief Whether a pair passes the value-size limit and could fit in an empty shard.
+     * @param keySize Key length in bytes.
+     * @param valueSize Value length in bytes.
      */
-    bool putInShard(Shard& targetShard, const std::string& key, const std::string& value);
+    bool admits(size_t keySize, size_t valueSize) const {
+        if (maxValueBytes != 0 && valueSize > maxValueBytes) {
+            return false;
+        }
+        size_t shard_byte_budget = shardByteBudget.load(std::memory_order_relaxed);
+        return shard_byte_budget == 0 || EntryCharge(keySize, valueSize) <= shard_byte_budget;
+    }
+
+    /**
+     * @brief admits for a value about to go through copyValue.
+     * @param keySize Key length in bytes.
+     * @param valueSize Uncompressed value length in bytes.
+     *
+     * A value copyValue may compress is only held to maxValueBytes here; the
+     * budget is checked against its stored size once it has been copied.
+     */
+    bool admitsCopy(size_t keySize, size_t valueSize) const {
+        if (compressionThreshold != 0 && valueSize >= compressionThreshold) {
+            return maxValueBytes == 0 || valueSize <= maxValueBytes;
+        }
+        return admits(keySize, valueSize);
+    }
+
+    /**
+     * @brief Build the shard for a slot of a layout with shardCount shards.
+     * @param shardIndex Slot the shard will occupy.
+     * @param shardCount Shard count of the layout, which sets the budget share and NUMA node.
+     */
+    std::unique_ptr<Shard> makeShard(size_t shardIndex, size_t shardCount) const;
+
+    /**
+     * @brief Each shard's share of the memory budget with shardCount shards; 0 = unlimited.
+     */
+    size_t budgetShare(size_t shardCount) const;
+
+    /**
+     * @brief Lock the shard that owns a key under the current layout.
+     * @param key Key being operated on.
+     * @param hash Key hash from keyHash.
+     * @param shardLockGuard Empty std::unique_lock or std::shared_lock; holds the shard's lock on return.
+     * @return Shard& The key's shard.
+     *
+     * While a reshard migrates, the key is first moved out of its old shard
+     * if it is still there. The layout is checked again once the lock is
+     * held, so an operation never acts on a shard the key has just left.
+     */
+    template <typename Lock>
+    Shard& lockKeyShard(std::string_view key, uint64_t hash, Lock& shardLockGuard);
+
+    /**
+     * @brief Take a shard's lock, counting the wait in the shard's stats if it was held.
+     * @param targetShard Shard to lock.
+     * @return Lock std::unique_lock or std::shared_lock owning the shard's lock.
+     *
+     * Every acquisition is also recorded in the LockAcquire latency histogram.
+     */
+    template <typename Lock>
+    Lock lockShard(Shard& targetShard);
+
+    /**
+     * @brief Run an async operation at once if its shard lock is free, or queue it on the shard.
+     * @param operation Operation with its key, hash, and callback filled in.
+     */
+    void submitAsync(AsyncOp operation);
+
+    /**
+     * @brief Perform an async operation on its shard, locked exclusively and already reaped.
+     * @param shard The key's shard under the current layout.
+     * @param operation Operation to perform; its result is stored in it.
+     * @param displacedValues Receives overwritten, evicted, and deleted values.
+     */
+    void runLockedAsync(Shard& shard, AsyncOp& operation, DisplacedValues& displacedValues);
+
+    /**
+     * @brief Drain task: run a shard's queued operations in batches, one lock acquisition per batch.
+     * @param shardIndex Shard whose queue to drain.
+     *
+     * Operations whose key a reshard has routed elsewhere since they were
+     * queued run through the synchronous forms after the lock is released.
+     */
+    void drainSubmissions(size_t shardIndex);
+
+    /**
+     * @brief Record an async operation's latency since submission and call its callback.
+     * @param operation Completed operation.
+     * @param recordLatency false when a synchronous form ran it and recorded it already.
+     */
+    void completeAsync(AsyncOp& operation, bool recordLatency);
+
+    /**
+     * @brief Move one key from its source shard to its target shard under a migrating layout.
+     * @param key Key to move; must not view the source entry's own key buffer.
+     * @param hash Key hash from keyHash.
+     * @param layout Migrating layout the key was routed under.
+     *
+     * Locks both shards exclusively, lower index first. Does nothing if the
+     * key is not in its source shard or the layout has moved on.
+     */
+    void migrateKey(std::string_view key, uint64_t hash, uint64_t layout);
+
+    /**
+     * @brief Lock the key's shard and insert or update it with an absolute deadline.
+     * @param key Key to insert/update.
+     * @param hash Key hash from keyHash.
+     * @param value Value to store.
+     * @param expiresAt Deadline in steady-clock milliseconds, or 0 for no expiry.
+     * @param plainValue Uncompressed bytes of value for the log; only read if value is compressed.
+     * @return true If the pair was stored; false if it is too large to admit.
+     */
+    bool putWithDeadline(std::string_view key, uint64_t hash, ValueHandle value, uint64_t expiresAt,
+                         std::string_view plainValue = {});
+
+    /**
+     * @brief Copy a value into the slab of the shard its key routes to, without locking.
+     * @param hash Key hash from keyHash.
+     * @param value Bytes to copy.
+     *
+     * Values of at least compressionThreshold bytes are stored as an LZ4
+     * block when it is at most seven eighths of their size. A reshard may
+     * route the key elsewhere before it is stored; the chunk still returns
+     * to the slab it came from.
+     */
+    ValueHandle copyValue(uint64_t hash, std::string_view value);
+
+    /**
+     * @brief The value as callers see it: compressed values are decompressed into a new handle.
+     * @param value Handle taken from an entry; call it after the shard lock is released.
+     */
+    ValueHandle decodeValue(ValueHandle value);
+
+    /**
+     * @brief Find a key, erasing it first if it has expired.
+     * @param targetShard Shard to search; must be locked exclusively.
+     * @param key Key to look up.
+     * @param hash Key hash from keyHash.
+     * @return Entry* Live entry, or nullptr.
+     */
+    Entry* findLive(Shard& targetShard, std::string_view key, uint64_t hash);
+
+    /**
+     * @brief Set an entry's deadline and schedule it on the shard's wheel.
+     * @param targetShard Shard owning the entry; must be locked exclusively.
+     * @param entry Entry to update.
+     * @param expiresAt Deadline in steady-clock milliseconds, or 0 for no expiry.
+     */
+    void setDeadline(Shard& targetShard, Entry& entry, uint64_t expiresAt);
+
+    /**
+     * @brief Reclaim up to kExpiryReapBudget expired entries from the shard's wheel.
+     * @param targetShard Shard to reap; must be locked exclusively.
+     */
+    void reapExpired(Shard& targetShard);
 
     /**
      * @brief Retrieve a value from a specific shard.
      * @param targetShard Shard to search.
      * @param key Key to retrieve.
-     * @param value Output parameter for the value.
+     * @param hash Key hash from keyHash.
+     * @param value Output parameter for the value handle.
+     * @return true If key exists.
+     * @return false If key does not exist.
+     */
+    bool getFromShard(Shard& targetShard, std::string_view key, uint64_t hash, ValueHandle& value);
+
+    /**
+     * @brief Retrieve a value from a specific shard under a shared lock.
+     * @param targetShard Shard to search.
+     * @param key Key to retrieve.
+     * @param hash Key hash from keyHash.
+     * @param value Output parameter for the value handle.
      * @return true If key exists.
      * @return false If key does not exist.
+     *
+     * Leaves the recency order untouched and sets the entry's reference bit instead.
      */
-    bool getFromShard(Shard& targetShard, const std::string& key, std::string& value);
+    bool peekFromShard(Shard& targetShard, std::string_view key, uint64_t hash, ValueHandle& value);
+
+    /**
+     * @brief Pick the entry to evict from a full shard.
+     * @param targetShard Shard to evict from; must be locked exclusively.
+     * @return Entry* The policy's victim, skipping entries referenced since their last promotion.
+     *
+     * Entries whose reference bit is set get a second chance: the bit is cleared and
+     * the access deferred by a shared-lock read is replayed through the policy.
+     */
+    Entry* selectVictim(Shard& targetShard);
 
     /**
      * @brief Delete a key from a specific shard.
      * @param targetShard Shard to operate on.
      * @param key Key to delete.
+     * @param hash Key hash from keyHash.
+     * @param removedValue Receives the deleted value so it can be released after unlocking.
      * @return true If key existed and was deleted.
      * @return false If key does not exist.
      */
-    bool delFromShard(Shard& targetShard, const std::string& key);
+    bool delFromShard(Shard& targetShard, std::string_view key, uint64_t hash, ValueHandle& removedValue);
 
     // ========================================
     // Shard selection helper
     // ========================================
 
     /**
-     * @brief Determine which shard a key belongs to.
-     * @param key Key to map.
-     * @return size_t Index of the shard in the shards vector.
+     * @brief Bucket a batch of keys by shard without copying them.
+     * @param keyCount Number of keys in the batch.
+     * @param keyAt Callable returning the key at an input index.
+     * @param groups Output; filled with the input indices for each shard.
      *
-     * Uses a standard hash function modulo the number of shards.
+     * During a migration the batch's keys are first moved to their new
+     * shards. Work on a group must check that shardLayout still equals
+     * groups.layout once its shard is locked, and fall back to single-key
+     * operations if not.
      */
-    size_t shardIndex(const std::string& key) const {
-        return std::hash<std::string>{}(key) % shards.size();
+    template <typename KeyAt>
+    void groupByShard(size_t keyCount, KeyAt keyAt, ShardGroups& groups);
+
+    /**
+     * @brief Run work for every shard with keys in a batch, inline or on the executor.
+     * @param groups Batch grouped by shard.
+     * @param batchSize Number of keys in the batch; compared against parallelBatchThreshold.
+     * @param shardWork Callable taking (shard index, first group index, end group index).
+     */
+    template <typename ShardWork>
+    void forEachShardGroup(const ShardGroups& groups, size_t batchSize, ShardWork shardWork);
+
+    /**
+     * @brief Hash a key once for both shard selection and the in-shard lookup.
+     * @param key Key to hash.
+     * @return uint64_t Seeded hash; the high half picks the shard, the low half goes to the table.
+     */
+    uint64_t keyHash(std::string_view key) const { return HashKey(key, hashSeed); }
+
+    /**
+     * @brief Determine which shard a key hash belongs to.
+     * @param hash Key hash from keyHash.
+     * @param shardCount Number of shards in the layout.
+     * @return size_t Shard index in [0, shardCount).
+     *
+     * Jump consistent hashing (Lamping and Veach) over the high 32 bits: when
+     * the count grows from n to m, a key either keeps its shard or moves to
+     * one of the new shards n..m-1, and only (m - n) / m of the keys move.
+     * Costs about ln(shardCount) multiply-and-divide steps.
+     */
+    static size_t ShardFor(uint64_t hash, size_t shardCount) {
+        uint64_t state = hash >> 32;
+        int64_t shard = -1;
+        int64_t next_shard = 0;
+        while (next_shard < static_cast<int64_t>(shardCount)) {
+            shard = next_shard;
+            state = state * 2862933555777941757ull + 1;
+            next_shard = static_cast<int64_t>(static_cast<double>(shard + 1) *
+                                              (static_cast<double>(int64_t{1} << 31) / static_cast<double>((state >> 33) + 1)));
+        }
+        return static_cast<size_t>(shard);
     }
+
+    /**
+     * @brief Pack a routing layout into one word: bits 0-23 the shard count,
+     *        24-47 the count keys are migrating from (equal when idle), 48-63 an epoch.
+     */
+    static uint64_t PackLayout(size_t shardCount, size_t sourceCount, uint64_t epoch) {
+        return static_cast<uint64_t>(shardCount) | (static_cast<uint64_t>(sourceCount) << 24) | (epoch << 48);
+    }
+
+    static size_t LayoutShards(uint64_t layout) { return static_cast<size_t>(layout & kMaxShardCount); }
+    static size_t LayoutSources(uint64_t layout) { return static_cast<size_t>((layout >> 24) & kMaxShardCount); }
+    static uint64_t LayoutEpoch(uint64_t layout) { return layout >> 48; }
+    static bool LayoutMigrating(uint64_t layout) { return LayoutShards(layout) != LayoutSources(layout); }
+
+    /**
+     * @brief Number of shard slots that may hold keys under a layout (old and new shards while migrating).
+     */
+    static size_t LayoutSpan(uint64_t layout) { return std::max(LayoutShards(layout), LayoutSources(layout)); }
+
+    /**
+     * @brief The part of a key hash handed to the shard table.
+     */
+    static uint32_t TableHash(uint64_t hash) { return static_cast<uint32_t>(hash); }
 };
+
+/**
+ * @brief Default store: intrusive slab-allocated shards.
+ */
+using Store = BasicStore<SlabShardTable>;
+
+/**
+ * @brief Store using the original std::unordered_map + std::list shard layout.
+ */
+using ListStore = BasicStore<ListShardTable>;
+
+/**
+ * @brief Slab-allocated store with segmented LRU eviction.
+ */
+using SlruStore = BasicStore<SlabShardTable, SlruPolicy>;
+
+/**
+ * @brief Slab-allocated store with W-TinyLFU eviction.
+ */
+using TinyLfuStore = BasicStore<SlabShardTable, TinyLfuPolicy>;
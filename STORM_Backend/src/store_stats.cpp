@@ -0,0 +1,105 @@
+#include "store_stats.h"
+
+namespace {
+
+/**
+ * @brief Append one metric family: HELP and TYPE lines followed by a single sample.
+ */
+void AppendMetric(std::string& output, const char* name, const char* type, const char* help, uint64_t value) {
+    output += "# HELP ";
+    output += name;
+    output += ' ';
+    output += help;
+    output += "\n# TYPE ";
+    output += name;
+    output += ' ';
+    output += type;
+    output += '\n';
+    output += name;
+    output += ' ';
+    output += std::to_string(value);
+    output += '\n';
+}
+
+/**
+ * @brief Append a per-shard metric family, one sample per shard labelled by index.
+ */
+template <typename Field>
+void AppendShardMetric(std::string& output, const char* name, const char* type, const char* help,
+                       const StoreStats& stats, Field field) {
+    output += "# HELP ";
+    output += name;
+    output += ' ';
+    output += help;
+    output += "\n# TYPE ";
+    output += name;
+    output += ' ';
+    output += type;
+    output += '\n';
+    for (size_t shard_index = 0; shard_index < stats.shards.size(); ++shard_index) {
+        output += name;
+        output += "{shard=\"" + std::to_string(shard_index) + "\"} ";
+        output += std::to_string(field(stats.shards[shard_index]));
+        output += '\n';
+    }
+}
+
+} // namespace
+
+void AppendPrometheusMetrics(std::string& output, const StoreStats& stats) {
+    AppendMetric(output, "storm_gets_total", "counter", "Key lookups.", stats.gets);
+    AppendMetric(output, "storm_hits_total", "counter", "Lookups that found a live key.", stats.hits);
+    AppendMetric(output, "storm_misses_total", "counter", "Lookups that found nothing.", stats.misses);
+    AppendMetric(output, "storm_puts_total", "counter", "Values stored.", stats.puts);
+    AppendMetric(output, "storm_deletes_total", "counter", "Keys removed by deletes.", stats.deletes);
+    AppendMetric(output, "storm_evictions_total", "counter", "Entries evicted to make room.", stats.evictions);
+    AppendMetric(output, "storm_expirations_total", "counter", "Expired entries reclaimed.", stats.expirations);
+    AppendMetric(output, "storm_lock_contentions_total", "counter", "Shard lock acquisitions that waited.",
+                 stats.lockContentions);
+    AppendMetric(output, "storm_lock_wait_nanoseconds_total", "counter", "Time spent waiting for shard locks.",
+                 stats.lockWaitNanos);
+    AppendMetric(output, "storm_keys", "gauge", "Entries held.", stats.keys);
+    AppendMetric(output, "storm_bytes", "gauge", "Bytes charged against the memory budget.", stats.bytes);
+    AppendMetric(output, "storm_slab_page_bytes", "gauge", "Slab pages allocated for values.",
+                 stats.slab.pageBytes);
+    AppendMetric(output, "storm_slab_chunk_bytes", "gauge", "Slab chunks holding a value.", stats.slab.chunkBytes);
+    AppendMetric(output, "storm_slab_requested_bytes", "gauge", "Value bytes and headers in slab chunks.",
+                 stats.slab.requestedBytes);
+    AppendMetric(output, "storm_slab_heap_bytes", "gauge", "Values too large for a slab class.",
+                 stats.slab.heapBytes);
+    AppendMetric(output, "storm_compressed_values_total", "counter", "Values stored compressed.",
+                 stats.compression.compressedValues);
+    AppendMetric(output, "storm_incompressible_values_total", "counter",
+                 "Values above the compression threshold stored verbatim.", stats.compression.incompressibleValues);
+    AppendMetric(output, "storm_compression_input_bytes_total", "counter", "Bytes of the values compressed.",
+                 stats.compression.inputBytes);
+    AppendMetric(output, "storm_compression_output_bytes_total", "counter", "Bytes they were compressed to.",
+                 stats.compression.outputBytes);
+    AppendMetric(output, "storm_compress_nanoseconds_total", "counter", "Time spent compressing values.",
+                 stats.compression.compressNanos);
+    AppendMetric(output, "storm_decompressions_total", "counter", "Reads that decompressed a value.",
+                 stats.compression.decompressions);
+    AppendMetric(output, "storm_decompress_nanoseconds_total", "counter", "Time spent decompressing values.",
+                 stats.compression.decompressNanos);
+    AppendMetric(output, "storm_near_cache_hits_total", "counter", "Gets served from a thread's near cache.",
+                 stats.nearCacheHits);
+    AppendMetric(output, "storm_near_cache_fills_total", "counter", "Hot values copied into a near cache.",
+                 stats.nearCacheFills);
+
+    AppendShardMetric(output, "storm_shard_keys", "gauge", "Entries held by the shard.", stats,
+                      [](const ShardStats& shard) { return static_cast<uint64_t>(shard.keys); });
+    AppendShardMetric(output, "storm_shard_bytes", "gauge", "Bytes charged by the shard.", stats,
+                      [](const ShardStats& shard) { return static_cast<uint64_t>(shard.bytes); });
+    AppendShardMetric(output, "storm_shard_slab_page_bytes", "gauge", "Slab pages the shard allocated.", stats,
+                      [](const ShardStats& shard) { return static_cast<uint64_t>(shard.slab.pageBytes); });
+    AppendShardMetric(output, "storm_shard_evictions_total", "counter", "Entries the shard evicted.", stats,
+                      [](const ShardStats& shard) { return shard.evictions; });
+    AppendShardMetric(output, "storm_shard_lock_contentions_total", "counter",
+                      "Acquisitions of the shard lock that waited.", stats,
+                      [](const ShardStats& shard) { return shard.lockContentions; });
+    AppendShardMetric(output, "storm_shard_lock_wait_nanoseconds_total", "counter",
+                      "Time spent waiting for the shard lock.", stats,
+                      [](const ShardStats& shard) { return shard.lockWaitNanos; });
+    AppendShardMetric(output, "storm_shard_hot_keys", "gauge", "Keys of the shard currently detected as hot.", stats,
+                      [](const ShardStats& shard) { return static_cast<uint64_t>(shard.hotKeys.size()); });
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "hot_keys.h"
+#include "slab_allocator.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Small per-thread number for picking a counter stripe.
+ *
+ * Threads are numbered round robin the first time they ask, so callers that
+ * take it modulo their stripe count spread threads evenly.
+ */
+inline size_t ThreadStripe() {
+    static std::atomic<size_t> next_stripe{0};
+    thread_local size_t stripe = next_stripe.fetch_add(1, std::memory_order_relaxed);
+    return stripe;
+}
+
+/**
+ * @brief Operation counters a store keeps without shared atomics on the request path.
+ */
+enum class StoreCounter : size_t {
+    Hits,    ///< Lookups that found a live key
+    Misses,  ///< Lookups that found nothing
+    Puts,    ///< Values stored (inserts and overwrites)
+    Deletes, ///< Keys removed by a delete
+    CompressedValues,     ///< Values copyValue stored compressed
+    IncompressibleValues, ///< Values above the threshold that did not shrink enough
+    CompressInputBytes,   ///< Uncompressed bytes of the compressed values
+    CompressOutputBytes,  ///< Bytes those values were compressed to
+    CompressNanos,        ///< Time spent compressing, including incompressible attempts
+    Decompressions,       ///< Reads that decompressed a value
+    DecompressNanos,      ///< Time spent decompressing
+    NearCacheHits,        ///< Gets served from a thread's near cache; also counted as Hits
+    NearCacheFills,       ///< Hot values copied into a thread's near cache
+    Count
+};
+
+/**
+ * @brief Striped counters: each thread adds to its own cache line, and readers sum the stripes.
+ *
+ * A thread is assigned a stripe the first time it counts anything, round
+ * robin, so up to kStripeCount threads never share a line. Beyond that,
+ * threads share stripes and the increments stay correct, just no longer
+ * contention-free. Totals are read with relaxed loads and are only as
+ * consistent as a concurrent sum can be.
+ */
+class OperationCounters {
+public:
+    static constexpr size_t kStripeCount = 64;
+
+    /**
+     * @brief Add to one counter in the calling thread's stripe.
+     */
+    void add(StoreCounter counter, uint64_t amount = 1) {
+        if (amount != 0) {
+            Stripe& stripe = stripes[ThreadStripe() % kStripeCount];
+            stripe.values[static_cast<size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Sum of one counter over every stripe.
+     */
+    uint64_t total(StoreCounter counter) const {
+        uint64_t sum = 0;
+        for (const Stripe& stripe : stripes) {
+            sum += stripe.values[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+private:
+    static constexpr size_t kCounterCount = static_cast<size_t>(StoreCounter::Count);
+
+    struct alignas(64) Stripe {
+        std::array<std::atomic<uint64_t>, kCounterCount> values{};
+    };
+
+    std::array<Stripe, kStripeCount> stripes;
+};
+
+/**
+ * @brief Occupancy and counters of one shard.
+ */
+struct ShardStats {
+    size_t keys = 0;              ///< Entries held, including expired ones not yet reclaimed
+    size_t bytes = 0;             ///< Bytes charged against the budget
+    uint64_t evictions = 0;       ///< Entries evicted to make room
+    uint64_t expirations = 0;     ///< Expired entries reclaimed
+    uint64_t lockContentions = 0; ///< Lock acquisitions that had to wait
+    uint64_t lockWaitNanos = 0;   ///< Time spent waiting in those acquisitions
+    SlabStats slab;               ///< Value memory held by the shard's slab allocator
+    std::vector<HotKey> hotKeys;  ///< The shard's hot keys, hottest first
+};
+
+/**
+ * @brief Transparent value compression counters; all 0 when compression is off.
+ */
+struct CompressionStats {
+    uint64_t compressedValues = 0;     ///< Values stored compressed
+    uint64_t incompressibleValues = 0; ///< Values above the threshold stored verbatim
+    uint64_t inputBytes = 0;           ///< Uncompressed bytes of the compressed values
+    uint64_t outputBytes = 0;          ///< Bytes those values were stored in
+    uint64_t compressNanos = 0;        ///< Time spent compressing
+    uint64_t decompressions = 0;       ///< Reads that decompressed a value
+    uint64_t decompressNanos = 0;      ///< Time spent decompressing
+
+    /**
+     * @brief inputBytes / outputBytes, or 0 before the first compressed value.
+     */
+    double ratio() const {
+        return outputBytes == 0 ? 0.0 : static_cast<double>(inputBytes) / static_cast<double>(outputBytes);
+    }
+};
+
+/**
+ * @brief Point-in-time statistics of a store; see BasicStore::stats.
+ */
+struct StoreStats {
+    uint64_t gets = 0;            ///< Lookups (hits + misses)
+    uint64_t hits = 0;            ///< Lookups that found a live key
+    uint64_t misses = 0;          ///< Lookups that found nothing
+    uint64_t puts = 0;            ///< Values stored
+    uint64_t deletes = 0;         ///< Keys removed by a delete
+    uint64_t evictions = 0;       ///< Sum over shards
+    uint64_t expirations = 0;     ///< Sum over shards
+    uint64_t lockContentions = 0; ///< Sum over shards
+    uint64_t lockWaitNanos = 0;   ///< Sum over shards
+    size_t keys = 0;              ///< Sum over shards
+    size_t bytes = 0;             ///< Sum over shards
+    SlabStats slab;               ///< Sum over shards
+    CompressionStats compression; ///< Value compression counters
+    uint64_t nearCacheHits = 0;   ///< Gets served from a near cache, without a shard lock
+    uint64_t nearCacheFills = 0;  ///< Values copied into a near cache
+    std::vector<HotKey> hotKeys;  ///< The hottest keys over all shards, hottest first, at most HotKeyTracker::kTrackedKeys
+    std::vector<ShardStats> shards; ///< One per shard of the current layout
+
+    /**
+     * @brief hits / gets, or 0 before the first lookup.
+     */
+    double hitRatio() const { return gets == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(gets); }
+};
+
+/**
+ * @brief Append the statistics in the Prometheus text exposition format (version 0.0.4).
+ * @param output Buffer to append to.
+ * @param stats Statistics to render.
+ */
+void AppendPrometheusMetrics(std::string& output, const StoreStats& stats);
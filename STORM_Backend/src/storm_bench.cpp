@@ -0,0 +1,648 @@
+#include "latency_histogram.h"
+#include "owned_shard_store.h"
+#include "store.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief YCSB-style benchmark of the store, printing one JSON object per run.
+ *
+ * Every run loads `--records` keys, pre-generates each thread's operations
+ * (type and key index) and all key strings, and only then starts the clock,
+ * so formatting keys and drawing random numbers is not what is measured.
+ * Lists given to --workload, --threads, and --shards are swept as a cross
+ * product and printed as one JSON array.
+ */
+
+/**
+ * @brief Key request distributions, as in YCSB.
+ */
+enum class KeyDistribution {
+    Default, ///< The workload's own: latest for D, zipfian otherwise
+    Uniform, ///< Every record equally likely
+    Zipfian, ///< Scrambled zipfian: a few hot keys spread over the key space
+    Latest   ///< Zipfian over recency: recently inserted keys are hottest
+};
+
+/**
+ * @brief Operation types of the YCSB core workloads.
+ */
+enum class BenchOp : uint8_t {
+    Read,            ///< get
+    Update,          ///< put of an existing key
+    Insert,          ///< put of a new key
+    Scan,            ///< getMany of consecutive record keys
+    ReadModifyWrite, ///< get then put of the same key
+    Count
+};
+
+/**
+ * @brief Operation mix of one YCSB workload (fractions sum to 1).
+ */
+struct WorkloadMix {
+    char name = 'a';
+    double read = 0;
+    double update = 0;
+    double insert = 0;
+    double scan = 0;
+    double readModifyWrite = 0;
+};
+
+/**
+ * @brief Command-line configuration for the benchmark binary.
+ */
+struct BenchOptions {
+    std::vector<char> workloads{'a'};        ///< YCSB workloads to run, a..f
+    KeyDistribution distribution = KeyDistribution::Default;
+    size_t records = 100000;                 ///< Keys loaded before timing
+    size_t operations = 1000000;             ///< Timed operations per run, split over threads
+    std::vector<size_t> threadCounts{1};     ///< Client threads per run
+    std::vector<size_t> shardCounts{16};     ///< Shards per run
+    size_t shardCapacity = 0;                ///< Keys per shard; 0 = room for every key
+    size_t keyBytes = 16;                    ///< Key length (at least 12)
+    size_t valueBytes = 100;                 ///< Value length
+    size_t maxScanLength = 100;              ///< Longest scan in workload E
+    double zipfTheta = 0.99;                 ///< Zipfian skew
+    std::string storeType = "lru";           ///< lru, list, slru, tinylfu, or owned
+    RecencyMode recencyMode = RecencyMode::Exact;
+    uint64_t seed = 1;                       ///< Seeds key choice and the store's key hash
+};
+
+/**
+ * @brief One pre-generated operation.
+ */
+struct PlannedOp {
+    BenchOp type;
+    uint32_t scanLength; ///< Keys read by a scan
+    uint64_t keyIndex;   ///< Index into the key table
+};
+
+/**
+ * @brief JSON name of an operation type.
+ */
+const char* BenchOpName(BenchOp op) {
+    switch (op) {
+        case BenchOp::Read: return "read";
+        case BenchOp::Update: return "update";
+        case BenchOp::Insert: return "insert";
+        case BenchOp::Scan: return "scan";
+        case BenchOp::ReadModifyWrite: return "rmw";
+        case BenchOp::Count: break;
+    }
+    return "unknown";
+}
+
+/**
+ * @brief The YCSB core workload mixes.
+ * @return false If name is not a..f.
+ */
+bool LookupWorkload(char name, WorkloadMix& mix) {
+    switch (name) {
+        case 'a': mix = {name, 0.50, 0.50, 0.00, 0.00, 0.00}; return true;
+        case 'b': mix = {name, 0.95, 0.05, 0.00, 0.00, 0.00}; return true;
+        case 'c': mix = {name, 1.00, 0.00, 0.00, 0.00, 0.00}; return true;
+        case 'd': mix = {name, 0.95, 0.00, 0.05, 0.00, 0.00}; return true;
+        case 'e': mix = {name, 0.00, 0.00, 0.05, 0.95, 0.00}; return true;
+        case 'f': mix = {name, 0.50, 0.00, 0.00, 0.00, 0.50}; return true;
+        default: return false;
+    }
+}
+
+// ========================================
+// Key generation
+// ========================================
+
+/**
+ * @brief 64-bit FNV-1a of an integer, as YCSB scrambles zipfian ranks.
+ */
+uint64_t Fnv64(uint64_t value) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (int byte = 0; byte < 8; ++byte) {
+        hash ^= value & 0xff;
+        hash *= 0x100000001b3ull;
+        value >>= 8;
+    }
+    return hash;
+}
+
+/**
+ * @brief Zipfian ranks in [0, itemCount), rank 0 the most popular (Gray et al., as YCSB draws them).
+ */
+class ZipfianGenerator {
+public:
+    ZipfianGenerator(uint64_t itemCount, double zipfTheta) : items(itemCount), theta(zipfTheta) {
+        zetaTwo = 1.0 + std::pow(0.5, theta);
+        for (uint64_t rank = 1; rank <= items; ++rank) {
+            zetaN += 1.0 / std::pow(static_cast<double>(rank), theta);
+        }
+        alpha = 1.0 / (1.0 - theta);
+        eta = (1.0 - std::pow(2.0 / static_cast<double>(items), 1.0 - theta)) / (1.0 - zetaTwo / zetaN);
+    }
+
+    template <typename Random>
+    uint64_t next(Random& random) {
+        double uniform = std::uniform_real_distribution<double>(0.0, 1.0)(random);
+        double scaled = uniform * zetaN;
+        if (scaled < 1.0) {
+            return 0;
+        }
+        if (scaled < zetaTwo) {
+            return 1;
+        }
+        auto rank = static_cast<uint64_t>(static_cast<double>(items) * std::pow(eta * uniform - eta + 1.0, alpha));
+        return std::min(rank, items - 1);
+    }
+
+private:
+    uint64_t items;
+    double theta;
+    double zetaN = 0;
+    double alpha = 0;
+    double eta = 0;
+    double zetaTwo = 0;
+};
+
+/**
+ * @brief Key of a record index: "user" and the zero-padded index, keyBytes long.
+ */
+std::string FormatKey(uint64_t index, size_t key_bytes) {
+    std::string digits = std::to_string(index);
+    std::string key = "user";
+    if (digits.size() + key.size() < key_bytes) {
+        key.append(key_bytes - key.size() - digits.size(), '0');
+    }
+    key += digits;
+    return key;
+}
+
+/**
+ * @brief Distribution a run uses: the requested one, or the workload's own.
+ */
+KeyDistribution EffectiveDistribution(const BenchOptions& options, const WorkloadMix& mix) {
+    if (options.distribution != KeyDistribution::Default) {
+        return options.distribution;
+    }
+    return mix.name == 'd' ? KeyDistribution::Latest : KeyDistribution::Zipfian;
+}
+
+/**
+ * @brief Draw every thread's operations for one run.
+ * @param options Records, operations, distribution, and scan length.
+ * @param mix Operation fractions.
+ * @param thread_count Threads to plan for.
+ * @return Per-thread operation lists; inserted keys follow the records in the key table.
+ *
+ * Thread t's j-th insert gets key index records + j * thread_count + t, so
+ * inserts never collide. Latest reads count back over the thread's own
+ * inserts, as a YCSB client only reads keys it knows are acknowledged, so
+ * they never miss because another thread is running behind.
+ */
+std::vector<std::vector<PlannedOp>> PlanOperations(const BenchOptions& options, const WorkloadMix& mix,
+                                                   size_t thread_count) {
+    KeyDistribution distribution = EffectiveDistribution(options, mix);
+    ZipfianGenerator zipfian(options.records, options.zipfTheta);
+    size_t per_thread = options.operations / thread_count;
+
+    std::vector<std::vector<PlannedOp>> plans(thread_count);
+    for (size_t thread_index = 0; thread_index < thread_count; ++thread_index) {
+        std::mt19937_64 random(options.seed * 1000003 + thread_index);
+        std::uniform_real_distribution<double> choose(0.0, 1.0);
+        std::uniform_int_distribution<uint64_t> uniform_record(0, options.records - 1);
+        std::uniform_int_distribution<uint32_t> scan_length(1, static_cast<uint32_t>(options.maxScanLength));
+        uint64_t inserted = 0;
+
+        std::vector<PlannedOp>& plan = plans[thread_index];
+        plan.reserve(per_thread);
+        for (size_t position = 0; position < per_thread; ++position) {
+            double pick = choose(random);
+            BenchOp type = BenchOp::ReadModifyWrite;
+            if ((pick -= mix.read) < 0) {
+                type = BenchOp::Read;
+            } else if ((pick -= mix.update) < 0) {
+                type = BenchOp::Update;
+            } else if ((pick -= mix.insert) < 0) {
+                type = BenchOp::Insert;
+            } else if ((pick -= mix.scan) < 0) {
+                type = BenchOp::Scan;
+            }
+
+            PlannedOp planned{type, 0, 0};
+            if (type == BenchOp::Insert) {
+                planned.keyIndex = options.records + inserted++ * thread_count + thread_index;
+            } else if (distribution == KeyDistribution::Uniform) {
+                planned.keyIndex = uniform_record(random);
+            } else if (distribution == KeyDistribution::Zipfian) {
+                planned.keyIndex = Fnv64(zipfian.next(random)) % options.records;
+            } else {
+                // Rank r is this thread's r-th most recent insert, then the records from the last one back
+                uint64_t rank = zipfian.next(random);
+                planned.keyIndex = rank < inserted
+                                       ? options.records + (inserted - 1 - rank) * thread_count + thread_index
+                                       : options.records - 1 - (rank - inserted) % options.records;
+            }
+            if (type == BenchOp::Scan) {
+                planned.scanLength = scan_length(random);
+            }
+            plan.push_back(planned);
+        }
+    }
+    return plans;
+}
+
+// ========================================
+// Running
+// ========================================
+
+/**
+ * @brief Timed result of one thread: a latency histogram per operation type.
+ */
+struct ThreadResult {
+    std::vector<LatencyHistogram> histograms = std::vector<LatencyHistogram>(static_cast<size_t>(BenchOp::Count));
+    uint64_t readHits = 0;
+    uint64_t reads = 0;
+};
+
+/**
+ * @brief Add one latency to a plain (single-threaded) histogram.
+ */
+void RecordLatency(LatencyHistogram& histogram, uint64_t nanos) {
+    ++histogram.buckets[LatencyHistogram::BucketIndex(nanos)];
+    histogram.sum += nanos;
+    histogram.max = std::max(histogram.max, nanos);
+}
+
+/**
+ * @brief Append one latency summary, in microseconds, as a JSON object.
+ */
+void AppendLatencyJson(std::ostringstream& json, const LatencyHistogram& histogram) {
+    uint64_t count = histogram.count();
+    char fields[256];
+    std::snprintf(fields, sizeof(fields),
+                  "{ \"count\": %llu, \"mean_us\": %.3f, \"p50_us\": %.3f, \"p90_us\": %.3f, \"p99_us\": %.3f, "
+                  "\"p999_us\": %.3f, \"max_us\": %.3f }",
+                  static_cast<unsigned long long>(count),
+                  count == 0 ? 0.0 : static_cast<double>(histogram.sum) / static_cast<double>(count) / 1000.0,
+                  static_cast<double>(histogram.percentile(0.5)) / 1000.0,
+                  static_cast<double>(histogram.percentile(0.9)) / 1000.0,
+                  static_cast<double>(histogram.percentile(0.99)) / 1000.0,
+                  static_cast<double>(histogram.percentile(0.999)) / 1000.0,
+                  static_cast<double>(histogram.max) / 1000.0);
+    json << fields;
+}
+
+/**
+ * @brief How one thread issues operations: straight on a locked store.
+ */
+template <typename StoreType>
+class BenchSession {
+public:
+    explicit BenchSession(StoreType& sessionStore) : target(sessionStore) {}
+    StoreType& store() { return target; }
+
+private:
+    StoreType& target;
+};
+
+/**
+ * @brief How one thread issues operations on a shared-nothing store: through its own client.
+ */
+template <>
+class BenchSession<OwnedShardStore> {
+public:
+    explicit BenchSession(OwnedShardStore& sessionStore) : client(sessionStore.connect()) {}
+    OwnedShardStore::Client& store() { return *client; }
+
+private:
+    std::unique_ptr<OwnedShardStore::Client> client;
+};
+
+/**
+ * @brief Load, plan, and time one workload on a fresh store.
+ * @return std::string The run's JSON object.
+ */
+template <typename StoreType>
+std::string RunWorkload(const BenchOptions& options, const WorkloadMix& mix, size_t thread_count,
+                        size_t shard_count) {
+    // Plan first: it fixes how many keys the run can insert
+    std::vector<std::vector<PlannedOp>> plans = PlanOperations(options, mix, thread_count);
+    size_t key_count = options.records;
+    for (const std::vector<PlannedOp>& plan : plans) {
+        for (const PlannedOp& planned : plan) {
+            key_count = std::max<size_t>(key_count, planned.keyIndex + 1);
+        }
+    }
+    std::vector<std::string> keys(key_count);
+    for (size_t key_index = 0; key_index < key_count; ++key_index) {
+        keys[key_index] = FormatKey(key_index, options.keyBytes);
+    }
+    std::string value(options.valueBytes, 'v');
+
+    StoreOptions store_options;
+    store_options.shardCount = shard_count;
+    store_options.maxKeysPerShard = options.shardCapacity != 0 ? options.shardCapacity
+                                                                : (key_count + key_count / 4) / shard_count + 16;
+    store_options.recencyMode = options.recencyMode;
+    store_options.hashSeed = options.seed;
+    StoreType store(store_options);
+
+    // Load the records in batches, untimed
+    constexpr size_t kLoadBatch = 1024;
+    {
+        BenchSession<StoreType> load_session(store);
+        std::vector<std::pair<std::string, std::string>> load_batch;
+        for (size_t key_index = 0; key_index < options.records; ++key_index) {
+            load_batch.emplace_back(keys[key_index], value);
+            if (load_batch.size() == kLoadBatch || key_index + 1 == options.records) {
+                load_session.store().putMany(load_batch);
+                load_batch.clear();
+            }
+        }
+    }
+
+    std::vector<ThreadResult> results(thread_count);
+    std::atomic<size_t> ready_threads{0};
+    std::atomic<bool> started{false};
+    std::vector<std::thread> threads;
+    for (size_t thread_index = 0; thread_index < thread_count; ++thread_index) {
+        threads.emplace_back([&, thread_index] {
+            const std::vector<PlannedOp>& plan = plans[thread_index];
+            ThreadResult& result = results[thread_index];
+            BenchSession<StoreType> session(store);
+            auto& target = session.store();
+            std::vector<std::string_view> scan_keys;
+            std::vector<ValueHandle> scan_values;
+            scan_keys.reserve(options.maxScanLength);
+
+            ready_threads.fetch_add(1);
+            while (!started.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (const PlannedOp& planned : plan) {
+                const std::string& key = keys[planned.keyIndex];
+                auto op_start = std::chrono::steady_clock::now();
+                switch (planned.type) {
+                    case BenchOp::Read:
+                        ++result.reads;
+                        result.readHits += target.get(key) ? 1 : 0;
+                        break;
+                    case BenchOp::Update:
+                    case BenchOp::Insert:
+                        target.put(key, value);
+                        break;
+                    case BenchOp::Scan:
+                        scan_keys.clear();
+                        for (uint32_t offset = 0; offset < planned.scanLength; ++offset) {
+                            scan_keys.push_back(keys[(planned.keyIndex + offset) % options.records]);
+                        }
+                        target.getMany(scan_keys, scan_values);
+                        break;
+                    case BenchOp::ReadModifyWrite:
+                        target.get(key);
+                        target.put(key, value);
+                        break;
+                    case BenchOp::Count:
+                        break;
+                }
+                auto elapsed = std::chrono::steady_clock::now() - op_start;
+                RecordLatency(result.histograms[static_cast<size_t>(planned.type)],
+                              static_cast<uint64_t>(
+                                  std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+            }
+        });
+    }
+    while (ready_threads.load() < thread_count) {
+        std::this_thread::yield();
+    }
+    auto run_start = std::chrono::steady_clock::now();
+    started.store(true, std::memory_order_release);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - run_start).count();
+
+    // Merge the per-thread histograms
+    std::vector<LatencyHistogram> merged(static_cast<size_t>(BenchOp::Count));
+    uint64_t total_operations = 0;
+    uint64_t reads = 0;
+    uint64_t read_hits = 0;
+    for (const ThreadResult& result : results) {
+        for (size_t op_index = 0; op_index < merged.size(); ++op_index) {
+            const LatencyHistogram& histogram = result.histograms[op_index];
+            for (size_t bucket = 0; bucket < LatencyHistogram::kBucketCount; ++bucket) {
+                merged[op_index].buckets[bucket] += histogram.buckets[bucket];
+            }
+            merged[op_index].sum += histogram.sum;
+            merged[op_index].max = std::max(merged[op_index].max, histogram.max);
+        }
+        reads += result.reads;
+        read_hits += result.readHits;
+    }
+    LatencyHistogram overall;
+    for (const LatencyHistogram& histogram : merged) {
+        total_operations += histogram.count();
+        for (size_t bucket = 0; bucket < LatencyHistogram::kBucketCount; ++bucket) {
+            overall.buckets[bucket] += histogram.buckets[bucket];
+        }
+        overall.sum += histogram.sum;
+        overall.max = std::max(overall.max, histogram.max);
+    }
+
+    std::ostringstream json;
+    char throughput[64];
+    std::snprintf(throughput, sizeof(throughput), "%.6f, \"opsPerSecond\": %.0f", seconds,
+                  seconds > 0 ? static_cast<double>(total_operations) / seconds : 0.0);
+    const char* distribution_names[] = {"default", "uniform", "zipfian", "latest"};
+    json << "{ \"workload\": \"" << mix.name << "\", \"distribution\": \""
+         << distribution_names[static_cast<size_t>(EffectiveDistribution(options, mix))] << "\", \"store\": \""
+         << options.storeType << "\", \"recency\": \""
+         << (options.recencyMode == RecencyMode::Clock ? "clock" : "exact") << "\", \"threads\": " << thread_count
+         << ", \"shards\": " << shard_count << ", \"records\": " << options.records
+         << ", \"keyBytes\": " << options.keyBytes << ", \"valueBytes\": " << options.valueBytes
+         << ", \"latencyTracking\": " << (kLatencyTracking ? "true" : "false")
+         << ", \"operations\": " << total_operations << ", \"seconds\": " << throughput
+         << ", \"readHitRatio\": " << (reads == 0 ? 1.0 : static_cast<double>(read_hits) / static_cast<double>(reads))
+         << ", \"latency\": { \"all\": ";
+    AppendLatencyJson(json, overall);
+    for (size_t op_index = 0; op_index < merged.size(); ++op_index) {
+        if (merged[op_index].count() == 0) {
+            continue;
+        }
+        json << ", \"" << BenchOpName(static_cast<BenchOp>(op_index)) << "\": ";
+        AppendLatencyJson(json, merged[op_index]);
+    }
+    json << " } }";
+    return json.str();
+}
+
+// ========================================
+// Command line
+// ========================================
+
+/**
+ * @brief Print command-line usage.
+ * @param programName argv[0].
+ */
+void PrintUsage(const char* programName) {
+    std::cerr << "Usage: " << programName << " [options]\n"
+              << "  --workload LIST     YCSB workloads to run, e.g. a or a,b,c,f (default a)\n"
+              << "  --distribution D    uniform, zipfian, or latest (default: latest for d, zipfian otherwise)\n"
+              << "  --records N         keys loaded before timing (default 100000)\n"
+              << "  --operations N      timed operations per run, split over threads (default 1000000)\n"
+              << "  --threads LIST      client thread counts, e.g. 1,4,16 (default 1)\n"
+              << "  --shards LIST       shard counts, e.g. 16,64 (default 16)\n"
+              << "  --capacity N        keys per shard (default 0: room for every key)\n"
+              << "  --key-size N        key length in bytes, at least 12 (default 16)\n"
+              << "  --value-size N      value length in bytes (default 100)\n"
+              << "  --scan-length N     longest scan in workload e (default 100)\n"
+              << "  --theta X           zipfian skew (default 0.99)\n"
+              << "  --store TYPE        lru, list, slru, tinylfu, or owned (default lru)\n"
+              << "  --clock             shared-lock reads (RecencyMode::Clock)\n"
+              << "  --seed N            seed for key choice and key hashing (default 1)\n";
+}
+
+/**
+ * @brief Parse a comma-separated list of positive counts.
+ * @return false If an element is not a positive number.
+ */
+bool ParseCountList(const std::string& text, std::vector<size_t>& counts) {
+    counts.clear();
+    std::istringstream list(text);
+    std::string element;
+    while (std::getline(list, element, ',')) {
+        char* end = nullptr;
+        unsigned long long count = std::strtoull(element.c_str(), &end, 10);
+        if (element.empty() || *end != '\0' || count == 0) {
+            return false;
+        }
+        counts.push_back(static_cast<size_t>(count));
+    }
+    return !counts.empty();
+}
+
+/**
+ * @brief Parse command-line arguments.
+ * @param argc Argument count.
+ * @param argv Argument vector.
+ * @param options Output parameter for the parsed options.
+ * @return true If arguments were valid.
+ */
+bool ParseArguments(int argc, char** argv, BenchOptions& options) {
+    for (int index = 1; index < argc; ++index) {
+        std::string argument = argv[index];
+        bool has_value = index + 1 < argc;
+
+        if (argument == "--workload" && has_value) {
+            options.workloads.clear();
+            std::istringstream list(argv[++index]);
+            std::string element;
+            WorkloadMix mix;
+            while (std::getline(list, element, ',')) {
+                if (element.size() != 1 || !LookupWorkload(static_cast<char>(std::tolower(element[0])), mix)) {
+                    return false;
+                }
+                options.workloads.push_back(mix.name);
+            }
+        } else if (argument == "--distribution" && has_value) {
+            std::string distribution = argv[++index];
+            if (distribution == "uniform") {
+                options.distribution = KeyDistribution::Uniform;
+            } else if (distribution == "zipfian") {
+                options.distribution = KeyDistribution::Zipfian;
+            } else if (distribution == "latest") {
+                options.distribution = KeyDistribution::Latest;
+            } else {
+                return false;
+            }
+        } else if (argument == "--records" && has_value) {
+            options.records = std::strtoul(argv[++index], nullptr, 10);
+        } else if (argument == "--operations" && has_value) {
+            options.operations = std::strtoul(argv[++index], nullptr, 10);
+        } else if (argument == "--threads" && has_value) {
+            if (!ParseCountList(argv[++index], options.threadCounts)) return false;
+        } else if (argument == "--shards" && has_value) {
+            if (!ParseCountList(argv[++index], options.shardCounts)) return false;
+        } else if (argument == "--capacity" && has_value) {
+            options.shardCapacity = std::strtoul(argv[++index], nullptr, 10);
+        } else if (argument == "--key-size" && has_value) {
+            options.keyBytes = std::strtoul(argv[++index], nullptr, 10);
+        } else if (argument == "--value-size" && has_value) {
+            options.valueBytes = std::strtoul(argv[++index], nullptr, 10);
+        } else if (argument == "--scan-length" && has_value) {
+            options.maxScanLength = std::strtoul(argv[++index], nullptr, 10);
+        } else if (argument == "--theta" && has_value) {
+            options.zipfTheta = std::strtod(argv[++index], nullptr);
+        } else if (argument == "--store" && has_value) {
+            options.storeType = argv[++index];
+        } else if (argument == "--clock") {
+            options.recencyMode = RecencyMode::Clock;
+        } else if (argument == "--seed" && has_value) {
+            options.seed = std::strtoull(argv[++index], nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    bool known_store = options.storeType == "lru" || options.storeType == "list" || options.storeType == "slru" ||
+                       options.storeType == "tinylfu" || options.storeType == "owned";
+    return known_store && options.records > 1 && options.operations > 0 && options.keyBytes >= 12 &&
+           options.maxScanLength > 0 && options.zipfTheta > 0 && options.zipfTheta < 1;
+}
+
+/**
+ * @brief Run one workload on the selected store type.
+ */
+std::string RunSelectedStore(const BenchOptions& options, const WorkloadMix& mix, size_t thread_count,
+                             size_t shard_count) {
+    if (options.storeType == "list") {
+        return RunWorkload<ListStore>(options, mix, thread_count, shard_count);
+    }
+    if (options.storeType == "slru") {
+        return RunWorkload<SlruStore>(options, mix, thread_count, shard_count);
+    }
+    if (options.storeType == "tinylfu") {
+        return RunWorkload<TinyLfuStore>(options, mix, thread_count, shard_count);
+    }
+    if (options.storeType == "owned") {
+        return RunWorkload<OwnedShardStore>(options, mix, thread_count, shard_count);
+    }
+    return RunWorkload<Store>(options, mix, thread_count, shard_count);
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!ParseArguments(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    // Every combination is one JSON object; progress goes to stderr so stdout stays parseable
+    std::cout << "[\n";
+    bool first_run = true;
+    for (char workload : options.workloads) {
+        WorkloadMix mix;
+        LookupWorkload(workload, mix);
+        for (size_t shard_count : options.shardCounts) {
+            for (size_t thread_count : options.threadCounts) {
+                std::cerr << "workload " << workload << ", " << shard_count << " shards, " << thread_count
+                          << " threads..." << std::endl;
+                std::cout << (first_run ? "  " : ",\n  ") << RunSelectedStore(options, mix, thread_count, shard_count);
+                first_run = false;
+            }
+        }
+    }
+    std::cout << "\n]" << std::endl;
+    return 0;
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Hierarchical timing wheel of expiry deadlines for one shard.
+ * @tparam EntryRef How the shard table names an entry (see ShardTable::ExpiryRef).
+ *
+ * Six levels of 64 buckets cover 2^36 one-millisecond ticks (about two
+ * years); later deadlines wait in an overflow bucket. A level-l bucket holds
+ * deadlines that agree with the current tick on every base-64 digit above l,
+ * and its index is digit l of the deadline. Each bucket is therefore visited
+ * once, when the wheel reaches it: higher levels are cascaded into finer ones
+ * and level 0 buckets are handed to the caller as due. A record moves at most
+ * once per level, and occupancy bitmaps let advance() jump straight to the
+ * next non-empty bucket instead of stepping through idle ticks.
+ *
+ * Records are never removed early. When a key is deleted or its TTL changes
+ * the old record stays where it is, and the caller discards it once it comes
+ * due because the entry no longer carries that deadline.
+ *
+ * Not thread-safe; the owning shard's exclusive lock must be held.
+ */
+template <typename EntryRef>
+class TimingWheel {
+public:
+    /**
+     * @brief One scheduled deadline.
+     */
+    struct Record {
+        EntryRef entry;     ///< Entry the deadline was scheduled for
+        uint64_t expiresAt; ///< Deadline in milliseconds
+    };
+
+    /**
+     * @brief Construct an empty wheel.
+     * @param startTick Current time in milliseconds; deadlines are placed relative to it.
+     */
+    explicit TimingWheel(uint64_t startTick) : currentTick(startTick) {}
+
+    /**
+     * @brief Whether no records are pending (stale ones included).
+     */
+    bool empty() const { return recordCount == 0; }
+
+    /**
+     * @brief Number of pending records, stale ones included.
+     */
+    size_t size() const { return recordCount; }
+
+    /**
+     * @brief Schedule a deadline for an entry.
+     * @param entry Entry reference that the due callback will receive.
+     * @param expiresAt Deadline in milliseconds; past deadlines come due on the next advance.
+     */
+    void schedule(EntryRef entry, uint64_t expiresAt) {
+        place(Record{std::move(entry), expiresAt});
+        ++recordCount;
+    }
+
+    /**
+     * @brief Process buckets that have come due, doing at most budget units of work.
+     * @param now Current time in milliseconds.
+     * @param budget Maximum number of records to cascade or hand to onDue; the rare
+     *               overflow bucket is always re-placed as a whole.
+     * @param onDue Called as onDue(const Record&) for every record in a due level-0 bucket.
+     * @return size_t Work units used.
+     *
+     * Unfinished buckets keep their remaining records, so a later call picks
+     * up exactly where this one stopped.
+     */
+    template <typename OnDue>
+    size_t advance(uint64_t now, size_t budget, OnDue&& onDue) {
+        size_t work_done = 0;
+
+        while (work_done < budget && recordCount > 0) {
+            size_t level = 0;
+            uint64_t event_tick = nextEventTick(level);
+            if (event_tick > now) {
+                break;
+            }
+            // A partly cascaded bucket can report a start tick behind an already processed tick
+            if (event_tick > currentTick) {
+                currentTick = event_tick;
+            }
+
+            // The top level wrapped; overflow records that are still too far out land back
+            // in overflow, so re-place the whole bucket from a detached copy in one go
+            if (level == kLevelCount) {
+                std::vector<Record> waiting;
+                waiting.swap(overflow);
+                for (Record& record : waiting) {
+                    place(std::move(record));
+                }
+                work_done += waiting.size();
+                continue;
+            }
+
+            size_t bucket_index = digitAt(event_tick, level);
+            std::vector<Record>& bucket = levels[level][bucket_index];
+
+            while (!bucket.empty() && work_done < budget) {
+                Record record = std::move(bucket.back());
+                bucket.pop_back();
+                ++work_done;
+
+                if (level == 0) {
+                    --recordCount;
+                    onDue(record);
+                } else {
+                    // Cascade towards level 0 relative to the bucket's start tick
+                    place(std::move(record));
+                }
+            }
+
+            if (bucket.empty()) {
+                occupied[level] &= ~(uint64_t{1} << bucket_index);
+            }
+        }
+
+        return work_done;
+    }
+
+    /**
+     * @brief Drop every pending record.
+     * @param startTick Current time in milliseconds.
+     */
+    void clear(uint64_t startTick) {
+        for (auto& level_buckets : levels) {
+            for (auto& bucket : level_buckets) {
+                bucket.clear();
+            }
+        }
+        overflow.clear();
+        occupied.fill(0);
+        currentTick = startTick;
+        recordCount = 0;
+    }
+
+private:
+    static constexpr size_t kLevelBits = 6;                        ///< log2 of buckets per level
+    static constexpr size_t kBucketsPerLevel = size_t{1} << kLevelBits;
+    static constexpr size_t kLevelCount = 6;                       ///< Levels before the overflow bucket
+
+    using Level = std::array<std::vector<Record>, kBucketsPerLevel>;
+
+    std::array<Level, kLevelCount> levels;            ///< Buckets per level; level 0 is one tick wide
+    std::array<uint64_t, kLevelCount> occupied{};     ///< Bit b set when levels[l][b] is non-empty
+    std::vector<Record> overflow;                     ///< Deadlines beyond the top level
+    uint64_t currentTick = 0;                         ///< Earliest tick that may still hold due records
+    size_t recordCount = 0;                           ///< Records in all buckets
+
+    static size_t digitAt(uint64_t tick, size_t level) {
+        return static_cast<size_t>(tick >> (kLevelBits * level)) & (kBucketsPerLevel - 1);
+    }
+
+    /**
+     * @brief Put a record in the bucket matching its deadline relative to currentTick.
+     */
+    void place(Record record) {
+        uint64_t tick = record.expiresAt > currentTick ? record.expiresAt : currentTick;
+
+        // The highest base-64 digit that differs from the current tick picks the level
+        uint64_t differing_bits = tick ^ currentTick;
+        size_t level = 0;
+        while (level < kLevelCount && (differing_bits >> (kLevelBits * (level + 1))) != 0) {
+            ++level;
+        }
+
+        if (level == kLevelCount) {
+            overflow.push_back(std::move(record));
+            return;
+        }
+
+        size_t bucket_index = digitAt(tick, level);
+        levels[level][bucket_index].push_back(std::move(record));
+        occupied[level] |= uint64_t{1} << bucket_index;
+    }
+
+    /**
+     * @brief Tick at which the next non-empty bucket must be handled.
+     * @param level Output; level of that bucket, or kLevelCount for the overflow bucket.
+     *
+     * Every bucket at a level starts after all buckets of the levels below it,
+     * so the lowest level with an occupied bucket at or after the current
+     * digit holds the next event.
+     */
+    uint64_t nextEventTick(size_t& level) const {
+        for (level = 0; level < kLevelCount; ++level) {
+            uint64_t pending = occupied[level] & (~uint64_t{0} << digitAt(currentTick, level));
+            if (pending != 0) {
+                size_t level_shift = kLevelBits * level;
+                uint64_t block_start = (currentTick >> (level_shift + kLevelBits)) << (level_shift + kLevelBits);
+                return block_start | (static_cast<uint64_t>(__builtin_ctzll(pending)) << level_shift);
+            }
+        }
+
+        // Only overflow records remain; they are re-placed when the top level wraps
+        size_t top_shift = kLevelBits * kLevelCount;
+        return ((currentTick >> top_shift) + 1) << top_shift;
+    }
+};
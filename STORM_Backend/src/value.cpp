@@ -0,0 +1,55 @@
+#include "value.h"
+#include <cstring>
+#include <new>
+
+namespace {
+
+/**
+ * @brief Block whose bytes follow it in the same allocation.
+ */
+void DestroyInlineBlock(ValueBlock* block) {
+    block->~ValueBlock();
+    ::operator delete(block);
+}
+
+/**
+ * @brief Block that owns a std::string adopted from the caller.
+ */
+struct AdoptedValueBlock : ValueBlock {
+    std::string owned;
+};
+
+void DestroyAdoptedBlock(ValueBlock* block) {
+    delete static_cast<AdoptedValueBlock*>(block);
+}
+
+} // namespace
+
+ValueBlock* ValueHandle::allocateInline(size_t size, char*& bytes) {
+    void* storage = ::operator new(sizeof(ValueBlock) + size);
+    ValueBlock* block = new (storage) ValueBlock();
+
+    bytes = static_cast<char*>(storage) + sizeof(ValueBlock);
+    block->size = size;
+    block->bytes = bytes;
+    block->destroy = DestroyInlineBlock;
+    return block;
+}
+
+ValueHandle ValueHandle::copyOf(std::string_view bytes) {
+    char* inline_bytes = nullptr;
+    ValueBlock* block = allocateInline(bytes.size(), inline_bytes);
+    if (!bytes.empty()) {
+        std::memcpy(inline_bytes, bytes.data(), bytes.size());
+    }
+    return ValueHandle(block);
+}
+
+ValueHandle ValueHandle::adopt(std::string&& bytes) {
+    auto* block = new AdoptedValueBlock();
+    block->owned = std::move(bytes);
+    block->size = block->owned.size();
+    block->bytes = block->owned.data();
+    block->destroy = DestroyAdoptedBlock;
+    return ValueHandle(block);
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/**
+ * @brief Reference-counted storage block behind a ValueHandle.
+ *
+ * The bytes either follow the block in the same allocation or live in a
+ * std::string adopted from the caller. Blocks are immutable once published.
+ */
+struct ValueBlock {
+    std::atomic<uint32_t> referenceCount{1};   ///< Handles sharing this block
+    uint32_t decompressedSize = 0;             ///< Length before compression; 0 = bytes stored verbatim
+    size_t size = 0;                           ///< Number of value bytes
+    const char* bytes = nullptr;               ///< First value byte
+    void (*destroy)(ValueBlock* block) = nullptr; ///< Frees the block when the last handle drops
+};
+
+/**
+ * @brief Shared, immutable handle to a stored value.
+ *
+ * Copying a handle only bumps a reference count, so readers can take a value
+ * out of a shard while holding the lock for just the lookup, then read or
+ * send the bytes after releasing it. A handle stays valid after the key is
+ * overwritten, deleted, or evicted.
+ */
+class ValueHandle {
+public:
+    /**
+     * @brief Empty handle; represents "no value".
+     */
+    ValueHandle() noexcept = default;
+
+    ValueHandle(const ValueHandle& other) noexcept : block(other.block) {
+        if (block != nullptr) {
+            block->referenceCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    ValueHandle(ValueHandle&& other) noexcept : block(other.block) {
+        other.block = nullptr;
+    }
+
+    ValueHandle& operator=(ValueHandle other) noexcept {
+        std::swap(block, other.block);
+        return *this;
+    }
+
+    ~ValueHandle() { reset(); }
+
+    /**
+     * @brief Create a value holding a copy of bytes (one allocation).
+     * @param bytes Value contents.
+     * @return ValueHandle Handle owning the new copy.
+     */
+    static ValueHandle copyOf(std::string_view bytes);
+
+    /**
+     * @brief Create a value that takes ownership of an existing string without copying it.
+     * @param bytes String to adopt; left empty.
+     * @return ValueHandle Handle owning the string's buffer.
+     */
+    static ValueHandle adopt(std::string&& bytes);
+
+    /**
+     * @brief Create a value whose bytes a callback writes before the handle is shared (one allocation).
+     * @param size Value length in bytes.
+     * @param fill Called once with a pointer to the size uninitialised bytes.
+     * @return ValueHandle Handle owning the new bytes.
+     */
+    template <typename Fill>
+    static ValueHandle build(size_t size, Fill&& fill) {
+        char* bytes = nullptr;
+        ValueBlock* new_block = allocateInline(size, bytes);
+        fill(bytes);
+        return ValueHandle(new_block);
+    }
+
+    /**
+     * @brief Drop this handle's reference.
+     */
+    void reset() noexcept {
+        if (block != nullptr && block->referenceCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            block->destroy(block);
+        }
+        block = nullptr;
+    }
+
+    const char* data() const noexcept { return block != nullptr ? block->bytes : ""; }
+    size_t size() const noexcept { return block != nullptr ? block->size : 0; }
+    std::string_view view() const noexcept { return std::string_view(data(), size()); }
+    std::string str() const { return std::string(data(), size()); }
+
+    /**
+     * @brief Whether the handle refers to a value.
+     */
+    explicit operator bool() const noexcept { return block != nullptr; }
+
+    /**
+     * @brief Whether the bytes are an LZ4 block that decompresses to decompressedSize() bytes.
+     */
+    bool compressed() const noexcept { return block != nullptr && block->decompressedSize != 0; }
+
+    /**
+     * @brief Length of the value once decompressed; size() for uncompressed values.
+     */
+    size_t decompressedSize() const noexcept { return compressed() ? block->decompressedSize : size(); }
+
+private:
+    friend class SlabAllocator;
+
+    explicit ValueHandle(ValueBlock* valueBlock) noexcept : block(valueBlock) {}
+
+    /**
+     * @brief Allocate a block with room for size bytes right after it.
+     * @param size Value length in bytes.
+     * @param bytes Output: the block's (writable) bytes.
+     */
+    static ValueBlock* allocateInline(size_t size, char*& bytes);
+
+    ValueBlock* block = nullptr; ///< Shared block, or nullptr for an empty handle
+};
@@ -0,0 +1,133 @@
+#include "worker_pool.h"
+#include <algorithm>
+
+// ========================================
+// Lifecycle
+// ========================================
+
+WorkerPool::WorkerPool(size_t workerCount) {
+    if (workerCount == 0) {
+        size_t core_count = std::max<size_t>(1, std::thread::hardware_concurrency());
+        workerCount = std::max<size_t>(1, core_count - 1);
+    }
+
+    workers.reserve(workerCount);
+    for (size_t worker_index = 0; worker_index < workerCount; ++worker_index) {
+        workers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> pool_lock_guard(poolLock);
+        stopping = true;
+    }
+    jobAvailable.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+// ========================================
+// Job execution
+// ========================================
+
+/**
+ * @brief Run a job's tasks on the pool and the calling thread, then wait for stragglers.
+ * @param taskCount Number of tasks.
+ * @param task Callable invoked once per task index.
+ */
+void WorkerPool::parallelFor(size_t taskCount, const std::function<void(size_t)>& task) {
+    if (taskCount == 0) {
+        return;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->task = &task;
+    job->taskCount = taskCount;
+
+    {
+        std::lock_guard<std::mutex> pool_lock_guard(poolLock);
+        jobs.push_back(job);
+    }
+    jobAvailable.notify_all();
+
+    // The caller works on its own job instead of blocking straight away
+    runTasks(*job);
+
+    std::unique_lock<std::mutex> pool_lock_guard(poolLock);
+
+    // Every task is claimed by now; drop the job so workers stop picking it up
+    auto queued_job = std::find(jobs.begin(), jobs.end(), job);
+    if (queued_job != jobs.end()) {
+        jobs.erase(queued_job);
+    }
+
+    jobFinished.wait(pool_lock_guard, [&] {
+        return job->finishedTasks.load(std::memory_order_acquire) == taskCount;
+    });
+}
+
+/**
+ * @brief Queue a one-task job that the workers retire when it is done.
+ * @param task Callable to run once.
+ */
+void WorkerPool::post(std::function<void()> task) {
+    auto job = std::make_shared<Job>();
+    job->ownedTask = [posted_task = std::move(task)](size_t) { posted_task(); };
+    job->task = &job->ownedTask;
+    job->taskCount = 1;
+
+    {
+        std::lock_guard<std::mutex> pool_lock_guard(poolLock);
+        jobs.push_back(std::move(job));
+    }
+    jobAvailable.notify_one();
+}
+
+/**
+ * @brief Claim and run tasks from a job until none are left to claim.
+ * @param job Job to work on.
+ */
+void WorkerPool::runTasks(Job& job) {
+    while (true) {
+        size_t task_index = job.nextTask.fetch_add(1, std::memory_order_relaxed);
+        if (task_index >= job.taskCount) {
+            return;
+        }
+
+        (*job.task)(task_index);
+
+        // The last task to finish wakes the caller; notifying under the lock avoids a lost wakeup
+        if (job.finishedTasks.fetch_add(1, std::memory_order_acq_rel) + 1 == job.taskCount) {
+            std::lock_guard<std::mutex> pool_lock_guard(poolLock);
+            jobFinished.notify_all();
+        }
+    }
+}
+
+/**
+ * @brief Worker thread body: help with the oldest queued job until the pool stops.
+ */
+void WorkerPool::workerLoop() {
+    while (true) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> pool_lock_guard(poolLock);
+            jobAvailable.wait(pool_lock_guard, [this] { return stopping || !jobs.empty(); });
+            if (jobs.empty()) {
+                return; // stopping and nothing left to help with
+            }
+            job = jobs.front();
+        }
+
+        runTasks(*job);
+
+        // Nothing left to claim; retire the job if its caller has not already
+        std::lock_guard<std::mutex> pool_lock_guard(poolLock);
+        if (!jobs.empty() && jobs.front() == job) {
+            jobs.pop_front();
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed-size thread pool for fanning batch work out across shards.
+ *
+ * parallelFor splits a job into independent tasks numbered 0..taskCount-1.
+ * Workers and the calling thread claim tasks from a shared atomic counter, so
+ * the caller never sits idle while its job is pending and several callers
+ * can share one pool. post queues a single task that nobody waits for.
+ * Tasks must not throw.
+ */
+class WorkerPool {
+public:
+    /**
+     * @brief Start the worker threads.
+     * @param workerCount Number of background threads; 0 = one per core minus the caller.
+     */
+    explicit WorkerPool(size_t workerCount = 0);
+
+    /**
+     * @brief Stop and join every worker; pending jobs are finished first.
+     */
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * @brief Run task(0) .. task(taskCount - 1) concurrently and wait for all of them.
+     * @param taskCount Number of tasks in the job.
+     * @param task Callable invoked once per task index, possibly from several threads at once.
+     */
+    void parallelFor(size_t taskCount, const std::function<void(size_t)>& task);
+
+    /**
+     * @brief Run a task on a worker thread without waiting for it.
+     * @param task Callable to invoke once; the pool keeps it until it has run.
+     */
+    void post(std::function<void()> task);
+
+    /**
+     * @brief Number of background threads (the caller adds one more during parallelFor).
+     */
+    size_t workerCount() const { return workers.size(); }
+
+private:
+    /**
+     * @brief One parallelFor call; shared by every thread working on it.
+     */
+    struct Job {
+        const std::function<void(size_t)>* task = nullptr; ///< Caller's callable; outlives the job's tasks
+        std::function<void(size_t)> ownedTask;             ///< Callable of a posted job, which has no waiting caller
+        size_t taskCount = 0;                              ///< Total tasks
+        std::atomic<size_t> nextTask{0};                   ///< Next unclaimed task index
+        std::atomic<size_t> finishedTasks{0};              ///< Tasks that have completed
+    };
+
+    std::vector<std::thread> workers;         ///< Background threads
+    std::deque<std::shared_ptr<Job>> jobs;    ///< Jobs with tasks still to claim, oldest first
+    std::mutex poolLock;                      ///< Guards jobs and stopping
+    std::condition_variable jobAvailable;     ///< Signalled when a job is queued or the pool stops
+    std::condition_variable jobFinished;      ///< Signalled when a job's last task completes
+    bool stopping = false;                    ///< Set by the destructor
+
+    void workerLoop();
+
+    /**
+     * @brief Claim and run tasks from a job until none are left to claim.
+     * @param job Job to work on.
+     */
+    void runTasks(Job& job);
+};
@@ -0,0 +1,612 @@
+#include "net_server.h"
+#include "replication.h"
+#include "resp.h"
+#include "store.h"
+#include <algorithm>
+#include <chrono>
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+#include <thread>
+
+/**
+ * ==============================
+ * Test helpers
+ * ==============================
+ */
+
+/**
+ * @brief Open a blocking TCP connection to the local server.
+ * @param port Server port.
+ * @return int Connected socket, or -1 on failure.
+ */
+static int ConnectToServer(uint16_t port) {
+    int socketFd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+    if (connect(socketFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        close(socketFd);
+        return -1;
+    }
+    return socketFd;
+}
+
+/**
+ * @brief Send a request buffer and read until the expected number of reply lines arrive.
+ * @param socketFd Connected socket.
+ * @param request Bytes to send (may contain several pipelined commands).
+ * @param expectedLines Number of newline-terminated reply lines to wait for.
+ * @return std::string Raw reply bytes.
+ */
+static std::string RoundTrip(int socketFd, const std::string& request, size_t expectedLines) {
+    send(socketFd, request.data(), request.size(), 0);
+
+    std::string reply;
+    char buffer[4096];
+    while (static_cast<size_t>(std::count(reply.begin(), reply.end(), '\n')) < expectedLines) {
+        ssize_t readCount = recv(socketFd, buffer, sizeof(buffer), 0);
+        if (readCount <= 0) break;
+        reply.append(buffer, static_cast<size_t>(readCount));
+    }
+    return reply;
+}
+
+/**
+ * ==============================
+ * Text protocol over TCP
+ * ==============================
+ */
+
+/**
+ * @brief Tests that pipelined line-protocol commands are answered in order.
+ */
+TEST(NetServerTest, PipelinedTextCommands) {
+    Store testStore(100, 4);
+    NetServerConfig config;
+    config.bindAddress = "127.0.0.1";
+    config.port = 0;
+    config.loopCount = 2;
+
+    NetServer testServer(testStore, config);
+    testServer.start();
+    ASSERT_NE(testServer.port(), 0);
+
+    int clientFd = ConnectToServer(testServer.port());
+    ASSERT_GE(clientFd, 0);
+
+    std::string reply = RoundTrip(clientFd, "PUT foo bar\r\nGET foo\nDEL foo\nGET foo\n", 4);
+    EXPECT_EQ(reply,
+              "{ \"success\": true }\n"
+              "{ \"success\": true, \"value\": \"bar\" }\n"
+              "{ \"success\": true }\n"
+              "{ \"success\": false, \"error\": \"Key not found\" }\n");
+
+    // Writes through the network are visible to in-process readers
+    RoundTrip(clientFd, "PUT shared value\n", 1);
+    std::string retrievedValue;
+    EXPECT_TRUE(testStore.get("shared", retrievedValue));
+    EXPECT_EQ(retrievedValue, "value");
+
+    close(clientFd);
+    testServer.stop();
+}
+
+/**
+ * @brief Tests that a command split across several writes is reassembled.
+ */
+TEST(NetServerTest, PartialReadsAndExit) {
+    Store testStore(100, 4);
+    NetServerConfig config;
+    config.bindAddress = "127.0.0.1";
+    config.port = 0;
+    config.loopCount = 1;
+
+    NetServer testServer(testStore, config);
+    testServer.start();
+
+    int clientFd = ConnectToServer(testServer.port());
+    ASSERT_GE(clientFd, 0);
+
+    send(clientFd, "PUT ke", 6, 0);
+    usleep(20000);
+    std::string reply = RoundTrip(clientFd, "y val\nGET key\n", 2);
+    EXPECT_EQ(reply,
+              "{ \"success\": true }\n"
+              "{ \"success\": true, \"value\": \"val\" }\n");
+
+    // EXIT closes the connection from the server side
+    send(clientFd, "EXIT\n", 5, 0);
+    char buffer[16];
+    EXPECT_EQ(recv(clientFd, buffer, sizeof(buffer), 0), 0);
+
+    close(clientFd);
+}
+
+/**
+ * @brief Tests that an HTTP GET /metrics on the command port returns Prometheus text and closes.
+ */
+TEST(NetServerTest, MetricsEndpoint) {
+    Store testStore(100, 4);
+    testStore.put("counted", "value");
+    testStore.get("counted");
+    NetServerConfig config;
+    config.bindAddress = "127.0.0.1";
+    config.port = 0;
+    config.loopCount = 1;
+
+    NetServer testServer(testStore, config);
+    testServer.start();
+
+    int clientFd = ConnectToServer(testServer.port());
+    ASSERT_GE(clientFd, 0);
+    std::string request = "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    send(clientFd, request.data(), request.size(), 0);
+
+    // The server closes after one response, so read to end of stream
+    std::string reply;
+    char buffer[4096];
+    ssize_t readCount;
+    while ((readCount = recv(clientFd, buffer, sizeof(buffer), 0)) > 0) {
+        reply.append(buffer, static_cast<size_t>(readCount));
+    }
+    EXPECT_EQ(reply.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_NE(reply.find("storm_hits_total 1\n"), std::string::npos);
+    EXPECT_NE(reply.find("storm_keys 1\n"), std::string::npos);
+    close(clientFd);
+
+    clientFd = ConnectToServer(testServer.port());
+    ASSERT_GE(clientFd, 0);
+    request = "GET /other HTTP/1.1\r\n\r\n";
+    send(clientFd, request.data(), request.size(), 0);
+    reply.clear();
+    while ((readCount = recv(clientFd, buffer, sizeof(buffer), 0)) > 0) {
+        reply.append(buffer, static_cast<size_t>(readCount));
+    }
+    EXPECT_EQ(reply.rfind("HTTP/1.1 404", 0), 0u);
+    close(clientFd);
+    testServer.stop();
+}
+
+/**
+ * @brief Tests that batch mode groups PUT runs, keeps replies in input order, and resumes split lines.
+ */
+TEST(BatchProcessorTest, GroupsPutRunsInOrder) {
+    StoreOptions storeOptions;
+    storeOptions.maxKeysPerShard = 100;
+    storeOptions.shardCount = 4;
+    storeOptions.maxValueBytes = 8;
+    Store testStore(storeOptions);
+    BatchProcessor batchProcessor(testStore, {}, 3);
+
+    std::string input = "PUT a 1\nPUT b 2\r\nPUT c 3\nPUT d 4\nGET b\nPUT e\n"
+                        "PUT f 6\nPUT g waytoolarge\nHISTORY\nEXIT\nPUT h 8\n";
+    std::string reply;
+    size_t consumed = 0;
+
+    // A block ending mid-line executes only its complete lines
+    size_t splitAt = input.find("GET b") + 3;
+    EXPECT_EQ(batchProcessor.execute(std::string_view(input).substr(0, splitAt), false, consumed, reply),
+              CommandProcessor::Status::Continue);
+    EXPECT_EQ(consumed, input.find("GET b"));
+    EXPECT_EQ(batchProcessor.execute(std::string_view(input).substr(consumed), true, consumed, reply),
+              CommandProcessor::Status::Exit);
+
+    EXPECT_EQ(reply, "{ \"success\": true, \"stored\": 3 }\n"
+                     "{ \"success\": true, \"stored\": 1 }\n"
+                     "{ \"success\": true, \"value\": \"2\" }\n"
+                     "{ \"success\": false, \"error\": \"PUT requires key and value\" }\n"
+                     "{ \"success\": false, \"stored\": 1, \"rejected\": 1, \"error\": \"Value too large\" }\n"
+                     "{ \"history\": [\n] }\n");
+    EXPECT_EQ(testStore.stats().keys, 5u);
+    EXPECT_FALSE(testStore.get("h"));
+
+    // A read-only session refuses PUTs one line at a time
+    SessionOptions replicaSession;
+    replicaSession.readOnly = true;
+    BatchProcessor replicaProcessor(testStore, replicaSession);
+    reply.clear();
+    replicaProcessor.execute("PUT x 1\nPUT y 2", true, consumed, reply);
+    EXPECT_EQ(reply, "{ \"success\": false, \"error\": \"Read-only replica\" }\n"
+                     "{ \"success\": false, \"error\": \"Read-only replica\" }\n");
+    EXPECT_EQ(consumed, 15u);
+}
+
+/**
+ * ==============================
+ * RESP protocol
+ * ==============================
+ */
+
+/**
+ * @brief Tests that the parser hands out views and waits for incomplete requests.
+ */
+TEST(RespParserTest, ParsesMultibulkAndInlineRequests) {
+    std::vector<std::string_view> arguments;
+    size_t consumed = 0;
+
+    const std::string request = "*3\r\n$3\r\nSET\r\n$3\r\nfoo\r\n$5\r\nb r\r\n\r\n*1\r\n$4\r\nPING\r\n";
+    ASSERT_EQ(ParseRespRequest(request.data(), request.size(), arguments, consumed), RespParseStatus::Complete);
+    ASSERT_EQ(arguments.size(), 3u);
+    EXPECT_EQ(arguments[0], "SET");
+    EXPECT_EQ(arguments[1], "foo");
+    EXPECT_EQ(arguments[2], "b r\r\n");
+    EXPECT_EQ(arguments[2].data(), request.data() + 26); // Zero-copy view into the buffer
+    EXPECT_EQ(consumed, 33u);
+
+    // Every strict prefix of a request is incomplete
+    for (size_t prefixLength = 0; prefixLength < consumed; ++prefixLength) {
+        EXPECT_EQ(ParseRespRequest(request.data(), prefixLength, arguments, consumed), RespParseStatus::Incomplete);
+    }
+
+    const std::string inlineRequest = "GET  foo\r\n";
+    ASSERT_EQ(ParseRespRequest(inlineRequest.data(), inlineRequest.size(), arguments, consumed),
+              RespParseStatus::Complete);
+    ASSERT_EQ(arguments.size(), 2u);
+    EXPECT_EQ(arguments[1], "foo");
+
+    const std::string badRequest = "*1\r\n+PING\r\n";
+    EXPECT_EQ(ParseRespRequest(badRequest.data(), badRequest.size(), arguments, consumed), RespParseStatus::Error);
+}
+
+/**
+ * @brief Tests the Redis command mapping over a RESP connection.
+ */
+TEST(NetServerTest, RespCommands) {
+    Store testStore(100, 4);
+    NetServerConfig config;
+    config.bindAddress = "127.0.0.1";
+    config.port = 0;
+    config.loopCount = 1;
+
+    NetServer testServer(testStore, config);
+    testServer.start();
+
+    int clientFd = ConnectToServer(testServer.port());
+    ASSERT_GE(clientFd, 0);
+
+    std::string reply = RoundTrip(clientFd,
+        "*3\r\n$3\r\nSET\r\n$1\r\na\r\n$1\r\n1\r\n"
+        "*5\r\n$4\r\nMSET\r\n$1\r\nb\r\n$1\r\n2\r\n$1\r\nc\r\n$1\r\n3\r\n"
+        "*2\r\n$3\r\nget\r\n$1\r\na\r\n"
+        "*4\r\n$4\r\nMGET\r\n$1\r\nb\r\n$1\r\nx\r\n$1\r\nc\r\n"
+        "*3\r\n$6\r\nEXISTS\r\n$1\r\na\r\n$1\r\nx\r\n"
+        "*3\r\n$3\r\nDEL\r\n$1\r\na\r\n$1\r\nx\r\n"
+        "*2\r\n$3\r\nGET\r\n$1\r\na\r\n",
+        13);
+    EXPECT_EQ(reply,
+              "+OK\r\n"
+              "+OK\r\n"
+              "$1\r\n1\r\n"
+              "*3\r\n$1\r\n2\r\n$-1\r\n$1\r\n3\r\n"
+              ":1\r\n"
+              ":1\r\n"
+              "$-1\r\n");
+
+    // RESP3 switches the null encoding
+    reply = RoundTrip(clientFd, "*2\r\n$5\r\nHELLO\r\n$1\r\n3\r\n*2\r\n$3\r\nGET\r\n$1\r\na\r\n", 14);
+    EXPECT_EQ(reply.rfind("%6\r\n", 0), 0u);
+    EXPECT_NE(reply.find(":3\r\n"), std::string::npos);
+    EXPECT_EQ(reply.substr(reply.size() - 3), "_\r\n");
+
+    close(clientFd);
+}
+
+/**
+ * @brief Tests that a RESP request too large for the input buffer fails and closes instead of hanging.
+ */
+TEST(NetServerTest, OversizedRespRequestsCloseTheConnection) {
+    Store testStore(100, 4);
+    NetServerConfig config;
+    config.bindAddress = "127.0.0.1";
+    config.port = 0;
+    config.loopCount = 1;
+
+    NetServer testServer(testStore, config);
+    testServer.start();
+
+    timeval receiveTimeout{10, 0};
+    auto readToEnd = [&](int socketFd, std::string& reply) {
+        setsockopt(socketFd, SOL_SOCKET, SO_RCVTIMEO, &receiveTimeout, sizeof(receiveTimeout));
+        char buffer[4096];
+        ssize_t readCount;
+        while ((readCount = recv(socketFd, buffer, sizeof(buffer), 0)) > 0) {
+            reply.append(buffer, static_cast<size_t>(readCount));
+        }
+        return readCount == 0 || errno != EAGAIN;
+    };
+
+    // One argument over the bulk limit is refused as soon as its header arrives
+    int clientFd = ConnectToServer(testServer.port());
+    ASSERT_GE(clientFd, 0);
+    std::string request = "*3\r\n$3\r\nSET\r\n$1\r\nk\r\n$" + std::to_string(70 * 1024 * 1024) + "\r\n";
+    send(clientFd, request.data(), request.size(), 0);
+    std::string reply;
+    EXPECT_TRUE(readToEnd(clientFd, reply));
+    EXPECT_EQ(reply, "-ERR Protocol error\r\n");
+    close(clientFd);
+
+    // Arguments each within the limit but together over the input buffer close the connection too
+    clientFd = ConnectToServer(testServer.port());
+    ASSERT_GE(clientFd, 0);
+    std::string argument(30 * 1024 * 1024, 'x');
+    std::thread senderThread([&] {
+        std::string header = "*4\r\n$4\r\nMSET\r\n$1\r\nk\r\n";
+        send(clientFd, header.data(), header.size(), MSG_NOSIGNAL);
+        for (int part = 0; part < 3; ++part) {
+            std::string bulkHeader = "$" + std::to_string(argument.size()) + "\r\n";
+            if (send(clientFd, bulkHeader.data(), bulkHeader.size(), MSG_NOSIGNAL) < 0 ||
+                send(clientFd, argument.data(), argument.size(), MSG_NOSIGNAL) < 0) {
+                return;
+            }
+        }
+    });
+    reply.clear();
+    EXPECT_TRUE(readToEnd(clientFd, reply));
+    shutdown(clientFd, SHUT_RDWR);
+    senderThread.join();
+    close(clientFd);
+    EXPECT_FALSE(testStore.get("k"));
+    testServer.stop();
+}
+
+/**
+ * @brief Tests the TTL commands, executed directly on a session with inline requests.
+ */
+TEST(RespSessionTest, ExpirationCommands) {
+    Store testStore(100, 4);
+    RespSession session(testStore);
+    std::vector<std::string_view> arguments;
+    size_t consumed = 0;
+
+    auto execute = [&](const std::string& request) {
+        std::string reply;
+        EXPECT_EQ(ParseRespRequest(request.data(), request.size(), arguments, consumed), RespParseStatus::Complete);
+        session.execute(arguments, reply);
+        return reply;
+    };
+
+    EXPECT_EQ(execute("SET a 1 EX 100\r\n"), "+OK\r\n");
+    EXPECT_EQ(execute("TTL a\r\n"), ":100\r\n");
+    EXPECT_EQ(execute("SET b 2\r\n"), "+OK\r\n");
+    EXPECT_EQ(execute("TTL b\r\n"), ":-1\r\n");
+    EXPECT_EQ(execute("TTL missing\r\n"), ":-2\r\n");
+    EXPECT_EQ(execute("PEXPIRE b 50000\r\n"), ":1\r\n");
+    EXPECT_EQ(execute("TTL b\r\n"), ":50\r\n");
+    EXPECT_EQ(execute("PERSIST b\r\n"), ":1\r\n");
+    EXPECT_EQ(execute("PERSIST b\r\n"), ":0\r\n");
+    EXPECT_EQ(execute("PTTL b\r\n"), ":-1\r\n");
+    EXPECT_EQ(execute("EXPIRE missing 10\r\n"), ":0\r\n");
+    EXPECT_EQ(execute("EXPIRE a 0\r\n"), ":1\r\n");
+    EXPECT_EQ(execute("GET a\r\n"), "$-1\r\n");
+
+    EXPECT_EQ(execute("SET c 3 EX 0\r\n"), "-ERR invalid expire time in 'set' command\r\n");
+    EXPECT_EQ(execute("SET c 3 EX soon\r\n"), "-ERR value is not an integer or out of range\r\n");
+    EXPECT_EQ(execute("SET c 3 NX\r\n"), "-ERR syntax error\r\n");
+}
+
+/**
+ * @brief Tests SCAN over RESP: cursor paging, MATCH prefixes, and argument errors.
+ */
+TEST(RespSessionTest, ScanCommand) {
+    Store testStore(100, 4);
+    RespSession session(testStore);
+    std::vector<std::string_view> arguments;
+    size_t consumed = 0;
+
+    auto execute = [&](std::vector<std::string_view>& parsedArguments, const std::string& request) {
+        std::string reply;
+        EXPECT_EQ(ParseRespRequest(request.data(), request.size(), parsedArguments, consumed), RespParseStatus::Complete);
+        session.execute(parsedArguments, reply);
+        return reply;
+    };
+
+    for (int index = 0; index < 30; ++index) {
+        testStore.put("user:" + std::to_string(index), "v");
+        testStore.put("order:" + std::to_string(index), "v");
+    }
+
+    // Page through every user key; each page is "*2", the cursor, then the keys
+    std::string cursor = "0";
+    size_t userKeys = 0;
+    do {
+        std::string reply = execute(arguments, "SCAN " + cursor + " MATCH user:* COUNT 8\r\n");
+        ASSERT_EQ(reply.substr(0, 4), "*2\r\n");
+        size_t cursorStart = reply.find("\r\n", 4) + 2;
+        cursor = reply.substr(cursorStart, reply.find("\r\n", cursorStart) - cursorStart);
+        for (size_t found = reply.find("user:"); found != std::string::npos; found = reply.find("user:", found + 1)) {
+            ++userKeys;
+        }
+        EXPECT_EQ(reply.find("order:"), std::string::npos);
+    } while (cursor != "0");
+    EXPECT_GE(userKeys, 30u);
+
+    EXPECT_EQ(execute(arguments, "SCAN\r\n"), "-ERR wrong number of arguments for 'scan' command\r\n");
+    EXPECT_EQ(execute(arguments, "SCAN x\r\n"), "-ERR invalid cursor\r\n");
+    EXPECT_EQ(execute(arguments, "SCAN 0 COUNT 0\r\n"), "-ERR value is out of range, must be positive\r\n");
+    EXPECT_EQ(execute(arguments, "SCAN 0 MATCH u?er*\r\n"),
+              "-ERR only MATCH patterns of the form prefix* are supported\r\n");
+    EXPECT_EQ(execute(arguments, "SCAN 0 COUNT\r\n"), "-ERR syntax error\r\n");
+}
+
+/**
+ * @brief Tests INCR, DECR, INCRBY, DECRBY, APPEND, and CAS over RESP.
+ */
+TEST(RespSessionTest, ReadModifyWriteCommands) {
+    Store testStore(100, 4);
+    RespSession session(testStore);
+    std::vector<std::string_view> arguments;
+    size_t consumed = 0;
+
+    auto execute = [&](const std::string& request) {
+        std::string reply;
+        EXPECT_EQ(ParseRespRequest(request.data(), request.size(), arguments, consumed), RespParseStatus::Complete);
+        session.execute(arguments, reply);
+        return reply;
+    };
+
+    EXPECT_EQ(execute("INCR hits\r\n"), ":1\r\n");
+    EXPECT_EQ(execute("INCRBY hits 10\r\n"), ":11\r\n");
+    EXPECT_EQ(execute("DECR hits\r\n"), ":10\r\n");
+    EXPECT_EQ(execute("DECRBY hits -5\r\n"), ":15\r\n");
+    EXPECT_EQ(execute("GET hits\r\n"), "$2\r\n15\r\n");
+    EXPECT_EQ(execute("INCRBY hits many\r\n"), "-ERR value is not an integer or out of range\r\n");
+    EXPECT_EQ(execute("SET name storm\r\n"), "+OK\r\n");
+    EXPECT_EQ(execute("INCR name\r\n"), "-ERR value is not an integer or out of range\r\n");
+    EXPECT_EQ(execute("INCR\r\n"), "-ERR wrong number of arguments for 'incr' command\r\n");
+
+    EXPECT_EQ(execute("APPEND name db\r\n"), ":7\r\n");
+    EXPECT_EQ(execute("GET name\r\n"), "$7\r\nstormdb\r\n");
+    EXPECT_EQ(execute("CAS name storm x\r\n"), ":0\r\n");
+    EXPECT_EQ(execute("CAS name stormdb x\r\n"), ":1\r\n");
+    EXPECT_EQ(execute("GET name\r\n"), "$1\r\nx\r\n");
+}
+
+/**
+ * @brief Tests FLUSHALL and FLUSHDB with and without ASYNC, and their argument errors.
+ */
+TEST(RespSessionTest, FlushCommands) {
+    Store testStore(100, 4);
+    RespSession session(testStore);
+    std::vector<std::string_view> arguments;
+    size_t consumed = 0;
+
+    auto execute = [&](const std::string& request) {
+        std::string reply;
+        EXPECT_EQ(ParseRespRequest(request.data(), request.size(), arguments, consumed), RespParseStatus::Complete);
+        session.execute(arguments, reply);
+        return reply;
+    };
+
+    for (const char* flushRequest : {"FLUSHALL\r\n", "FLUSHALL ASYNC\r\n", "FLUSHDB sync\r\n", "FLUSHDB ASYNC\r\n"}) {
+        EXPECT_EQ(execute("SET a 1\r\n"), "+OK\r\n");
+        EXPECT_EQ(execute(flushRequest), "+OK\r\n");
+        EXPECT_EQ(execute("GET a\r\n"), "$-1\r\n");
+    }
+    EXPECT_EQ(execute("FLUSHALL LATER\r\n"), "-ERR syntax error\r\n");
+    EXPECT_EQ(execute("FLUSHALL ASYNC SYNC\r\n"), "-ERR syntax error\r\n");
+}
+
+/**
+ * ==============================
+ * Replication
+ * ==============================
+ */
+
+/**
+ * @brief Tests that the replication backlog hands out whole records and reports trimmed offsets as lost.
+ */
+TEST(ReplicationTest, BacklogReadsAndTrims) {
+    ReplicationLog backlog(256 << 10);
+    std::string records;
+    EXPECT_EQ(backlog.read(0, 1 << 20, std::chrono::milliseconds(1), records), ReplicationLog::ReadStatus::Idle);
+
+    backlog.appendPut("key", "value", 0);
+    backlog.appendDelete("key");
+    uint64_t firstEnd = backlog.endOffset();
+    ASSERT_EQ(backlog.read(0, 1 << 20, std::chrono::milliseconds(0), records), ReplicationLog::ReadStatus::Data);
+    EXPECT_EQ(records.size(), firstEnd);
+
+    LogRecord record;
+    size_t recordBytes = 0;
+    ASSERT_EQ(DecodeLogRecord(records.data(), records.size(), record, recordBytes), LogDecodeStatus::Complete);
+    EXPECT_EQ(record.type, LogRecordType::Put);
+    EXPECT_EQ(record.key, "key");
+    EXPECT_EQ(record.value, "value");
+    ASSERT_EQ(DecodeLogRecord(records.data() + recordBytes, records.size() - recordBytes, record, recordBytes),
+              LogDecodeStatus::Complete);
+    EXPECT_EQ(record.type, LogRecordType::Delete);
+
+    // Push well past the limit: the oldest chunks go and a reader there must resync
+    std::string bigValue(1024, 'x');
+    for (int index = 0; index < 1024; ++index) {
+        backlog.appendPut("key" + std::to_string(index), bigValue, 0);
+    }
+    EXPECT_EQ(backlog.read(0, 1 << 20, std::chrono::milliseconds(0), records), ReplicationLog::ReadStatus::Lost);
+
+    backlog.close();
+    EXPECT_EQ(backlog.read(backlog.endOffset(), 1 << 20, std::chrono::milliseconds(1000), records),
+              ReplicationLog::ReadStatus::Closed);
+}
+
+/**
+ * @brief Tests a replica's full sync from a snapshot and then the streamed mutations, and that it refuses writes.
+ */
+TEST(ReplicationTest, ReplicaFollowsPrimary) {
+    std::string snapshotPath = testing::TempDir() + "storm_replication";
+    Store primaryStore(1000, 4);
+    auto backlog = std::make_shared<ReplicationLog>();
+    primaryStore.setReplicationLog(backlog);
+    primaryStore.put("before", "sync");
+    primaryStore.put("doomed", "value");
+
+    ReplicationPrimaryConfig primaryConfig;
+    primaryConfig.bindAddress = "127.0.0.1";
+    primaryConfig.port = 0;
+    primaryConfig.snapshotPath = snapshotPath + ".sync";
+    ReplicationPrimary primary(primaryStore, backlog, primaryConfig);
+    primary.start();
+
+    Store replicaStore(1000, 8);
+    ReplicaClient replica(replicaStore, "127.0.0.1", primary.port(), snapshotPath + ".sync-in");
+    replica.start();
+
+    auto waitUntilCaughtUp = [&] {
+        for (int attempt = 0; attempt < 500; ++attempt) {
+            ReplicationStatus status = replica.status();
+            if (status.connected && status.appliedOffset == backlog->endOffset()) return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    };
+    ASSERT_TRUE(waitUntilCaughtUp());
+    EXPECT_EQ(replicaStore.get("before").view(), "sync");
+    EXPECT_EQ(replica.status().fullSyncs, 1u);
+
+    // Streamed: single and batched writes, TTLs, deletes, and a clear in the middle
+    primaryStore.put("streamed", "one");
+    primaryStore.putMany({{"a", "1"}, {"b", "2"}, {"c", "3"}});
+    primaryStore.put("expiring", "soon", std::chrono::seconds(100));
+    primaryStore.del("doomed");
+    primaryStore.delMany({"a", "b"});
+    ASSERT_TRUE(waitUntilCaughtUp());
+    EXPECT_EQ(replicaStore.get("streamed").view(), "one");
+    EXPECT_FALSE(replicaStore.get("a"));
+    EXPECT_EQ(replicaStore.get("c").view(), "3");
+    EXPECT_FALSE(replicaStore.get("doomed"));
+    EXPECT_GT(replicaStore.ttl("expiring"), 0);
+    EXPECT_EQ(replica.status().lagBytes, 0u);
+    EXPECT_EQ(primary.status().connectedReplicas, 1u);
+
+    primaryStore.clear();
+    primaryStore.put("after", "clear");
+    ASSERT_TRUE(waitUntilCaughtUp());
+    EXPECT_FALSE(replicaStore.get("streamed"));
+    EXPECT_FALSE(replicaStore.get("c"));
+    EXPECT_EQ(replicaStore.get("after").view(), "clear");
+
+    // Sessions on the replica serve reads but refuse writes
+    SessionOptions replicaSession;
+    replicaSession.readOnly = true;
+    replicaSession.replicationStatus = [&] { return replica.status(); };
+    CommandProcessor textSession(replicaStore, false, replicaSession);
+    std::string reply;
+    textSession.execute("PUT after other", reply);
+    EXPECT_EQ(reply, "{ \"success\": false, \"error\": \"Read-only replica\" }\n");
+    RespSession respSession(replicaStore, replicaSession);
+    reply.clear();
+    respSession.execute({"SET", "after", "other"}, reply);
+    EXPECT_EQ(reply.rfind("-READONLY", 0), 0u);
+    reply.clear();
+    respSession.execute({"INFO", "replication"}, reply);
+    EXPECT_NE(reply.find("role:slave"), std::string::npos);
+    EXPECT_NE(reply.find("master_link_status:up"), std::string::npos);
+    EXPECT_EQ(replicaStore.get("after").view(), "clear");
+
+    replica.stop();
+    primary.stop();
+}
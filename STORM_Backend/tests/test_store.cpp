@@ -1,9 +1,21 @@
 #include "store.h"
+#include "compression.h"
+#include "numa_placement.h"
+#include "owned_shard_store.h"
 #include <gtest/gtest.h>
 #include <thread>
 #include <vector>
 #include <atomic>
 #include <random>
+#include <chrono>
+#include <set>
+#include <unordered_map>
+#include <algorithm>
+#include <filesystem>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <streambuf>
 
 /**
  * ==============================
@@ -136,6 +148,521 @@ TEST(StoreTest, ClearRemovesAllEntries) {
     EXPECT_FALSE(testStore.get("Z", retrievedValue));
 }
 
+/**
+ * @brief Tests that clear leaves a working store at once and frees the old entries in the background.
+ */
+TEST(StoreTest, ClearReclaimsEntriesInBackground) {
+    Store testStore(1000, 4);
+    for (int index = 0; index < 1000; ++index) {
+        testStore.put("key_" + std::to_string(index), std::string(100, 'v'), std::chrono::seconds(60));
+    }
+    ValueHandle heldValue = testStore.get("key_7");
+
+    testStore.clear();
+    EXPECT_EQ(testStore.memoryUsage(), 0u);
+    EXPECT_EQ(testStore.ttl("key_7"), Store::kTtlMissing);
+    std::string retrievedValue;
+    EXPECT_FALSE(testStore.get("key_7", retrievedValue));
+
+    // The swapped-in tables and wheels accept keys and TTLs straight away
+    testStore.put("fresh", "value", std::chrono::milliseconds(20));
+    EXPECT_TRUE(testStore.get("fresh", retrievedValue));
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    EXPECT_FALSE(testStore.get("fresh", retrievedValue));
+
+    // A handle taken before the clear stays valid after the old table is destroyed
+    testStore.waitForReclamation();
+    ASSERT_TRUE(heldValue);
+    EXPECT_EQ(std::string(heldValue.data(), heldValue.size()), std::string(100, 'v'));
+}
+
+/**
+ * @brief Tests that the reclaimer destroys every retired object, in order, and waitIdle waits for them.
+ */
+TEST(StoreTest, ReclaimerDestroysRetiredObjects) {
+    struct Tracked {
+        Tracked(std::vector<int>& destroyedIds, int trackedId) : destroyed(destroyedIds), id(trackedId) {}
+        ~Tracked() { destroyed.push_back(id); }
+
+        std::vector<int>& destroyed;
+        int id;
+    };
+
+    std::vector<int> destroyedIds;
+    {
+        Reclaimer reclaimer;
+        for (int id = 0; id < 100; ++id) {
+            reclaimer.retire(std::make_unique<Tracked>(destroyedIds, id));
+        }
+        reclaimer.waitIdle();
+        EXPECT_EQ(reclaimer.pending(), 0u);
+        ASSERT_EQ(destroyedIds.size(), 100u);
+        for (int id = 0; id < 100; ++id) {
+            EXPECT_EQ(destroyedIds[id], id);
+        }
+
+        // Objects still queued at destruction are destroyed, not leaked
+        reclaimer.retire(std::make_unique<Tracked>(destroyedIds, 100));
+    }
+    EXPECT_EQ(destroyedIds.size(), 101u);
+}
+
+/**
+ * @brief Tests that string_view keys behave exactly like std::string keys.
+ */
+TEST(StoreTest, StringViewKeys) {
+    Store slabStore(4, 2);
+    ListStore listStore(4, 2);
+    const std::string buffer = "alpha beta gamma";
+    std::string_view alphaKey(buffer.data(), 5);
+    std::string_view betaKey(buffer.data() + 6, 4);
+
+    slabStore.put(alphaKey, std::string_view(buffer.data() + 11, 5));
+    listStore.put(alphaKey, std::string_view(buffer.data() + 11, 5));
+
+    std::string retrievedValue;
+    EXPECT_TRUE(slabStore.get("alpha", retrievedValue));
+    EXPECT_EQ(retrievedValue, "gamma");
+    EXPECT_TRUE(listStore.get(std::string("alpha"), retrievedValue));
+    EXPECT_EQ(retrievedValue, "gamma");
+    EXPECT_FALSE(slabStore.get(betaKey, retrievedValue));
+    EXPECT_FALSE(listStore.get(betaKey, retrievedValue));
+
+    EXPECT_TRUE(slabStore.del(alphaKey));
+    EXPECT_TRUE(listStore.del(alphaKey));
+    EXPECT_FALSE(listStore.get("alpha", retrievedValue));
+}
+
+/**
+ * @brief Tests that value handles returned by get stay valid after overwrite, eviction, and delete.
+ */
+TEST(StoreTest, ValueHandlesOutliveOverwrite) {
+    Store slabStore(1, 1);
+    ListStore listStore(1, 1);
+
+    slabStore.put("key", "first");
+    listStore.put("key", std::string("first"));
+    ValueHandle slabValue = slabStore.get("key");
+    ValueHandle listValue = listStore.get("key");
+    ASSERT_TRUE(slabValue);
+    ASSERT_TRUE(listValue);
+
+    // Overwrite, then evict, then delete: the handles keep the old bytes alive
+    slabStore.put("key", std::string("second"));
+    listStore.put("key", "second");
+    EXPECT_EQ(slabStore.get("key").view(), "second");
+    slabStore.put("other", "third");
+    listStore.put("other", "third");
+    EXPECT_FALSE(slabStore.get("key"));
+    EXPECT_TRUE(listStore.del("other"));
+
+    EXPECT_EQ(slabValue.view(), "first");
+    EXPECT_EQ(listValue.view(), "first");
+
+    // Handles can be stored directly and shared between keys without copying
+    ValueHandle sharedValue = ValueHandle::copyOf("shared");
+    slabStore.put("a", sharedValue);
+    EXPECT_EQ(slabStore.get("a").data(), sharedValue.data());
+}
+
+/**
+ * @brief Tests per-key TTLs: lazy expiry on access, EXPIRE/PERSIST, and TTL clearing on plain put.
+ */
+TEST(StoreTest, KeysExpireAfterTtl) {
+    Store slabStore(10, 2);
+    ListStore listStore(10, 2);
+    Store clockStore(10, 2, RecencyMode::Clock);
+    std::string retrievedValue;
+
+    slabStore.put("short", "1", std::chrono::milliseconds(20));
+    listStore.put("short", "1", std::chrono::milliseconds(20));
+    clockStore.put("short", "1", std::chrono::milliseconds(20));
+    slabStore.put("long", "2", std::chrono::hours(1));
+    slabStore.put("forever", "3");
+
+    EXPECT_TRUE(slabStore.get("short", retrievedValue));
+    EXPECT_GT(slabStore.ttl("short"), 0);
+    EXPECT_LE(slabStore.ttl("short"), 20);
+    EXPECT_EQ(slabStore.ttl("forever"), Store::kTtlPersistent);
+    EXPECT_EQ(slabStore.ttl("missing"), Store::kTtlMissing);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    EXPECT_FALSE(slabStore.get("short", retrievedValue));
+    EXPECT_FALSE(listStore.get("short", retrievedValue));
+    EXPECT_FALSE(clockStore.get("short", retrievedValue));
+    EXPECT_EQ(clockStore.ttl("short"), Store::kTtlMissing);
+    EXPECT_FALSE(slabStore.del("short"));
+    EXPECT_TRUE(slabStore.get("long", retrievedValue));
+
+    // EXPIRE and PERSIST only apply to live keys
+    EXPECT_FALSE(slabStore.expire("short", std::chrono::seconds(1)));
+    EXPECT_TRUE(slabStore.expire("forever", std::chrono::seconds(30)));
+    EXPECT_GT(slabStore.ttl("forever"), 29000);
+    EXPECT_TRUE(slabStore.persist("forever"));
+    EXPECT_FALSE(slabStore.persist("forever"));
+    EXPECT_EQ(slabStore.ttl("forever"), Store::kTtlPersistent);
+
+    // A plain put clears the TTL; a non-positive TTL deletes the key
+    slabStore.put("long", "4");
+    EXPECT_EQ(slabStore.ttl("long"), Store::kTtlPersistent);
+    EXPECT_TRUE(slabStore.expire("long", std::chrono::milliseconds(0)));
+    EXPECT_FALSE(slabStore.get("long", retrievedValue));
+}
+
+/**
+ * @brief Tests that the timing wheel hands out records only once due, across levels and in bounded batches.
+ */
+TEST(StoreTest, TimingWheelCascadesDeadlines) {
+    const uint64_t startTick = 1000000;
+    TimingWheel<uint32_t> expiryWheel(startTick);
+    std::vector<uint64_t> deadlines = {startTick + 1, startTick + 63, startTick + 64, startTick + 5000,
+                                       startTick + 300000, startTick + (uint64_t{1} << 40), startTick - 5};
+    for (uint32_t index = 0; index < deadlines.size(); ++index) {
+        expiryWheel.schedule(index, deadlines[index]);
+    }
+
+    std::vector<uint32_t> dueEntries;
+    auto collect = [&](const TimingWheel<uint32_t>::Record& record) { dueEntries.push_back(record.entry); };
+
+    // Overdue records come due straight away
+    expiryWheel.advance(startTick, 100, collect);
+    EXPECT_EQ(dueEntries, std::vector<uint32_t>({6}));
+
+    expiryWheel.advance(startTick + 64, 100, collect);
+    EXPECT_EQ(dueEntries, std::vector<uint32_t>({6, 0, 1, 2}));
+
+    // A budget of one unit only cascades or expires a single record per call
+    dueEntries.clear();
+    size_t callCount = 0;
+    while (dueEntries.size() < 2 && callCount < 100) {
+        EXPECT_LE(expiryWheel.advance(startTick + 300000, 1, collect), 1u);
+        ++callCount;
+    }
+    EXPECT_EQ(dueEntries, std::vector<uint32_t>({3, 4}));
+    EXPECT_EQ(expiryWheel.size(), 1u);
+
+    // Deadlines past the top level wait in the overflow bucket
+    expiryWheel.advance(startTick + (uint64_t{1} << 40) - 1, 1000, collect);
+    EXPECT_EQ(expiryWheel.size(), 1u);
+    expiryWheel.advance(startTick + (uint64_t{1} << 40), 1000, collect);
+    EXPECT_TRUE(expiryWheel.empty());
+    EXPECT_EQ(dueEntries.back(), 5u);
+}
+
+/**
+ * @brief Tests that timing-wheel reaping drops stale records for overwritten keys and reclaims expired ones.
+ */
+TEST(StoreTest, ExpiredEntriesAreReclaimedWithoutAccess) {
+    Store testStore(4, 1);
+
+    // Overwriting without a TTL leaves a stale wheel record that must not delete the key
+    testStore.put("kept", "v", std::chrono::milliseconds(10));
+    testStore.put("kept", "kept");
+
+    // The expired keys are more recent than "kept", so LRU eviction alone would remove it first
+    for (int index = 0; index < 3; ++index) {
+        testStore.put("ttl_" + std::to_string(index), "v", std::chrono::milliseconds(10));
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+
+    // The writers reclaim expired entries, so the full shard evicts nothing live
+    testStore.put("a", "1");
+    testStore.put("b", "2");
+    testStore.put("c", "3");
+
+    std::string retrievedValue;
+    EXPECT_TRUE(testStore.get("kept", retrievedValue));
+    EXPECT_EQ(retrievedValue, "kept");
+    EXPECT_TRUE(testStore.get("a", retrievedValue));
+    EXPECT_TRUE(testStore.get("b", retrievedValue));
+    EXPECT_TRUE(testStore.get("c", retrievedValue));
+}
+
+/**
+ * @brief Tests that a byte budget evicts as many LRU entries as a large value needs.
+ */
+TEST(StoreTest, MemoryBudgetEvictsByBytes) {
+    StoreOptions storeOptions;
+    storeOptions.maxKeysPerShard = 0; // Bounded by bytes only
+    storeOptions.shardCount = 1;
+    storeOptions.memoryBudget = 16 * 1024;
+    Store testStore(storeOptions);
+
+    for (int index = 0; index < 40; ++index) {
+        EXPECT_TRUE(testStore.put("small_" + std::to_string(index), std::string(100, 's')));
+    }
+    EXPECT_LE(testStore.memoryUsage(), storeOptions.memoryBudget);
+
+    // A value of most of the budget pushes out the oldest small entries, not just one
+    std::string retrievedValue;
+    EXPECT_TRUE(testStore.put("large", std::string(12 * 1024, 'l')));
+    EXPECT_LE(testStore.memoryUsage(), storeOptions.memoryBudget);
+    EXPECT_TRUE(testStore.get("large", retrievedValue));
+    EXPECT_EQ(retrievedValue.size(), 12u * 1024);
+    EXPECT_FALSE(testStore.get("small_0", retrievedValue));
+    EXPECT_FALSE(testStore.get("small_20", retrievedValue));
+    EXPECT_TRUE(testStore.get("small_39", retrievedValue));
+
+    // Growing an existing entry evicts others, never the entry itself
+    EXPECT_TRUE(testStore.put("small_39", std::string(3 * 1024, 'g')));
+    EXPECT_LE(testStore.memoryUsage(), storeOptions.memoryBudget);
+    EXPECT_TRUE(testStore.get("small_39", retrievedValue));
+    EXPECT_EQ(retrievedValue, std::string(3 * 1024, 'g'));
+
+    // Deletes and clear give the bytes back
+    size_t usageBeforeDelete = testStore.memoryUsage();
+    EXPECT_TRUE(testStore.del("large"));
+    EXPECT_LE(testStore.memoryUsage() + 12 * 1024, usageBeforeDelete);
+    testStore.clear();
+    EXPECT_EQ(testStore.memoryUsage(), 0u);
+}
+
+/**
+ * @brief Tests that growing an entry in CLOCK mode evicts referenced entries instead of overshooting the budget.
+ */
+TEST(StoreTest, GrowingEntryEvictsPastReferencedEntries) {
+    StoreOptions storeOptions;
+    storeOptions.maxKeysPerShard = 0;
+    storeOptions.shardCount = 1;
+    storeOptions.memoryBudget = 4096;
+    storeOptions.recencyMode = RecencyMode::Clock;
+    Store testStore(storeOptions);
+
+    EXPECT_TRUE(testStore.put("a", std::string(1500, 'a')));
+    EXPECT_TRUE(testStore.put("b", std::string(100, 'b')));
+    EXPECT_TRUE(testStore.get("a")); // Sets a's reference bit, so a is promoted past b at the tail
+
+    EXPECT_TRUE(testStore.put("b", std::string(2500, 'b')));
+    EXPECT_LE(testStore.memoryUsage(), storeOptions.memoryBudget);
+    EXPECT_FALSE(testStore.get("a"));
+    EXPECT_EQ(testStore.get("b").size(), 2500u);
+}
+
+/**
+ * @brief Tests that values over the size limit or the shard budget are rejected untouched.
+ */
+TEST(StoreTest, OversizedValuesAreRejected) {
+    StoreOptions storeOptions;
+    storeOptions.shardCount = 2;
+    storeOptions.memoryBudget = 8 * 1024; // 4 KiB per shard
+    storeOptions.maxValueBytes = 2 * 1024;
+    Store testStore(storeOptions);
+
+    std::string retrievedValue;
+    EXPECT_TRUE(testStore.put("key", "original"));
+    EXPECT_FALSE(testStore.put("key", std::string(2 * 1024 + 1, 'x')));
+    EXPECT_TRUE(testStore.get("key", retrievedValue));
+    EXPECT_EQ(retrievedValue, "original");
+    EXPECT_FALSE(testStore.put("other", std::string(4 * 1024, 'x'), std::chrono::seconds(10)));
+    EXPECT_FALSE(testStore.get("other", retrievedValue));
+
+    // The limit applies per value; keys stay bounded by the shard share of the budget
+    StoreOptions budgetOnly;
+    budgetOnly.shardCount = 2;
+    budgetOnly.memoryBudget = 8 * 1024;
+    Store budgetStore(budgetOnly);
+    EXPECT_FALSE(budgetStore.put("huge", std::string(5 * 1024, 'x')));
+    EXPECT_TRUE(budgetStore.put("fits", std::string(3 * 1024, 'x')));
+
+    // putMany skips pairs that put would reject
+    std::vector<std::pair<std::string, std::string>> batch = {
+        {"a", "1"}, {"b", std::string(3 * 1024, 'x')}, {"c", "3"}};
+    EXPECT_EQ(testStore.putMany(batch), 2u);
+    EXPECT_TRUE(testStore.get("a", retrievedValue));
+    EXPECT_FALSE(testStore.get("b", retrievedValue));
+    EXPECT_TRUE(testStore.get("c", retrievedValue));
+}
+
+/**
+ * @brief Tests batch reads and deletes across shards, including duplicates and missing keys.
+ */
+TEST(StoreTest, BatchGetAndDelete) {
+    Store testStore(16, 4);
+    testStore.putMany({{"k1", "v1"}, {"k2", "v2"}, {"k3", "old"}, {"k3", "v3"}, {"k4", "v4"}});
+
+    std::vector<std::string_view> requestedKeys = {"k3", "missing", "k1", "k3", "k4"};
+    std::vector<ValueHandle> retrievedValues;
+    EXPECT_EQ(testStore.getMany(requestedKeys, retrievedValues), 4u);
+    ASSERT_EQ(retrievedValues.size(), requestedKeys.size());
+    EXPECT_EQ(retrievedValues[0].view(), "v3");
+    EXPECT_FALSE(retrievedValues[1]);
+    EXPECT_EQ(retrievedValues[2].view(), "v1");
+    EXPECT_EQ(retrievedValues[3].view(), "v3");
+    EXPECT_EQ(retrievedValues[4].view(), "v4");
+
+    EXPECT_EQ(testStore.delMany({"k1", "k3", "k3", "missing"}), 2u);
+    EXPECT_EQ(testStore.getMany({"k1", "k2", "k3", "k4"}, retrievedValues), 2u);
+    EXPECT_FALSE(retrievedValues[0]);
+    EXPECT_EQ(retrievedValues[1].view(), "v2");
+    EXPECT_FALSE(retrievedValues[2]);
+    EXPECT_EQ(retrievedValues[3].view(), "v4");
+}
+
+/**
+ * @brief Tests that batches handed to a worker pool give the same results as inline batches.
+ */
+TEST(StoreTest, ParallelBatchesUseExecutor) {
+    Store testStore(1000, 16);
+    testStore.setExecutor(std::make_shared<WorkerPool>(3), 64);
+
+    std::vector<std::pair<std::string, std::string>> keyValuePairs;
+    for (int index = 0; index < 8000; ++index) {
+        keyValuePairs.emplace_back("key_" + std::to_string(index), "val_" + std::to_string(index));
+    }
+    testStore.putMany(keyValuePairs);
+
+    std::vector<std::string_view> requestedKeys;
+    for (const auto& keyValuePair : keyValuePairs) {
+        requestedKeys.push_back(keyValuePair.first);
+    }
+    std::vector<ValueHandle> retrievedValues;
+    EXPECT_EQ(testStore.getMany(requestedKeys, retrievedValues), keyValuePairs.size());
+    for (size_t index = 0; index < keyValuePairs.size(); ++index) {
+        EXPECT_EQ(retrievedValues[index].view(), keyValuePairs[index].second);
+    }
+
+    // Small batches stay on the caller's thread
+    EXPECT_EQ(testStore.delMany({"key_1", "key_2", "missing"}), 2u);
+    EXPECT_EQ(testStore.delMany(requestedKeys), keyValuePairs.size() - 2);
+    EXPECT_EQ(testStore.getMany(requestedKeys, retrievedValues), 0u);
+}
+
+/**
+ * @brief Tests that a shared worker pool runs every task exactly once for concurrent callers.
+ */
+TEST(StoreTest, WorkerPoolRunsEachTaskOnce) {
+    WorkerPool workerPool(2);
+    const int callerCount = 4;
+    const size_t taskCount = 500;
+    std::vector<std::vector<std::atomic<int>>> runCounts(callerCount);
+    for (auto& callerRunCounts : runCounts) {
+        callerRunCounts = std::vector<std::atomic<int>>(taskCount);
+    }
+
+    std::vector<std::thread> callers;
+    for (int callerIndex = 0; callerIndex < callerCount; ++callerIndex) {
+        callers.emplace_back([&, callerIndex] {
+            for (int round = 0; round < 20; ++round) {
+                workerPool.parallelFor(taskCount, [&](size_t taskIndex) {
+                    runCounts[callerIndex][taskIndex].fetch_add(1);
+                });
+            }
+        });
+    }
+    for (auto& caller : callers) caller.join();
+
+    for (const auto& callerRunCounts : runCounts) {
+        for (const auto& runCount : callerRunCounts) {
+            EXPECT_EQ(runCount.load(), 20);
+        }
+    }
+}
+
+/**
+ * ==============================
+ * Read-modify-write
+ * ==============================
+ */
+
+/**
+ * @brief Tests compareAndSet, incrBy, append, and update, including their failure cases.
+ */
+TEST(StoreTest, ReadModifyWriteOperations) {
+    Store testStore(100, 4);
+    std::string retrievedValue;
+
+    EXPECT_FALSE(testStore.compareAndSet("cas", "a", "b"));
+    testStore.put("cas", "a");
+    EXPECT_FALSE(testStore.compareAndSet("cas", "x", "b"));
+    EXPECT_TRUE(testStore.compareAndSet("cas", "a", "b"));
+    ASSERT_TRUE(testStore.get("cas", retrievedValue));
+    EXPECT_EQ(retrievedValue, "b");
+
+    int64_t counter = 0;
+    EXPECT_TRUE(testStore.incrBy("counter", 5, counter));
+    EXPECT_EQ(counter, 5);
+    EXPECT_TRUE(testStore.incrBy("counter", -7, counter));
+    EXPECT_EQ(counter, -2);
+    testStore.put("counter", std::to_string(INT64_MAX));
+    EXPECT_FALSE(testStore.incrBy("counter", 1, counter));
+    EXPECT_EQ(counter, -2);
+    EXPECT_FALSE(testStore.incrBy("cas", 1, counter));
+    testStore.put("padded", "12 ");
+    EXPECT_FALSE(testStore.incrBy("padded", 1, counter));
+
+    // Read-modify-write keeps the key's TTL, unlike put
+    size_t length = 0;
+    EXPECT_TRUE(testStore.append("log", "ab", length));
+    EXPECT_EQ(length, 2u);
+    ASSERT_TRUE(testStore.expire("log", std::chrono::seconds(100)));
+    EXPECT_TRUE(testStore.append("log", "cde", length));
+    EXPECT_EQ(length, 5u);
+    ASSERT_TRUE(testStore.get("log", retrievedValue));
+    EXPECT_EQ(retrievedValue, "abcde");
+    EXPECT_GT(testStore.ttl("log"), 0);
+
+    // The generic form can also keep or delete
+    auto deleteIfEven = [](const ValueHandle& current, std::string&) {
+        return current && (current.view().back() - '0') % 2 == 0 ? UpdateAction::Delete : UpdateAction::Keep;
+    };
+    testStore.put("odd", "7");
+    testStore.put("even", "8");
+    EXPECT_EQ(testStore.update("odd", deleteIfEven), UpdateStatus::Unchanged);
+    EXPECT_EQ(testStore.update("even", deleteIfEven), UpdateStatus::Deleted);
+    EXPECT_EQ(testStore.update("missing", deleteIfEven), UpdateStatus::Unchanged);
+    EXPECT_TRUE(testStore.get("odd", retrievedValue));
+    EXPECT_FALSE(testStore.get("even", retrievedValue));
+
+    StoreOptions limitedOptions;
+    limitedOptions.maxValueBytes = 4;
+    Store limitedStore(limitedOptions);
+    EXPECT_TRUE(limitedStore.append("key", "abcd", length));
+    EXPECT_FALSE(limitedStore.append("key", "e", length));
+    EXPECT_EQ(limitedStore.update("key", [](const ValueHandle&, std::string& next) {
+        next = "too long";
+        return UpdateAction::Store;
+    }), UpdateStatus::Rejected);
+    ASSERT_TRUE(limitedStore.get("key", retrievedValue));
+    EXPECT_EQ(retrievedValue, "abcd");
+}
+
+/**
+ * @brief Tests that concurrent increments and compare-and-set loops never lose an update.
+ */
+TEST(StoreTest, ConcurrentReadModifyWritesAreAtomic) {
+    Store testStore(100, 4);
+    testStore.put("swapped", "0");
+    const int kThreadCount = 8;
+    const int kUpdatesPerThread = 1000;
+
+    std::vector<std::thread> updaterThreads;
+    for (int threadIndex = 0; threadIndex < kThreadCount; ++threadIndex) {
+        updaterThreads.emplace_back([&] {
+            int64_t counter = 0;
+            std::string currentValue;
+            for (int update = 0; update < kUpdatesPerThread; ++update) {
+                testStore.incrBy("counter", 1, counter);
+
+                // A get-then-CAS loop: retried whenever another thread got in between
+                do {
+                    testStore.get("swapped", currentValue);
+                } while (!testStore.compareAndSet("swapped", currentValue,
+                                                  std::to_string(std::stoi(currentValue) + 1)));
+            }
+        });
+    }
+    for (std::thread& updaterThread : updaterThreads) {
+        updaterThread.join();
+    }
+
+    std::string retrievedValue;
+    ASSERT_TRUE(testStore.get("counter", retrievedValue));
+    EXPECT_EQ(retrievedValue, std::to_string(kThreadCount * kUpdatesPerThread));
+    ASSERT_TRUE(testStore.get("swapped", retrievedValue));
+    EXPECT_EQ(retrievedValue, std::to_string(kThreadCount * kUpdatesPerThread));
+}
+
 /**
  * ==============================
  * Concurrency Stress Test
@@ -209,3 +736,1702 @@ TEST(StoreTest, ConcurrencyStress) {
 
     EXPECT_LE(totalKeysStored, static_cast<int>(kNumShards * kShardCapacity));
 }
+
+/**
+ * ==============================
+ * Shared-Lock Read Path
+ * ==============================
+ */
+
+/**
+ * @brief Tests that CLOCK-mode reads defer promotion until eviction but keep LRU order.
+ */
+TEST(StoreTest, ClockModeGivesReferencedKeysSecondChance) {
+    Store testStore(2, 1, RecencyMode::Clock); // Single shard
+
+    testStore.put("A", "1");
+    testStore.put("B", "2");
+
+    std::string retrievedValue;
+    EXPECT_TRUE(testStore.get("A", retrievedValue)); // Sets A's reference bit only
+
+    testStore.put("C", "3"); // A is at the tail but referenced, so "B" is evicted
+
+    EXPECT_TRUE(testStore.get("A", retrievedValue));
+    EXPECT_EQ(retrievedValue, "1");
+    EXPECT_FALSE(testStore.get("B", retrievedValue));
+    EXPECT_TRUE(testStore.get("C", retrievedValue));
+    EXPECT_EQ(retrievedValue, "3");
+}
+
+/**
+ * @brief Tests concurrent CLOCK-mode readers alongside a writer.
+ */
+TEST(StoreTest, ClockModeConcurrentReaders) {
+    Store testStore(50, 2, RecencyMode::Clock);
+    for (int index = 0; index < 50; ++index) {
+        testStore.put("key_" + std::to_string(index), "val_" + std::to_string(index));
+    }
+
+    std::atomic<bool> stopWriter{false};
+    std::thread writerThread([&testStore, &stopWriter]() {
+        for (int index = 0; !stopWriter.load(); ++index) {
+            testStore.put("churn_" + std::to_string(index % 200), "x");
+        }
+    });
+
+    std::vector<std::thread> readerThreads;
+    for (int threadIndex = 0; threadIndex < 8; ++threadIndex) {
+        readerThreads.emplace_back([&testStore]() {
+            std::string retrievedValue;
+            for (int iteration = 0; iteration < 20000; ++iteration) {
+                int keyIndex = iteration % 50;
+                if (testStore.get("key_" + std::to_string(keyIndex), retrievedValue)) {
+                    EXPECT_EQ(retrievedValue, "val_" + std::to_string(keyIndex));
+                }
+            }
+        });
+    }
+
+    for (auto& readerThread : readerThreads) {
+        readerThread.join();
+    }
+    stopWriter.store(true);
+    writerThread.join();
+}
+
+/**
+ * ==============================
+ * Shard Table Policies
+ * ==============================
+ */
+
+/**
+ * @brief Tests that the list-based reference layout keeps the same LRU semantics.
+ */
+TEST(StoreTest, ListShardTableEvictsLeastRecentlyUsed) {
+    ListStore testStore(2, 1); // Single shard, capacity 2
+
+    testStore.put("A", "1");
+    testStore.put("B", "2");
+
+    std::string retrievedValue;
+    EXPECT_TRUE(testStore.get("A", retrievedValue));
+
+    testStore.put("C", "3"); // Should evict "B"
+
+    EXPECT_TRUE(testStore.get("A", retrievedValue));
+    EXPECT_EQ(retrievedValue, "1");
+    EXPECT_FALSE(testStore.get("B", retrievedValue));
+    EXPECT_TRUE(testStore.get("C", retrievedValue));
+    EXPECT_TRUE(testStore.del("C"));
+    EXPECT_FALSE(testStore.get("C", retrievedValue));
+}
+
+/**
+ * @brief Tests that recycled and freed slab slots keep every live key reachable.
+ */
+TEST(StoreTest, SlabShardTableRecyclesSlots) {
+    const int kCapacity = 64;
+    Store testStore(kCapacity, 1); // Single shard
+
+    // Churn far past capacity so every slot is recycled many times
+    for (int index = 0; index < kCapacity * 20; ++index) {
+        testStore.put("key_" + std::to_string(index), "val_" + std::to_string(index));
+        if (index % 7 == 0) {
+            testStore.del("key_" + std::to_string(index - 3));
+        }
+    }
+
+    // Only the most recent keys survive, minus the ones deleted along the way
+    std::string retrievedValue;
+    const int kLastIndex = kCapacity * 20 - 1;
+    EXPECT_TRUE(testStore.get("key_" + std::to_string(kLastIndex), retrievedValue));
+    EXPECT_EQ(retrievedValue, "val_" + std::to_string(kLastIndex));
+    EXPECT_FALSE(testStore.get("key_0", retrievedValue));
+
+    int liveKeys = 0;
+    for (int index = 0; index <= kLastIndex; ++index) {
+        if (testStore.get("key_" + std::to_string(index), retrievedValue)) {
+            EXPECT_EQ(retrievedValue, "val_" + std::to_string(index));
+            ++liveKeys;
+        }
+    }
+    EXPECT_LE(liveKeys, kCapacity);
+    EXPECT_GT(liveKeys, kCapacity / 2);
+
+    // The table swapped in by clear takes new keys
+    testStore.clear();
+    testStore.put("fresh", "value");
+    EXPECT_TRUE(testStore.get("fresh", retrievedValue));
+    EXPECT_EQ(retrievedValue, "value");
+}
+
+/**
+ * @brief Tests the slab index against a reference map under random puts, gets, and deletes.
+ */
+TEST(StoreTest, SlabIndexMatchesReferenceModel) {
+    // Fewer distinct keys than capacity, so every difference is an index bug, not an eviction
+    const int kCapacity = 5000;
+    const int kKeySpace = 4000;
+    Store testStore(kCapacity, 1);
+    std::unordered_map<std::string, std::string> referenceMap;
+
+    std::mt19937 randomGenerator(7);
+    std::uniform_int_distribution<int> keyDistribution(0, kKeySpace - 1);
+    std::uniform_int_distribution<int> operationDistribution(0, 2);
+
+    std::string retrievedValue;
+    for (int step = 0; step < 200000; ++step) {
+        std::string key = "k" + std::to_string(keyDistribution(randomGenerator));
+        switch (operationDistribution(randomGenerator)) {
+            case 0: {
+                std::string value = "v" + std::to_string(step);
+                testStore.put(key, value);
+                referenceMap[key] = value;
+                break;
+            }
+            case 1: {
+                auto reference = referenceMap.find(key);
+                bool found = testStore.get(key, retrievedValue);
+                ASSERT_EQ(found, reference != referenceMap.end()) << key;
+                if (found) {
+                    ASSERT_EQ(retrievedValue, reference->second);
+                }
+                break;
+            }
+            default:
+                ASSERT_EQ(testStore.del(key), referenceMap.erase(key) == 1) << key;
+                break;
+        }
+    }
+}
+
+/**
+ * ==============================
+ * Eviction Policies
+ * ==============================
+ */
+
+namespace {
+
+/**
+ * @brief Warm up a hot set, run a cache-aside scan of one-off keys, and count the hot keys left.
+ * @param testStore Single-shard store with room for more than the hot set.
+ * @param capacity Key capacity of the shard.
+ * @param hotKeyCount Number of frequently read keys.
+ * @param scanLength Number of distinct keys the scan reads once and then fills.
+ */
+template <typename TestStore>
+int HotKeysSurvivingScan(TestStore& testStore, int capacity, int hotKeyCount, int scanLength) {
+    std::string retrievedValue;
+    for (int index = 0; index < capacity; ++index) {
+        testStore.put("cold_" + std::to_string(index), "value");
+    }
+    // Hot keys are read cache-aside: a miss fills the key from the backend
+    for (int round = 0; round < 4; ++round) {
+        for (int index = 0; index < hotKeyCount; ++index) {
+            std::string hotKey = "hot_" + std::to_string(index);
+            if (!testStore.get(hotKey, retrievedValue)) {
+                testStore.put(hotKey, "value");
+            }
+        }
+    }
+
+    // Each scanned key misses once and is filled, but never read again
+    for (int index = 0; index < scanLength; ++index) {
+        std::string scanKey = "scan_" + std::to_string(index);
+        if (!testStore.get(scanKey, retrievedValue)) {
+            testStore.put(scanKey, "value");
+        }
+    }
+
+    int survivingHotKeys = 0;
+    for (int index = 0; index < hotKeyCount; ++index) {
+        if (testStore.get("hot_" + std::to_string(index), retrievedValue)) {
+            ++survivingHotKeys;
+        }
+    }
+    return survivingHotKeys;
+}
+
+} // namespace
+
+/**
+ * @brief Tests that SLRU and W-TinyLFU keep a hot set through a scan that flushes plain LRU.
+ */
+TEST(StoreTest, ScanResistantPoliciesKeepHotKeys) {
+    const int kCapacity = 100;
+    const int kHotKeys = 20;
+    const int kScanLength = 1000;
+
+    Store lruStore(kCapacity, 1);
+    EXPECT_EQ(HotKeysSurvivingScan(lruStore, kCapacity, kHotKeys, kScanLength), 0);
+
+    SlruStore slruStore(kCapacity, 1);
+    EXPECT_EQ(HotKeysSurvivingScan(slruStore, kCapacity, kHotKeys, kScanLength), kHotKeys);
+
+    TinyLfuStore tinyLfuStore(kCapacity, 1);
+    EXPECT_EQ(HotKeysSurvivingScan(tinyLfuStore, kCapacity, kHotKeys, kScanLength), kHotKeys);
+
+    // Capacity still holds, and new keys are admitted once they prove popular
+    std::string retrievedValue;
+    for (int round = 0; round < 6; ++round) {
+        tinyLfuStore.put("rising", "value");
+        tinyLfuStore.get("rising", retrievedValue);
+        for (int index = 0; index < 3; ++index) {
+            tinyLfuStore.put("filler_" + std::to_string(round * 3 + index), "value");
+        }
+    }
+    EXPECT_TRUE(tinyLfuStore.get("rising", retrievedValue));
+
+    int liveKeys = 0;
+    for (int index = 0; index < kScanLength; ++index) {
+        liveKeys += tinyLfuStore.get("scan_" + std::to_string(index), retrievedValue) ? 1 : 0;
+    }
+    EXPECT_LE(liveKeys + kHotKeys + 1, kCapacity);
+}
+
+/**
+ * @brief Tests that the frequency sketch counts accesses and halves them as it ages.
+ */
+TEST(StoreTest, FrequencySketchCountsAndAges) {
+    FrequencySketch frequencySketch(64);
+    std::hash<std::string> keyHasher;
+
+    for (int count = 0; count < 12; ++count) {
+        frequencySketch.increment(keyHasher("popular"));
+    }
+    frequencySketch.increment(keyHasher("rare"));
+    EXPECT_GE(frequencySketch.estimate(keyHasher("popular")), 12u);
+    EXPECT_GE(frequencySketch.estimate(keyHasher("rare")), 1u);
+    EXPECT_LT(frequencySketch.estimate(keyHasher("rare")), 12u);
+
+    // Counters saturate at 15
+    for (int count = 0; count < 20; ++count) {
+        frequencySketch.increment(keyHasher("popular"));
+    }
+    EXPECT_EQ(frequencySketch.estimate(keyHasher("popular")), 15u);
+
+    // Enough other traffic triggers aging, which halves the old counts
+    for (int index = 0; index < 64 * 10; ++index) {
+        frequencySketch.increment(keyHasher("other_" + std::to_string(index)));
+    }
+    EXPECT_LE(frequencySketch.estimate(keyHasher("popular")), 7u);
+
+    frequencySketch.clear();
+    EXPECT_EQ(frequencySketch.estimate(keyHasher("popular")), 0u);
+}
+
+/**
+ * @brief Tests that the key hash depends on every byte and on the seed, and spreads keys across shards.
+ */
+TEST(StoreTest, SeededKeyHashSpreadsKeys) {
+    // Every prefix length of one key, including the short-key and multi-lane paths, hashes differently
+    std::string longKey(130, 'k');
+    for (size_t index = 0; index < longKey.size(); ++index) {
+        longKey[index] = static_cast<char>('a' + index % 26);
+    }
+    std::vector<uint64_t> prefixHashes;
+    for (size_t length = 0; length <= longKey.size(); ++length) {
+        prefixHashes.push_back(HashKey(std::string_view(longKey).substr(0, length), 1));
+    }
+    std::sort(prefixHashes.begin(), prefixHashes.end());
+    EXPECT_EQ(std::adjacent_find(prefixHashes.begin(), prefixHashes.end()), prefixHashes.end());
+
+    // Flipping one byte or changing the seed changes the hash
+    std::string flippedKey = longKey;
+    flippedKey[77] ^= 1;
+    EXPECT_NE(HashKey(longKey, 1), HashKey(flippedKey, 1));
+    EXPECT_NE(HashKey("key", 1), HashKey("key", 2));
+    EXPECT_EQ(HashKey("key", 7), HashKey("key", 7));
+
+    // Sequential keys fill 16 shards evenly through the top 32 bits
+    constexpr int kKeyCount = 16000;
+    std::vector<int> shardCounts(16, 0);
+    for (int index = 0; index < kKeyCount; ++index) {
+        uint64_t hash = HashKey("key_" + std::to_string(index), 42);
+        ++shardCounts[((hash >> 32) * 16) >> 32];
+    }
+    for (int count : shardCounts) {
+        EXPECT_GT(count, kKeyCount / 16 * 8 / 10);
+        EXPECT_LT(count, kKeyCount / 16 * 12 / 10);
+    }
+
+    // Stores with a fixed seed still behave like any other store
+    StoreOptions storeOptions;
+    storeOptions.hashSeed = 12345;
+    Store seededStore(storeOptions);
+    std::string retrievedValue;
+    EXPECT_TRUE(seededStore.put("key", "value"));
+    EXPECT_TRUE(seededStore.get("key", retrievedValue));
+    EXPECT_EQ(retrievedValue, "value");
+}
+
+/**
+ * @brief Tests that shards are cache-line aligned and that NUMA placement covers nodes in contiguous blocks.
+ */
+TEST(StoreTest, ShardsAreAlignedAndPlacedOnNodes) {
+    StoreOptions storeOptions;
+    storeOptions.shardCount = 8;
+    storeOptions.numaAware = true;
+    Store numaStore(storeOptions);
+    ASSERT_EQ(numaStore.shardCount(), 8u);
+
+    // Placement is either off (no NUMA) or a non-decreasing walk over the available nodes
+    const std::vector<int>& numaNodes = NumaNodes();
+    for (size_t shard = 0; shard < numaStore.shardCount(); ++shard) {
+        int shardNode = numaStore.shardNode(shard);
+        if (numaNodes.empty()) {
+            EXPECT_EQ(shardNode, -1);
+        } else {
+            EXPECT_NE(std::find(numaNodes.begin(), numaNodes.end(), shardNode), numaNodes.end());
+            if (shard > 0) {
+                EXPECT_GE(shardNode, numaStore.shardNode(shard - 1));
+            }
+        }
+    }
+    EXPECT_EQ(numaStore.shardNode(0), numaNodes.empty() ? -1 : numaNodes.front());
+
+    // Without the option nothing is placed, and keys map to valid shards either way
+    Store plainStore(storeOptions.maxKeysPerShard, 8);
+    std::string retrievedValue;
+    for (int index = 0; index < 100; ++index) {
+        std::string key = "key_" + std::to_string(index);
+        EXPECT_LT(numaStore.shardOf(key), 8u);
+        EXPECT_TRUE(numaStore.put(key, "value"));
+        EXPECT_TRUE(numaStore.get(key, retrievedValue));
+    }
+    EXPECT_EQ(plainStore.shardNode(0), -1);
+}
+
+/**
+ * ==============================
+ * Resharding
+ * ==============================
+ */
+
+namespace {
+
+/**
+ * @brief Grow a store from 4 to 16 shards and back, checking every key survives and only new shards receive keys.
+ * @return Number of keys the growth moved.
+ */
+template <typename TestStore>
+size_t CheckReshardRoundTrip(TestStore& testStore, int keyCount) {
+    std::vector<size_t> originalShards;
+    for (int index = 0; index < keyCount; ++index) {
+        std::string key = "key_" + std::to_string(index);
+        EXPECT_TRUE(testStore.put(key, "value_" + std::to_string(index)));
+        originalShards.push_back(testStore.shardOf(key));
+    }
+
+    EXPECT_TRUE(testStore.reshard(16));
+    EXPECT_FALSE(testStore.reshard(8)); // One migration at a time
+    EXPECT_TRUE(testStore.reshardProgress().active);
+
+    // Keys stay readable before the scan has reached them, and writes go to the new layout
+    std::string retrievedValue;
+    EXPECT_TRUE(testStore.get("key_0", retrievedValue));
+    EXPECT_EQ(retrievedValue, "value_0");
+    EXPECT_TRUE(testStore.put("key_1", "updated"));
+
+    while (testStore.migrateSome(64)) {
+    }
+    ReshardProgress growProgress = testStore.reshardProgress();
+    EXPECT_FALSE(growProgress.active);
+    EXPECT_EQ(testStore.shardCount(), 16u);
+
+    for (int index = 0; index < keyCount; ++index) {
+        std::string key = "key_" + std::to_string(index);
+        size_t newShard = testStore.shardOf(key);
+        EXPECT_TRUE(newShard == originalShards[index] || newShard >= 4) << key;
+        EXPECT_TRUE(testStore.get(key, retrievedValue)) << key;
+        EXPECT_EQ(retrievedValue, index == 1 ? "updated" : "value_" + std::to_string(index));
+    }
+
+    // Shrinking empties the removed shards back into the first four
+    EXPECT_TRUE(testStore.reshard(4));
+    while (testStore.migrateSome()) {
+    }
+    EXPECT_EQ(testStore.shardCount(), 4u);
+    for (int index = 0; index < keyCount; ++index) {
+        std::string key = "key_" + std::to_string(index);
+        EXPECT_EQ(testStore.shardOf(key), originalShards[index]);
+        EXPECT_TRUE(testStore.get(key, retrievedValue)) << key;
+    }
+    EXPECT_FALSE(testStore.reshard(0));
+    EXPECT_FALSE(testStore.reshard(17));
+    return growProgress.keysMoved;
+}
+
+} // namespace
+
+/**
+ * @brief Tests that resharding moves only the keys jump hashing reassigns, on both table layouts.
+ */
+TEST(StoreTest, ReshardMovesKeysIncrementally) {
+    constexpr int kKeyCount = 4000;
+    StoreOptions storeOptions;
+    storeOptions.maxKeysPerShard = kKeyCount;
+    storeOptions.shardCount = 4;
+    storeOptions.maxShardCount = 16;
+
+    Store slabStore(storeOptions);
+    size_t slabMoved = CheckReshardRoundTrip(slabStore, kKeyCount);
+    ListStore listStore(storeOptions);
+    size_t listMoved = CheckReshardRoundTrip(listStore, kKeyCount);
+
+    // Growing from 4 to 16 shards should move about three quarters of the keys
+    for (size_t movedKeys : {slabMoved, listMoved}) {
+        EXPECT_GT(movedKeys, kKeyCount * 65 / 100);
+        EXPECT_LT(movedKeys, kKeyCount * 85 / 100);
+    }
+}
+
+/**
+ * @brief Tests that reads and writes running during a reshard never lose or resurrect values.
+ */
+TEST(StoreTest, ReshardUnderConcurrentTraffic) {
+    constexpr int kThreadCount = 4;
+    constexpr int kKeysPerThread = 500;
+    StoreOptions storeOptions;
+    storeOptions.maxKeysPerShard = kThreadCount * kKeysPerThread;
+    storeOptions.shardCount = 4;
+    storeOptions.maxShardCount = 32;
+    Store concurrentStore(storeOptions);
+
+    for (int thread = 0; thread < kThreadCount; ++thread) {
+        for (int index = 0; index < kKeysPerThread; ++index) {
+            concurrentStore.put("t" + std::to_string(thread) + "_" + std::to_string(index), "0");
+        }
+    }
+
+    // Each worker owns its keys, bumps a version per write, and checks it reads back what it wrote last
+    std::atomic<bool> stopWorkers{false};
+    std::atomic<int> readMismatches{0};
+    std::vector<std::thread> workerThreads;
+    for (int thread = 0; thread < kThreadCount; ++thread) {
+        workerThreads.emplace_back([&, thread] {
+            std::vector<int> versions(kKeysPerThread, 0);
+            std::mt19937 generator(thread);
+            std::string retrievedValue;
+            while (!stopWorkers.load()) {
+                int index = static_cast<int>(generator() % kKeysPerThread);
+                std::string key = "t" + std::to_string(thread) + "_" + std::to_string(index);
+                if (generator() % 4 == 0) {
+                    versions[index] += 1;
+                    concurrentStore.put(key, std::to_string(versions[index]));
+                } else if (generator() % 8 == 0) {
+                    std::vector<std::string_view> batchKeys{key};
+                    std::vector<ValueHandle> batchValues;
+                    if (concurrentStore.getMany(batchKeys, batchValues) != 1 ||
+                        batchValues[0].view() != std::to_string(versions[index])) {
+                        readMismatches.fetch_add(1);
+                    }
+                } else if (!concurrentStore.get(key, retrievedValue) || retrievedValue != std::to_string(versions[index])) {
+                    readMismatches.fetch_add(1);
+                }
+            }
+        });
+    }
+
+    for (size_t shardCount : {16u, 32u, 8u, 5u}) {
+        EXPECT_TRUE(concurrentStore.reshard(shardCount));
+        while (concurrentStore.migrateSome(32)) {
+            std::this_thread::yield();
+        }
+        EXPECT_EQ(concurrentStore.shardCount(), shardCount);
+    }
+
+    stopWorkers.store(true);
+    for (std::thread& workerThread : workerThreads) {
+        workerThread.join();
+    }
+    EXPECT_EQ(readMismatches.load(), 0);
+}
+
+/**
+ * ==============================
+ * Append-Only Log
+ * ==============================
+ */
+
+namespace {
+
+/**
+ * @brief Fresh file path under the test temporary directory.
+ */
+std::string TemporaryFilePath(const std::string& name) {
+    std::string filePath = testing::TempDir() + "storm_" + name;
+    std::filesystem::remove(filePath);
+    return filePath;
+}
+
+} // namespace
+
+/**
+ * @brief Tests that replaying the log rebuilds the contents left by single-key, batch, TTL, and clear operations.
+ */
+TEST(StoreTest, AppendLogReplaysMutations) {
+    std::string logPath = TemporaryFilePath("replay.log");
+    {
+        Store loggedStore(100, 4);
+        loggedStore.setAppendLog(std::make_shared<AppendLog>(logPath, FsyncPolicy::Always));
+
+        loggedStore.put("gone", "soon");
+        loggedStore.clear();
+        loggedStore.put("plain", "value");
+        loggedStore.put("overwritten", "first");
+        loggedStore.put("overwritten", "second");
+        loggedStore.put("deleted", "value");
+        EXPECT_TRUE(loggedStore.del("deleted"));
+        EXPECT_FALSE(loggedStore.del("never_existed"));
+        loggedStore.put("expiring", "value", std::chrono::hours(1));
+        loggedStore.put("persisted", "value", std::chrono::hours(1));
+        EXPECT_TRUE(loggedStore.persist("persisted"));
+        loggedStore.put("short_lived", "value", std::chrono::milliseconds(1));
+        loggedStore.putMany({{"batch_a", "1"}, {"batch_b", "2"}, {"batch_c", "3"}});
+        std::vector<std::string_view> deletedKeys{"batch_b"};
+        EXPECT_EQ(loggedStore.delMany(deletedKeys), 1u);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    Store replayedStore(100, 4);
+    AppendLogReader logReader(logPath);
+    EXPECT_EQ(replayedStore.replay(logReader), 15u);
+    EXPECT_FALSE(logReader.tornTail());
+
+    std::string retrievedValue;
+    EXPECT_FALSE(replayedStore.get("gone", retrievedValue));
+    EXPECT_TRUE(replayedStore.get("plain", retrievedValue));
+    EXPECT_EQ(retrievedValue, "value");
+    EXPECT_TRUE(replayedStore.get("overwritten", retrievedValue));
+    EXPECT_EQ(retrievedValue, "second");
+    EXPECT_FALSE(replayedStore.get("deleted", retrievedValue));
+    EXPECT_FALSE(replayedStore.get("short_lived", retrievedValue));
+    EXPECT_GT(replayedStore.ttl("expiring"), 0);
+    EXPECT_EQ(replayedStore.ttl("persisted"), Store::kTtlPersistent);
+    EXPECT_TRUE(replayedStore.get("batch_a", retrievedValue));
+    EXPECT_FALSE(replayedStore.get("batch_b", retrievedValue));
+    EXPECT_TRUE(replayedStore.get("batch_c", retrievedValue));
+    std::filesystem::remove(logPath);
+}
+
+/**
+ * @brief Tests that a torn final record stops replay at the last complete one and appends resume after it.
+ */
+TEST(StoreTest, AppendLogStopsAtTornTail) {
+    std::string logPath = TemporaryFilePath("torn.log");
+    uint64_t completeBytes = 0;
+    {
+        AppendLog appendLog(logPath, FsyncPolicy::Never);
+        appendLog.appendPut("first", "1", 0);
+        EXPECT_TRUE(appendLog.sync());
+        completeBytes = appendLog.writtenBytes();
+        appendLog.appendPut("second", std::string(1000, 'x'), 0);
+    }
+
+    // Cut the second record short, as a crash in the middle of a write would
+    std::filesystem::resize_file(logPath, completeBytes + 100);
+    {
+        Store replayedStore(100, 4);
+        AppendLogReader logReader(logPath);
+        EXPECT_EQ(replayedStore.replay(logReader), 1u);
+        EXPECT_TRUE(logReader.tornTail());
+        EXPECT_EQ(logReader.validBytes(), completeBytes);
+        EXPECT_TRUE(replayedStore.get("first"));
+        EXPECT_FALSE(replayedStore.get("second"));
+    }
+
+    std::filesystem::resize_file(logPath, completeBytes);
+    {
+        AppendLog appendLog(logPath, FsyncPolicy::EverySecond);
+        appendLog.appendDelete("first");
+    }
+    Store replayedStore(100, 4);
+    AppendLogReader logReader(logPath);
+    EXPECT_EQ(replayedStore.replay(logReader), 2u);
+    EXPECT_FALSE(logReader.tornTail());
+    EXPECT_FALSE(replayedStore.get("first"));
+    std::filesystem::remove(logPath);
+}
+
+/**
+ * ==============================
+ * Snapshots
+ * ==============================
+ */
+
+/**
+ * @brief Tests that a snapshot restores values, TTLs, and LRU order, into the same or a different layout.
+ */
+TEST(StoreTest, SnapshotRestoresContentsAndRecency) {
+    std::string snapshotPath = TemporaryFilePath("snapshot.snap");
+    StoreOptions storeOptions;
+    storeOptions.maxKeysPerShard = 10;
+    storeOptions.shardCount = 1;
+    storeOptions.hashSeed = 42;
+
+    Store savedStore(storeOptions);
+    for (int index = 0; index < 10; ++index) {
+        savedStore.put("key_" + std::to_string(index), "value_" + std::to_string(index));
+    }
+    EXPECT_TRUE(savedStore.get("key_0"));
+    EXPECT_TRUE(savedStore.expire("key_2", std::chrono::hours(1)));
+    EXPECT_TRUE(savedStore.expire("key_3", std::chrono::milliseconds(1)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    savedStore.snapshot(snapshotPath);
+
+    SnapshotReader snapshotReader(snapshotPath);
+    EXPECT_EQ(snapshotReader.hashSeed(), 42u);
+    EXPECT_EQ(snapshotReader.sectionCount(), 1u);
+
+    Store loadedStore(storeOptions);
+    EXPECT_EQ(loadedStore.loadSnapshot(snapshotReader), 9u);
+    std::string retrievedValue;
+    EXPECT_TRUE(loadedStore.get("key_5", retrievedValue));
+    EXPECT_EQ(retrievedValue, "value_5");
+    EXPECT_FALSE(loadedStore.get("key_3"));
+    EXPECT_GT(loadedStore.ttl("key_2"), 0);
+    EXPECT_EQ(loadedStore.ttl("key_4"), Store::kTtlPersistent);
+
+    // key_1 was least recent when saved and key_0 most recent, and the load kept that order
+    EXPECT_TRUE(loadedStore.put("new_a", "value"));
+    EXPECT_TRUE(loadedStore.put("new_b", "value"));
+    EXPECT_FALSE(loadedStore.get("key_1"));
+    EXPECT_TRUE(loadedStore.get("key_0"));
+
+    // A store with another seed, shard count, and table layout routes every entry itself
+    StoreOptions otherOptions;
+    otherOptions.maxKeysPerShard = 100;
+    otherOptions.shardCount = 3;
+    ListStore otherStore(otherOptions);
+    EXPECT_EQ(otherStore.loadSnapshot(snapshotReader), 9u);
+    for (int index = 0; index < 10; ++index) {
+        EXPECT_EQ(static_cast<bool>(otherStore.get("key_" + std::to_string(index))), index != 3) << index;
+    }
+    std::filesystem::remove(snapshotPath);
+}
+
+/**
+ * @brief Tests that a snapshot taken while a shrinking reshard migrates keeps every key.
+ */
+TEST(StoreTest, SnapshotDuringShrinkKeepsEveryKey) {
+    std::string snapshotPath = TemporaryFilePath("shrinking.snap");
+    StoreOptions storeOptions;
+    storeOptions.maxKeysPerShard = 0;
+    storeOptions.shardCount = 8;
+    const int kKeyCount = 20000;
+
+    for (int trial = 0; trial < 5; ++trial) {
+        Store savedStore(storeOptions);
+        for (int index = 0; index < kKeyCount; ++index) {
+            savedStore.put("key_" + std::to_string(index), "v");
+        }
+        ASSERT_TRUE(savedStore.reshard(2));
+
+        // Keys keep moving from high shards into low ones while the snapshot runs
+        std::atomic<bool> snapshotDone{false};
+        std::thread migrationThread([&] {
+            while (!snapshotDone.load() && savedStore.migrateSome(16)) {
+                std::this_thread::yield();
+            }
+        });
+        savedStore.snapshot(snapshotPath);
+        snapshotDone.store(true);
+        migrationThread.join();
+
+        SnapshotReader snapshotReader(snapshotPath);
+        Store loadedStore(storeOptions);
+        loadedStore.loadSnapshot(snapshotReader);
+        for (int index = 0; index < kKeyCount; ++index) {
+            ASSERT_TRUE(loadedStore.get("key_" + std::to_string(index))) << "trial " << trial << " key_" << index;
+        }
+    }
+    std::filesystem::remove(snapshotPath);
+}
+
+/**
+ * @brief Tests that compaction leaves only later writes in the log, and snapshot plus log restore everything.
+ */
+TEST(StoreTest, LogCompactionKeepsLaterWrites) {
+    std::string logPath = TemporaryFilePath("compacted.log");
+    std::string snapshotPath = TemporaryFilePath("compacted.snap");
+    {
+        Store loggedStore(100, 4);
+        loggedStore.setAppendLog(std::make_shared<AppendLog>(logPath, FsyncPolicy::Never));
+        for (int index = 0; index < 50; ++index) {
+            loggedStore.put("key_" + std::to_string(index), "old");
+        }
+        loggedStore.compactLog(snapshotPath);
+
+        loggedStore.put("key_0", "new");
+        loggedStore.del("key_1");
+        loggedStore.put("later", "value");
+    }
+    EXPECT_FALSE(std::filesystem::exists(logPath + ".next"));
+
+    Store restoredStore(100, 4);
+    SnapshotReader snapshotReader(snapshotPath);
+    EXPECT_EQ(restoredStore.loadSnapshot(snapshotReader), 50u);
+    AppendLogReader logReader(logPath);
+    EXPECT_EQ(restoredStore.replay(logReader), 3u);
+
+    std::string retrievedValue;
+    EXPECT_TRUE(restoredStore.get("key_0", retrievedValue));
+    EXPECT_EQ(retrievedValue, "new");
+    EXPECT_FALSE(restoredStore.get("key_1"));
+    EXPECT_TRUE(restoredStore.get("key_49", retrievedValue));
+    EXPECT_EQ(retrievedValue, "old");
+    EXPECT_TRUE(restoredStore.get("later"));
+    std::filesystem::remove(logPath);
+    std::filesystem::remove(snapshotPath);
+}
+
+/**
+ * ==============================
+ * Statistics
+ * ==============================
+ */
+
+/**
+ * @brief Tests that stats() counts hits, misses, puts, deletes, and evictions, per store and per shard.
+ */
+TEST(StoreTest, StatsCountOperations) {
+    Store testStore(4, 2); // 8 slots in total
+    for (int index = 0; index < 10; ++index) {
+        testStore.put("key_" + std::to_string(index), "value");
+    }
+    testStore.get("key_9");
+    testStore.get("missing");
+    testStore.del("key_9");
+    testStore.del("missing");
+    testStore.putMany({{"batch_a", "1"}, {"batch_b", "2"}});
+
+    StoreStats storeStats = testStore.stats();
+    EXPECT_EQ(storeStats.puts, 12u);
+    EXPECT_EQ(storeStats.hits, 1u);
+    EXPECT_EQ(storeStats.misses, 1u);
+    EXPECT_EQ(storeStats.gets, 2u);
+    EXPECT_DOUBLE_EQ(storeStats.hitRatio(), 0.5);
+    EXPECT_EQ(storeStats.deletes, 1u);
+    EXPECT_GE(storeStats.evictions, 3u); // 11 live keys never fit in 8 slots
+    ASSERT_EQ(storeStats.shards.size(), 2u);
+
+    size_t shardKeys = 0;
+    uint64_t shardEvictions = 0;
+    for (const ShardStats& shardStats : storeStats.shards) {
+        shardKeys += shardStats.keys;
+        shardEvictions += shardStats.evictions;
+    }
+    EXPECT_EQ(shardKeys, storeStats.keys);
+    EXPECT_EQ(shardEvictions, storeStats.evictions);
+    EXPECT_EQ(storeStats.keys, 12u - 1u - storeStats.evictions);
+
+    std::string metrics;
+    AppendPrometheusMetrics(metrics, storeStats);
+    EXPECT_NE(metrics.find("storm_hits_total 1\n"), std::string::npos);
+    EXPECT_NE(metrics.find("storm_shard_keys{shard=\"1\"}"), std::string::npos);
+}
+
+/**
+ * @brief Tests that every value lands in a bucket whose bound is within 1/16 above it.
+ */
+TEST(LatencyHistogramTest, BucketsBoundValues) {
+    for (uint64_t value : {0ull, 1ull, 15ull, 16ull, 17ull, 31ull, 32ull, 1000ull, 123456789ull, 1ull << 40}) {
+        size_t bucketIndex = LatencyHistogram::BucketIndex(value);
+        ASSERT_LT(bucketIndex, LatencyHistogram::kBucketCount);
+        uint64_t upperBound = LatencyHistogram::BucketUpperBound(bucketIndex);
+        EXPECT_GE(upperBound, value);
+        EXPECT_LE(upperBound - value, value / LatencyHistogram::kSubBucketCount);
+        if (bucketIndex > 0) {
+            EXPECT_LT(LatencyHistogram::BucketUpperBound(bucketIndex - 1), value);
+        }
+    }
+    EXPECT_EQ(LatencyHistogram::BucketIndex(~0ull), LatencyHistogram::kBucketCount - 1);
+
+    LatencyHistogram testHistogram;
+    for (uint64_t value = 1; value <= 1000; ++value) {
+        ++testHistogram.buckets[LatencyHistogram::BucketIndex(value)];
+        testHistogram.max = value;
+    }
+    EXPECT_EQ(testHistogram.count(), 1000u);
+    EXPECT_NEAR(static_cast<double>(testHistogram.percentile(0.5)), 500.0, 500.0 / 16);
+    EXPECT_NEAR(static_cast<double>(testHistogram.percentile(0.99)), 990.0, 990.0 / 16);
+    EXPECT_EQ(testHistogram.percentile(1.0), 1000u);
+}
+
+/**
+ * @brief Tests that store operations from several threads are merged into per-operation histograms.
+ */
+TEST(StoreTest, LatencyRecordsEveryOperation) {
+    if (!kLatencyTracking) {
+        GTEST_SKIP() << "built with STORM_NO_LATENCY";
+    }
+    Store testStore(1000, 4);
+    std::vector<std::thread> threads;
+    for (int threadIndex = 0; threadIndex < 4; ++threadIndex) {
+        threads.emplace_back([&testStore, threadIndex] {
+            for (int index = 0; index < 100; ++index) {
+                std::string key = std::to_string(threadIndex) + "_" + std::to_string(index);
+                testStore.put(key, "value");
+                testStore.get(key);
+            }
+            testStore.del(std::to_string(threadIndex) + "_0");
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    testStore.putMany({{"a", "1"}, {"b", "2"}});
+
+    std::vector<LatencySummary> summaries = testStore.latency();
+    ASSERT_EQ(summaries.size(), static_cast<size_t>(LatencyOp::Count));
+    const LatencySummary& putSummary = summaries[static_cast<size_t>(LatencyOp::Put)];
+    EXPECT_EQ(putSummary.count, 400u);
+    EXPECT_LE(putSummary.p50Nanos, putSummary.p999Nanos);
+    EXPECT_LE(putSummary.p999Nanos, putSummary.maxNanos);
+    EXPECT_GT(putSummary.maxNanos, 0u);
+    EXPECT_EQ(summaries[static_cast<size_t>(LatencyOp::Get)].count, 400u);
+    EXPECT_EQ(summaries[static_cast<size_t>(LatencyOp::Del)].count, 4u);
+    EXPECT_EQ(summaries[static_cast<size_t>(LatencyOp::PutMany)].count, 1u);
+    EXPECT_GE(summaries[static_cast<size_t>(LatencyOp::LockAcquire)].count, 804u);
+
+    testStore.resetLatency();
+    EXPECT_EQ(testStore.latency()[static_cast<size_t>(LatencyOp::Put)].count, 0u);
+}
+
+/**
+ * ==============================
+ * Slab allocation
+ * ==============================
+ */
+
+/**
+ * @brief Tests that released chunks are reused by the next value of their class and sizes are bounded.
+ */
+TEST(SlabAllocatorTest, RecyclesChunksBySizeClass) {
+    SlabAllocator testSlab;
+
+    ValueHandle first = testSlab.copy("hello");
+    const char* firstBytes = first.data();
+    EXPECT_EQ(testSlab.stats().pageBytes, SlabAllocator::kPageBytes);
+    EXPECT_EQ(testSlab.stats().chunkBytes, SlabAllocator::ChargeFor(5));
+    first.reset();
+    EXPECT_EQ(testSlab.stats().chunkBytes, 0u);
+
+    // Same class: the freed chunk comes straight back
+    ValueHandle second = testSlab.copy("world");
+    EXPECT_EQ(second.data(), firstBytes);
+    EXPECT_EQ(second.view(), "world");
+
+    // Another class carves its own page; values past the largest class use the heap
+    ValueHandle medium = testSlab.copy(std::string(500, 'm'));
+    ValueHandle large = testSlab.copy(std::string(2 * SlabAllocator::kMaxChunkBytes, 'l'));
+    SlabStats slabStats = testSlab.stats();
+    EXPECT_EQ(slabStats.pageBytes, 2 * SlabAllocator::kPageBytes);
+    EXPECT_GT(slabStats.heapBytes, 2 * SlabAllocator::kMaxChunkBytes);
+    EXPECT_EQ(large.view(), std::string(2 * SlabAllocator::kMaxChunkBytes, 'l'));
+    EXPECT_GT(slabStats.fragmentation(), 0.0);
+    EXPECT_LT(slabStats.fragmentation(), 1.0);
+
+    // A chunk never wastes more than one growth step
+    for (size_t valueSize : {0, 1, 100, 1000, 4000, 8000}) {
+        size_t charge = SlabAllocator::ChargeFor(valueSize);
+        EXPECT_GE(charge, valueSize);
+        EXPECT_LE(charge, static_cast<size_t>((valueSize + 64) * SlabAllocator::kGrowthFactor) + 8);
+    }
+
+    // Values may outlive their allocator
+    auto shortLivedSlab = std::make_unique<SlabAllocator>();
+    ValueHandle survivor = shortLivedSlab->copy("survivor");
+    shortLivedSlab.reset();
+    EXPECT_EQ(survivor.view(), "survivor");
+}
+
+/**
+ * @brief Tests that a full shard recycles evicted values' chunks instead of allocating more pages.
+ */
+TEST(StoreTest, EvictedValuesReturnToShardSlab) {
+    Store testStore(100, 1); // Single shard
+    std::string value(200, 'v');
+    for (int index = 0; index < 100; ++index) {
+        testStore.put("key" + std::to_string(index), value);
+    }
+    size_t filledPageBytes = testStore.stats().slab.pageBytes;
+    EXPECT_GT(filledPageBytes, 0u);
+
+    for (int index = 100; index < 2000; ++index) {
+        testStore.put("key" + std::to_string(index), value);
+    }
+    StoreStats storeStats = testStore.stats();
+    EXPECT_EQ(storeStats.evictions, 1900u);
+    EXPECT_EQ(storeStats.slab.pageBytes, filledPageBytes);
+    EXPECT_EQ(storeStats.slab.chunkBytes, 100 * SlabAllocator::ChargeFor(value.size()));
+    ASSERT_EQ(storeStats.shards.size(), 1u);
+    EXPECT_EQ(storeStats.shards[0].slab.pageBytes, filledPageBytes);
+
+    std::string metrics;
+    AppendPrometheusMetrics(metrics, storeStats);
+    EXPECT_NE(metrics.find("storm_slab_page_bytes " + std::to_string(filledPageBytes) + "\n"), std::string::npos);
+}
+
+/**
+ * ==============================
+ * Scanning
+ * ==============================
+ */
+
+namespace {
+
+/**
+ * @brief Run a whole scan and collect the distinct keys it returned.
+ */
+template <typename StoreType>
+std::set<std::string> ScanAll(StoreType& store, size_t count, std::string_view prefix = {}) {
+    std::set<std::string> keys;
+    uint64_t cursor = 0;
+    do {
+        ScanResult page = store.scan(cursor, count, prefix);
+        keys.insert(page.keys.begin(), page.keys.end());
+        cursor = page.cursor;
+    } while (cursor != 0);
+    return keys;
+}
+
+} // namespace
+
+/**
+ * @brief Tests that a scan pages through every live key in bounded pages and filters by prefix.
+ */
+TEST(StoreTest, ScanVisitsEveryKey) {
+    Store testStore(1000, 4);
+    for (int index = 0; index < 500; ++index) {
+        testStore.put("user:" + std::to_string(index), "v");
+        testStore.put("order:" + std::to_string(index), "v");
+    }
+    testStore.put("short-lived", "v", std::chrono::milliseconds(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    size_t pages = 0;
+    uint64_t cursor = 0;
+    do {
+        ScanResult page = testStore.scan(cursor, 16);
+        EXPECT_LE(page.keys.size(), 16u);
+        cursor = page.cursor;
+        ++pages;
+    } while (cursor != 0);
+    EXPECT_GT(pages, 1000u / 16);
+
+    std::set<std::string> everyKey = ScanAll(testStore, 64);
+    EXPECT_EQ(everyKey.size(), 1000u);
+    EXPECT_EQ(everyKey.count("short-lived"), 0u);
+
+    std::set<std::string> userKeys = ScanAll(testStore, 64, "user:");
+    EXPECT_EQ(userKeys.size(), 500u);
+    EXPECT_EQ(userKeys.count("order:1"), 0u);
+
+    ListStore listStore(1000, 4);
+    for (int index = 0; index < 300; ++index) {
+        listStore.put("key" + std::to_string(index), "v");
+    }
+    EXPECT_EQ(ScanAll(listStore, 10).size(), 300u);
+}
+
+/**
+ * @brief Tests that keys present throughout a scan are returned despite concurrent writes and reshards.
+ */
+TEST(StoreTest, ScanSurvivesChurnAndReshard) {
+    StoreOptions storeOptions;
+    storeOptions.maxKeysPerShard = 0;
+    storeOptions.shardCount = 4;
+    Store testStore(storeOptions);
+    for (int index = 0; index < 2000; ++index) {
+        testStore.put("stable" + std::to_string(index), "v");
+    }
+
+    std::atomic<bool> stopChurn{false};
+    std::thread churnThread([&] {
+        for (int round = 0; !stopChurn.load(); ++round) {
+            std::string key = "churn" + std::to_string(round % 500);
+            if (round % 3 == 0) {
+                testStore.del(key);
+            } else {
+                testStore.put(key, "v");
+            }
+        }
+    });
+
+    // Grow and then shrink part-way through separate scans
+    for (size_t targetShards : {7u, 3u}) {
+        std::set<std::string> seen;
+        uint64_t cursor = 0;
+        size_t pageCount = 0;
+        do {
+            ScanResult page = testStore.scan(cursor, 50);
+            seen.insert(page.keys.begin(), page.keys.end());
+            cursor = page.cursor;
+            if (++pageCount == 10) {
+                ASSERT_TRUE(testStore.reshard(targetShards));
+            }
+            testStore.migrateSome(64);
+        } while (cursor != 0);
+        while (testStore.migrateSome()) {
+        }
+
+        for (int index = 0; index < 2000; ++index) {
+            ASSERT_EQ(seen.count("stable" + std::to_string(index)), 1u) << "stable" << index;
+        }
+    }
+
+    stopChurn.store(true);
+    churnThread.join();
+
+    // A ListStore rehash mid-scan walks the shard again; 59 and 127 buckets are
+    // consecutive libstdc++ sizes, so the scan must not tell epochs apart by bucket count
+    for (int trial = 0; trial < 20; ++trial) {
+        ListStore listStore(0, 1);
+        std::string keyPrefix = "trial" + std::to_string(trial) + "_";
+        for (int index = 0; index < 50; ++index) {
+            listStore.put(keyPrefix + std::to_string(index), "v");
+        }
+
+        ScanResult page = listStore.scan(0, 5);
+        std::set<std::string> seen(page.keys.begin(), page.keys.end());
+        for (int index = 50; index < 90; ++index) {
+            listStore.put(keyPrefix + std::to_string(index), "v");
+        }
+        while (page.cursor != 0) {
+            page = listStore.scan(page.cursor, 5);
+            seen.insert(page.keys.begin(), page.keys.end());
+        }
+
+        for (int index = 0; index < 50; ++index) {
+            ASSERT_EQ(seen.count(keyPrefix + std::to_string(index)), 1u) << keyPrefix << index;
+        }
+    }
+}
+
+/**
+ * ==============================
+ * Compression
+ * ==============================
+ */
+
+namespace {
+
+/**
+ * @brief A JSON document of the repetitive kind compression is meant for.
+ */
+std::string JsonDocument(int id) {
+    std::string document = "{ \"id\": " + std::to_string(id) + ", \"items\": [";
+    for (int item = 0; item < 40; ++item) {
+        document += "{ \"sku\": \"item-" + std::to_string(item) + "\", \"quantity\": " +
+                    std::to_string(item % 7) + ", \"status\": \"in_stock\" }, ";
+    }
+    return document + "] }";
+}
+
+} // namespace
+
+/**
+ * @brief Tests that the LZ4 codec round-trips, refuses data that does not shrink, and rejects corrupt blocks.
+ */
+TEST(CompressionTest, Lz4RoundTrip) {
+    std::string document = JsonDocument(1);
+    std::vector<char> compressed(document.size());
+    size_t compressedSize = Lz4Compress(document.data(), document.size(), compressed.data(), compressed.size());
+    ASSERT_GT(compressedSize, 0u);
+    EXPECT_LT(compressedSize, document.size() / 4);
+
+    std::string decompressed(document.size(), '\0');
+    ASSERT_TRUE(Lz4Decompress(compressed.data(), compressedSize, decompressed.data(), decompressed.size()));
+    EXPECT_EQ(decompressed, document);
+
+    // Wrong length and truncated input are errors, never overruns
+    EXPECT_FALSE(Lz4Decompress(compressed.data(), compressedSize, decompressed.data(), decompressed.size() - 1));
+    EXPECT_FALSE(Lz4Decompress(compressed.data(), compressedSize / 2, decompressed.data(), decompressed.size()));
+
+    // Random bytes do not fit in less room than they started with
+    std::mt19937 generator(7);
+    std::string noise(4096, '\0');
+    for (char& byte : noise) {
+        byte = static_cast<char>(generator());
+    }
+    std::vector<char> noiseOutput(noise.size() - noise.size() / 8);
+    EXPECT_EQ(Lz4Compress(noise.data(), noise.size(), noiseOutput.data(), noiseOutput.size()), 0u);
+
+    // Short inputs are all literals
+    std::vector<char> shortOutput(16);
+    size_t shortSize = Lz4Compress("abc", 3, shortOutput.data(), shortOutput.size());
+    std::string shortDecompressed(3, '\0');
+    ASSERT_TRUE(Lz4Decompress(shortOutput.data(), shortSize, shortDecompressed.data(), 3));
+    EXPECT_EQ(shortDecompressed, "abc");
+}
+
+/**
+ * @brief Tests that large values are stored compressed, charged for their stored size, and read back intact.
+ */
+TEST(StoreTest, CompressesLargeValuesTransparently) {
+    StoreOptions storeOptions;
+    storeOptions.maxKeysPerShard = 0;
+    storeOptions.shardCount = 2;
+    storeOptions.compressionThreshold = 1024;
+    Store compressingStore(storeOptions);
+    storeOptions.compressionThreshold = 0;
+    Store plainStore(storeOptions);
+
+    std::vector<std::pair<std::string, std::string>> documents;
+    for (int id = 0; id < 50; ++id) {
+        documents.emplace_back("doc" + std::to_string(id), JsonDocument(id));
+    }
+    for (const auto& [key, document] : documents) {
+        EXPECT_TRUE(compressingStore.put(key, document));
+        EXPECT_TRUE(plainStore.put(key, document));
+    }
+    compressingStore.put("small", "below the threshold");
+    EXPECT_LT(compressingStore.memoryUsage() * 3, plainStore.memoryUsage());
+
+    std::string value;
+    ASSERT_TRUE(compressingStore.get("doc7", value));
+    EXPECT_EQ(value, documents[7].second);
+    ASSERT_TRUE(compressingStore.get("small", value));
+    EXPECT_EQ(value, "below the threshold");
+
+    std::vector<std::string_view> keys{"doc1", "missing", "doc2"};
+    std::vector<ValueHandle> values;
+    EXPECT_EQ(compressingStore.getMany(keys, values), 2u);
+    EXPECT_EQ(values[0].view(), documents[1].second);
+    EXPECT_EQ(values[2].view(), documents[2].second);
+    EXPECT_FALSE(values[2].compressed());
+
+    // Random bytes are kept as they are
+    std::mt19937 generator(11);
+    std::string noise(2048, '\0');
+    for (char& byte : noise) {
+        byte = static_cast<char>(generator());
+    }
+    compressingStore.putMany({{"noise", noise}});
+    ASSERT_TRUE(compressingStore.get("noise", value));
+    EXPECT_EQ(value, noise);
+
+    CompressionStats compressionStats = compressingStore.stats().compression;
+    EXPECT_EQ(compressionStats.compressedValues, documents.size());
+    EXPECT_EQ(compressionStats.incompressibleValues, 1u);
+    EXPECT_EQ(compressionStats.decompressions, 3u);
+    EXPECT_GT(compressionStats.ratio(), 3.0);
+    EXPECT_EQ(plainStore.stats().compression.compressedValues, 0u);
+}
+
+/**
+ * @brief Tests that concurrent appends to a compressed value, compressed with the lock released, are never lost.
+ */
+TEST(StoreTest, ConcurrentAppendsToCompressedValue) {
+    StoreOptions storeOptions;
+    storeOptions.maxKeysPerShard = 0;
+    storeOptions.shardCount = 2;
+    storeOptions.compressionThreshold = 1024;
+    Store testStore(storeOptions);
+    std::string document = JsonDocument(3);
+    ASSERT_TRUE(testStore.put("doc", document));
+    ASSERT_GT(testStore.stats().compression.compressedValues, 0u);
+
+    const int kThreadCount = 4;
+    const int kAppendsPerThread = 50;
+    std::vector<std::thread> appenderThreads;
+    for (int threadIndex = 0; threadIndex < kThreadCount; ++threadIndex) {
+        appenderThreads.emplace_back([&, threadIndex] {
+            size_t length = 0;
+            std::string suffix(1, static_cast<char>('a' + threadIndex));
+            for (int append = 0; append < kAppendsPerThread; ++append) {
+                EXPECT_TRUE(testStore.append("doc", suffix, length));
+            }
+        });
+    }
+    for (std::thread& appenderThread : appenderThreads) {
+        appenderThread.join();
+    }
+
+    std::string retrievedValue;
+    ASSERT_TRUE(testStore.get("doc", retrievedValue));
+    ASSERT_EQ(retrievedValue.size(), document.size() + kThreadCount * kAppendsPerThread);
+    EXPECT_EQ(retrievedValue.compare(0, document.size(), document), 0);
+    for (int threadIndex = 0; threadIndex < kThreadCount; ++threadIndex) {
+        EXPECT_EQ(std::count(retrievedValue.begin() + static_cast<std::ptrdiff_t>(document.size()),
+                             retrievedValue.end(), static_cast<char>('a' + threadIndex)),
+                  kAppendsPerThread);
+    }
+}
+
+/**
+ * ==============================
+ * Asynchronous operations
+ * ==============================
+ */
+
+namespace {
+
+/**
+ * @brief Blocks the thread that enters it until released, to hold a shard lock inside update().
+ */
+class LockGate {
+public:
+    void enter() {
+        std::unique_lock<std::mutex> gateLockGuard(gateLock);
+        entered = true;
+        gateChanged.notify_all();
+        gateChanged.wait(gateLockGuard, [this] { return released; });
+    }
+
+    void waitUntilEntered() {
+        std::unique_lock<std::mutex> gateLockGuard(gateLock);
+        gateChanged.wait(gateLockGuard, [this] { return entered; });
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> gateLockGuard(gateLock);
+        released = true;
+        gateChanged.notify_all();
+    }
+
+private:
+    std::mutex gateLock;
+    std::condition_variable gateChanged;
+    bool entered = false;
+    bool released = false;
+};
+
+/**
+ * @brief Output buffer whose first write waits at a gate, to pause list() mid-listing.
+ */
+class GatedStreamBuffer : public std::streambuf {
+public:
+    explicit GatedStreamBuffer(LockGate& gate) : writeGate(gate) {}
+
+protected:
+    int overflow(int character) override {
+        if (!passedGate) {
+            passedGate = true;
+            writeGate.enter();
+        }
+        written.push_back(static_cast<char>(character));
+        return character;
+    }
+
+public:
+    std::string written;
+
+private:
+    LockGate& writeGate;
+    bool passedGate = false;
+};
+
+} // namespace
+
+/**
+ * @brief Tests that async operations on a free shard complete before returning, without needing a drain.
+ */
+TEST(StoreTest, AsyncOperationsRunInlineWhenUncontended) {
+    Store testStore(100, 4);
+    testStore.setExecutor(std::make_shared<WorkerPool>(1));
+
+    bool stored = false;
+    testStore.putAsync("key", "value", [&](bool succeeded) { stored = succeeded; });
+    EXPECT_TRUE(stored);
+
+    std::string retrievedValue;
+    testStore.getAsync("key", [&](ValueHandle value) { retrievedValue.assign(value.view()); });
+    EXPECT_EQ(retrievedValue, "value");
+
+    bool deleted = false;
+    testStore.delAsync("key", [&](bool succeeded) { deleted = succeeded; });
+    EXPECT_TRUE(deleted);
+    EXPECT_FALSE(testStore.get("key"));
+}
+
+/**
+ * @brief Tests that putAsync holds a value that did not compress to the byte budget, like put.
+ */
+TEST(StoreTest, AsyncPutRejectsIncompressibleValuesOverBudget) {
+    StoreOptions storeOptions;
+    storeOptions.maxKeysPerShard = 0;
+    storeOptions.shardCount = 1;
+    storeOptions.memoryBudget = 16384;
+    storeOptions.compressionThreshold = 1024;
+    Store testStore(storeOptions);
+    testStore.setExecutor(std::make_shared<WorkerPool>(1));
+
+    std::mt19937 generator(5);
+    std::string noise(20000, '\0');
+    for (char& byte : noise) {
+        byte = static_cast<char>(generator());
+    }
+    testStore.put("k", "old");
+    testStore.put("other", "kept");
+    EXPECT_FALSE(testStore.put("k", noise));
+
+    // Over an existing key and as a new key
+    for (const char* key : {"k", "new"}) {
+        bool stored = true;
+        testStore.putAsync(key, noise, [&](bool succeeded) { stored = succeeded; });
+        EXPECT_FALSE(stored) << key;
+    }
+    EXPECT_LE(testStore.memoryUsage(), storeOptions.memoryBudget);
+    EXPECT_EQ(testStore.get("k").view(), "old");
+    EXPECT_EQ(testStore.get("other").view(), "kept");
+    EXPECT_FALSE(testStore.get("new"));
+}
+
+/**
+ * @brief Tests that operations on a locked shard are queued, return at once, and drain in order.
+ */
+TEST(StoreTest, AsyncOperationsQueueOnContendedShard) {
+    Store testStore(100, 1); // Single shard
+    testStore.setExecutor(std::make_shared<WorkerPool>(2));
+    testStore.put("existing", "old");
+
+    // update() runs its function with the shard locked exclusively, so no operation can take the lock
+    LockGate lockGate;
+    std::thread lockHolder([&] {
+        testStore.update("existing", [&](const ValueHandle&, std::string&) {
+            lockGate.enter();
+            return UpdateAction::Keep;
+        });
+    });
+    lockGate.waitUntilEntered();
+
+    std::atomic<int> completedCount{0};
+    std::promise<std::string> readValue;
+    bool stored = false;
+    testStore.putAsync("existing", "new", [&](bool succeeded) {
+        stored = succeeded;
+        completedCount.fetch_add(1);
+    });
+    testStore.getAsync("existing", [&](ValueHandle value) {
+        readValue.set_value(std::string(value.view()));
+        completedCount.fetch_add(1);
+    });
+    EXPECT_EQ(completedCount.load(), 0);
+
+    lockGate.release();
+    lockHolder.join();
+
+    // The get was queued after the put, so it sees the new value
+    EXPECT_EQ(readValue.get_future().get(), "new");
+    while (completedCount.load() < 2) {
+        std::this_thread::yield();
+    }
+    EXPECT_TRUE(stored);
+    std::string retrievedValue;
+    EXPECT_TRUE(testStore.get("existing", retrievedValue));
+    EXPECT_EQ(retrievedValue, "new");
+}
+
+/**
+ * @brief Tests that list() writes with no shard lock held, and still prints compressed values in plain form.
+ */
+TEST(StoreTest, ListWritesOutsideTheShardLock) {
+    StoreOptions storeOptions;
+    storeOptions.maxKeysPerShard = 100;
+    storeOptions.shardCount = 1;
+    storeOptions.compressionThreshold = 1024;
+    Store testStore(storeOptions);
+    testStore.setExecutor(std::make_shared<WorkerPool>(1));
+    std::string document(4096, 'a');
+    testStore.put("document", document);
+
+    LockGate writeGate;
+    GatedStreamBuffer gatedBuffer(writeGate);
+    std::ostream gatedOutput(&gatedBuffer);
+    std::thread lister([&] { testStore.list(gatedOutput); });
+    writeGate.waitUntilEntered();
+
+    // A free shard lets the put run inline; it would be queued behind a held lock
+    bool stored = false;
+    testStore.putAsync("other", "value", [&](bool succeeded) { stored = succeeded; });
+    EXPECT_TRUE(stored);
+
+    writeGate.release();
+    lister.join();
+    EXPECT_NE(gatedBuffer.written.find("\"document\": \"" + document + "\""), std::string::npos);
+}
+
+/**
+ * ==============================
+ * Shared-nothing shards
+ * ==============================
+ */
+
+/**
+ * @brief Tests single-key and batch operations sent as messages to shard owners.
+ */
+TEST(OwnedShardStoreTest, OperationsReachOwningShard) {
+    StoreOptions options;
+    options.maxKeysPerShard = 100;
+    options.shardCount = 4;
+    OwnedShardStore testStore(options);
+    auto client = testStore.connect();
+
+    EXPECT_TRUE(client->put("foo", "bar"));
+    std::string retrievedValue;
+    EXPECT_TRUE(client->get("foo", retrievedValue));
+    EXPECT_EQ(retrievedValue, "bar");
+    EXPECT_TRUE(client->del("foo"));
+    EXPECT_FALSE(client->del("foo"));
+    EXPECT_FALSE(client->get("foo"));
+
+    std::vector<std::pair<std::string, std::string>> keyValuePairs;
+    for (int index = 0; index < 40; ++index) {
+        keyValuePairs.emplace_back("key" + std::to_string(index), "value" + std::to_string(index));
+    }
+    client->putMany(keyValuePairs);
+
+    std::vector<std::string_view> batchKeys = {"key0", "missing", "key17", "key39"};
+    std::vector<ValueHandle> batchValues;
+    EXPECT_EQ(client->getMany(batchKeys, batchValues), 3u);
+    ASSERT_EQ(batchValues.size(), 4u);
+    EXPECT_EQ(batchValues[0].view(), "value0");
+    EXPECT_FALSE(batchValues[1]);
+    EXPECT_EQ(batchValues[2].view(), "value17");
+    EXPECT_EQ(batchValues[3].view(), "value39");
+
+    EXPECT_EQ(client->delMany(batchKeys), 3u);
+    EXPECT_FALSE(client->get("key17"));
+    EXPECT_TRUE(client->get("key18"));
+}
+
+/**
+ * @brief Tests that many clients, connecting and disconnecting, each see their own writes.
+ */
+TEST(OwnedShardStoreTest, ConcurrentClientsSeeTheirWrites) {
+    StoreOptions options;
+    options.maxKeysPerShard = 10000;
+    options.shardCount = 4;
+    OwnedShardStore testStore(options);
+
+    constexpr int kThreadCount = 8;
+    constexpr int kKeysPerThread = 500;
+    std::atomic<int> mismatchCount{0};
+    std::vector<std::thread> clientThreads;
+    for (int threadIndex = 0; threadIndex < kThreadCount; ++threadIndex) {
+        clientThreads.emplace_back([&, threadIndex] {
+            // Reconnect halfway through so freed slots get reused
+            for (int round = 0; round < 2; ++round) {
+                auto client = testStore.connect();
+                for (int index = round * kKeysPerThread / 2; index < (round + 1) * kKeysPerThread / 2; ++index) {
+                    std::string key = "t" + std::to_string(threadIndex) + "_" + std::to_string(index);
+                    client->put(key, key);
+                    std::string retrievedValue;
+                    if (!client->get(key, retrievedValue) || retrievedValue != key) {
+                        mismatchCount.fetch_add(1);
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread& clientThread : clientThreads) {
+        clientThread.join();
+    }
+    EXPECT_EQ(mismatchCount.load(), 0);
+
+    auto client = testStore.connect();
+    std::vector<std::string> allKeys;
+    for (int threadIndex = 0; threadIndex < kThreadCount; ++threadIndex) {
+        for (int index = 0; index < kKeysPerThread; ++index) {
+            allKeys.push_back("t" + std::to_string(threadIndex) + "_" + std::to_string(index));
+        }
+    }
+    std::vector<std::string_view> keyViews(allKeys.begin(), allKeys.end());
+    std::vector<ValueHandle> values;
+    EXPECT_EQ(client->getMany(keyViews, values), allKeys.size());
+}
+
+/**
+ * ==============================
+ * Hot keys and near cache
+ * ==============================
+ */
+
+/**
+ * @brief Tests that a key taking most of the reads is reported hot, and keys read rarely are not.
+ */
+TEST(StoreTest, DetectsHotKeys) {
+    Store testStore(1000, 4);
+    for (int index = 0; index < 200; ++index) {
+        testStore.put("key_" + std::to_string(index), "v");
+    }
+    testStore.put("hot", "v");
+
+    std::string retrievedValue;
+    for (int round = 0; round < 20; ++round) {
+        for (int index = 0; index < 200; ++index) {
+            testStore.get("key_" + std::to_string(index), retrievedValue);
+            testStore.get("hot", retrievedValue);
+        }
+    }
+
+    StoreStats storeStats = testStore.stats();
+    ASSERT_FALSE(storeStats.hotKeys.empty());
+    EXPECT_EQ(storeStats.hotKeys.front().key, "hot");
+    EXPECT_GE(storeStats.hotKeys.front().reads, 2000u);
+    EXPECT_EQ(storeStats.hotKeys.size(), 1u);
+    EXPECT_EQ(storeStats.shards[testStore.shardOf("hot")].hotKeys.size(), 1u);
+
+    // Without a near cache every read still goes through its shard
+    EXPECT_EQ(storeStats.nearCacheHits, 0u);
+    EXPECT_EQ(storeStats.hits, 8000u);
+}
+
+/**
+ * @brief Tests that the near cache serves a hot key lock-free and never outlives a write to it.
+ */
+TEST(StoreTest, NearCacheServesHotKeysUntilChanged) {
+    StoreOptions storeOptions;
+    storeOptions.maxKeysPerShard = 1000;
+    storeOptions.shardCount = 4;
+    storeOptions.nearCacheSlots = 64;
+    Store testStore(storeOptions);
+
+    testStore.put("hot", "v1");
+    testStore.put("timed", "t", std::chrono::seconds(60));
+    std::string retrievedValue;
+    for (int index = 0; index < 2000; ++index) {
+        ASSERT_TRUE(testStore.get("hot", retrievedValue));
+        ASSERT_EQ(retrievedValue, "v1");
+        ASSERT_TRUE(testStore.get("timed", retrievedValue));
+    }
+    StoreStats storeStats = testStore.stats();
+    EXPECT_GT(storeStats.nearCacheHits, 1000u);
+    EXPECT_LT(storeStats.nearCacheFills, 100u);
+    EXPECT_EQ(storeStats.hits, 4000u);
+
+    // Each kind of change is seen by the very next get
+    testStore.put("hot", "v2");
+    ASSERT_TRUE(testStore.get("hot", retrievedValue));
+    EXPECT_EQ(retrievedValue, "v2");
+    for (int index = 0; index < 100; ++index) {
+        testStore.get("hot", retrievedValue);
+    }
+    testStore.expire("hot", std::chrono::milliseconds(20));
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    EXPECT_FALSE(testStore.get("hot", retrievedValue));
+
+    testStore.put("hot", "v3");
+    for (int index = 0; index < 100; ++index) {
+        testStore.get("hot", retrievedValue);
+    }
+    testStore.del("hot");
+    EXPECT_FALSE(testStore.get("hot", retrievedValue));
+
+    testStore.put("hot", "v4");
+    for (int index = 0; index < 100; ++index) {
+        testStore.get("hot", retrievedValue);
+    }
+    testStore.clear();
+    EXPECT_FALSE(testStore.get("hot", retrievedValue));
+
+    // A write from another thread invalidates this thread's copy too
+    testStore.put("hot", "v5");
+    for (int index = 0; index < 100; ++index) {
+        testStore.get("hot", retrievedValue);
+    }
+    std::thread([&] { testStore.put("hot", "v6"); }).join();
+    ASSERT_TRUE(testStore.get("hot", retrievedValue));
+    EXPECT_EQ(retrievedValue, "v6");
+}
+
+/**
+ * @brief Tests that a shard clear() has already emptied stops serving near-cached values before clear returns.
+ */
+TEST(StoreTest, NearCacheMissesAsSoonAsClearEmptiesTheShard) {
+    StoreOptions storeOptions;
+    storeOptions.maxKeysPerShard = 1000;
+    storeOptions.shardCount = 2;
+    storeOptions.nearCacheSlots = 64;
+    Store testStore(storeOptions);
+
+    // clear() empties shards in index order, so one held in shard 1 pauses it after shard 0
+    std::string hotKey;
+    std::string heldKey;
+    for (int index = 0; hotKey.empty() || heldKey.empty(); ++index) {
+        std::string key = "key_" + std::to_string(index);
+        (testStore.shardOf(key) == 0 ? hotKey : heldKey) = key;
+    }
+    testStore.put(hotKey, "cached");
+    std::string retrievedValue;
+    for (int index = 0; index < 2000; ++index) {
+        ASSERT_TRUE(testStore.get(hotKey, retrievedValue));
+    }
+    ASSERT_GT(testStore.stats().nearCacheHits, 0u);
+
+    LockGate lockGate;
+    std::thread lockHolder([&] {
+        testStore.update(heldKey, [&](const ValueHandle&, std::string&) {
+            lockGate.enter();
+            return UpdateAction::Keep;
+        });
+    });
+    lockGate.waitUntilEntered();
+    std::thread clearer([&] { testStore.clear(); });
+    // ttl reads under the shard lock, bypassing the near cache
+    while (testStore.ttl(hotKey) != Store::kTtlMissing) {
+        std::this_thread::yield();
+    }
+
+    EXPECT_FALSE(testStore.get(hotKey, retrievedValue));
+
+    lockGate.release();
+    lockHolder.join();
+    clearer.join();
+}
+
+/**
+ * @brief Tests that readers served by near caches never see a key's value go backwards while it is rewritten.
+ */
+TEST(StoreTest, NearCacheReadsStayMonotonicUnderWrites) {
+    StoreOptions storeOptions;
+    storeOptions.maxKeysPerShard = 1000;
+    storeOptions.shardCount = 2;
+    storeOptions.recencyMode = RecencyMode::Clock;
+    storeOptions.nearCacheSlots = 16;
+    Store testStore(storeOptions);
+    testStore.put("hot", "0");
+
+    const int kWrites = 2000;
+    std::atomic<bool> writing{true};
+    std::atomic<int> regressions{0};
+    std::vector<std::thread> readerThreads;
+    for (int readerIndex = 0; readerIndex < 4; ++readerIndex) {
+        readerThreads.emplace_back([&] {
+            int lastSeen = 0;
+            std::string retrievedValue;
+            while (writing.load()) {
+                if (testStore.get("hot", retrievedValue)) {
+                    int seen = std::stoi(retrievedValue);
+                    if (seen < lastSeen) {
+                        regressions.fetch_add(1);
+                    }
+                    lastSeen = seen;
+                }
+            }
+            // Once the writer is done, every reader sees the final value
+            testStore.get("hot", retrievedValue);
+            if (retrievedValue != std::to_string(kWrites)) {
+                regressions.fetch_add(1);
+            }
+        });
+    }
+    for (int write = 1; write <= kWrites; ++write) {
+        testStore.put("hot", std::to_string(write));
+        if (write % 64 == 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+    writing.store(false);
+    for (std::thread& readerThread : readerThreads) {
+        readerThread.join();
+    }
+    EXPECT_EQ(regressions.load(), 0);
+    EXPECT_GT(testStore.stats().nearCacheHits, 0u);
+}